@@ -1,18 +1,17 @@
 #include "CommonDef.h"
+#include "Logger.h"
 
-bool TestError(int error, std::string where, bool fatal) {
+bool TestError(int error, const char *where, bool fatal) {
   if (error) {
-    if (fatal)
-        std::cerr << "***FATAL ";
-    std::cerr << "ERROR, code " << error;
-    
-    if (where != "")
-        std::cerr << " @ "<< where << std::endl;
-    else std::cerr << std::endl;
-    
-    if (fatal)
-        exit(-1);
-    
+    if (fatal) {
+      if (where[0]) vLog(SILENT, "***FATAL ERROR, code {} @ {}", error, where);
+      else vLog(SILENT, "***FATAL ERROR, code {}", error);
+      logger::get().flush();
+      exit(-1);
+    }
+
+    if (where[0]) vLog(ERROR, "ERROR, code {} @ {}", error, where);
+    else vLog(ERROR, "ERROR, code {}", error);
     return 0;
   }
   
@@ -20,54 +19,26 @@ bool TestError(int error, std::string where, bool fatal) {
 }
 
 std::string show_hex(unsigned int number, int size){
-    std::ostringstream to_return;
-  to_return<<"0x";
-  int i=size-1;
-  if(size==-1){
-    while(number>=pow(16.0,i))i++;
-    i--;
-  }
-  for (int k=i; k>-1; k--){
-    for (int j=1; j<18; j++){
-      if (number<j*pow(16.0,k)){
-	  switch (j){
-	    case 11:
-	      to_return<<"A";
-	      break;
-	    case 12:
-	      to_return<<"B";
-	      break;
-	    case 13:
-	      to_return<<"C";
-	      break;
-	    case 14:
-	      to_return<<"D";
-	      break;
-	    case 15:
-	      to_return<<"E";
-	      break;
-	    case 16:
-	      to_return<<"F";
-	      break;
-	    default:
-	      to_return<<j-1;
-	  }
-	  number=number-(j-1)*pow(16.0,k);
-	  break;
-      }
-    }
-  }
-  return(to_return.str());
+  static const char digits[] = "0123456789ABCDEF";
+  int needed = 1;
+  while (needed < 8 && (number >> (4*needed)) != 0) needed++;
+  if (size < needed) size = needed;
+
+  std::string to_return(2 + size, '0');
+  to_return[1] = 'x';
+  for (int k = 0; k < size && k < 8; k++)
+    to_return[1 + size - k] = digits[(number >> (4*k)) & 0xF];
+  return(to_return);
 }
 
 
 
 unsigned int digit(unsigned int data, int begin, int end)
 {
-    if (begin<end){return -1;}
-    data=data%(int)pow(2.0,begin+1);
-    data=data-data%(int)pow(2.0,end);
-    return (data/pow(2.0,end));
+    if (begin<end || end<0 || begin>31){return -1;}
+    int width=begin-end+1;
+    unsigned int mask=(width==32 ? 0xFFFFFFFFu : (1u<<width)-1u);
+    return ((data>>end) & mask);
 }
 
 unsigned int digit(unsigned int data, int position)
@@ -7,7 +7,7 @@
 #include <stdlib.h>
 
 
-bool TestError(int error, std::string where="", bool fatal = false);
+bool TestError(int error, const char *where="", bool fatal = false);
 /**<
  * \brief Handles errors.
  * 
@@ -15,7 +15,7 @@ bool TestError(int error, std::string where="", bool fatal = false);
  * \param endroit1 String indicating the place of the error. Will be shown in error message.
  * \param fatal If set to true, the program exists.
  * 
- * This function is the same as the vmeBoard member function but doesn't handle verbosity.
+ * The error is logged at the ERROR level (see logger), so that an error storm does not stall the caller. where must be a string literal.
  * 
  */
 std::string show_hex(unsigned int number, int size=-1);
@@ -23,14 +23,20 @@ std::string show_hex(unsigned int number, int size=-1);
  * \brief Converts an hexadecimal number to a string.
  * 
  * \param number Number to convert.
- * \param size Number of "digits" to show. Autoset if not specified.
+ * \param size Number of "digits" to show at least. Autoset if not specified.
  * 
  */
 //string show_hex(int number,int size=-1){ return(show_hex ((unsigned int) number,size));}
 
 unsigned int digit(unsigned int data, int begin, int end);
+/**<
+ * \brief Returns the bits begin (highest) to end (lowest) of data, shifted down to bit 0.
+ * 
+ * Returns -1 if the range is not valid. For registers of the boards, prefer the vmeField of their register map (see Registers.h), where masks and shifts are constants.
+ */
 
 unsigned int digit(unsigned int data, int digit);
+///< Returns the bit number digit of data.
 
 
 /// Defines coutLevels to manage library output.
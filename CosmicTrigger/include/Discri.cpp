@@ -4,11 +4,11 @@ discri::discri(vmeController *controller,int add):vmeBoard(controller,A32_U_DATA
   this->add=add;
   this->status=0x0000;//All channels off
   this->setMultiChannel(0);
-  int DATA;
-  if(readData(add+0xFE,&DATA)!=0){
-    if (vLevel(ERROR))std::cerr<<"** ERROR, unable to connect to Discriminator at add="<<add<<std::endl;
+  unsigned int DATA;
+  if(readRegister<v812::VersionSerial>(DATA)!=0){
+    vLog(ERROR, "** ERROR, unable to connect to Discriminator at add={}", add);
   }
-  else{if(vLevel(NORMAL))std::cout<<"Connexion to discri... ok!"<<std::endl;}
+  else{vLog(NORMAL, "Connexion to discri... ok!");}
   this->setMultiChannel(this->status);
 }
 
@@ -20,13 +20,11 @@ int discri::setChannel(int num, bool newState){
     else return(setMultiChannel(0x0000));
   }
   
-  bool curState=(this->status%(int)pow(2,num+1))/pow(2,num);  
-  if(!newState && curState)this->status-=pow(2,num);
-  else if (newState && !curState) this->status+=pow(2,num);
-  int DATA=status;
-  if(TestError(writeData(this->add+0x4A,&DATA),"Discri: Changing channel status")){
-    if (vLevel(NORMAL))std::cout<<"New status for channel "<<num<<": "<<(this->status%(int)pow(2,num+1))/pow(2,num)<<std::endl;
-    std::cout<<"DEBUG..."<<num<<"-"<<this->status<<"-"<<(this->status%(int)pow(2,num+1))/pow(2,num)<<std::endl; 
+  if(newState) this->status|=(1<<num);
+  else this->status&=~(1<<num);
+  if(TestError(writeRegister<v812::PatternInhibit>(this->status),"Discri: Changing channel status")){
+    vLog(NORMAL, "New status for channel {}: {}", num, (this->status>>num)&1);
+    vLog(DEBUG, "DEBUG...{}-{}-{}", num, this->status, (this->status>>num)&1);
     return(1);
   }
   else return(-1);
@@ -35,9 +33,8 @@ int discri::setChannel(int num, bool newState){
 
 int discri::setMultiChannel(int code){
   this->status=code;
-  int DATA=code;
-  if(TestError(writeData(this->add+0x4A,&DATA),"Discri: Changing channel status")){
-    if (vLevel(NORMAL))    std::cout<<"Channels changed. Code:"<<code<<std::endl;
+  if(TestError(writeRegister<v812::PatternInhibit>(code),"Discri: Changing channel status")){
+    vLog(NORMAL, "Channels changed. Code:{}", code);
     return(1);
   }
   return(-1);
@@ -49,8 +46,8 @@ int discri::setMajority(int num){
   if ((nRound+0.5)>int(nRound)){ round=(int)nRound+1;}
   else{ round=(int)nRound;}
   
-  if(TestError(writeData(this->add+0x48,&round),"Discri: setting majority")){
-    if(vLevel(NORMAL))std::cout<<"Set majority level to "<<num<<"(sent: "<<round<<")"<<std::endl;
+  if(TestError(writeRegister<v812::Majority>(round),"Discri: setting majority")){
+    vLog(NORMAL, "Set majority level to {}(sent: {})", num, round);
     return (1);
   }
   return(-1);
@@ -58,20 +55,19 @@ int discri::setMajority(int num){
 
 int discri::setTh(int value,int num){
   if(value>255 || value<0){
-    if(vLevel(WARNING)) std::cerr<<"*  WARNING: illegal value , command ignored"<<std::endl;
+    vLog(WARNING, "*  WARNING: illegal value , command ignored");
     return(-1);
   }
   else{
     if (num==-1){
       int status=1;
-      if(vLevel(NORMAL))std::cout<<"Setting all thresholds to "<<value<<std::endl;
+      vLog(NORMAL, "Setting all thresholds to {}", value);
       for (int i=0; i<16; i++) if(this->setTh(value,i)<0)status=-1;
       return(status);
     }
     else{
-      if(vLevel(DEBUG)) std::cout<<"Setting threshold to "<<value<<" on channel "<<num<<"...";
-      if(TestError(writeData(add+2*num,&value),"Discri: Setting threshold")){
-	if (vLevel(DEBUG))std::cout<<" ok!"<<std::endl;
+      if(TestError(writeRegister<v812::Threshold>(num,value),"Discri: Setting threshold")){
+	vLog(DEBUG, "Setting threshold to {} on channel {}... ok!", value, num);
 	return(1);
       }
       else return(-1);
@@ -82,18 +78,14 @@ int discri::setTh(int value,int num){
 
 int discri::setWidth(int value,int num){
   if(value>255 || value<1){
-    if(vLevel(WARNING))std::cerr<<"*  WARNING: illegal value , command ignored"<<std::endl;
+    vLog(WARNING, "*  WARNING: illegal value , command ignored");
     return(-1);
   }
   else{
-      int DATA=value;
-      if(vLevel(NORMAL)) std::cout<<"Setting output width to"<<value<<"...";
       bool state;
-      if (num<8)state=TestError(writeData(this->add+0x40,&DATA),"Discri: Setting width");
-      if (num<0||num>7)state=TestError(writeData(this->add+0x42,&DATA),"Discri: Setting width");
-      if(state && vLevel(NORMAL)){
-	std::cout<<" ok!"<<std::endl;
-      }
+      if (num<8)state=TestError(writeRegister<v812::OutputWidth>(0,value),"Discri: Setting width");
+      if (num<0||num>7)state=TestError(writeRegister<v812::OutputWidth>(1,value),"Discri: Setting width");
+      if(state) vLog(NORMAL, "Setting output width to {}... ok!", value);
       if(!state) return(-1);
       else return(1);
     }
@@ -103,24 +95,22 @@ int discri::setWidth(int value,int num){
 
 
 int discri::viewStatus(void){
-  if(vLevel(NORMAL))std::cout<<show_hex(this->status,4)<<std::endl;
+  vLog(NORMAL, "{x}", this->status);
   return(this->status);
 }
 
 
 int discri::setDeadTime(int value,int num){
   if(value>255 || value<0){
-    if(vLevel(WARNING))std::cerr<<"*  WARNING: illegal value , command ignored"<<std::endl;
+    vLog(WARNING, "*  WARNING: illegal value , command ignored");
     return(-1);
   }
   else{
-      int DATA=value;
-      if(vLevel(NORMAL))std::cout<<"Setting dead time to "<<value<<"...";
       bool state;
-      if (num<8)state=TestError(writeData(this->add+0x44,&DATA),"Discri: setting dead time");
-      if (num<0||num>7)state=TestError(writeData(this->add+0x46,&DATA),"Discri: setting dead time");
+      if (num<8)state=TestError(writeRegister<v812::DeadTime>(0,value),"Discri: setting dead time");
+      if (num<0||num>7)state=TestError(writeRegister<v812::DeadTime>(1,value),"Discri: setting dead time");
       
-      if(state && vLevel(NORMAL))std::cout<<" ok!"<<std::endl;
+      if(state) vLog(NORMAL, "Setting dead time to {}... ok!", value);
       if(!state)return(-1);
       else return(1);
     }
@@ -3,6 +3,20 @@
 
 #include "VmeBoard.h"
 
+/**
+ * \brief Register map of the V812 (see the data sheet).
+ *
+ * Output widths and dead times are set per group of 8 channels.
+ */
+namespace v812 {
+  typedef vmeRegisterArray<0x00, 2, 16, D16> Threshold;
+  typedef vmeRegisterArray<0x40, 2, 2, D16> OutputWidth;
+  typedef vmeRegisterArray<0x44, 2, 2, D16> DeadTime;
+  typedef vmeRegister<0x48, D16> Majority;
+  typedef vmeRegister<0x4A, D16> PatternInhibit;
+  typedef vmeRegister<0xFE, D16> VersionSerial;
+}
+
 /**
  * 
  * \brief Discriminator/Coincidence unit controller.
@@ -17,6 +17,7 @@ class event
 {
 public:
     event():time(0), eventNumber(0), errorCode(-1){}
+    void clear(){ time = 0; eventNumber = 0; hits.clear(); tdcErrors.clear(); errorCode = -1; } ///< Back to a new event, keeping the memory of the vectors
     time_t time;
     unsigned int eventNumber;
     std::vector<hit> hits;
@@ -1,5 +1,14 @@
 #include "HV.h"
 
+namespace {
+  /// Frees the values allocated by hv::readValues(), if it allocated them.
+  void freeValues(double **val, bool allocated) {
+    if (!allocated) return;
+    for (int i = 0; i < 4; i++) delete[] val[i];
+    delete[] val;
+  }
+}
+
 hv::hv(vmeController *controller, int bridgeAdd, int hvAdd):vmeBoard(controller,A24_S_DATA,D16){
   this->add=bridgeAdd;
   this->hvAdd=hvAdd;
@@ -9,20 +18,17 @@ hv::hv(vmeController *controller, int bridgeAdd, int hvAdd):vmeBoard(controller,
 
 int hv::reset(void){
   //std::cout<<show_hex(bridgeAdd)<<std::endl;
-  int DATA=0x0000;
-  if(vLevel(NORMAL))std::cout<<"Reseting HV...";
-  if(TestError(writeData(add+0x06,&DATA),"HV: reset")){
-    if (vLevel(NORMAL))std::cout<<" ok!"<<std::endl;
+  if(TestError(writeRegister<v288::Reset>(0),"HV: reset")){
+    vLog(NORMAL, "Reseting HV... ok!");
     return(1);
   }
   return(-1);
 }
 
 int hv::getStatus(){
-    int DATA=0;
-    if(vLevel(DEBUG))std::cout<<"Getting HV status...";
-    if(TestError(readData(add+0x02,&DATA),"HV: getStatus")){
-      if (vLevel(DEBUG))std::cout<<" ok!"<<std::endl;
+    unsigned int DATA=0;
+    if(TestError(readRegister<v288::Status>(DATA),"HV: getStatus")){
+      vLog(DEBUG, "Getting HV status... ok!");
       return(DATA);
     }
     else return(-1);
@@ -30,40 +36,34 @@ int hv::getStatus(){
 
 int hv::comLoop(int data1, int data2) {
     // FIXME
-    usleep(100000);
-    
-    if (getStatus() == 0xFFFF && vLevel(WARNING))
-        std::cout << "*  WARNING: Initial status of HV was: error..." << std::endl;
-    
-    int DATA = 0x0001;
+    usleep(v288::CommandDelay);
+
+    return sendCommand(data1, data2);
+}
+
+int hv::sendCommand(int data1, int data2) {
+    if (getStatus() == (int) v288::NoValidData)
+        vLog(WARNING, "*  WARNING: Initial status of HV was: error...");
     
-    if (!TestError(writeData(add, &DATA), "HV: comLoop, starting communication"))
+    if (!TestError(writeRegister<v288::Data>(0x0001), "HV: comLoop, starting communication"))
         return -1;  //Hello
     
-    DATA = hvAdd;
-    
-    if(!TestError(writeData(add, &DATA), "HV: comLoop, setting alim address"))
+    if(!TestError(writeRegister<v288::Data>(hvAdd), "HV: comLoop, setting alim address"))
         return -1;   //Alim address
 
-    DATA = data1;
-    
-    if(!TestError(writeData(add, &DATA), "HV: comLoop, setting first command"))
+    if(!TestError(writeRegister<v288::Data>(data1), "HV: comLoop, setting first command"))
         return -1;   //Command
     
     if (data2 > -1){
-        DATA = data2;
-        if(!TestError(writeData(add, &DATA), "HV: comLoop, setting second command"))
+        if(!TestError(writeRegister<v288::Data>(data2), "HV: comLoop, setting second command"))
             return -1;  //Value 
     }
     
-    DATA = 0x0000;
-    
-    if (!TestError(writeData(add + 0x04, &DATA), "HV: comLoop, ordering to send a command"))
-        std::cout << "Error?" << std::endl; //Send command
+    if (!TestError(writeRegister<v288::Transmit>(0), "HV: comLoop, ordering to send a command"))
+        vLog(ERROR, "Error?"); //Send command
 
-    if (getStatus() == 0xFFFF) {
-        if (vLevel(ERROR))
-            std::cout << "** ERROR while sending " << show_hex(data1, 4) << "&" << show_hex(data2,4) << std::endl;
+    if (getStatus() == (int) v288::NoValidData) {
+        vLog(ERROR, "** ERROR while sending {x}&{x}", data1, data2);
         return -1;
     }
 //     int lbreak=0;
@@ -93,8 +93,7 @@ int hv::setChState(bool state, int channel) {
   
     } else if (channel > 3) {
     
-        if (vLevel(WARNING))
-            std::cerr << "*   WARNING: invalid parameter: " << channel << ". Statement ignored" << std::endl;
+        vLog(WARNING, "*   WARNING: invalid parameter: {}. Statement ignored", channel);
         return -1;
     
     } else {
@@ -102,6 +101,47 @@ int hv::setChState(bool state, int channel) {
     }
 }
 
+int hv::sendChState(bool state, int channel) {
+    if (channel < 0 || channel > 3) {
+        vLog(WARNING, "*   WARNING: invalid parameter: {}. Statement ignored", channel);
+        return -1;
+    }
+    return sendCommand(channel * 256 + 0x000B - state);
+}
+
+int hv::sendChV(int volt, int channel) {
+    if (channel < 0 || channel > 3) {
+        vLog(WARNING, "*   WARNING: invalid parameter: {}. Statement ignored", channel);
+        return -1;
+    }
+    return sendCommand(channel * 256 + 0x0003, volt);
+}
+
+int hv::sendReadValues(void) {
+    return sendCommand(0x01);
+}
+
+int hv::readResponse(double ** val) {
+    // The first word is the error code of the crate, no valid data until it has answered
+    unsigned int DATA = 0;
+    readRegister<v288::Data>(DATA);
+    if (getStatus() == (int) v288::NoValidData)
+        return 0;
+    if (DATA) {
+        vLog(WARNING, "No data...");
+        return -1;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            readRegister<v288::Data>(DATA);
+            val[i][j] = DATA;
+        }
+    }
+    if (DATA == v288::NoValidData) { this->reset(); }
+    return 1;
+}
+
 int hv::setChV(int volt, int channel){
   if (channel<0){
     int status=1;
@@ -111,39 +151,40 @@ int hv::setChV(int volt, int channel){
     return(status);
   }
   else if(channel>3){
-    if(vLevel(WARNING)) std::cerr<<"*   WARNING: invalid parameter: "<<channel<<". Statement ignored"<<std::endl;
+    vLog(WARNING, "*   WARNING: invalid parameter: {}. Statement ignored", channel);
     return(-1);
   }
   else{
-    usleep(10000);
+    usleep(v288::SetDelay);
     return(comLoop(channel*256+0x0003,volt));
   }
 }
 
 double ** hv::readValues(double ** val){
-  if(val==0){
+  bool allocated=(val==0);
+  if(allocated){
     //std::cout<<"New value vector"<<std::endl;
     val=new double * [4]; 
     for(int i=0; i<4; i++) val[i]=new double[4];
   }
   
-  if(comLoop(0x01)==-1)return(0);
+  if(comLoop(0x01)==-1){freeValues(val, allocated); return(0);}
 //   return(1);
-  int DATA=0;
+  unsigned int DATA=0;
   //int lBreak=0;
-  usleep(100000);
+  usleep(v288::ResponseDelay);
   getStatus();
-  readData(add,&DATA);
-  if(DATA){std::cout<<"No data..."<<std::endl; return(0);}
+  readRegister<v288::Data>(DATA);
+  if(DATA){vLog(WARNING, "No data..."); freeValues(val, allocated); return(0);}
   
   for(int i=0; i<4; i++){
     for(int j=0; j<4; j++){
-      readData(add,&DATA);
+      readRegister<v288::Data>(DATA);
       //std::cout<<DATA<<std::endl;
       val[i][j]=DATA;
       }
   }
-  if(DATA==0xFFFF){this->reset();}
+  if(DATA==v288::NoValidData){this->reset();}
 
 //   if(TestError(readData(add,&DATA),"HV: reading values")==-1){return(-1);}
   
@@ -3,6 +3,22 @@
 
 #include "VmeBoard.h"
 
+/**
+ * \brief Register map of the V288 CAENET bridge.
+ */
+namespace v288 {
+  typedef vmeRegister<0x00, D16> Data;    ///< Transmit buffer (write) and receive buffer (read)
+  typedef vmeRegister<0x02, D16> Status;  ///< NoValidData after a failed operation
+  typedef vmeRegister<0x04, D16> Transmit;
+  typedef vmeRegister<0x06, D16> Reset;
+
+  const unsigned int NoValidData = 0xFFFF;
+
+  const unsigned int CommandDelay = 100000;  ///< Wait (us) before sending a command, for the bridge to be ready
+  const unsigned int SetDelay = 10000;       ///< Additional wait (us) before setting a voltage
+  const unsigned int ResponseDelay = 100000; ///< Wait (us) for the answer of the crate to a command
+}
+
 
 /**<
  * 
@@ -58,6 +74,34 @@ class hv: public vmeBoard {
          * 
          */
         
+        int sendCommand(int data1, int data2 = -1);
+        /**
+         * \brief Same as comLoop(), without waiting for the bridge first.
+         * 
+         * For callers which wait themselves (v288::CommandDelay), e.g. without holding the VME bus meanwhile.
+         * 
+         */
+
+        int sendChState(bool state, int channel);
+        int sendChV(int volt, int channel);
+        int sendReadValues(void);
+        /**
+         * \brief Send the command of setChState() or setChV() for a single channel, or the command of readValues(), without waiting.
+         * 
+         * The caller waits v288::CommandDelay (and v288::SetDelay before sendChV()) before, and reads the answer of sendReadValues() with readResponse() after v288::ResponseDelay.
+         * 
+         * These functions return 1 if the command was sent, -1 if not.
+         * 
+         */
+
+        int readResponse(double ** data);
+        /**
+         * \brief Read the answer of the crate to sendReadValues() into data (4 arrays of 4 doubles).
+         * 
+         * This function returns 1 if the values were read, 0 if the bridge has no answer yet (it can be polled), and -1 if the crate answered with an error.
+         * 
+         */
+
         int setChState(bool state, int channel = -1);
         /**
          * \brief Sets channel on/off.
@@ -84,13 +128,13 @@ class hv: public vmeBoard {
 
         double ** readValues(double ** data = 0);
         /**
-         * \brief Reads bridge i/o register
+         * \brief Reads the values of the 4 channels (4 values each).
          * 
-         * This function will read the value stored on the bridge's i/o register.
+         * The values are written to data (4 arrays of 4 doubles), which is returned: pass the same arrays at each call, so that reading does not allocate.
          * 
-         * If the slave wrote on it correctly, the function will return 1. 
+         * If data is 0, the arrays are allocated with new[], and must be deleted by the caller.
          * 
-         * If there is a communication problem, or if the slave did not write on the bridge, the function returns -1
+         * If there is a communication problem, or if the slave did not write on the bridge, the function returns 0 (and frees the arrays it allocated).
          * 
          */
         
@@ -0,0 +1,240 @@
+#include "Logger.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+  int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  template<typename T> void writeRaw(std::ostream &out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+}
+
+logger& logger::get() {
+  static logger instance;
+  return instance;
+}
+
+logger::logger():
+  level(NORMAL),
+  rateLimit(20),
+  suppressed(0),
+  dropped(0),
+  queue(new record[QueueSize]),
+  enqueuePos(0),
+  dequeuePos(0),
+  sites(new site[NSites]),
+  useBinary(false),
+  stop(false) {
+  static_assert((QueueSize & (QueueSize - 1)) == 0, "The queue size must be a power of 2");
+  for (std::size_t i = 0; i < QueueSize; i++)
+    queue[i].sequence.store(i, std::memory_order_relaxed);
+  for (std::size_t i = 0; i <= NSites; i++) {
+    site &s = (i < NSites) ? sites[i] : overflowSite;
+    s.format.store(0, std::memory_order_relaxed);
+    s.level.store(SILENT, std::memory_order_relaxed);
+    s.second.store(0, std::memory_order_relaxed);
+    s.count.store(0, std::memory_order_relaxed);
+    s.suppressed.store(0, std::memory_order_relaxed);
+  }
+  thread = std::thread(&logger::run, this);
+}
+
+logger::~logger() {
+  stop.store(true);
+  thread.join();
+  if (binary.is_open()) binary.close();
+  delete[] queue;
+  delete[] sites;
+}
+
+bool logger::setBinaryOutput(const std::string &fileName) {
+  if (useBinary.load()) return false;
+  binary.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+  if (!binary.is_open()) return false;
+  useBinary.store(true, std::memory_order_release);
+  return true;
+}
+
+void logger::log(coutLevel level, const char *format, const logArg *args, std::size_t nArgs) {
+  int64_t time = nowNs();
+  if (!allow(level, format, time / 1000000000)) return;
+  push(time, level, format, args, nArgs);
+}
+
+bool logger::allow(coutLevel level, const char *format, int64_t second) {
+  unsigned int limit = rateLimit.load(std::memory_order_relaxed);
+  if (limit == 0) return true;
+
+  // Open addressing on the address of the format string, claimed with a CAS on first use
+  site *s = &overflowSite;
+  std::size_t hash = (reinterpret_cast<uintptr_t>(format) >> 3) * 0x9E3779B1u;
+  for (std::size_t probe = 0; probe < 8; probe++) {
+    site &candidate = sites[(hash + probe) % NSites];
+    const char *owner = candidate.format.load(std::memory_order_acquire);
+    if (owner == 0 && candidate.format.compare_exchange_strong(owner, format)) owner = format;
+    if (owner == format) {
+      s = &candidate;
+      break;
+    }
+  }
+
+  int64_t current = s->second.load(std::memory_order_relaxed);
+  if (current != second && s->second.compare_exchange_strong(current, second))
+    s->count.store(0, std::memory_order_relaxed);
+  if (s->count.fetch_add(1, std::memory_order_relaxed) < limit) return true;
+
+  s->level.store(level, std::memory_order_relaxed);
+  s->suppressed.fetch_add(1, std::memory_order_relaxed);
+  suppressed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void logger::push(int64_t time, coutLevel level, const char *format, const logArg *args, std::size_t nArgs) {
+  // Bounded multi-producer queue: a cell is free for position pos when its sequence is pos,
+  // and holds the message of position pos when its sequence is pos+1
+  std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+  record *cell;
+  while (true) {
+    cell = &queue[pos & (QueueSize - 1)];
+    std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+    if (diff == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    }
+    else if (diff < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    else pos = enqueuePos.load(std::memory_order_relaxed);
+  }
+
+  cell->msg.time = time;
+  cell->msg.level = level;
+  cell->msg.format = format;
+  cell->msg.nArgs = (nArgs < MaxArgs) ? nArgs : MaxArgs;
+  for (std::size_t i = 0; i < cell->msg.nArgs; i++) cell->msg.args[i] = args[i];
+  cell->sequence.store(pos + 1, std::memory_order_release);
+}
+
+bool logger::pop() {
+  std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+  record &cell = queue[pos & (QueueSize - 1)];
+  if (cell.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+
+  message msg = cell.msg;
+  cell.sequence.store(pos + QueueSize, std::memory_order_release);
+  write(msg);
+  dequeuePos.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+void logger::flush() {
+  std::size_t target = enqueuePos.load(std::memory_order_acquire);
+  for (int i = 0; i < 1000 && dequeuePos.load(std::memory_order_acquire) < target; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void logger::reportSuppressed() {
+  for (std::size_t i = 0; i <= NSites; i++) {
+    site &s = (i < NSites) ? sites[i] : overflowSite;
+    const char *format = s.format.load(std::memory_order_acquire);
+    if (format == 0 && i < NSites) continue;
+    uint64_t n = s.suppressed.exchange(0, std::memory_order_relaxed);
+    if (n == 0) continue;
+
+    message msg;
+    msg.time = nowNs();
+    msg.level = (coutLevel) s.level.load(std::memory_order_relaxed);
+    msg.format = (i < NSites) ? "({} similar messages suppressed: {})" : "({} messages suppressed)";
+    msg.nArgs = (i < NSites) ? 2 : 1;
+    msg.args[0] = logArg((unsigned long long) n);
+    msg.args[1] = logArg(format);
+    write(msg);
+  }
+}
+
+void logger::write(const message &msg) {
+  if (useBinary.load(std::memory_order_acquire)) {
+    uint16_t length = std::strlen(msg.format);
+    writeRaw<int64_t>(binary, msg.time);
+    writeRaw<int8_t>(binary, msg.level);
+    writeRaw<uint8_t>(binary, msg.nArgs);
+    writeRaw<uint16_t>(binary, length);
+    binary.write(msg.format, length);
+    for (std::size_t i = 0; i < msg.nArgs; i++) {
+      const logArg &arg = msg.args[i];
+      writeRaw<uint8_t>(binary, arg.type);
+      if (arg.type == logArg::String) {
+        uint16_t argLength = std::strlen(arg.value.s);
+        writeRaw<uint16_t>(binary, argLength);
+        binary.write(arg.value.s, argLength);
+      }
+      else writeRaw<uint64_t>(binary, arg.value.u);
+    }
+    return;
+  }
+
+  std::ostream &out = (msg.level <= WARNING) ? std::cerr : std::cout;
+  out << format(msg.format, msg.args, msg.nArgs) << '\n';
+}
+
+std::string logger::format(const char *format, const logArg *args, std::size_t nArgs) {
+  std::ostringstream out;
+  std::size_t next = 0;
+  for (const char *c = format; *c; c++) {
+    bool hex = (c[0] == '{' && c[1] == 'x' && c[2] == '}');
+    if (!(c[0] == '{' && c[1] == '}') && !hex) {
+      out << *c;
+      continue;
+    }
+    c += hex ? 2 : 1;
+    if (next >= nArgs) continue;
+
+    const logArg &arg = args[next++];
+    switch (arg.type) {
+      case logArg::Int:
+        if (hex) out << show_hex((unsigned int) arg.value.i);
+        else out << arg.value.i;
+        break;
+      case logArg::UInt:
+        if (hex) out << show_hex((unsigned int) arg.value.u);
+        else out << arg.value.u;
+        break;
+      case logArg::Double:
+        out << arg.value.d;
+        break;
+      case logArg::String:
+        out << arg.value.s;
+        break;
+      default:
+        break;
+    }
+  }
+  return out.str();
+}
+
+void logger::run() {
+  int64_t lastReport = nowNs();
+  while (true) {
+    bool stopping = stop.load();
+    bool wrote = false;
+    while (pop()) wrote = true;
+
+    int64_t now = nowNs();
+    if (stopping || now - lastReport >= 1000000000) {
+      reportSuppressed();
+      lastReport = now;
+      wrote = true;
+    }
+    if (wrote) {
+      if (useBinary.load(std::memory_order_acquire)) binary.flush();
+      std::cout.flush();
+    }
+    if (stopping) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
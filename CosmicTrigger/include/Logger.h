@@ -0,0 +1,187 @@
+#ifndef __LOGGER
+#define __LOGGER
+
+#include "CommonDef.h"
+
+#include <atomic>
+#include <thread>
+#include <string>
+#include <fstream>
+#include <cstddef>
+#include <stdint.h>
+
+/**
+ * \brief Argument of a log message, kept as is until the message is formatted.
+ *
+ * Strings are kept as pointers: they must live as long as the program (string literals).
+ */
+struct logArg {
+  enum Type { None, Int, UInt, Double, String };
+
+  logArg(): type(None) { value.i = 0; }
+  logArg(int v): type(Int) { value.i = v; }
+  logArg(long v): type(Int) { value.i = v; }
+  logArg(long long v): type(Int) { value.i = v; }
+  logArg(unsigned int v): type(UInt) { value.u = v; }
+  logArg(unsigned long v): type(UInt) { value.u = v; }
+  logArg(unsigned long long v): type(UInt) { value.u = v; }
+  logArg(double v): type(Double) { value.d = v; }
+  logArg(const char* v): type(String) { value.s = v; }
+
+  Type type;
+  union {
+    long long i;
+    unsigned long long u;
+    double d;
+    const char* s;
+  } value;
+};
+
+/**
+ * \brief Asynchronous logger of the drivers and of the daemons.
+ *
+ * Messages are filtered by level (see coutLevel): those above the level set by setLevel() cost a single comparison.
+ * The others are queued without being formatted, and formatted and written by a background thread,
+ * so that a slow console never stalls the readout:
+ *
+ * - The queue is a bounded lock-free ring: logging never blocks and never allocates. When the ring is full, the message is dropped (see getDropped()).
+ *
+ * - Each format string (i.e. each place messages come from) may log at most setRateLimit() messages per second.
+ * The others are suppressed: their number is reported once per second, and counted (see getSuppressed()).
+ *
+ * - Format strings have "{}" where the arguments go ("{x}" for hexadecimal, as show_hex()). They are kept as pointers: use string literals.
+ *
+ * Messages are written as lines of text on std::cout (std::cerr for errors and warnings), or as binary records in a file (see setBinaryOutput()).
+ *
+ * vmeBoard::vLevel() and the verbosity of the vmeController use the level of the logger.
+ */
+class logger {
+public:
+  static const std::size_t MaxArgs = 6; ///< Arguments of a message at most
+  static const std::size_t QueueSize = 4096; ///< Messages waiting to be written at most (power of 2)
+
+  static logger& get();
+  /**<
+   * \brief The logger of the process. Its thread is started on first use.
+   */
+
+  ~logger();
+  /**<
+   * \brief Writes the messages still queued and stops the thread.
+   */
+
+  void setLevel(int level) { this->level.store(level, std::memory_order_relaxed); }
+  ///< Messages of a higher level than level are discarded. SILENT messages are always written.
+  int getLevel() const { return level.load(std::memory_order_relaxed); }
+  bool enabled(coutLevel level) const { return (int) level <= this->level.load(std::memory_order_relaxed); }
+  ///< Returns if messages of this level are written.
+
+  void setRateLimit(unsigned int perSecond) { rateLimit.store(perSecond, std::memory_order_relaxed); }
+  ///< Messages per second at most for each format string (0: no limit). Default: 20.
+
+  bool setBinaryOutput(const std::string &fileName);
+  /**<
+   * \brief Writes the messages to fileName as binary records, instead of text on the console.
+   *
+   * Each record is (little endian): time (int64, ns since epoch), level (int8), number of arguments (uint8),
+   * length of the format string (uint16), format string; then for each argument: type (uint8, see logArg::Type) and value
+   * (8 bytes, or uint16 length and characters for strings).
+   *
+   * Returns false if the file cannot be opened (messages then stay on the console).
+   */
+
+  void log(coutLevel level, const char *format, const logArg *args, std::size_t nArgs);
+  /**<
+   * \brief Queues a message. Use vLog() instead.
+   */
+
+  void flush();
+  /**<
+   * \brief Waits (at most one second) for the messages queued so far to be written.
+   */
+
+  uint64_t getSuppressed() const { return suppressed.load(std::memory_order_relaxed); }
+  ///< Number of messages suppressed by the rate limit so far.
+  uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+  ///< Number of messages dropped because the queue was full so far.
+
+  static std::string format(const char *format, const logArg *args, std::size_t nArgs);
+  /**<
+   * \brief Replaces the "{}" (or "{x}") of format by the arguments.
+   */
+
+private:
+  logger();
+  logger(const logger&);
+  logger& operator=(const logger&);
+
+  struct message {
+    int64_t time;
+    coutLevel level;
+    const char *format;
+    std::size_t nArgs;
+    logArg args[MaxArgs];
+  };
+
+  struct record {
+    std::atomic<std::size_t> sequence;
+    message msg;
+  };
+
+  /// Rate limit of a format string
+  struct site {
+    std::atomic<const char*> format;
+    std::atomic<int> level; ///< Of the last message suppressed
+    std::atomic<int64_t> second;
+    std::atomic<unsigned int> count;
+    std::atomic<uint64_t> suppressed;
+  };
+  static const std::size_t NSites = 256;
+
+  bool allow(coutLevel level, const char *format, int64_t second);
+  void push(int64_t time, coutLevel level, const char *format, const logArg *args, std::size_t nArgs);
+  bool pop();
+  void reportSuppressed();
+  void write(const message &msg);
+  void run();
+
+  std::atomic<int> level;
+  std::atomic<unsigned int> rateLimit;
+  std::atomic<uint64_t> suppressed;
+  std::atomic<uint64_t> dropped;
+
+  record *queue;
+  std::atomic<std::size_t> enqueuePos;
+  std::atomic<std::size_t> dequeuePos;
+
+  site *sites;
+  site overflowSite; ///< Shared by the format strings which do not fit in sites
+
+  std::ofstream binary;
+  std::atomic<bool> useBinary;
+  std::atomic<bool> stop;
+  std::thread thread;
+};
+
+inline void vLog(coutLevel level, const char *format) {
+  if (logger::get().enabled(level)) logger::get().log(level, format, 0, 0);
+}
+
+/**
+ * \brief Logs a message with arguments, if its level is enabled.
+ *
+ * The arguments are copied (numbers, or string literals): formatting happens on the logger's thread.
+ * \code
+ * vLog(ERROR, "ERROR, code {} @ {}", error, where);
+ * \endcode
+ */
+template<typename... Args>
+void vLog(coutLevel level, const char *format, Args... args) {
+  static_assert(sizeof...(Args) <= logger::MaxArgs, "Too many arguments for a log message");
+  logger &l = logger::get();
+  if (!l.enabled(level)) return;
+  const logArg array[] = { logArg(args)... };
+  l.log(level, format, array, sizeof...(Args));
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef __REGISTERS
+#define __REGISTERS
+
+#include "CommonDef.h"
+
+/**
+ * \brief Compile-time description of a board register.
+ *
+ * \param Offset Address of the register, relative to the base address of the board.
+ * \param Width Data width of the accesses (D16 or D32).
+ *
+ * The register maps of the boards (see the v1190, lecroy1151, ttcvi, v812 and v288 namespaces) are made of such types.
+ * They are used with vmeBoard::readRegister() and vmeBoard::writeRegister(), which always access a register with its own width.
+ */
+template<unsigned int Offset, DataWidth Width>
+struct vmeRegister {
+  static_assert(Width == D16 || Width == D32, "Registers are accessed in D16 or D32");
+  static_assert(Offset % Width == 0, "Register is not aligned on its width");
+
+  static constexpr unsigned int offset = Offset;
+  static constexpr DataWidth width = Width;
+  static constexpr unsigned int bits = 8 * Width;
+};
+
+/**
+ * \brief Compile-time description of an array of registers, one per channel.
+ *
+ * \param Base Address of the first register, relative to the base address of the board.
+ * \param Stride Distance between two registers, in bytes.
+ * \param Count Number of registers.
+ * \param Width Data width of the accesses (D16 or D32).
+ */
+template<unsigned int Base, unsigned int Stride, unsigned int Count, DataWidth Width>
+struct vmeRegisterArray {
+  static_assert(Width == D16 || Width == D32, "Registers are accessed in D16 or D32");
+  static_assert(Base % Width == 0 && Stride % Width == 0, "Registers are not aligned on their width");
+  static_assert(Stride >= (unsigned int) Width, "Registers overlap");
+
+  static constexpr unsigned int count = Count;
+  static constexpr DataWidth width = Width;
+  static constexpr unsigned int bits = 8 * Width;
+
+  static constexpr unsigned int offset(unsigned int index) { return Base + Stride * index; }
+  ///< Address of the register number index (from 0), relative to the base address of the board. index is not checked.
+};
+
+/**
+ * \brief Compile-time description of a field of a register (or of a data word).
+ *
+ * \param Reg Register the field belongs to.
+ * \param Shift Position of the lowest bit of the field.
+ * \param Width Number of bits of the field.
+ *
+ * Masks and shifts are constants: get(), set() and test() compile to one or two instructions.
+ */
+template<class Reg, unsigned int Shift, unsigned int Width>
+struct vmeField {
+  static_assert(Width > 0, "Empty field");
+  static_assert(Shift + Width <= Reg::bits, "Field does not fit in its register");
+
+  static constexpr unsigned int shift = Shift;
+  static constexpr unsigned int width = Width;
+  static constexpr unsigned int mask = (Width == 32 ? 0xFFFFFFFFu : (1u << (Width % 32)) - 1u) << Shift;
+
+  static constexpr unsigned int get(unsigned int data) { return (data & mask) >> Shift; }
+  ///< Returns the value of the field in data.
+  static constexpr unsigned int set(unsigned int data, unsigned int value) { return (data & ~mask) | ((value << Shift) & mask); }
+  ///< Returns data with the field replaced by value (truncated to the width of the field).
+  static constexpr bool test(unsigned int data) { return (data & mask) != 0; }
+  ///< Returns if any bit of the field is set in data.
+};
+
+#endif
@@ -2,16 +2,15 @@
 
 scaler::scaler(vmeController* controller,int address):vmeBoard(controller,A24_U_DATA,D16){
   this->add=address;
-  if(vLevel(DEBUG))std::cout<<"Address"<<show_hex(add)<<std::endl;
+  vLog(DEBUG, "Address{x}", add);
   getInfo();
 }
 
  
 int scaler::getCount(int channel){
-  int DATA=0;
-  int completeAdd=add+0x80+4*(channel-1);
-  if(TestError(readData(completeAdd,&DATA,A24_U_DATA,D32),"Scaler: getting count")){
-    if(vLevel(DEBUG))std::cout<<"Count="<<DATA<<"("<<show_hex(DATA)<<") at add:"<<show_hex(completeAdd)<<std::endl;
+  unsigned int DATA=0;
+  if(TestError(readRegister<lecroy1151::Counter>(channel-1,DATA),"Scaler: getting count")){
+    vLog(DEBUG, "Count={}({x}) at add:{x}", DATA, DATA, add+lecroy1151::Counter::offset(channel-1));
     return(DATA);
   }
   return(-1);
@@ -19,24 +18,17 @@ int scaler::getCount(int channel){
 
 
 int scaler::getInfo(){ 
-  int DATA=0;
-  if(vLevel(NORMAL))std::cout<<"Getting scaler information...";
-  if(TestError(readData(add+0xFE,&DATA),"Scaler: testing communication")){
-    if(vLevel(NORMAL)){
-    std::cout<<" ok!"<<std::endl;
-    }
+  unsigned int DATA=0;
+  if(TestError(readRegister<lecroy1151::ModuleInfo>(DATA),"Scaler: testing communication")){
+    vLog(NORMAL, "Getting scaler information... ok!");
    return(DATA);
   }
   return(-1);
 }
 
 int scaler::reset(){
-  int DATA=0;
-  if(vLevel(NORMAL))std::cout<<"Reseting scaler...";
-  if(TestError(writeData(add,&DATA),"Scaler: resetting")){
-    if(vLevel(NORMAL)){
-    std::cout<<" ok!"<<std::endl;
-    }
+  if(TestError(writeRegister<lecroy1151::Reset>(0),"Scaler: resetting")){
+    vLog(NORMAL, "Reseting scaler... ok!");
     return(1);
   }
   return(-1);
@@ -44,9 +36,9 @@ int scaler::reset(){
 
 
 int scaler::readPresets(int channel){
-  int DATA=0;
-  if(TestError(readData(add+0x40+4*(channel-1),&DATA),"Scaler: reading presets")){;
-    if(vLevel(NORMAL))std::cout<<"Preset: "<<DATA<<std::endl;
+  unsigned int DATA=0;
+  if(TestError(readRegister<lecroy1151::Preset>(channel-1,DATA),"Scaler: reading presets")){;
+    vLog(NORMAL, "Preset: {}", DATA);
     return(DATA);
   }
   return(-1);
@@ -54,12 +46,8 @@ int scaler::readPresets(int channel){
 
 
 int scaler::setPresets(int channel,int value){
-  int DATA=value;
-  if(vLevel(NORMAL))std::cout<<"Setting presets to "<<value<<"...";
-  if(TestError(writeData(add+0x40+4*(channel-1),&DATA),"Scaler: setting presets")){
-    if(vLevel(NORMAL)){
-      std::cout<<" ok!"<<std::endl;
-    }
+  if(TestError(writeRegister<lecroy1151::Preset>(channel-1,value),"Scaler: setting presets")){
+    vLog(NORMAL, "Setting presets to {}... ok!", value);
     return(1);
   }
   else{
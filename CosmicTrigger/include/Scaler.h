@@ -4,6 +4,15 @@
 
 #include "VmeBoard.h"
 
+/**
+ * \brief Register map of the scaler (LeCroy 1151 layout: 16 channels, 32 bit counters).
+ */
+namespace lecroy1151 {
+  typedef vmeRegister<0x00, D16> Reset;
+  typedef vmeRegisterArray<0x40, 4, 16, D16> Preset;
+  typedef vmeRegisterArray<0x80, 4, 16, D32> Counter;
+  typedef vmeRegister<0xFE, D16> ModuleInfo;
+}
 
 /**
  * \brief Counting unit.
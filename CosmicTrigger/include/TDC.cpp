@@ -1,15 +1,10 @@
 #include "TDC.h"
 #include<vector>
+#include<algorithm>
 #include "time.h"
 
 tdc::tdc(vmeController* controller,int address):vmeBoard(controller,A32_U_DATA,D16){
     this->add=address;
-    Opcode=add+0x102E;
-    StatusRegister=add+0x1002;
-    MicroHandshake=add+0x1030;
-    OutputBuffer=add+0x0000;
-    EventFIFO=add+0x1038;
-    ControlRegister=add+0x1000;
 }
 
 //@@@@@@@@@@@@@@@@@@@ FUNCTIONS GENERAL @@@@@@@@@@@@@@@@@@@ 
@@ -21,106 +16,111 @@ void tdc::reset(){
         ADD+=2;
         TestError(writeData(ADD, &DATA),"Reset...");
     }
-    if(vLevel(NORMAL))
-        std::cout<< " Module Reset, Software clear and Software event reset." << std::endl;
+    vLog(NORMAL, " Module Reset, Software clear and Software event reset.");
+}
+
+bool tdc::clear(){
+    TestError(writeRegister<v1190::SoftwareClear>(0),"TDC: software clear");
+
+    // The output buffer spans 0x0000-0x0FFC: one block transfer reads it all
+    const int blockSize = 0x1000;
+    const int maxBlocks = 64;
+    unsigned int buffer[blockSize/4];
+    int nBlocks = 0;
+    unsigned int status = getStatusWord();
+    while (dataReady(status) && nBlocks < maxBlocks){
+        int count = 0;
+        int error = readBlock(add+v1190::OutputBuffer::offset, buffer, blockSize, A32_U_BLT, D32, &count);
+        // A bus error only means that the buffer was emptied before the end of the block
+        if (error != BusError)
+            TestError(error,"TDC: flush buffer");
+        if (count == 0)
+            break;
+        nBlocks++;
+        status = getStatusWord();
+    }
+
+    vLog(NORMAL, "TDC buffer cleared ({} blocks flushed).", nBlocks);
+    return(!dataReady(status));
 }
 
 void tdc::writeOpcode(unsigned int &DATA)
 {
   waitWrite();
-  TestError(writeData(Opcode,&DATA),"TDC: writing OPCODE");
+  TestError(writeRegister<v1190::Opcode>(DATA),"TDC: writing OPCODE");
 }
 
 void tdc::readOpcode(unsigned int &DATA)
 {
   waitRead();
-  TestError(readData(Opcode,&DATA),"TDC: reading OPCODE");
+  TestError(readRegister<v1190::Opcode>(DATA),"TDC: reading OPCODE");
 }
 
 unsigned int tdc::getStatusWord(){
     unsigned int DATA;
-    TestError(readData(StatusRegister,&DATA),"TDC: read Status");
+    TestError(readRegister<v1190::StatusRegister>(DATA),"TDC: read Status");
     return(DATA);
 }
 
-// Functions to check specific bits in status word.
-// Status word = 4 -> Full and no data ready -> get new status word
-
-bool tdc::dataReady(unsigned int status){
-    return(status%2);
-}
-
-bool tdc::isAlmostFull(unsigned int status){
-    return((status>>1)%2);
-}
-
-bool tdc::isFull(unsigned int status){
-    return((status>>2)%2);
-}
-
-bool tdc::lostTrig(unsigned int status){
-    return((status>>15)%2);
-}
-
-
-int tdc::inError(unsigned int status){
-    return((status>>6)%16);
-}
-
 //@@@@@@@@@@@@@@@@@@@ FUNCTIONS DAQ @@@@@@@@@@@@@@@@@@@ 
 
 int tdc::getNumberOfEvents(){
     unsigned int DATA = 0;
-    TestError(readData(this->add+0x103C,&DATA,A32_U_DATA,D16),"TDC: get N events");
-    return(DATA);
+    TestError(readRegister<v1190::EventFIFOStored>(DATA),"TDC: get N events");
+    return(v1190::fifo::EventCount::get(DATA));
 }
 
 int tdc::getNumberOfWords(){
     unsigned int DATA = 0;
-    TestError(readData(this->add+0x1038,&DATA,A32_U_DATA,D32),"TDC: get N words");
-    return(DATA%65536);
+    TestError(readRegister<v1190::EventFIFO>(DATA),"TDC: get N words");
+    return(v1190::fifo::WordCount::get(DATA));
 }
 
 event tdc::getEvent(){
     event e;
+    getEvent(e);
+    return(e);
+}
+
+void tdc::getEvent(event &e){
+    e.clear();
     int nWords = getNumberOfWords();
-    if (nWords == 0) return (e);
+    if (nWords == 0) return;
     
     unsigned int DATA=0;
     bool inPayload = false;
     int lastWord = 0;
     for (int i=0; i<nWords; i++){
         lastWord = i;
-        TestError(readData(this->add,&DATA,A32_U_DATA,D32),"TDC: read buffer");
-        if (vLevel(DEBUG))
-            std::cout<<"WORD "<<i<<(i<10?"  ":" ")<<": "<<show_hex(DATA,8)<<std::endl;
-        short int wordType = DATA>>27;
+        TestError(readRegister<v1190::OutputBuffer>(DATA),"TDC: read buffer");
+        vLog(DEBUG, "WORD {}: {x}", i, DATA);
+        unsigned int wordType = v1190::word::WordType::get(DATA);
         if (!inPayload){ //We are not in the payload yet (expecting header)
-            if (wordType == 8){// Global header
+            if (wordType == v1190::word::GlobalHeader){
                 inPayload = true;
-                e.eventNumber = (DATA>>5)%4194304;
+                e.eventNumber = v1190::word::EventCount::get(DATA);
             }
             else{
                 e.errorCode = -2; // Sync loss error
             }
         }
         else{ // We are in the payload
-            if (wordType < 8 ){ // TDC Data
-                if (wordType==4) { //TDC error
-                    e.tdcErrors.push_back(DATA%65536);
+            if (wordType < v1190::word::GlobalHeader ){ // TDC Data
+                if (wordType == v1190::word::TDCError) {
+                    e.tdcErrors.push_back(v1190::word::ErrorFlags::get(DATA));
                 } 
-                else if (wordType==0){ //TDC meas
+                else if (wordType == v1190::word::Measurement){
                     hit h;
-                    h.channel = (DATA >> 19)%128;
-                    h.leading = !((DATA >> 26)%2);
-                    h.time    = (DATA)%524288;
+                    h.channel = v1190::word::Channel::get(DATA);
+                    h.leading = !v1190::word::Trailing::test(DATA);
+                    h.time    = v1190::word::Time::get(DATA);
                     e.hits.push_back(h);
                 }
             }
-            else if (wordType == 17){continue;} // Ext. time trigger tag
-            else if (wordType == 16){// Trailer
+            else if (wordType == v1190::word::TriggerTimeTag){continue;}
+            else if (wordType == v1190::word::GlobalTrailer){
                 inPayload = false;
-                e.errorCode = (DATA>>24)%8;
+                e.errorCode = v1190::word::TrailerStatus::get(DATA);
                 break;
             }
         }
@@ -128,7 +128,6 @@ event tdc::getEvent(){
     if (lastWord!=nWords-1) e.errorCode = -3;
     if (inPayload)  e.errorCode = -4;
     time(&e.time);
-    return(e);
 }
 
 
@@ -136,7 +135,7 @@ std::vector <event> tdc::readFIFO()
 {   
     int nEvents = getNumberOfEvents();
     std::vector <event> ev;
-    std::cout<<"Getting "<<nEvents<<" evts"<<std::endl;
+    vLog(NORMAL, "Getting {} evts", nEvents);
     for (int i=0; i<nEvents; i++){
         ev.push_back(getEvent());
     }
@@ -150,20 +149,22 @@ void tdc::setAcqMode(bool Trig){
     if(Trig) DATA = 0x0000;
     else DATA =0x0100;
     writeOpcode(DATA);
-    if(vLevel(DEBUG))std::cout << "Trigger Mode : " << Trig<< std::endl;
+    vLog(DEBUG, "Trigger Mode : {}", Trig);
 }
 
 bool tdc::getAcqMode(){
     unsigned int DATA=0x0200;
     writeOpcode(DATA);
     readOpcode(DATA);
-    if(vLevel(DEBUG))std::cout << "Trigger Mode : " << DATA%2<< std::endl;
+    vLog(DEBUG, "Trigger Mode : {}", DATA%2);
     return(DATA%2);
 }
 
 void tdc::setAlmostFull(int nMax){
-    unsigned int DATA = nMax;
-    TestError(writeData(this->add+=0x1022,&DATA,A32_U_DATA,D16),"TDC: write almost full");
+    // Valid levels: 1 to 32735 words
+    unsigned int DATA = std::min(std::max(nMax, 1), 32735);
+    TestError(writeRegister<v1190::AlmostFullLevel>(DATA),"TDC: write almost full");
+    vLog(DEBUG, "Almost full level : {} words", DATA);
 }
 
 void tdc::loadDefaultConfig(){
@@ -188,25 +189,25 @@ void tdc::setAutoLoadUserConfig(){
 }
 
 void tdc::setWindowWidth(unsigned int WidthSetting)
-  {   if (WidthSetting > 4095 ){if(vLevel(WARNING))std::cout << "Width Setting must be a integer in the range from 1 to 4095" << std::endl;}
+  {   if (WidthSetting > 4095 ){vLog(WARNING, "Width Setting must be a integer in the range from 1 to 4095");}
       else
       {unsigned int DATA=0x1000;
       writeOpcode(DATA);
       DATA = WidthSetting;
       writeOpcode(DATA);
-      std::cout << "Window Width set to"<< WidthSetting<< std::endl;
+      vLog(NORMAL, "Window Width set to {}", WidthSetting);
       }
   }
 
 
 void tdc::setWindowOffset(int OffsetSetting)
-  {   if (OffsetSetting > 40 || OffsetSetting < -2048){if(vLevel(WARNING))std::cout << "Offset Setting must be a integer in the range from -2048 to +40" << std::endl;}
+  {   if (OffsetSetting > 40 || OffsetSetting < -2048){vLog(WARNING, "Offset Setting must be a integer in the range from -2048 to +40");}
       else
       {unsigned int DATA = 0x1100;
       writeOpcode(DATA);
       DATA = OffsetSetting;
       writeOpcode(DATA);
-      if (vLevel(NORMAL))std::cout << "Window Width set to"<< OffsetSetting<< std::endl;
+      vLog(NORMAL, "Window Offset set to {}", OffsetSetting);
       }
   }
 
@@ -214,7 +215,7 @@ void tdc::setWindowOffset(int OffsetSetting)
 void tdc::setExSearchMargin(int ExSearchMrgnSetting )
   {
       if (ExSearchMrgnSetting > 50){
-          if(vLevel(WARNING)) std::cout << " 50*25ns is the maximal value. Extra Search Margin Setting must be a integer in the range from 0 to 50" << std::endl;
+          vLog(WARNING, " 50*25ns is the maximal value. Extra Search Margin Setting must be a integer in the range from 0 to 50");
           ExSearchMrgnSetting = 50;
       }
       else{
@@ -222,38 +223,29 @@ void tdc::setExSearchMargin(int ExSearchMrgnSetting )
         writeOpcode(DATA);
         DATA = ExSearchMrgnSetting;
         writeOpcode(DATA);
-        if(vLevel(NORMAL))std::cout << "Extra Search Margin Width set to"<< ExSearchMrgnSetting<< std::endl;
+        vLog(NORMAL, "Extra Search Margin Width set to {}", ExSearchMrgnSetting);
       }
   }
 
 void tdc::setRejectMargin(int RejectMrgnSetting)
   {
-      if (RejectMrgnSetting > 4095) {if(vLevel(WARNING))std::cout << "Offset Setting must be a integer in the range from -2048 to +40" << std::endl;}
+      if (RejectMrgnSetting > 4095) {vLog(WARNING, "Reject Margin Setting must be a integer in the range from 0 to 4095");}
       else
       {
         unsigned int DATA = 0x1300;
         writeOpcode(DATA);
         DATA = RejectMrgnSetting;
         writeOpcode(DATA);
-        if(vLevel(NORMAL))std::cout << "Reject Margin set to"<< RejectMrgnSetting<< std::endl;
+        vLog(NORMAL, "Reject Margin set to {}", RejectMrgnSetting);
       }
   }
 
 
 void tdc::printTriggerConfiguration()
   {
-      unsigned int DATA=0x1600;
-      writeOpcode(DATA);
-      readOpcode(DATA);
-      if(vLevel(NORMAL))std::cout<<" Match window width : "<<digit(DATA,11,0);
-      readOpcode(DATA);
-      if(vLevel(NORMAL))std::cout<<" Window ofset : "<<digit(DATA,11,0)-4096;
-      readOpcode(DATA);
-      if(vLevel(NORMAL))std::cout<<" Extra search window width: "<<digit(DATA,11,0);
-      readOpcode(DATA);
-      if(vLevel(NORMAL))std::cout<<" Reject margin width: "<<digit(DATA,11,0);
-      readOpcode(DATA);
-      if(vLevel(NORMAL))std::cout<<" Trigger time substraction : "<<digit(DATA,0);
+      std::vector<unsigned int> config = getTriggerConfiguration();
+      vLog(NORMAL, " Match window width : {} Window ofset : {} Extra search window width: {} Reject margin width: {} Trigger time substraction : {}",
+           digit(config[0],11,0), (int) digit(config[1],11,0)-4096, digit(config[2],11,0), digit(config[3],11,0), digit(config[4],0));
   }
 std::vector<unsigned int> tdc::getTriggerConfiguration(){
     unsigned int DATA = 0x1600;
@@ -268,7 +260,7 @@ std::vector<unsigned int> tdc::getTriggerConfiguration(){
       
 void tdc::setEdgeDetection(int mode){
    if(mode>3 || mode<0){
-     if(vLevel(WARNING)){std::cout<<"Bad mode (0=pair, 1=trailing, 2=leading and 3=t&l)"<<std::endl<<"Mode set to pair"<<std::endl;}
+     vLog(WARNING, "Bad mode (0=pair, 1=trailing, 2=leading and 3=t&l). Mode set to pair");
      mode=0; 
     }
     unsigned int DATA = 0x2200;
@@ -281,13 +273,13 @@ int tdc::getEdgeDetection(){
     unsigned int DATA = 0x2300;
     writeOpcode(DATA);
     readOpcode(DATA); 
-    if(vLevel(DEBUG)){std::cout<<" Dead time : "<<DATA%4<< "((0=pair, 1=trailing, 2=leading and 3=t&l)"<<std::endl;} 
+    vLog(DEBUG, " Edge detection : {} (0=pair, 1=trailing, 2=leading and 3=t&l)", DATA%4);
     return (DATA%4);
 }   
 
 void tdc::setEdgeResolution(int res){
     if (res>2 || res<0){
-        if (vLevel(WARNING)){std::cout<<"Bad resolution value (has to be 0,1 or 2)"<<std::endl;}
+        vLog(WARNING, "Bad resolution value (has to be 0,1 or 2)");
         return;
     }
     unsigned int DATA=0x2400;
@@ -300,13 +292,13 @@ int tdc::getEdgeResolution(){
       unsigned int DATA=0x2600;
       writeOpcode(DATA);
       readOpcode(DATA);
-      if(vLevel(DEBUG))std::cout<< "Resolution : "<<(DATA%4)<<std::endl;;
+      vLog(DEBUG, "Resolution : {}", DATA%4);
       return (DATA%4);
 }
 
 void tdc::setDeadTime(int deadTime){
    if(deadTime>3 || deadTime<0){
-     if(vLevel(WARNING)){std::cout<<"Bad dead time (0=5ns, 1=10ns, 2=30ns and 3=100ns"<<std::endl<<"Dead time set to 5ns"<<std::endl;}
+     vLog(WARNING, "Bad dead time (0=5ns, 1=10ns, 2=30ns and 3=100ns). Dead time set to 5ns");
      deadTime=0; 
     }
     unsigned int DATA = 0x2800;
@@ -321,7 +313,7 @@ void tdc::setMaxEventsPerHit(int N){
     writeOpcode(DATA);
     DATA=N;
     if (N>9 or N<0){
-        if(vLevel(WARNING)) std::cout << "Parameter not valid. Removing maximum hit limit."<<std::endl;
+        vLog(WARNING, "Parameter not valid. Removing maximum hit limit.");
         DATA=9;
     }
     writeOpcode(DATA);
@@ -331,29 +323,25 @@ int tdc::getMaxEventsPerHit(){
     unsigned int DATA=0x3400;
     writeOpcode(DATA);
     readOpcode(DATA);
-    if (vLevel(DEBUG))
-        std::cout<<"Max event per hit param = "<<DATA%16<<std::endl;
+    vLog(DEBUG, "Max event per hit param = {}", DATA%16);
     return(DATA%16);
 }
 
 void tdc::enableFIFO()
   {
-    unsigned int DATA;  
-    TestError(readData(ControlRegister, &DATA),"TDC: Enabling the FIFO");
-    if (digit(DATA,8)==0) {
-      DATA+=0x0100;}
-    TestError(writeData(ControlRegister, &DATA),"TDC: Enabling the FIFO");
-    if(vLevel(NORMAL))std::cout<<"FIFO enabled !"<<std::endl;
+    unsigned int DATA = 0;
+    TestError(readRegister<v1190::ControlRegister>(DATA),"TDC: Enabling the FIFO");
+    DATA = v1190::control::EventFIFOEnable::set(DATA, 1);
+    TestError(writeRegister<v1190::ControlRegister>(DATA),"TDC: Enabling the FIFO");
+    vLog(NORMAL, "FIFO enabled !");
 }
   
 int tdc::getDeadTime(){
     unsigned int DATA = 0x2900;
     writeOpcode(DATA);
     readOpcode(DATA); 
-    if(vLevel(DEBUG)){
-      int d=DATA%4;
-      std::cout<<" Dead time : "<<d<< "(="<<5*(d==0)+10*(d==1)+30*(d==2)+100*(d==3)<<"ns)"<<std::endl;
-    } 
+    int d=DATA%4;
+    vLog(DEBUG, " Dead time : {}(={}ns)", d, 5*(d==0)+10*(d==1)+30*(d==2)+100*(d==3));
     return(DATA%4);
 }  
 
@@ -365,16 +353,14 @@ void tdc::disableTDCHeaderAndTrailer()
       writeOpcode(DATA);
       readOpcode(DATA);
       if (DATA%2==0)
-      if(vLevel(NORMAL))
-          std::cout << "TDC Header and Trailer disabled"<< std::endl;
+          vLog(NORMAL, "TDC Header and Trailer disabled");
   }
   
 void tdc::setStatusAllChannels(bool status){
     unsigned int DATA=0x4200;
     if (status==0) DATA+=0x0100;
     writeOpcode(DATA);
-    if (vLevel(DEBUG))
-        std::cout<<"Set all channels to "<<(status?"ON":"OFF")<<std::endl;
+    vLog(DEBUG, "Set all channels to {}", status?"ON":"OFF");
 }
 
 void tdc::setStatusChannel(int channel, bool status){
@@ -382,8 +368,7 @@ void tdc::setStatusChannel(int channel, bool status){
     if (status==0)DATA+=0x0100;
     DATA+=channel;
     writeOpcode(DATA);
-    if(vLevel(DEBUG))
-        std::cout<<"Set channel "<<channel<<" to "<<(status?"ON":"OFF")<<std::endl;
+    vLog(DEBUG, "Set channel {} to {}", channel, status?"ON":"OFF");
 }
 
 int tdc::waitRead(void)
@@ -392,13 +377,13 @@ int tdc::waitRead(void)
     int i=0;
     bool success = 0;
     while(i<10000){
-            TestError(readData(this->MicroHandshake,&DATA,A32_U_DATA,D16),"TDC: wait_read");
-            if(DATA%4==3 || DATA%4==2) {success = true; break;}
+            TestError(readRegister<v1190::MicroHandshake>(DATA),"TDC: wait_read");
+            if(v1190::handshake::ReadOk::test(DATA)) {success = true; break;}
             else i++;
             usleep(100); //TODO Optimise sleeping time
     }
-    if (!success && vLevel(ERROR))
-        std::cerr<<"ERROR, device busy after 10000 tries"<<std::endl;
+    if (!success)
+        vLog(ERROR, "ERROR, device busy after 10000 tries");
     return success;
 }
 
@@ -408,13 +393,13 @@ int tdc::waitWrite(void)
     int i=0;
     bool success = 0;
     while(i<10000){
-            TestError(readData(this->MicroHandshake,&DATA,A32_U_DATA,D16),"TDC: wait_write");
-            if(DATA%2==1){success = true; break;}
+            TestError(readRegister<v1190::MicroHandshake>(DATA),"TDC: wait_write");
+            if(v1190::handshake::WriteOk::test(DATA)){success = true; break;}
             else i++;
             usleep(100); //TODO Optimise sleeping time
     }
     
-    if (!success && vLevel(ERROR))
-        std::cerr<<"Error, device busy after 10000 tries"<<std::endl;
+    if (!success)
+        vLog(ERROR, "Error, device busy after 10000 tries");
     return success;
 }
@@ -7,6 +7,61 @@
 #include <sstream>
 #include <stdint.h>
 
+/**
+ * \brief Register map of the V1190 TDC (see the data sheet), and fields of its output buffer words.
+ */
+namespace v1190 {
+  typedef vmeRegister<0x0000, D32> OutputBuffer;
+  typedef vmeRegister<0x1000, D16> ControlRegister;
+  typedef vmeRegister<0x1002, D16> StatusRegister;
+  typedef vmeRegister<0x1016, D16> SoftwareClear;
+  typedef vmeRegister<0x1022, D16> AlmostFullLevel;
+  typedef vmeRegister<0x102E, D16> Opcode;
+  typedef vmeRegister<0x1030, D16> MicroHandshake;
+  typedef vmeRegister<0x1038, D32> EventFIFO;
+  typedef vmeRegister<0x103C, D16> EventFIFOStored;
+
+  namespace control {
+    typedef vmeField<ControlRegister, 8, 1> EventFIFOEnable;
+  }
+
+  namespace status {
+    typedef vmeField<StatusRegister, 0, 1> DataReady;
+    typedef vmeField<StatusRegister, 1, 1> AlmostFull;
+    typedef vmeField<StatusRegister, 2, 1> Full;
+    typedef vmeField<StatusRegister, 6, 4> Error; ///< One bit per TDC chip
+    typedef vmeField<StatusRegister, 15, 1> TriggerLost;
+  }
+
+  namespace handshake {
+    typedef vmeField<MicroHandshake, 0, 1> WriteOk;
+    typedef vmeField<MicroHandshake, 1, 1> ReadOk;
+  }
+
+  namespace fifo {
+    typedef vmeField<EventFIFO, 0, 16> WordCount;
+    typedef vmeField<EventFIFOStored, 0, 11> EventCount;
+  }
+
+  /// Words of the output buffer, identified by their type
+  namespace word {
+    enum Type {
+      Measurement = 0x00,
+      TDCError = 0x04,
+      GlobalHeader = 0x08,
+      GlobalTrailer = 0x10,
+      TriggerTimeTag = 0x11
+    };
+    typedef vmeField<OutputBuffer, 27, 5> WordType;
+    typedef vmeField<OutputBuffer, 5, 22> EventCount;   ///< Global header
+    typedef vmeField<OutputBuffer, 0, 19> Time;         ///< Measurement
+    typedef vmeField<OutputBuffer, 19, 7> Channel;      ///< Measurement
+    typedef vmeField<OutputBuffer, 26, 1> Trailing;     ///< Measurement
+    typedef vmeField<OutputBuffer, 0, 16> ErrorFlags;   ///< TDC error
+    typedef vmeField<OutputBuffer, 24, 3> TrailerStatus;///< Global trailer
+  }
+}
+
 /**
  * \brief
  *  This class has a few functions encoding the basic functionalities of the TDC.
@@ -37,6 +92,17 @@ public:
    * \brief resets the board.
    */
 
+  bool clear();
+  /**<
+   * \brief Empties the output buffer and the event FIFO.
+   * 
+   * Issues a software clear, then flushes what is left in the output buffer with block transfers
+   * (e.g. data of triggers arriving meanwhile), until the status word shows no data ready.
+   * Much faster than reading the events one by one with 'getEvent()'.
+   * 
+   * Returns true if the buffer is empty.
+   */
+
   void writeOpcode(unsigned int &data);
   /**<
    * \brief writes a command line of 16 bit in the Micro Controller register.
@@ -54,26 +120,26 @@ public:
   /**<
    * \brief Returns the status word of the TDC card.
    */
-  static bool dataReady(unsigned int status);
+  static bool dataReady(unsigned int status) { return v1190::status::DataReady::test(status); }
   /**<
    * \brief Returns if data ready in FIFO.
    * \param status is the status word of the TDC.
    */
-  static bool isAlmostFull(unsigned int status);
+  static bool isAlmostFull(unsigned int status) { return v1190::status::AlmostFull::test(status); }
   /**<
    * \brief Returns if buffer is almost full.
    * \param status is the status word of the TDC.
    */
-  static bool isFull(unsigned int status);
+  static bool isFull(unsigned int status) { return v1190::status::Full::test(status); }
   /**<
    * \brief Returns if buffer is full.
    * \param status is the status word of the TDC.
    */
-  static bool lostTrig(unsigned int status);
+  static bool lostTrig(unsigned int status) { return v1190::status::TriggerLost::test(status); }
   /**< \brief Returns if a trigger was lost
    *  \param status is the status word of the TDC.
    */
-  static int  inError(unsigned int status);
+  static int  inError(unsigned int status) { return v1190::status::Error::get(status); }
   /**<
    * \brief Returns TDC status. One bit per TDC (4bits in total).
    * \param status is the status word of the TDC.
@@ -93,6 +159,12 @@ public:
   /**<
    * \brief Reads an event from the FIFO
    */
+  void getEvent(event &e);
+  /**<
+   * \brief Reads an event from the FIFO into e
+   * 
+   * e is cleared first. Its vectors keep their memory, so that reusing the same event does not allocate.
+   */
   std::vector <event> readFIFO();
   /**<
    * \brief Returns all events in the FIFO
@@ -259,22 +331,15 @@ public:
   void setAlmostFull(int nMax);
   /**<
    * \brief Set almost full level
+   *
+   * The status reports almost full when the output buffer holds at least nMax words (1 to 32735,
+   * clamped). An event takes one word per hit, plus its headers and trailers.
    */
 
 
 
 private:
 
-  int add;//Default:0x00120000;
-
-  //REGISTER ADRESSES (must depend on add)
-  int Opcode;
-  int StatusRegister;
-  int MicroHandshake;
-  int OutputBuffer;
-  int EventFIFO;
-  int ControlRegister;
-
   //PRIVATE FUNCTIONS
   int waitWrite(void);
   int waitRead(void);
@@ -4,75 +4,77 @@ ttcVi::ttcVi(vmeController* controller,int address):vmeBoard(controller,A32_U_DA
   this->add=address;
   this->channel=1;
   this->channelFrequency=0;
-  if(vLevel(NORMAL))std::cout<<"New TTCvi... ok!"<<std::endl;
+  vLog(NORMAL, "New TTCvi... ok!");
 }
 
 void ttcVi::sendTrig(){
-    int DATA(0);
-    if(TestError(writeData(this->add+0x86,&DATA),"TTCvi: sending trigger") && vLevel(DEBUG)) std::cout<<"Sent VME trigger"<<std::endl;
+    if(TestError(writeRegister<ttcvi::SoftwareL1A>(0),"TTCvi: sending trigger")) vLog(DEBUG, "Sent VME trigger");
 }
 
 void ttcVi::resetCounter(){
-    int DATA(0);
-    if(TestError(writeData(this->add+0x8C,&DATA),"TTCvi: reset counter") && vLevel(DEBUG)) std::cout<<"ResetCounter"<<std::endl;
+    if(TestError(writeRegister<ttcvi::ResetEventCounter>(0),"TTCvi: reset counter")) vLog(DEBUG, "ResetCounter");
 }
 long int ttcVi::getEventNumber(){
-    int DATA0(0),DATA1(0);
-    if(TestError(readData(this->add+0x88,&DATA0),"TTCvi: sending trigger") 
-        && TestError(readData(this->add+0x8A,&DATA1),"TTCvi: sending trigger") 
-        && vLevel(DEBUG))        std::cout<<"Read event Number"<<std::endl;
+    unsigned int DATA0(0),DATA1(0);
+    if(TestError(readRegister<ttcvi::EventCounterMSB>(DATA0),"TTCvi: sending trigger") 
+        && TestError(readRegister<ttcvi::EventCounterLSB>(DATA1),"TTCvi: sending trigger"))
+      vLog(DEBUG, "Read event Number");
 
-    return(0x10000*(DATA0%256)+DATA1);
+    return((ttcvi::EventCountHigh::get(DATA0)<<16) | DATA1);
 }
 
 void ttcVi::changeChannel(int channel){
   this->channel=channel;
   int DATA=-1;
+  const char *mode="";
   switch (channel){
     case 0:
-      if (vLevel(NORMAL))std::cout<<"Set mode to L1A(0)...";
+      mode="L1A(0)";
       DATA=0x0000;
       break;
     case 1:
-      if (vLevel(NORMAL))std::cout<<"Set mode to L1A(1)...";
+      mode="L1A(1)";
       DATA=0x0001;
       break;
     case 2:
-      if (vLevel(NORMAL))std::cout<<"Set mode to L1A(2)...";
+      mode="L1A(2)";
       DATA=0x0002;
       break;
     case 3:
-      if (vLevel(NORMAL))std::cout<<"Set mode to L1A(3)...";
+      mode="L1A(3)";
       DATA=0x0003;
       break;
     case -1:
-      if (vLevel(NORMAL))std::cout<<"Set mode to random with frequence: "<<this->channelFrequency<<"...";
+      mode="random";
       DATA=0x0005;
       break;
     case 4:
-      if (vLevel(NORMAL))std::cout<<"Set mode to VME function...";
+      mode="VME function";
       DATA=0x0004;
       break;
     case 5:
-      if (vLevel(NORMAL))std::cout<<"Set mode to random with frequence: "<<this->channelFrequency<<"...";
+      mode="random";
       DATA=0x0005;
       break;
     case 6:
-      if (vLevel(NORMAL))std::cout<<"Set mode to calibration...";
+      mode="calibration";
       DATA=0x0006;
       break;
     case 7:
-      if (vLevel(NORMAL))std::cout<<"Set mode Disabled...";
+      mode="Disabled";
       DATA=0x0007;
       break;
 
     default:
-      if (vLevel(WARNING))std::cout<<"*   WARNING: wrong code to change channel. Expected -1(random),0,1,2,3. Statement ignored"<<std::endl;
+      vLog(WARNING, "*   WARNING: wrong code to change channel. Expected -1(random),0,1,2,3. Statement ignored");
     }
   if (DATA>-1){
-    DATA+=this->channelFrequency*16*16*16;
-    if(TestError(writeData(this->add+0x80,&DATA),"TTCvi: Writing new mode")&&vLevel(NORMAL))std::cout<<" ok!"<<std::endl;
-    if(vLevel(DEBUG))std::cout<<"Sent: "<<show_hex(DATA,4)<<" to TTCvi (add:"<<show_hex(this->add,6)<<")"<<std::endl;
+    DATA=ttcvi::csr1::RandomRate::set(DATA,this->channelFrequency);
+    if(TestError(writeRegister<ttcvi::CSR1>(DATA),"TTCvi: Writing new mode")){
+      if(channel==-1 || channel==5) vLog(NORMAL, "Set mode to random with frequence: {}... ok!", this->channelFrequency);
+      else vLog(NORMAL, "Set mode to {}... ok!", mode);
+    }
+    vLog(DEBUG, "Sent: {x} to TTCvi (add:{x})", DATA, this->add);
   }
 }
 
@@ -80,42 +82,42 @@ void ttcVi::changeChannel(int channel){
 void ttcVi::changeRandomFrequency(int frequencyId){
   this->channelFrequency=frequencyId;
   if (channel==-1){
-    if(verbose>2)std::cout<<"Sending new frequency to TTCvi"<<std::endl;
+    vLog(NORMAL, "Sending new frequency to TTCvi");
     this->changeChannel(-1);
   }
 }
 
 
 int ttcVi::viewMode(void){  
-  int DATA=0;
-  if(TestError(readData(this->add+0x80,&DATA),"TTCvi: viewMode")){
-  switch(DATA%16){
+  unsigned int DATA=0;
+  if(TestError(readRegister<ttcvi::CSR1>(DATA),"TTCvi: viewMode")){
+  switch(ttcvi::csr1::TriggerSelect::get(DATA)){
     case 0:
-      if (vLevel(NORMAL))std::cout<<"L1A(0)"<<std::endl;
+      vLog(NORMAL, "L1A(0)");
       break;
     case 1:
-      if (vLevel(NORMAL))std::cout<<"L1A(1)"<<std::endl;
+      vLog(NORMAL, "L1A(1)");
       break;
     case 2:
-      if (vLevel(NORMAL))std::cout<<"L1A(2)"<<std::endl;
+      vLog(NORMAL, "L1A(2)");
       break;
     case 3:
-      if (vLevel(NORMAL))std::cout<<"L1A(3)"<<std::endl;
+      vLog(NORMAL, "L1A(3)");
       break;
     case 5:
-      if (vLevel(NORMAL))std::cout<<"Random, frequency="<<DATA/(16*16*16)<<std::endl;
+      vLog(NORMAL, "Random, frequency={}", ttcvi::csr1::RandomRate::get(DATA));
       break;
     case 6:
-      if(vLevel(NORMAL))std::cout<<"Calibration"<<std::endl;
+      vLog(NORMAL, "Calibration");
       break;
     case 7:
-      if(vLevel(NORMAL))std::cout<<"disabled"<<std::endl;
+      vLog(NORMAL, "disabled");
       break;
     default:
-      if(vLevel(WARNING))std::cerr<<"*   WARNING: unknown TTCvi mode."<<std::endl;
+      vLog(WARNING, "*   WARNING: unknown TTCvi mode.");
     
   }
-    return(16*16*16*(DATA/(16*16*16))+DATA%16);
+    return(DATA & (ttcvi::csr1::RandomRate::mask | ttcvi::csr1::TriggerSelect::mask));
   }
   else return(-1);
 }
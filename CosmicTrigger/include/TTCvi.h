@@ -4,6 +4,23 @@
 
 #include "VmeBoard.h"
 
+/**
+ * \brief Register map of the TTCvi (see the TTCvi specification).
+ */
+namespace ttcvi {
+  typedef vmeRegister<0x80, D16> CSR1;
+  typedef vmeRegister<0x86, D16> SoftwareL1A;
+  typedef vmeRegister<0x88, D16> EventCounterMSB;
+  typedef vmeRegister<0x8A, D16> EventCounterLSB;
+  typedef vmeRegister<0x8C, D16> ResetEventCounter;
+
+  namespace csr1 {
+    typedef vmeField<CSR1, 0, 4> TriggerSelect;  ///< L1A source (bits 0-2, see changeChannel()) and orbit select (bit 3)
+    typedef vmeField<CSR1, 12, 3> RandomRate;    ///< Frequency of the random trigger (see changeRandomFrequency())
+  }
+
+  typedef vmeField<EventCounterMSB, 0, 8> EventCountHigh;///< Bits 16-23 of the event count
+}
 //TODO: functions to change variables
 
 
@@ -96,7 +113,6 @@ public:
    */
   
 private:
-  int verbose;
   int channel;
   int channelFrequency;
 };
@@ -6,7 +6,7 @@ vmeBoard::vmeBoard(vmeController* cont, AddressModifier AM, DataWidth DW):
     DW(DW) {}
 
 bool vmeBoard::vLevel(coutLevel level) {
-    return cont->getVerbose() >= (int)level;
+    return logger::get().enabled(level);
 }
 
 int vmeBoard::writeData(long unsigned int add, void *DATA) {
@@ -25,6 +25,10 @@ int vmeBoard::readData(long unsigned int add, void *DATA, AddressModifier tAM, D
   return cont->readData(add, DATA, tAM, tDW);
 }
 
+int vmeBoard::readBlock(long unsigned int add, void *buffer, int size, AddressModifier tAM, DataWidth tDW, int *count) {
+  return cont->readBlock(add, buffer, size, tAM, tDW, count);
+}
+
 void vmeBoard::setAM(AddressModifier AM) {
   this->AM=AM;
 }
@@ -2,6 +2,7 @@
 #define __VMEBOARD
 
 #include "VmeController.h"
+#include "Registers.h"
 
   /**
    * \brief Mother class for any board type class.
@@ -73,6 +74,53 @@ class vmeBoard{
          *
          */
     
+        int readBlock(long unsigned int add, void *buffer, int size, AddressModifier tAM, DataWidth tDW, int *count);
+          /**<\brief Block transfer
+         *
+         * Reads at most size bytes starting at add with a single block transfer (tAM must be a BLT address modifier). The number of bytes actually read is stored in count.
+         *
+         */
+
+        template<class Reg> int readRegister(unsigned int &DATA) {
+          DATA = 0;
+          return readData(add + Reg::offset, &DATA, AM, Reg::width);
+        }
+        /**<\brief Reads a register described by a vmeRegister
+         *
+         * The register is read with its own data width and the stored AddressModifier. DATA is cleared first, so that the upper bits are 0 for a D16 register.
+         *
+         */
+
+        template<class Reg> int writeRegister(unsigned int DATA) {
+          return writeData(add + Reg::offset, &DATA, AM, Reg::width);
+        }
+        /**<\brief Writes a register described by a vmeRegister
+         *
+         * The register is written with its own data width and the stored AddressModifier.
+         *
+         */
+
+        template<class Reg> int readRegister(unsigned int index, unsigned int &DATA) {
+          DATA = 0;
+          if (index >= Reg::count) return InvalidParam;
+          return readData(add + Reg::offset(index), &DATA, AM, Reg::width);
+        }
+        /**<\brief Reads the register number index (from 0) of a vmeRegisterArray
+         *
+         * Returns InvalidParam if there is no such register.
+         *
+         */
+
+        template<class Reg> int writeRegister(unsigned int index, unsigned int DATA) {
+          if (index >= Reg::count) return InvalidParam;
+          return writeData(add + Reg::offset(index), &DATA, AM, Reg::width);
+        }
+        /**<\brief Writes the register number index (from 0) of a vmeRegisterArray
+         *
+         * Returns InvalidParam if there is no such register.
+         *
+         */
+
         void setAM(AddressModifier AM);
         /**< \brief Saves default value
          *
@@ -90,7 +138,7 @@ class vmeBoard{
         bool vLevel(coutLevel level);
         /**< \brief Checks the verbosity level.
          * 
-         * This function will access the verbosity level of the vmeController and return 1 if the given level is above the controller's level.
+         * This function will access the verbosity level of the logger (set by the vmeController) and return 1 if the given level is enabled.
          * 
          * It allows the controller to choose what messages should be displayed.
          * 
@@ -2,6 +2,7 @@
 #define __VMECONTROLLER
 
 #include "CommonDef.h"
+#include "Logger.h"
 
 #include <iostream>
 #include <cmath>
@@ -23,15 +24,16 @@ class vmeController  {
     public:
         
         vmeController(int verbose):
-            verbose(verbose) {}
+            verbose(verbose) { logger::get().setLevel(verbose); }
 
         virtual void setMode(AddressModifier AM, DataWidth DW) = 0; ///<Sets default modes.
         virtual int writeData(long unsigned int address,void* data) = 0; ///<Short write data function using default modes.
         virtual int readData(long unsigned int address,void* data) = 0; ///<Short read data function using default modes.
         virtual int writeData(long unsigned int address,void* data,AddressModifier AM, DataWidth DW) = 0; ///<Write data function using given mode.
         virtual int readData(long unsigned int address,void* data,AddressModifier AM, DataWidth DW) = 0; ///<Read data function using given mode.
+        virtual int readBlock(long unsigned int address,void* buffer,int size,AddressModifier AM, DataWidth DW,int* count) = 0; ///<Block transfer (BLT) read of at most size bytes, the number of bytes read is stored in count.
         
-        void setVerbose(int verbose){ this->verbose = verbose; } ///< Sets verbosity level
+        void setVerbose(int verbose){ this->verbose = verbose; logger::get().setLevel(verbose); } ///< Sets verbosity level (of the logger, see logger::setLevel())
         int getVerbose() { return verbose; }
         
         virtual AddressModifier getAM(void) = 0; ///<Gets default mode
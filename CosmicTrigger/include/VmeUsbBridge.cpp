@@ -13,9 +13,9 @@ UsbController::UsbController(int verbose):
     DW = D16;
     
     if (m_status == 0)
-        std::cout << "VME USB Init... ok!" << std::endl;
+        vLog(NORMAL, "VME USB Init... ok!");
     else
-      std::cout << "***FATAL ERROR: " << m_status << " when starting usb board" << std::endl;
+        vLog(ERROR, "***FATAL ERROR: {} when starting usb board", m_status);
 }
 
 void UsbController::setMode(AddressModifier AM, DataWidth DW) {
@@ -39,6 +39,10 @@ int UsbController::readData(long unsigned int address, void* data, AddressModifi
     return CAENVME_ReadCycle(*BHandle,address, data, (CVAddressModifier)(int)AM, (CVDataWidth)(int)DW);
 }
 
+int UsbController::readBlock(long unsigned int address, void* buffer, int size, AddressModifier AM, DataWidth DW, int* count) {
+    return CAENVME_BLTReadCycle(*BHandle, address, buffer, size, (CVAddressModifier)(int)AM, (CVDataWidth)(int)DW, count);
+}
+
 AddressModifier UsbController::getAM(void) {
     return AM;
 }
@@ -49,5 +53,5 @@ DataWidth UsbController::getDW(void) {
 
 UsbController::~UsbController() {
     CAENVME_End(*BHandle);
-    std::cout << "Exiting controller" << std::endl; 
+    vLog(NORMAL, "Exiting controller");
 }
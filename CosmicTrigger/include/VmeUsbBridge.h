@@ -35,6 +35,7 @@ class UsbController: public vmeController {
         int readData(long unsigned int address, void* data);
         int writeData(long unsigned int address, void* data, AddressModifier AM, DataWidth DW);
         int readData(long unsigned int address, void* data, AddressModifier AM, DataWidth DW);
+        int readBlock(long unsigned int address, void* buffer, int size, AddressModifier AM, DataWidth DW, int* count);
         int getStatus() { return m_status; }
 
         AddressModifier getAM(void);
@@ -52,7 +52,7 @@ bool checkHits (float * t, int * hits, scaler * s, int V, hv * h,int mask = 0b11
   gettimeofday(&tStart,NULL);  
   int * initCounts = new int [nChannel];
   for(int i=0; i<nChannel; i++){
-    initCounts[i]=s->getCount(i);
+    initCounts[i]=s->getCount(i+1);
     if (initCounts[i]<0){cout<<"Unable to read init counts"<<endl;return(0);}
   }
   gettimeofday(&tStop,NULL);  
@@ -64,7 +64,7 @@ bool checkHits (float * t, int * hits, scaler * s, int V, hv * h,int mask = 0b11
     gettimeofday(&tStop,NULL);
   }
   for(int i=0; i<nChannel; i++){
-    int x = s->getCount(i)-initCounts[i]; 
+    int x = s->getCount(i+1)-initCounts[i]; 
     if(x<0){cout<<"Unable to read final counts"<<endl;return(0);}
     hits[i]+=x;
   }
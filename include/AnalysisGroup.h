@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QLabel>
+#include <QGroupBox>
+#include <QTableWidget>
+
+#include <memory>
+#include <cstdint>
+
+class Interface;
+class OnlineAnalysis;
+
+class AnalysisGroup: public QGroupBox {
+    friend class Interface;
+
+    Q_OBJECT
+
+    public:
+        /*
+         * Constructor: one row per analysed channel
+         */
+        AnalysisGroup(Interface& m_interface, std::shared_ptr<OnlineAnalysis> analysis);
+
+        virtual ~AnalysisGroup() {}
+
+    private:
+        /*
+         * Show the results of the last interval, if they are new (once per second)
+         * LOCKS: analysis
+         */
+        void notifyUpdate();
+
+        /*
+         * Called when the run is stopped: clear the results
+         */
+        void atStopRun();
+
+        Interface& m_interface;
+        std::shared_ptr<OnlineAnalysis> m_analysis;
+        // Timestamp of the results currently displayed
+        std::uint64_t m_displayed_timestamp;
+
+        QLabel *m_reference_label;
+        QLabel *m_multiplicity_label;
+        QTableWidget *m_table;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <functional>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+#include "ThreadUtils.h"
+
+/*
+ * Owner of the VME bus: all the accesses to the boards (through the SetupManager) are run by
+ * its thread ("bus"), one at a time, whatever thread asks for them. The per-board locks of the
+ * ConditionManager only keep the sequences on one board consistent, they do not stop two
+ * boards from being accessed at the same time through the same controller.
+ *
+ * Requests are queued by priority class, from the highest: TDC readout, trigger (TTC, including
+ * backpressure), scaler, HV, and control (interface, control socket, logger). The highest
+ * class with a request is served first, in order within a class. So that a busy readout does
+ * not starve the others, a request which waited longer than the bound of its class is served
+ * before those of higher classes (the one which waited the longest first). A request is never
+ * interrupted: the readout waits at most for the request being run, and for one request of
+ * each overdue class. The readout should therefore ask for a whole burst of events at once,
+ * and requests must never wait for a slow device: the exchanges with the HV crate are split
+ * into several requests, the waits in between being on the thread of the caller.
+ *
+ * Requests must not take any lock, so that the bus never waits for a thread which waits for
+ * the bus. The queues are drained before the thread stops.
+ */
+class BusScheduler {
+
+    public:
+
+        using m_clock = std::chrono::steady_clock;
+
+        enum class Priority {
+            Readout,
+            Trigger,
+            Scaler,
+            HV,
+            Control
+        };
+        static const std::size_t NPriorities = 5;
+
+        // Names of the classes, in order of priority
+        static const std::vector<std::string> PriorityNames;
+        // Longest wait before a request is served ahead of the higher classes (0: no bound)
+        static const std::vector<std::chrono::milliseconds> MaxWait;
+
+        struct Stats {
+            Stats(): n_requests(0), total_wait(0), max_wait(0), total_run(0), max_run(0) {}
+
+            void add(m_clock::duration wait, m_clock::duration run);
+
+            std::uint64_t n_requests;
+            // Time spent in the queue, and running on the bus
+            m_clock::duration total_wait;
+            m_clock::duration max_wait;
+            m_clock::duration total_run;
+            m_clock::duration max_run;
+        };
+
+        BusScheduler(ThreadSettings settings);
+        /*
+         * Run the requests still queued, and stop the thread
+         */
+        ~BusScheduler();
+
+        BusScheduler(const BusScheduler&) = delete;
+        BusScheduler& operator=(const BusScheduler&) = delete;
+
+        /*
+         * Run `function` on the bus and return its result (exceptions are rethrown here).
+         * Blocks until it has run. Called from the bus thread itself, runs it directly.
+         */
+        template<typename F>
+        auto call(Priority priority, F function) -> decltype(function()) {
+            if (std::this_thread::get_id() == m_thread.get_id())
+                return function();
+
+            std::packaged_task<decltype(function())()> task(function);
+            auto result = task.get_future();
+            // The task outlives the request: we wait for it below
+            submit(priority, [&task]() { task(); });
+            return result.get();
+        }
+
+        /*
+         * Statistics of each class (in order of priority) since the last call, reset them
+         * LOCKS: this
+         */
+        std::vector<Stats> popIntervalStats();
+
+        /*
+         * Print the statistics of each class since construction, and the longest run of the
+         * requests of the other classes, which bounds the wait of the readout behind them
+         * LOCKS: this
+         */
+        void printSummary(std::ostream& out);
+
+    private:
+
+        struct Request {
+            std::function<void()> function;
+            m_clock::time_point submitted;
+        };
+
+        void submit(Priority priority, std::function<void()> function);
+        /*
+         * Class of the next request to run (queues must not be all empty)
+         */
+        std::size_t pickClass(m_clock::time_point now) const;
+        void run();
+
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+        bool m_stop;
+        std::size_t m_n_queued;
+        std::vector<std::deque<Request>> m_queues;
+
+        std::vector<Stats> m_interval;
+        std::vector<Stats> m_total;
+
+        std::thread m_thread;
+};
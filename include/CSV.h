@@ -0,0 +1,99 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Small class to handle CSV file writing for continuous logging.
+ *
+ * Fields are declared with addField(), which returns an integer handle, and the
+ * header is written by freeze(). Values are then set through their handle and
+ * formatted directly into per-field buffers, so that filling and writing a line
+ * does not allocate. Fields not set since the last line are left empty.
+ *
+ * The file is flushed every `flush_lines` lines or when `flush_interval` has
+ * elapsed since the last flush (checked when a line is written), whichever comes
+ * first; a value of 0 disables the corresponding criterion.
+ */
+class CSV {
+
+    public:
+
+        typedef std::size_t Field;
+
+        CSV(std::string fileName, std::size_t flush_lines = 1, std::chrono::milliseconds flush_interval = std::chrono::milliseconds(0));
+        ~CSV();
+
+        /*
+         * Declare a new column and return its handle.
+         * Adding a field twice returns the existing handle.
+         */
+        Field addField(const std::string& field);
+
+        /*
+         * Write the header: no field can be added afterwards
+         */
+        void freeze();
+
+        template<typename T>
+        void setField(Field field, T content) {
+            if (!checkField(field))
+                return;
+
+            formatValue(field, content, std::is_integral<T>());
+        }
+
+        /*
+         * Write the current line and clear all the fields
+         */
+        void putLine();
+
+        void flush();
+
+    private:
+
+        using m_clock = std::chrono::steady_clock;
+
+        // Large enough for any 64-bit integer or double formatted with "%g"
+        static const std::size_t ValueSize = 32;
+
+        bool checkField(Field field);
+
+        template<typename T>
+        void formatValue(Field field, T content, std::true_type) {
+            if (content < 0)
+                formatSigned(field, static_cast<std::int64_t>(content));
+            else
+                formatUnsigned(field, static_cast<std::uint64_t>(content), false);
+        }
+
+        template<typename T>
+        void formatValue(Field field, T content, std::false_type) {
+            formatDouble(field, static_cast<double>(content));
+        }
+
+        void formatSigned(Field field, std::int64_t content);
+        void formatUnsigned(Field field, std::uint64_t content, bool negative);
+        void formatDouble(Field field, double content);
+
+        bool m_frozen;
+        std::vector<std::string> m_fields;
+
+        // Formatted values: ValueSize characters per field, and their actual lengths
+        std::vector<char> m_values;
+        std::vector<std::size_t> m_lengths;
+        // Reused to assemble each line
+        std::string m_line;
+
+        std::size_t m_flush_lines;
+        std::chrono::milliseconds m_flush_interval;
+        std::size_t m_lines_since_flush;
+        m_clock::time_point m_last_flush;
+
+        std::ofstream m_file;
+};
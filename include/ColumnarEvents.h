@@ -0,0 +1,155 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+#include "Event.h"
+
+/*
+ * Columnar files of TDC events (.evcol), for offline analysis.
+ *
+ * Instead of one object per event with nested hit vectors (as in the ROOT files), the
+ * events are stored as flat columns: one row per event (number, time, error code, number
+ * of hits and of TDC errors) and one row per hit (index of its event in the file, channel,
+ * time, leading edge). Analyses then scan contiguous arrays, e.g. a channel-time histogram
+ * is a loop over two arrays of integers.
+ *
+ * The rows are split into row groups of a fixed number of events, which can be read
+ * independently (and in parallel). Each column of a row group is encoded:
+ * - plain: 32-bit little-endian integers (hit times)
+ * - varint: LEB128 unsigned integers (numbers of hits, TDC errors)
+ * - delta: zigzag LEB128 differences between consecutive values (event numbers, times,
+ *   event index of the hits: mostly 1 byte per row)
+ * - dictionary: table of the distinct values, then one byte per row (channels, error codes),
+ *   or delta if there are more than 256 distinct values
+ * - bit-packed: 1 bit per row (hit edges)
+ *
+ * Layout of the file:
+ *   magic "SCEVCOL1"
+ *   row groups: n_events, n_hits, n_tdc_errors, n_columns (u32), then for each column:
+ *               column id (u8), encoding (u8), size in bytes (u32), encoded data
+ *   footer: for each row group: offset (u64), first event index (u64), n_events, n_hits (u32)
+ *           number of row groups (u32), offset of the footer (u64), magic "SCEVCOL1"
+ * All integers are little-endian.
+ */
+
+/*
+ * Decoded content of one or several row groups
+ */
+struct EventColumns {
+    // One entry per event
+    std::vector<std::uint32_t> event_number;
+    std::vector<std::int64_t> event_time;
+    std::vector<std::int32_t> error_code;
+    std::vector<std::uint32_t> n_hits;
+    std::vector<std::uint32_t> n_tdc_errors;
+
+    // One entry per hit, in the order of the events
+    std::vector<std::uint64_t> hit_event;
+    std::vector<std::uint8_t> hit_channel;
+    std::vector<std::uint32_t> hit_time;
+    std::vector<std::uint8_t> hit_leading;
+
+    // One entry per TDC error, in the order of the events
+    std::vector<std::uint32_t> tdc_error;
+
+    // Index in the file of the first event
+    std::uint64_t first_event;
+
+    std::size_t getNEvents() const { return event_number.size(); }
+    std::size_t getNHits() const { return hit_time.size(); }
+
+    void clear();
+};
+
+/*
+ * Write events to a columnar file. Events are buffered until a row group is complete.
+ * Throws std::ios_base::failure if the file cannot be written.
+ */
+class ColumnarEventWriter {
+    public:
+        static const std::size_t DefaultRowGroupSize = 65536;
+
+        ColumnarEventWriter(std::string fileName, std::size_t row_group_size = DefaultRowGroupSize);
+        /*
+         * Calls close(): errors are only reported, not thrown
+         */
+        ~ColumnarEventWriter();
+
+        ColumnarEventWriter(const ColumnarEventWriter&) = delete;
+        ColumnarEventWriter& operator=(const ColumnarEventWriter&) = delete;
+
+        void write(const event& e);
+
+        /*
+         * Write the last row group and the footer
+         */
+        void close();
+
+        std::uint64_t getNEvents() const { return m_n_events; }
+
+    private:
+        struct RowGroupInfo {
+            std::uint64_t offset;
+            std::uint64_t first_event;
+            std::uint32_t n_events;
+            std::uint32_t n_hits;
+        };
+
+        void writeRowGroup();
+        void writeBytes(const std::string& bytes);
+
+        std::string m_file_name;
+        std::ofstream m_file;
+        bool m_closed;
+        std::uint64_t m_offset;
+        std::size_t m_row_group_size;
+        std::uint64_t m_n_events;
+
+        EventColumns m_columns;
+        std::vector<RowGroupInfo> m_row_groups;
+        // Encoding buffer, reused from one row group to the next
+        std::string m_buffer;
+};
+
+/*
+ * Read a columnar file. Row groups can be read concurrently from several threads.
+ * Throws std::ios_base::failure if the file cannot be read or is not valid.
+ */
+class ColumnarEventReader {
+    public:
+        ColumnarEventReader(std::string fileName);
+        ~ColumnarEventReader();
+
+        ColumnarEventReader(const ColumnarEventReader&) = delete;
+        ColumnarEventReader& operator=(const ColumnarEventReader&) = delete;
+
+        std::size_t getNRowGroups() const { return m_row_groups.size(); }
+        std::uint64_t getNEvents() const { return m_n_events; }
+        std::uint64_t getNHits() const { return m_n_hits; }
+        std::size_t getRowGroupNEvents(std::size_t row_group) const { return m_row_groups.at(row_group).n_events; }
+
+        /*
+         * Decode row group `row_group` into `columns` (cleared first: reuse it to avoid allocations)
+         * Thread-safe
+         */
+        void readRowGroup(std::size_t row_group, EventColumns& columns) const;
+
+    private:
+        struct RowGroupInfo {
+            std::uint64_t offset;
+            std::uint64_t size;
+            std::uint64_t first_event;
+            std::uint32_t n_events;
+            std::uint32_t n_hits;
+        };
+
+        std::string m_file_name;
+        int m_fd;
+        std::vector<RowGroupInfo> m_row_groups;
+        std::uint64_t m_n_events;
+        std::uint64_t m_n_hits;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+#include <json/value.h>
+
+/*
+ * Append-only journal of condition records, one JSON object per line (JSON Lines).
+ *
+ * Each record is written to the file as soon as it is appended, so that a crash of
+ * the program does not lose anything. To limit the cost of the disk synchronisation,
+ * fsync() is only called every `sync_records` records, or once `sync_interval` has
+ * elapsed since the first unsynchronised record (see syncIfDue()).
+ *
+ * Appending and synchronising are thread-safe.
+ *
+ * Records have a "record" member: "start", "conditions" or "stop".
+ * compact() turns a journal into the JSON layout of cond_log_run_N.json.
+ */
+class ConditionJournal {
+
+    public:
+
+        ConditionJournal(std::string fileName, std::size_t sync_records = 10, std::chrono::milliseconds sync_interval = std::chrono::milliseconds(1000));
+        ~ConditionJournal();
+
+        ConditionJournal(const ConditionJournal&) = delete;
+        ConditionJournal& operator=(const ConditionJournal&) = delete;
+
+        /*
+         * Write `record` with its type in the "record" member
+         */
+        void append(std::string type, Json::Value record);
+
+        /*
+         * Synchronise the file if records have been waiting longer than the sync interval.
+         * Called regularly by the logger thread.
+         */
+        void syncIfDue();
+        void sync();
+
+        /*
+         * Read journal `journal_name` and write its content to `output_name`, in the layout
+         * of the end-of-run condition log. The list of conditions is streamed, so that the
+         * journal is never loaded into memory as a whole.
+         * A journal without "stop" record (crashed run) is compacted without stop time.
+         * Throws std::ios_base::failure if a file cannot be opened.
+         */
+        static void compact(std::string journal_name, std::string output_name);
+
+    private:
+
+        using m_clock = std::chrono::steady_clock;
+
+        // Called with m_mtx held
+        void syncUnlocked();
+
+        std::mutex m_mtx;
+        const std::string m_file_name;
+        int m_fd;
+
+        std::size_t m_sync_records;
+        std::chrono::milliseconds m_sync_interval;
+        std::size_t m_unsynced_records;
+        m_clock::time_point m_first_unsynced;
+};
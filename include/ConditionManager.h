@@ -7,24 +7,32 @@
 #include <utility>
 #include <vector>
 #include <string>
+#include <functional>
 #include <cstddef>
 #include <cstdint>
 
 #include "SetupManager.h"
-#include "Interface.h"
 #include "RealSetupManager.h"
 #include "FakeSetupManager.h"
+#include "ReplaySetupManager.h"
 #include "Utils.h"
+#include "ProfiledMutex.h"
+#include "BusScheduler.h"
+#include "PeriodicScheduler.h"
+#include "DAQClock.h"
+#include "MemoryTracker.h"
+#include "ThreadUtils.h"
 
 #include "Event.h"
-
-class Interface;
+#include "EventPool.h"
+#include "LiveHistograms.h"
+#include "TriggerGovernor.h"
 
 class ConditionManager {
     
     public:
 
-        ConditionManager(Interface& m_interface, bool use_fake_setup);
+        ConditionManager(const Arguments& m_args);
         ~ConditionManager();
 
         class daemon_state_error: public std::runtime_error {
@@ -41,6 +49,25 @@ class ConditionManager {
             int readCurrent;
             bool setState;
             //int readState;
+
+            bool operator==(const HVPMT& other) const {
+                return setValue == other.setValue && readValue == other.readValue
+                    && readCurrent == other.readCurrent && setState == other.setState;
+            }
+        };
+
+        /*
+         * What the daemons last read, for displays: the HV values, the state of the TDC readout
+         * and the trigger count. Kept apart from the hardware locks, so that it can be read at any time.
+         */
+        struct Status {
+            std::vector<HVPMT> hv;
+            std::int64_t tdcEventCount;
+            std::size_t tdcOffset;
+            std::int64_t tdcFIFOEventCount;
+            bool tdcBackPressure;
+            bool tdcFatal;
+            std::uint64_t triggerEventNumber;
         };
 
         // Discri settings
@@ -57,12 +84,37 @@ class ConditionManager {
          * user would result in freezing the program.
          * ALL functions requesting a lock are documented => ALWAYS check the functions you are calling
          * if you request a lock yourself!!!
+         * Use ProfiledLock to lock them, so that wait and hold times are recorded for each call site.
+         */
+        ProfiledMutex& getHVLock() { return m_hv_mtx; }
+        ProfiledMutex& getTDCLock() { return m_tdc_mtx; }
+        ProfiledMutex& getTTCLock() { return m_ttc_mtx; }
+        ProfiledMutex& getDiscriLock() { return m_discri_mtx; }
+        ProfiledMutex& getScalerLock() { return m_scaler_mtx; }
+        // All the above, for reporting lock statistics
+        std::vector<ProfiledMutex*> getAllLocks() { return { &m_hv_mtx, &m_discri_mtx, &m_ttc_mtx, &m_tdc_mtx, &m_scaler_mtx }; }
+        /*
+         * All the accesses to the setup go through the bus scheduler, with the priority of the
+         * caller (readout, trigger, scaler, HV; other callers: control). For its latency statistics.
+         */
+        BusScheduler& getBus() { return m_bus; }
+        /*
+         * Scheduler running the daemons, also used for the logger
+         */
+        PeriodicScheduler& getScheduler() { return m_scheduler; }
+
+        /*
+         * Copy of the status, as last published by the daemons
+         * LOCKS: status (never a hardware lock)
+         */
+        Status getStatus();
+        /*
+         * Called by the daemons each time they change the status (not when they read the same values
+         * again), from their own threads and with the status lock held: it must only post a notification,
+         * e.g. to the GUI thread, and take the status with getStatus() from there. Null to remove it.
+         * LOCKS: status
          */
-        std::mutex& getHVLock() { return m_hv_mtx; }
-        std::mutex& getTDCLock() { return m_tdc_mtx; }
-        std::mutex& getTTCLock() { return m_ttc_mtx; }
-        std::mutex& getDiscriLock() { return m_discri_mtx; }
-        std::mutex& getScalerLock() { return m_scaler_mtx; }
+        void setStatusListener(std::function<void()> listener);
 
         /*
          * Define/retrieve/propagate the PMT HV conditions
@@ -79,7 +131,10 @@ class ConditionManager {
         //int getHVPMTReadState(std::size_t id) const { return m_hvpmt.at(id).readState; }
         std::size_t getNHVPMT() const { return m_hvpmt.size(); }
 
-        // Trigger control: channel 1 --> physics,  channel 5 --> random
+        /*
+         * Trigger control: channel 1 --> physics,  channel 5 --> random
+         * The random frequency used is the one set, unless the trigger governor throttles it.
+         */
         void setTriggerChannel(int channel) { m_triggerChannel = channel; }
         int getTriggerChannel() { return m_triggerChannel; }
         void setTriggerRandomFrequency(int frequency) { m_triggerRandomFrequency = frequency; }
@@ -88,6 +143,12 @@ class ConditionManager {
         void stopTrigger();
         void resetTrigger();
         std::uint64_t getTriggerEventNumber();
+        /*
+         * Trigger governor of the TDC daemon: it inhibits the trigger when the TDC is almost full
+         * (the "backpressure"), and throttles the random trigger to the capacity of the readout.
+         * Reset by configureTDC(). Needs the TTC lock.
+         */
+        const TriggerGovernor& getTriggerGovernor() const { return m_TDC_governor; }
 
         /*
          * Define/retrieve/propagate the Discriminator conditions
@@ -110,21 +171,34 @@ class ConditionManager {
         void startTDCReading();
         void stopTDCReading();
         /*
-         * Configure the TDC
+         * Configure the TDC, and program its almost full level
+         * LOCKS: TTC
          */
         void configureTDC();
-        std::vector<event>& getTDCEventBuffer() { return m_TDC_evtBuffer; };
+        /*
+         * Events read by the TDC daemon, to be taken by the logger. They come from a pool:
+         * they are recycled once their handle is destroyed. The daemon stops reading when it
+         * holds `event_buffer_size` events: the TDC then fills up and backpressures the trigger.
+         */
+        std::vector<EventPool::Handle>& getTDCEventBuffer() { return m_TDC_evtBuffer; };
         std::int64_t getTDCEventCount() { return m_TDC_evtCounter; }
         std::int64_t getTDCFIFOEventCount();
         bool checkTDCBackPressure() { return m_TDC_backPressuring; }
+        // Number of times the trigger governor inhibited the trigger since configureTDC()
+        std::uint64_t getTDCBackPressureEpisodes() { return m_TDC_backPressureEpisodes; }
         bool checkTDCFatalError() { return m_TDC_fatal; }
+        /*
+         * Occupancy and hit times of the events read by the TDC daemon since configureTDC().
+         * Thread-safe: does not need the TDC lock.
+         */
+        LiveHistograms& getTDCLiveHistograms() { return m_TDC_liveHistograms; }
         std::size_t getTDCOffset() { return m_TDC_offsetMinimum(); }
 
         // Defined in .cpp: list of rate measurements using the scaler
         // Maps a channel ID to a pair with a string (name of the measurement) and a double (constant multiplying the rate)
         static const std::map<ScalerChannel, std::pair<std::string, double>> ScalerReadings;
         double getScalerRate(ScalerChannel channel) { return m_scaler_rates.at(channel)(); }
-        void resetScaler() { m_setup_manager->resetScaler(); }
+        void resetScaler();
         /*
          * Start/stop the Scaler reading daemon
          * Public, since called by interface when start/stop run
@@ -136,15 +210,16 @@ class ConditionManager {
     private:
 
         /* 
-         * HV daemon: updates read values for voltage & current
-         * LOCKS: HV
+         * HV daemon, run every m_HV_interval: updates read values for voltage & current
+         * LOCKS: HV, status
          */
         void daemonHV();
         /* 
-         * TDC daemon: reads TDC events, backpressures trigger if needed
-         * LOCKS: TDC, TTC
+         * TDC daemon, run every ms: reads TDC events, backpressures trigger if needed
+         * Return: false after a fatal error (the daemon stops)
+         * LOCKS: TDC, TTC, status
          */
-        void daemonTDC();
+        bool daemonTDC();
         /* 
          * Scaler daemon: reads Scaler at fixed time intervals, computes rates
          * LOCKS: Scaler
@@ -157,21 +232,37 @@ class ConditionManager {
          */
         void startHVDaemon();
         void stopHVDaemon();
+
+        /*
+         * Apply `update` to the status; it returns whether it changed anything, in which case
+         * the listener is notified
+         * LOCKS: status
+         */
+        template<typename Update> void publishStatus(Update update);
+        /*
+         * Publish the state of the TDC readout, from the TDC daemon or when configuring the TDC
+         * LOCKS: status
+         */
+        void publishTDCStatus();
        
-        std::mutex m_hv_mtx;
-        std::mutex m_discri_mtx;
-        std::mutex m_ttc_mtx;
-        std::mutex m_tdc_mtx;
-        std::mutex m_scaler_mtx;
+        ProfiledMutex m_hv_mtx;
+        ProfiledMutex m_discri_mtx;
+        ProfiledMutex m_ttc_mtx;
+        ProfiledMutex m_tdc_mtx;
+        ProfiledMutex m_scaler_mtx;
 
-        Interface& m_interface;
+        // Declared before the setup manager: its thread runs all the accesses to the setup
+        BusScheduler m_bus;
 
-        std::thread thread_handle_HV;
-        std::atomic<bool> m_HV_daemon_running;
-        std::thread thread_handle_TDC;
-        std::atomic<bool> m_TDC_daemon_running;
-        std::thread thread_handle_scaler;
-        std::atomic<bool> m_scaler_daemon_running;
+        // Thread placement (name, CPU affinity, priority) of the daemons
+        // and their tasks on the scheduler (0: not running)
+        ThreadSettings m_HV_thread_settings;
+        PeriodicScheduler::TaskId m_HV_task;
+        ThreadSettings m_TDC_thread_settings;
+        // Read by the TDC daemon itself, to wait for more events
+        std::atomic<PeriodicScheduler::TaskId> m_TDC_task;
+        ThreadSettings m_scaler_thread_settings;
+        PeriodicScheduler::TaskId m_scaler_task;
 
         std::vector<HVPMT> m_hvpmt;
         std::vector<DiscriChannel> m_discriChannels;
@@ -180,15 +271,39 @@ class ConditionManager {
         int m_triggerChannel;
         int m_triggerRandomFrequency;
 
-        std::vector<event> m_TDC_evtBuffer;
+        // Declared before the buffer: destroyed after the events it gave out
+        EventPool m_TDC_eventPool;
+        std::vector<EventPool::Handle> m_TDC_evtBuffer;
+        // Events of the burst being read by the TDC daemon
+        std::vector<EventPool::Handle> m_TDC_burst;
+        // Declared before their writer, used by the TDC daemon only
+        LiveHistograms m_TDC_liveHistograms;
+        LiveHistograms::Writer m_TDC_histogramWriter;
         MovingMinimum<std::size_t> m_TDC_offsetMinimum;
+        // Used by the TDC daemon with the TTC lock held
+        TriggerGovernor m_TDC_governor;
+        unsigned int m_TDC_almostFullLevel;
         std::atomic<bool> m_TDC_backPressuring;
+        std::atomic<std::uint64_t> m_TDC_backPressureEpisodes;
         std::atomic<bool> m_TDC_fatal;
         std::int64_t m_TDC_evtCounter;
         std::size_t m_TDC_evtBuffer_flushSize;
+        std::size_t m_TDC_evtBuffer_maxSize;
+        // Last read by the TDC daemon, for the status
+        std::int64_t m_TDC_FIFOEventCount;
+        std::uint64_t m_TTC_eventNumber;
+
+        // Protects the status and its listener only: never held while accessing the setup
+        std::mutex m_status_mtx;
+        Status m_status;
+        std::function<void()> m_status_listener;
 
-        uint64_t m_scaler_interval;
-        std::map<ScalerChannel, Rate<std::chrono::high_resolution_clock>> m_scaler_rates;
+        std::uint64_t m_HV_interval;
+        std::uint64_t m_scaler_interval;
+        std::map<ScalerChannel, Rate<DAQClock>> m_scaler_rates;
         
         std::shared_ptr<SetupManager> m_setup_manager;
+
+        // Declared last: its tasks are cancelled before anything they use is destroyed
+        PeriodicScheduler m_scheduler;
 };
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <string>
+#include <stdexcept>
+
+class RunController;
+
+/*
+ * Unix-domain socket server forwarding text commands to a RunController.
+ *
+ * Protocol: one command per line (see `help` command), one answer line per command,
+ * starting with "OK" or "ERROR". Clients are served one at a time by a background thread.
+ * Can be used e.g. with `socat - UNIX-CONNECT:<path>` or `python/daqctl.py`.
+ */
+class ControlSocket {
+
+    public:
+
+        class socket_error: public std::runtime_error {
+            using std::runtime_error::runtime_error;
+        };
+
+        /*
+         * Create the socket at `path` (replacing any stale socket file) and start serving
+         * Throws socket_error if the socket cannot be created.
+         */
+        ControlSocket(RunController& m_controller, std::string path);
+        
+        /*
+         * Stop serving, close and remove the socket
+         */
+        ~ControlSocket();
+
+        const std::string& getPath() const { return m_path; }
+
+    private:
+
+        void serve();
+        void handleClient(int client_fd);
+
+        RunController& m_controller;
+        const std::string m_path;
+        int m_listen_fd;
+
+        std::thread thread_handle;
+        std::atomic<bool> m_running;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+
+/*
+ * Time of the simulations. Once enabled (before any clock below is used, e.g. by SlowControlTBLd
+ * --simulate), the clocks of the daemons, of the logger and of the simulated setups no longer
+ * follow the real time: the PeriodicScheduler sets the virtual time to the due time of each task
+ * it runs, and runs them one at a time, so that hours of data taking take as long as the CPU
+ * needs to process them, and always happen in the same order.
+ *
+ * Time measurements of the program itself (lock and bus profiling, CPU times, flushing of the
+ * files, retries of the TSDB spool) stay on the real clocks.
+ */
+class VirtualTime {
+
+    public:
+
+        // Date at which the wall clock starts in a simulation (2020-01-01 00:00:00 UTC), so that
+        // the outputs do not depend on when the simulation was run
+        static const std::time_t Epoch = 1577836800;
+
+        /*
+         * Switch the DAQ clocks to virtual time, starting from 0 (Epoch for the wall clock)
+         */
+        static void enable();
+        static bool isEnabled();
+
+        /*
+         * Virtual time since enable()
+         */
+        static std::chrono::nanoseconds now();
+        /*
+         * Move the virtual time forward to `time`. Never goes back.
+         */
+        static void advance(std::chrono::nanoseconds time);
+};
+
+/*
+ * Monotonic clock of the daemons and of the simulated setups: std::chrono::steady_clock,
+ * or the virtual time if enabled
+ */
+struct DAQClock {
+    typedef std::chrono::nanoseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<DAQClock> time_point;
+    static const bool is_steady = true;
+
+    static time_point now();
+};
+
+/*
+ * Wall clock of the logs: std::chrono::system_clock, or VirtualTime::Epoch + the virtual time if enabled
+ */
+struct DAQSystemClock {
+    typedef std::chrono::nanoseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<DAQSystemClock> time_point;
+    static const bool is_steady = false;
+
+    static time_point now();
+    static std::time_t to_time_t(const time_point& time);
+};
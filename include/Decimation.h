@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Fixed-length ring of samples of a set of channels, overwriting the oldest
+ * sample when full. Storage is allocated once at construction, so that pushing
+ * a sample does not allocate.
+ */
+class SampleRing {
+
+    public:
+
+        SampleRing(std::size_t n_channels, std::size_t length);
+
+        void push(std::uint64_t timestamp, const std::vector<double>& values);
+        void clear();
+
+        std::size_t size() const { return m_size; }
+        std::size_t getNChannels() const { return m_n_channels; }
+
+        /*
+         * Access the i-th sample, starting from the oldest one
+         */
+        std::uint64_t getTimestamp(std::size_t i) const { return m_timestamps[index(i)]; }
+        const double* getValues(std::size_t i) const { return &m_values[index(i) * m_n_channels]; }
+
+    private:
+
+        std::size_t index(std::size_t i) const { return (m_head + m_length - m_size + i) % m_length; }
+
+        std::size_t m_n_channels;
+        std::size_t m_length;
+        // Position where the next sample will be written
+        std::size_t m_head;
+        std::size_t m_size;
+        std::vector<std::uint64_t> m_timestamps;
+        std::vector<double> m_values;
+};
+
+/*
+ * Decimation of a set of channels: accumulates the minimum, maximum and mean of
+ * each channel over consecutive intervals of fixed length (in ms).
+ * The intervals are aligned on the first sample: the k-th one covers
+ * [first + k * period, first + (k + 1) * period), so that tiers started on the
+ * same sample stay aligned with each other. Intervals without any sample are skipped.
+ */
+class DecimationTier {
+
+    public:
+
+        DecimationTier(std::size_t n_channels, std::uint64_t period);
+
+        /*
+         * Add a sample. Return true if it is past the end of the current interval, which
+         * is then completed without it: the results can be read with the getters, until
+         * the next call to add()
+         */
+        bool add(std::uint64_t timestamp, const std::vector<double>& values);
+
+        /*
+         * Complete the current interval, even if shorter than the period.
+         * Return false if it does not contain any sample.
+         */
+        bool finish();
+
+        std::uint64_t getPeriod() const { return m_period; }
+
+        // Results of the last completed interval: the stop is the end of the interval,
+        // or the timestamp of its last sample if completed by finish()
+        std::uint64_t getStart() const { return m_result_start; }
+        std::uint64_t getStop() const { return m_result_stop; }
+        std::size_t getNSamples() const { return m_result_n; }
+        double getMin(std::size_t channel) const { return m_result_min[channel]; }
+        double getMax(std::size_t channel) const { return m_result_max[channel]; }
+        double getMean(std::size_t channel) const { return m_result_mean[channel]; }
+
+    private:
+
+        void complete(std::uint64_t stop);
+
+        std::uint64_t m_period;
+
+        // Timestamp of the first sample, on which the intervals are aligned
+        bool m_started;
+        std::uint64_t m_origin;
+
+        // Current interval: [m_start, m_start + m_period), and its last sample
+        std::uint64_t m_start;
+        std::uint64_t m_last;
+        std::size_t m_n;
+        std::vector<double> m_min;
+        std::vector<double> m_max;
+        std::vector<double> m_sum;
+
+        // Last completed interval
+        std::uint64_t m_result_start;
+        std::uint64_t m_result_stop;
+        std::size_t m_result_n;
+        std::vector<double> m_result_min;
+        std::vector<double> m_result_max;
+        std::vector<double> m_result_mean;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "Event.h"
+#include "EventPool.h"
+
+/*
+ * Filter applied by the logger to the TDC events of each 1 s record, after the online analysis
+ * (which sees all the events) and before the sinks, so that what is not useful is neither
+ * written nor published:
+ * - zero suppression: the hits on channels outside the channel mask, or outside the time window,
+ *   are removed from the events;
+ * - the events left without any hit are dropped, if `drop_empty`;
+ * - one of each `prescale` remaining events is kept.
+ * Events with TDC error words are always kept whole. The events kept keep their TDC event number,
+ * so that those dropped appear as gaps.
+ *
+ * Everything removed is counted exactly, since the start of the run, for normalisation.
+ * Not thread-safe: used by the logger only.
+ */
+class EventFilter {
+    public:
+        struct Settings {
+            Settings();
+
+            bool drop_empty;
+            // Channels whose hits are kept (empty: all)
+            std::vector<int> channels;
+            // Hits with time_min <= time <= time_max (TDC counts) are kept
+            unsigned int time_min;
+            unsigned int time_max;
+            // Keep one event of `prescale` (1: all)
+            std::uint32_t prescale;
+        };
+
+        struct Counts {
+            // Events given to the filter, and written
+            std::uint64_t events_in;
+            std::uint64_t events_kept;
+            // Events dropped because they had no hit left, or by the prescale
+            std::uint64_t events_empty;
+            std::uint64_t events_prescaled;
+            // Hits of the events given to the filter, and those removed by the channel mask or the time window
+            std::uint64_t hits_in;
+            std::uint64_t hits_masked;
+            std::uint64_t hits_outside_window;
+        };
+
+        EventFilter(const Settings& settings);
+
+        /*
+         * Whether the filter removes anything (if not, apply() only counts the events)
+         */
+        bool isActive() const { return m_active; }
+        const Settings& getSettings() const { return m_settings; }
+
+        /*
+         * Filter `events` in place: the events dropped are given back to their pool
+         */
+        void apply(std::vector<EventPool::Handle>& events);
+
+        Counts getCounts() const { return m_counts; }
+
+    private:
+
+        bool keepHit(const hit& h) const {
+            return (m_channel_mask.empty() || (h.channel < m_channel_mask.size() && m_channel_mask[h.channel]))
+                && h.time >= m_settings.time_min && h.time <= m_settings.time_max;
+        }
+
+        Settings m_settings;
+        bool m_active;
+        // Indexed by channel (empty: all the channels are kept)
+        std::vector<bool> m_channel_mask;
+        // Events which passed the other cuts since the last one kept by the prescale (modulo prescale)
+        std::uint32_t m_prescale_count;
+        Counts m_counts;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+#include "Event.h"
+
+/*
+ * Pool of reusable TDC events.
+ *
+ * Events are handed out by handle (a unique_ptr), moved from stage to stage (TDC daemon,
+ * logger, sinks) without being copied, and go back to the pool when their handle is
+ * destroyed. They keep the capacity of their hit and error vectors: once the pool is warm,
+ * reading and writing events does not allocate any memory.
+ *
+ * If all the events are in use, the pool grows. The pool must outlive all its handles.
+ */
+class EventPool {
+    public:
+
+        /*
+         * Deleter of the handles: give the event back to its pool
+         */
+        class Recycler {
+            public:
+                Recycler(EventPool* pool = nullptr): m_pool(pool) {}
+                void operator()(event* e) const;
+
+            private:
+                EventPool* m_pool;
+        };
+
+        typedef std::unique_ptr<event, Recycler> Handle;
+
+        /*
+         * Allocate `n_events` events, with room for `n_hits` hits each
+         */
+        EventPool(std::size_t n_events, std::size_t n_hits);
+
+        EventPool(const EventPool&) = delete;
+        EventPool& operator=(const EventPool&) = delete;
+
+        /*
+         * Get a cleared event
+         * LOCKS: this
+         */
+        Handle acquire();
+
+        /*
+         * Number of events allocated since creation (beyond `n_events`: the pool was too small)
+         * LOCKS: this
+         */
+        std::size_t getNAllocated();
+        /*
+         * Number of events not in use
+         * LOCKS: this
+         */
+        std::size_t getNAvailable();
+
+    private:
+
+        /*
+         * LOCKS: this
+         */
+        void release(event* e);
+        // Called with m_mtx held
+        void allocate(std::size_t n_events);
+
+        const std::size_t m_n_hits;
+
+        std::mutex m_mtx;
+        // Owns all the events, in use or not
+        std::vector<std::unique_ptr<event>> m_events;
+        std::vector<event*> m_available;
+};
@@ -3,17 +3,45 @@
 #include <cstddef>
 #include <cstdint>
 #include <vector>
+#include <mutex>
+#include <random>
 
 #include "SetupManager.h"
 #include "Event.h"
+#include "DAQClock.h"
 
-class Interface;
+class ConditionManager;
 
+/*
+ * Simulated setup, used when the boards cannot be reached: the actions on the setup have no effect,
+ * but the trigger, the TDC, the scaler and the HV behave like the real ones over time, on the DAQ
+ * clock (so that long runs can be simulated in virtual time, see VirtualTime):
+ * - the trigger fires at the random trigger frequency (channel 5), or at CosmicRate (other channels),
+ *   until it is stopped (channel 7);
+ * - triggered events wait in the TDC FIFO until read. Each takes one word per hit plus a header and
+ *   a trailer in the output buffer, which reports almost full from the almost full level (in words,
+ *   DefaultAlmostFullLevel until set), full from FIFOSize events, and lost triggers beyond;
+ * - each event has a leading hit on the channels of the PMTs (0 and 1) and on the reference channel (22),
+ *   at pseudo-random times which are the same from one run to the next;
+ * - the scaler counts the PMT singles at PMTRate, the triggers (NIM, VME and TTC), and the leakage
+ *   current, on 32-bit counters which wrap around as on the board;
+ * - the HV read values are the set values of the channels switched on.
+ *
+ * All the methods may be called concurrently (they are called under different hardware locks).
+ */
 class FakeSetupManager: public SetupManager {
-    
+
     public:
 
-        FakeSetupManager(Interface& m_interface);
+        // Trigger rate (Hz) of the physics channels
+        static constexpr double CosmicRate = 5;
+        // Singles rate (Hz) of each PMT
+        static constexpr double PMTRate = 200;
+        // Words, as on the board after a reset
+        static const std::size_t DefaultAlmostFullLevel = 64;
+        static const std::size_t FIFOSize = 2047;
+
+        FakeSetupManager(ConditionManager& m_conditions);
 
         virtual ~FakeSetupManager() override {};
 
@@ -24,25 +52,54 @@ class FakeSetupManager: public SetupManager {
 
         virtual void setTrigger(int channel, int randomFrequency) override;
         virtual void resetTrigger() override;
-        // Return 10 (same as getTDCNEvents() to stay "in sync")
+        // Number of triggers since the last reset
         virtual std::int64_t getTTCEventNumber() override;
 
         virtual bool propagateDiscriSettings() override;
-        
+
         virtual void setTDCWindowOffset(int offset) override;
         virtual void setTDCWindowWidth(int width) override;
-        // Return status for data ready
+        // Data ready, almost full, full and lost trigger bits
         virtual unsigned int getTDCStatus() override;
-        // Return 10
+        // Exact number of events in the FIFO
         virtual int getTDCNEvents() override;
-        // Return an empty, but valid, event
-        virtual event getTDCEvent() override;
+        // Next event of the FIFO (not a valid event if the FIFO is empty)
+        virtual void getTDCEvent(event& e) override;
+        // Empty the FIFO and restart the event numbers and the hit times
         virtual void configureTDC() override;
+        virtual void setTDCAlmostFullLevel(unsigned int words) override;
 
         virtual void resetScaler() override;
         virtual int getScalerCount(ScalerChannel channel) override;
 
     private:
 
-        Interface& m_interface;
+        using m_clock = DAQClock;
+
+        /*
+         * Trigger the events and count the scaler up to now. Must be called with the lock held.
+         */
+        void update();
+
+        ConditionManager& m_conditions;
+
+        std::mutex m_mtx;
+        m_clock::time_point m_last_update;
+
+        // Trigger rate (Hz), 0 when stopped, and fraction of an event not triggered yet
+        double m_trigger_rate;
+        double m_trigger_fraction;
+        std::int64_t m_ttc_number;
+
+        std::size_t m_n_fifo;
+        std::size_t m_almost_full_level;
+        bool m_lost_trigger;
+        std::uint32_t m_event_number;
+        std::mt19937 m_random;
+
+        // Indexed by channel number
+        std::vector<double> m_scaler_counts;
+
+        std::vector<int> m_hv_set_values;
+        std::vector<bool> m_hv_on;
 };
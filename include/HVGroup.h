@@ -11,6 +11,8 @@
 #include <memory>
 #include <cstddef>
 
+#include "ConditionManager.h"
+
 class Interface;
 
 class HVGroup: public QGroupBox {
@@ -34,6 +36,9 @@ class HVGroup: public QGroupBox {
             QLabel *readCurrent_label;
             QSpinBox *sb_set_value;
             QCheckBox *cb_set_state;
+            // Values currently displayed, and whether the read value is shown as within 5% of the set value
+            ConditionManager::HVPMT displayed;
+            bool displayedInRange;
         };
 
     private slots:
@@ -59,7 +64,10 @@ class HVGroup: public QGroupBox {
         void setHV();
 
     private:
-        void notifyUpdate();
+        /*
+         * Show the HV values of `status`, changing only the labels of the values which changed
+         */
+        void notifyUpdate(const ConditionManager::Status& status);
       
         //QGroupBox *m_box;
         std::vector<HVEntry> m_hventries;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QWidget>
+#include <QString>
+#include <QSize>
+
+#include <vector>
+
+class QPaintEvent;
+
+/*
+ * Bar plot of a histogram, repainted when new values are given to setData()
+ */
+class HistogramWidget: public QWidget {
+    public:
+        HistogramWidget(QString title, QString x_label, QWidget* parent = 0);
+
+        virtual ~HistogramWidget() {}
+
+        /*
+         * Bins covering [x_min, x_max], from left to right
+         */
+        void setData(const std::vector<double>& values, double x_min, double x_max);
+
+        virtual QSize sizeHint() const override { return QSize(360, 160); }
+
+    protected:
+        virtual void paintEvent(QPaintEvent* event) override;
+
+    private:
+        QString m_title;
+        QString m_x_label;
+        std::vector<double> m_values;
+        double m_x_min;
+        double m_x_max;
+};
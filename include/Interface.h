@@ -5,80 +5,72 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QGridLayout>
-#include <QTimer>
+#include <QElapsedTimer>
 #include <QSpinBox>
 
-#include <thread>
-#include <memory>
 #include <atomic>
 
 #include "Utils.h"
+#include "RunController.h"
 
 class ConditionManager;
-class LoggingManager;
 class HVGroup;
 class Trigger_TDC_Group;
+class AnalysisGroup;
+class LiveHistogramsGroup;
 class DiscriSettingsWindow;
 
 class Interface : public QWidget {
     friend class HVGroup;
     friend class Trigger_TDC_Group;
+    friend class AnalysisGroup;
+    friend class LiveHistogramsGroup;
     friend class DiscriSettingsWindow;
  
     Q_OBJECT
 
     public:
-        Interface(Arguments m_args, QWidget* parent = 0);
-
-        virtual ~Interface() {}
-
-        ConditionManager& getConditions();
-
-        /*
-         * Define states of the state machine.
-         * Possible transitions (defined in source file):
-         *  idle -> configured
-         *  configured -> running
-         *  running -> idle
-         *  configured -> idle
-         */
-        enum class State {
-            idle,
-            configured,
-            running
-        };
-        
         /*
-         * Get current state
+         * The Interface is a client of the RunController, which holds the run state machine
+         * and can also be driven through the control socket.
          */
-        Interface::State getState() const { return m_state; }
+        Interface(RunController& m_controller, QWidget* parent = 0);
 
         /*
-         * Convert the state to a string
+         * Stop listening to the RunController and the ConditionManager
          */
-        static std::string stateToString(Interface::State state);
+        virtual ~Interface();
+
+        ConditionManager& getConditions();
 
         /*
-         * Check if transition from `state_from` to `state_to` is allowed
+         * Get current state of the run
          */
-        static bool checkTransition(Interface::State state_from, Interface::State state_to);
+        RunController::State getState() const { return m_controller.getState(); }
 
     private slots:
         void updateConditionLog();
         void notifyUpdate();
 
         /*
-         * Configure the run, change state to "configured"
+         * Refresh the widgets after a notification, unless the last refresh was less than
+         * the refresh period ago: then wait until it has elapsed (notifications coming
+         * meanwhile are merged into this one)
+         */
+        void refresh();
+
+        /*
+         * Configure the run through the RunController, change state to "configured"
          */
         void configureRun();
        
         /*
-         * Start the run, change state to "running"
+         * Start the run through the RunController, change state to "running"
          */
         void startRun();
         
         /*
-         * Stop the run, change state to "idle"
+         * Stop the run through the RunController, change state to "idle"
          */
         void stopRun();
         
@@ -86,37 +78,43 @@ class Interface : public QWidget {
          * Quit the application: depending on current state, stop run or not
          */
         void quit();
+
+        /*
+         * Quit the application when asked by a client of the control socket: stop the run, without asking
+         */
+        void quitFromClient();
         
         void showDiscriSettingsWindow();
 
     private:
 
-        Arguments m_args;
-      
-        void setCounter(int i);
+        /*
+         * Ask for a refresh in the GUI thread, from any thread (listener of the RunController
+         * and of the ConditionManager). Does nothing if one is already pending.
+         */
+        void postRefresh();
 
-        HVGroup* m_hv_group;
-        Trigger_TDC_Group* m_ttc_tdc_group;
-        
-        // Use a timer to refresh the interface periodically
-        QTimer* m_timer;
-        
-        std::shared_ptr<LoggingManager> m_logging_manager;
-        std::shared_ptr<ConditionManager> m_conditions;
-        std::thread thread_handler;
-        
         /*
-         * Change  state to `state`.
-         * Throws exception if transition from current state is not allowed.
-         * Returns:
-         *  - `true` if state was changed successfully
-         *  - `false` if interface  was already in the requested state
+         * Bring the widgets in line with the state of the RunController,
+         * which may have been changed by another client
          */
-        bool setState(Interface::State state);
+        void syncRunState();
+
+        RunController& m_controller;
+        ConditionManager* m_conditions;
+        // State of the run as currently displayed
+        RunController::State m_displayed_state;
 
-        // Transitions are defined in .cc file
-        static const std::vector< std::pair<State, State> > m_transitions;
-        std::atomic<State> m_state;
+        HVGroup* m_hv_group;
+        Trigger_TDC_Group* m_ttc_tdc_group;
+        // Null if the online analysis is disabled
+        AnalysisGroup* m_analysis_group;
+        LiveHistogramsGroup* m_live_histograms_group;
+        
+        // The interface is only refreshed when notified of a change, at most every m_refresh_period ms
+        int m_refresh_period;
+        QElapsedTimer m_last_refresh;
+        std::atomic<bool> m_refresh_pending;
         
         QPushButton *m_configureBtn;
         QPushButton *m_startBtn;
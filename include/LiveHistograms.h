@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "Event.h"
+
+/*
+ * Live histograms of the TDC hits (occupancy and hit time of each channel), for display.
+ *
+ * They are filled from the readout thread without any lock: each writer has its own set of
+ * counters (shard), which only it modifies, and readers sum the shards when taking a snapshot.
+ * Filling a hit is a couple of relaxed loads and stores, so that however often (or slowly)
+ * the histograms are displayed, the readout is never delayed.
+ * Resetting does not touch the shards: the current sums are subtracted from later snapshots.
+ */
+class LiveHistograms {
+    public:
+        /*
+         * Content of the histograms at one point in time
+         */
+        struct Snapshot {
+            std::size_t n_channels;
+            std::size_t n_time_bins;
+            std::uint32_t time_bin_width;
+
+            std::uint64_t n_events;
+            std::uint64_t n_hits;
+            // Hits on channels not histogrammed
+            std::uint64_t n_other_hits;
+            // Hits per channel
+            std::vector<std::uint64_t> occupancy;
+            // Hit times of each channel: [channel * n_time_bins + bin]
+            std::vector<std::uint64_t> time;
+        };
+
+    private:
+        struct Shard {
+            Shard(std::size_t n_counters): counters(n_counters) {}
+            // Events, hits, other hits, occupancy, then time
+            std::vector<std::atomic<std::uint64_t>> counters;
+        };
+
+    public:
+        /*
+         * Fills the histograms. Must be used by one thread at a time (e.g. the readout thread).
+         */
+        class Writer {
+            public:
+                void fill(const event& e);
+
+            private:
+                friend class LiveHistograms;
+                Writer(Shard& shard, const LiveHistograms& histograms): m_shard(shard), m_histograms(histograms) {}
+
+                void increment(std::size_t counter) {
+                    std::atomic<std::uint64_t>& value = m_shard.counters[counter];
+                    value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                }
+
+                Shard& m_shard;
+                const LiveHistograms& m_histograms;
+        };
+
+        /*
+         * Histogram channels 0 to n_channels - 1, hit times from 0 to time_range (TDC counts) in n_time_bins bins
+         */
+        LiveHistograms(std::size_t n_channels, std::size_t n_time_bins, std::uint32_t time_range);
+
+        LiveHistograms(const LiveHistograms&) = delete;
+        LiveHistograms& operator=(const LiveHistograms&) = delete;
+
+        /*
+         * Add a writer, valid as long as the histograms
+         * LOCKS: histograms
+         */
+        Writer makeWriter();
+
+        /*
+         * Sum of the writers since the last reset(). `snapshot` is reused to avoid allocations.
+         * LOCKS: histograms
+         */
+        void getSnapshot(Snapshot& snapshot);
+
+        /*
+         * Start again from empty histograms
+         * LOCKS: histograms
+         */
+        void reset();
+
+        std::size_t getNChannels() const { return m_n_channels; }
+        std::size_t getNTimeBins() const { return m_n_time_bins; }
+        std::uint32_t getTimeBinWidth() const { return m_time_bin_width; }
+
+    private:
+        static const std::size_t EventsCounter = 0;
+        static const std::size_t HitsCounter = 1;
+        static const std::size_t OtherHitsCounter = 2;
+        static const std::size_t OccupancyCounters = 3;
+
+        std::size_t timeCounter(std::size_t channel, std::size_t bin) const {
+            return OccupancyCounters + m_n_channels + channel * m_n_time_bins + bin;
+        }
+
+        /*
+         * Sum of the shards into m_sums
+         */
+        void sumShards();
+
+        const std::size_t m_n_channels;
+        const std::size_t m_n_time_bins;
+        const std::uint32_t m_time_bin_width;
+        const std::size_t m_n_counters;
+
+        // Guards the list of shards, the baseline and the sums (not the content of the shards)
+        std::mutex m_mtx;
+        std::vector<std::unique_ptr<Shard>> m_shards;
+        std::vector<std::uint64_t> m_baseline;
+        std::vector<std::uint64_t> m_sums;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QGroupBox>
+#include <QSpinBox>
+#include <QLabel>
+#include <QTimer>
+
+#include <deque>
+#include <chrono>
+#include <cstdint>
+
+#include "LiveHistograms.h"
+
+class Interface;
+class HistogramWidget;
+
+class LiveHistogramsGroup: public QGroupBox {
+    friend class Interface;
+
+    Q_OBJECT
+
+    public:
+        /*
+         * Constructor
+         */
+        LiveHistogramsGroup(Interface& m_interface);
+
+        virtual ~LiveHistogramsGroup() {}
+
+        // Period (ms) at which the plots are repainted, whatever the trigger rate
+        static const int RefreshPeriod = 1000;
+        // Length of the rate history (number of refreshes)
+        static const std::size_t RateHistoryLength = 300;
+
+    private slots:
+        /*
+         * Take a snapshot of the live histograms and repaint the plots
+         */
+        void refresh();
+
+    private:
+        /*
+         * Called when the run is started/stopped: start/stop refreshing
+         */
+        void atStartRun();
+        void atStopRun();
+
+        Interface& m_interface;
+
+        QTimer *m_timer;
+        QSpinBox *m_channel_box;
+        QLabel *m_summary_label;
+        HistogramWidget *m_time_plot;
+        HistogramWidget *m_occupancy_plot;
+        HistogramWidget *m_rate_plot;
+
+        // Reused from one refresh to the next
+        LiveHistograms::Snapshot m_snapshot;
+        std::vector<double> m_values;
+
+        // Event rate at each refresh
+        std::deque<double> m_rates;
+        std::uint64_t m_last_n_events;
+        std::chrono::steady_clock::time_point m_last_refresh;
+};
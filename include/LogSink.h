@@ -0,0 +1,147 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+#include "Event.h"
+#include "EventPool.h"
+#include "TSDBSpool.h"
+#include "ThreadUtils.h"
+#include "MemoryTracker.h"
+
+/*
+ * Description of a logged quantity: column name in the CSV files, metric and tags in the database
+ */
+struct LogChannel {
+    std::string name;
+    std::string metric;
+    TSTags_t tags;
+};
+
+/*
+ * Channels of the records of a decimation tier:
+ * - sampled: sampled at high rate, logged as min/max/mean over the interval
+ * - values: read once per record
+ */
+struct LogLayout {
+    std::vector<LogChannel> sampled;
+    std::vector<LogChannel> values;
+};
+
+/*
+ * Content of one record of the continuous log.
+ * Filled by the LoggingManager while holding the hardware locks, and published to the
+ * sinks once they are released: sinks never run with a hardware lock held.
+ */
+struct LogRecord {
+    std::uint64_t timestamp;
+    std::size_t n_samples;
+    // Same order as LogLayout::sampled
+    std::vector<double> mean;
+    std::vector<double> min;
+    std::vector<double> max;
+    // Same order as LogLayout::values
+    std::vector<double> values;
+    // TDC events read since the last record (may be empty), recycled once the record is cleared
+    std::vector<EventPool::Handle> events;
+};
+
+/*
+ * Destination of the records of the continuous log
+ */
+class LogSink {
+    public:
+        virtual ~LogSink() {};
+
+        virtual void write(const LogRecord& record) = 0;
+};
+
+/*
+ * What a sink plugin needs to create its sink
+ */
+struct SinkContext {
+    // File written by the sink (file sinks)
+    std::string file_name;
+    // Channels of the records (sinks of the conditions)
+    const LogLayout* layout;
+    // Spool of the database, and suffix of the metrics of the records (database sink)
+    std::shared_ptr<TSDBSpool> tsdb_spool;
+    std::string metric_suffix;
+};
+
+/*
+ * The sinks are plugins (see PluginLoader), loaded when a run first uses them:
+ * - csv: write the conditions to a CSV file: timestamp, number of samples, then mean (named
+ *   after the channel), min and max of each sampled channel, then the values
+ * - root: write the TDC events to the "Events" tree of a ROOT file
+ * - columnar: write the TDC events to a columnar file (see ColumnarEventWriter)
+ * - tsdb: publish the conditions to OpenTSDB, through the spool. For each sampled channel, the mean
+ *   goes to metric+suffix, the min and max to metric+suffix+".min"/".max"; values go to metric+suffix.
+ *   Non-finite values are skipped.
+ * Each plugin defines `extern "C" LogSink* slowControlCreateSink(const SinkContext& context)`.
+ *
+ * Create the sink of plugin `plugin`. Throws PluginLoader::plugin_error if the plugin cannot be
+ * loaded, and what the sink throws (std::ios_base::failure if its file cannot be written).
+ */
+std::shared_ptr<LogSink> createSink(const std::string& plugin, const SinkContext& context);
+
+/*
+ * Background thread publishing records to sinks, so that slow sinks (e.g. the database)
+ * do not delay the logger. Sinks sharing a publisher are never called concurrently.
+ * At most `max_queue` records are waiting: beyond that, the oldest ones are dropped.
+ * The TDC events are not forwarded: only use it for sinks of the conditions.
+ * The remaining records are published before the destructor returns.
+ * The queued records, and the allocations of the sinks, are counted under `subsystem`.
+ */
+class AsyncPublisher {
+    public:
+        AsyncPublisher(ThreadSettings settings, MemoryTracker::Subsystem subsystem = MemoryTracker::Subsystem::Other, std::size_t max_queue = 100);
+        ~AsyncPublisher();
+
+        AsyncPublisher(const AsyncPublisher&) = delete;
+        AsyncPublisher& operator=(const AsyncPublisher&) = delete;
+
+        void publish(std::shared_ptr<LogSink> sink, const LogRecord& record);
+
+        std::size_t getNDropped();
+
+    private:
+        void run();
+
+        MemoryTracker::Subsystem m_subsystem;
+        std::size_t m_max_queue;
+
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+        std::deque< std::pair<std::shared_ptr<LogSink>, LogRecord> > m_queue;
+        bool m_stop;
+        std::size_t m_n_dropped;
+
+        std::thread m_thread;
+};
+
+/*
+ * Sink forwarding the records to another sink through an AsyncPublisher
+ */
+class AsyncSink: public LogSink {
+    public:
+        AsyncSink(std::shared_ptr<AsyncPublisher> publisher, std::shared_ptr<LogSink> sink):
+            m_publisher(publisher),
+            m_sink(sink)
+        {}
+        virtual ~AsyncSink() override {};
+
+        virtual void write(const LogRecord& record) override { m_publisher->publish(m_sink, record); }
+
+    private:
+        std::shared_ptr<AsyncPublisher> m_publisher;
+        std::shared_ptr<LogSink> m_sink;
+};
@@ -5,165 +5,153 @@
 #include <fstream>
 #include <vector>
 #include <map>
-#include <algorithm>
-#include <sstream>
+#include <set>
+#include <string>
 #include <cstdint>
 #include <cstddef>
 
 #include <json/value.h>
 
-#include <TTree.h>
-#include <TFile.h>
-
 #include "ConditionManager.h"
 #include "Utils.h"
-#include "PythonDB.h"
-
-// Forward declaration
-class Interface;
-
-/*
- * Small class to handle CSV file writing for continuous logging
- */
-class CSV {
-    
-    public:
-        
-        CSV(std::string fileName): m_frozen(false) {
-            m_file.open(fileName);
-            if (!m_file.is_open())
-                throw std::ios_base::failure("Could not open file " + fileName);
-        }
-        ~CSV() { m_file.close(); }
-
-        void freeze() {
-            m_frozen = true;
-
-            for (const auto& field: m_fields) {
-                m_file << field << ",";
-            }
-            m_file << std::endl;
-        }
-
-        void addField(std::string field) {
-            if (m_frozen) {
-                std::cout << "Warning: tried to add field to frozen CSV." << std::endl;
-                return;
-            }
-
-            if (std::find(m_fields.begin(), m_fields.end(), field) != m_fields.end()) {
-                std::cout << "Warning: tried to add already present field in CSV." << std::endl;
-                return;
-            }
-
-            m_fields.push_back(field);
-        }
-
-        template<typename T>
-        void setField(std::string field, T content) {
-            if (!m_frozen) {
-                std::cout << "Warning: tried to set field in a non-frozen CSV." << std::endl;
-                return;
-            }
-
-            if (std::find(m_fields.begin(), m_fields.end(), field) == m_fields.end()) {
-                std::cout << "Warning: field " << field << " does not exist." << std::endl; 
-                return;
-            }
-
-            std::ostringstream str_content;
-            str_content << content;
-            m_line[field] = str_content.str();
-        }
-
-        void putLine() {
-            if (!m_frozen) {
-                std::cout << "Warning: tried to output a non-frozen CSV." << std::endl;
-                return;
-            }
-
-            for (const auto& field: m_fields) {
-                m_file << m_line[field] << ",";
-            }
-
-            m_file << std::endl;
-
-            m_line.clear();
-        }
-
-    private:
-
-        bool m_frozen;
-        std::vector<std::string> m_fields;
-        std::map<std::string, std::string> m_line;
-        std::ofstream m_file;
-};
-
+#include "TSDBSpool.h"
+#include "OnlineAnalysis.h"
+#include "EventFilter.h"
+#include "CSV.h"
+#include "Decimation.h"
+#include "ConditionJournal.h"
+#include "LogSink.h"
+#include "ThreadUtils.h"
+#include "DAQClock.h"
 
 /*
  * LoggingManager: run by the background thread, manages all the logging: conditions (json), continuous (csv, root)
+ *
+ * Conditions are appended to the journal cond_journal_run_N.jsonl at each update,
+ * and compacted into cond_log_run_N.json at the end of the run.
+ *
+ * Continuous logging is multi-rate: the conditions are sampled every `sample_period` ms
+ * into an in-memory ring, and decimated into min/max/mean over 1 s (cont_log_run_N.csv)
+ * and 1 min (cont_log_1min_run_N.csv) intervals, which are written to CSV and OpenTSDB.
+ * Only values cached by the ConditionManager daemons are sampled, so that sampling does
+ * not add any VME access.
+ * The ring is dumped to ring_dump_run_N_K_REASON.csv around TDC fatal errors and
+ * backpressure episodes: half of the ring before the episode, half after.
+ *
+ * Each completed interval is first filled into a LogRecord while holding the hardware
+ * locks, then published to the sinks enabled by `sinks` (see LogSink.h), once they are released.
+ * The sinks are plugins, loaded by the first run which uses them: a run without the root sink
+ * neither loads nor initialises ROOT. The conditions go to CSV (csv) and OpenTSDB (tsdb), the
+ * TDC events to events_run_N.root (root) and events_run_N.evcol (columnar).
+ * Throws PluginLoader::plugin_error if the plugin of a sink cannot be loaded.
+ * OpenTSDB is fed from its own thread ("tsdb"), so that it does not delay the logger, through
+ * the spool owned by the RunController (no OpenTSDB logging if `tsdb_spool` is null).
+ * The TDC events are taken at each 1 s record and given to the online analysis (if `analysis`
+ * is not null), whose results are logged in the same record. They are then filtered (see
+ * EventFilter) before being published: the counts of the filter are logged in the record,
+ * its settings in the start record of the conditions log, and its final counts in the stop record.
  */
 class LoggingManager {
   public:
-      
-      using m_clock = std::chrono::system_clock;
 
-      LoggingManager(Interface& m_interface, std::uint32_t run_number, std::string log_path = "./", std::uint32_t m_continuous_log_time = 1000);
+      // Virtual in simulations (see VirtualTime)
+      using m_clock = DAQSystemClock;
+
+      LoggingManager(ConditionManager& m_conditions, std::uint32_t run_number, const Arguments& m_args, std::shared_ptr<TSDBSpool> tsdb_spool, std::shared_ptr<OnlineAnalysis> analysis);
       ~LoggingManager();
 
-      void run();
-      void stop();
-      
+      /*
+       * Sample the conditions: run every `sample_period` ms by the scheduler of the
+       * ConditionManager (on the logger thread) while the run is going on
+       */
+      void sample();
+
       /*
        * Update JSON logging with new values
        * Public: if interface changes something during a run, we have to update
        * LOCKS: HV, TDC
        */
-      void updateConditionManagerLog(bool first_time = false, m_clock::time_point log_time = m_clock::now());
+      void updateConditionManagerLog(m_clock::time_point log_time = m_clock::now());
 
       /* Static: to check if creating a LoggingManager with a certain run number would overwrite existing log files
        * Return: true if log files already exist
        */
       static bool checkRunNumber(std::uint32_t number, std::string log_path = "./");
-  
+
+      // Names of the threads whose CPU time is logged
+      static const std::vector<std::string> ThreadNames;
+
+      // Length (ms) of the intervals of the decimation tiers
+      static const std::uint64_t FastTierPeriod;
+      static const std::uint64_t SlowTierPeriod;
+
   private:
-        
+
+      /*
+       * Decimation tier, with the record it fills and the sinks it is published to
+       */
+      struct TierLog {
+          TierLog(const LogLayout& layout, std::uint64_t period);
+
+          LogLayout layout;
+          DecimationTier tier;
+          LogRecord record;
+          std::vector<std::shared_ptr<LogSink>> sinks;
+      };
+
       void initConditionManagerLog();
       void finalizeConditionManagerLog();
-      
+
       void initContinuousLog();
       /*
-       * Update CSV logging with new values
-       * LOCKS: HV, TDC, Scaler
+       * Sample the conditions into the ring and the decimation tiers, publish the tiers
+       * which completed an interval, and dump the ring if needed
+       * LOCKS: HV, TDC, Scaler, and those of fillRecord()
+       */
+      void sampleConditions(m_clock::time_point log_time, bool last_time = false);
+      /*
+       * Fill the record of a tier with its last completed interval. For the 1 s tier,
+       * also read the values not sampled at high rate (including the spool statistics), take
+       * the TDC events to be written, analyse and filter them (once the locks are released).
+       * LOCKS: TDC, TTC, HV, Scaler, Discri (lock statistics), spool, analysis if `read_values`
+       */
+      void fillRecord(TierLog& log, bool read_values);
+      /*
+       * Publish the record of a tier to its sinks. No hardware lock must be held.
+       */
+      void publishRecord(TierLog& log);
+      /*
+       * Write the content of the ring to disk
        */
-      void updateContinuousLog(m_clock::time_point log_time, bool last_time = false);
+      void dumpRing(std::string reason);
       void finalizeContinuousLog();
 
-      Interface& m_interface;
       ConditionManager& m_conditions;
-      std::atomic<bool> is_running;
 
       std::string m_log_path;
-      std::uint32_t m_continuous_log_time;
+      std::uint32_t m_sample_time;
+      std::size_t m_ring_length;
       std::uint32_t m_run_number;
-      std::shared_ptr<CSV> m_continuous_log;
-
-      std::shared_ptr<OpenTSDBInterface> m_DB;
-      std::vector<std::shared_ptr<TimeSeries>> m_timeSeries_HVPMT_setVal;
-      std::vector<std::shared_ptr<TimeSeries>> m_timeSeries_HVPMT_readVal;
-      std::shared_ptr<TimeSeries> m_timeSeries_TDC_interfaceEventBufferCounter;
-      std::shared_ptr<TimeSeries> m_timeSeries_TDC_FIFOEventBufferCounter;
-      std::shared_ptr<TimeSeries> m_timeSeries_TDC_eventCounter;
-      std::shared_ptr<TimeSeries> m_timeSeries_TDC_offset;
-      std::shared_ptr<TimeSeries> m_timeSeries_TTC_eventCounter;
-      std::map<ScalerChannel, std::shared_ptr<TimeSeries>> m_timeSeries_scaler;
-
-      Json::Value m_condition_json_root;
-      Json::Value m_condition_json_list;
-
-      TFile *m_root_file;
-      TTree *m_tree;
-      event m_tmp_event;
-      std::size_t m_TDC_eventBuffer_flushSize;
+      ThreadSettings m_tsdb_thread_settings;
+      std::set<std::string> m_sinks;
+
+      // Current sample of the channels sampled at high rate (same order as LogLayout::sampled)
+      std::vector<double> m_sample;
+      std::shared_ptr<SampleRing> m_ring;
+      std::shared_ptr<TierLog> m_fast_log;
+      std::shared_ptr<TierLog> m_slow_log;
+
+      // Ring dumps: pending dump, number of samples to wait before dumping, and what triggered it
+      bool m_dump_pending;
+      std::size_t m_dump_countdown;
+      std::string m_dump_reason;
+      std::size_t m_n_dumps;
+      bool m_last_TDC_fatal;
+      std::uint64_t m_last_TDC_backPressureEpisodes;
+
+      std::shared_ptr<TSDBSpool> m_tsdb_spool;
+      std::shared_ptr<OnlineAnalysis> m_analysis;
+      EventFilter m_event_filter;
+
+      std::shared_ptr<ConditionJournal> m_condition_journal;
 };
- 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Memory allocated by each subsystem of the program, to find what grows over long runs.
+ *
+ * The global operator new and delete of the executables are replaced (see MemoryTracker.cpp):
+ * each allocation is counted under the subsystem of the innermost MemoryScope of the thread
+ * which makes it (Other outside of any scope), and uncounted from the same subsystem when it
+ * is freed, by whichever thread. This includes the allocations of the plugins and of their
+ * libraries (e.g. the ROOT baskets). Memory allocated with malloc is only seen in the resident
+ * memory of the process.
+ *
+ * Cost: a few atomic additions per allocation and per free, and 16 bytes per allocation.
+ */
+class MemoryTracker {
+
+    public:
+
+        enum class Subsystem {
+            Other,
+            // TDC events: event pool, event buffer, hits
+            Events,
+            // Conditions log
+            JSON,
+            // Event trees and their baskets
+            ROOT,
+            // Datapoints queued for OpenTSDB, and its spool
+            TSDB
+        };
+        static const std::size_t NSubsystems = 5;
+        // Indexed by subsystem
+        static const char* const SubsystemNames[NSubsystems];
+
+        struct Usage {
+            // Bytes allocated and not freed yet
+            std::int64_t bytes;
+            // Allocations, and bytes allocated, since the start of the program
+            std::uint64_t allocations;
+            std::uint64_t allocated_bytes;
+        };
+
+        static Usage getUsage(Subsystem subsystem);
+        /*
+         * Sum over all the subsystems
+         */
+        static Usage getTotalUsage();
+
+        /*
+         * Resident memory of the process (bytes), from /proc/self/statm (0 if unknown)
+         */
+        static std::uint64_t getResidentBytes();
+};
+
+/*
+ * Count the allocations of the calling thread under `subsystem`, for as long as the object lives
+ */
+class MemoryScope {
+    public:
+        MemoryScope(MemoryTracker::Subsystem subsystem);
+        ~MemoryScope();
+
+        MemoryScope(const MemoryScope&) = delete;
+        MemoryScope& operator=(const MemoryScope&) = delete;
+
+    private:
+        MemoryTracker::Subsystem m_previous;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+#include "Event.h"
+#include "EventPool.h"
+
+/*
+ * Online timing analysis of the TDC events, run by the logger on the events of each 1 s record
+ * (once the hardware locks are released). The results are logged with the conditions (CSV,
+ * OpenTSDB) and shown by the interface.
+ *
+ * In each event, the time of the first leading hit on the reference channel (t0) is subtracted
+ * from the leading hits of the other channels: dt = t0 - time, as in TDCacqLoop.cpp. A hit is
+ * in coincidence with the reference if |dt| <= window. For each channel, over the interval:
+ * - occupancy: hits (any edge) per event
+ * - mean and RMS of dt
+ * - rate of hits in coincidence
+ * and the multiplicity: number of channels in coincidence in each event with a reference hit.
+ *
+ * The hits of the interval are packed channel by channel into flat arrays of dt, so that the
+ * statistics of a channel are branch-free reductions over contiguous integers, which the
+ * compiler vectorises.
+ */
+class OnlineAnalysis {
+    public:
+        // The channels in coincidence in an event are kept as a 64-bit mask
+        static const std::size_t MaxChannels = 64;
+
+        /*
+         * Results over one interval. Statistics of dt are NaN for channels without any hit.
+         */
+        struct Results {
+            Results(std::size_t n_channels = 0);
+
+            double getReferenceRate() const { return duration > 0 ? n_reference_events / duration : 0; }
+            double getMeanMultiplicity() const;
+
+            // End of the interval (ms since epoch), and its length (s)
+            std::uint64_t timestamp;
+            double duration;
+            std::uint64_t n_events;
+            // Events with a leading hit on the reference channel
+            std::uint64_t n_reference_events;
+
+            // One entry per channel
+            std::vector<double> occupancy;
+            std::vector<double> dt_mean;
+            std::vector<double> dt_rms;
+            std::vector<double> coincidence_rate;
+            // multiplicity[m]: number of events with a reference hit and m channels in coincidence
+            std::vector<std::uint64_t> multiplicity;
+        };
+
+        /*
+         * Channels from 0 to n_channels - 1 (at most MaxChannels) are analysed, window in TDC counts
+         */
+        OnlineAnalysis(int reference, std::size_t n_channels, std::int32_t window);
+
+        OnlineAnalysis(const OnlineAnalysis&) = delete;
+        OnlineAnalysis& operator=(const OnlineAnalysis&) = delete;
+
+        /*
+         * Analyse the events of the interval of `duration` seconds ending at `timestamp` (ms),
+         * and make the results available. Not reentrant: called by the logger only.
+         * LOCKS: analysis (only to publish the results)
+         */
+        void process(const std::vector<EventPool::Handle>& events, std::uint64_t timestamp, double duration);
+
+        /*
+         * Results of the last interval
+         * LOCKS: analysis
+         */
+        Results getResults();
+
+        /*
+         * Forget the results of the previous run
+         * LOCKS: analysis
+         */
+        void reset();
+
+        int getReference() const { return m_reference; }
+        std::size_t getNChannels() const { return m_n_channels; }
+        std::int32_t getWindow() const { return m_window; }
+
+    private:
+        /*
+         * Find the reference time of the events, and sort the relative times of their leading
+         * hits by channel into m_dt/m_dt_event (counting sort)
+         */
+        void pack(const std::vector<EventPool::Handle>& events);
+        /*
+         * Compute the statistics of each channel into m_work
+         */
+        void accumulate();
+
+        const int m_reference;
+        const std::size_t m_n_channels;
+        const std::int32_t m_window;
+
+        // Relative times in the order of the events, then packed by channel:
+        // [m_channel_begin[c], m_channel_begin[c + 1]) for channel c.
+        // Memory is kept from one interval to the next.
+        std::vector<std::uint8_t> m_flat_channel;
+        std::vector<std::int32_t> m_flat_dt;
+        std::vector<std::uint32_t> m_flat_event;
+        std::vector<std::size_t> m_channel_begin;
+        std::vector<std::int32_t> m_dt;
+        std::vector<std::uint32_t> m_dt_event;
+        // Per event: reference time (or -1 if none), channels in coincidence
+        std::vector<std::int64_t> m_event_t0;
+        std::vector<std::uint64_t> m_event_mask;
+        std::vector<std::uint64_t> m_n_hits;
+        std::vector<std::size_t> m_fill;
+
+        Results m_work;
+
+        std::mutex m_mtx;
+        Results m_results;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <map>
+#include <cstdint>
+
+#include "ThreadUtils.h"
+#include "DAQClock.h"
+
+/*
+ * Runs periodic tasks (the HV, TDC and scaler daemons, and the logger), each on its own thread
+ * so that their placement (CPUs, priority) and CPU time stay separate.
+ *
+ * Between two runs, a task waits on a condition variable for its next due time:
+ * - runs are scheduled on a monotonic clock, one period after the previous due time, so that
+ *   the period does not drift with the run time. A task late by more than a period does not
+ *   try to catch up.
+ * - cancel() wakes the task up at once: it only waits for the run in progress, if any.
+ * An idle task therefore costs one wakeup per period, and nothing once cancelled.
+ *
+ * In virtual time (see VirtualTime), tasks only run within advance(): one at a time, in the order
+ * of their due times (then of their scheduling), with the clock set to their due time. A task
+ * is therefore never late, and the same tasks always run in the same order.
+ */
+class PeriodicScheduler {
+
+    public:
+
+        using m_clock = DAQClock;
+
+        // 0 is never a valid task
+        typedef std::uint64_t TaskId;
+
+        PeriodicScheduler();
+        /*
+         * Cancel the tasks still scheduled
+         */
+        ~PeriodicScheduler();
+
+        PeriodicScheduler(const PeriodicScheduler&) = delete;
+        PeriodicScheduler& operator=(const PeriodicScheduler&) = delete;
+
+        /*
+         * Run `function` every `period`, starting one period from now, on a thread with `settings`.
+         * The task stops by itself when `function` returns false (it must still be cancelled).
+         * LOCKS: this
+         */
+        TaskId schedule(ThreadSettings settings, m_clock::duration period, std::function<bool()> function);
+
+        /*
+         * Stop a task: wait for its run in progress, if any. Can be called from the task itself.
+         * Return: false if there is no such task
+         * LOCKS: this
+         */
+        bool cancel(TaskId id);
+
+        /*
+         * Postpone the next run of a task to `delay` from now; the following runs are periodic
+         * from then. Meant to be called by the task itself, to wait for more work without polling.
+         * LOCKS: this
+         */
+        void delay(TaskId id, m_clock::duration delay);
+
+        /*
+         * Virtual time only (does nothing otherwise): run the tasks due up to `time`, then set
+         * the clock to `time`. Must not be called from a task.
+         * LOCKS: this
+         */
+        void advance(m_clock::time_point time);
+
+    private:
+
+        struct Task {
+            Task(m_clock::duration period, std::function<bool()> function);
+
+            std::mutex mtx;
+            std::condition_variable cv;
+            const m_clock::duration period;
+            const std::function<bool()> function;
+            // Protected by mtx, and in virtual time by the lock of the scheduler
+            m_clock::time_point next;
+            bool delayed;
+            bool cancelled;
+            bool finished;
+
+            std::thread thread;
+        };
+
+        static void run(Task& task);
+        void runVirtual(TaskId id, Task& task);
+        /*
+         * Virtual time: the next task to run within advance(), if any. Must be called with the lock held.
+         */
+        TaskId nextVirtualTask() const;
+
+        std::mutex m_mtx;
+        TaskId m_last_id;
+        std::map<TaskId, std::shared_ptr<Task>> m_tasks;
+
+        // Virtual time: tasks due up to m_virtual_limit may run, one at a time (m_virtual_busy)
+        std::condition_variable m_virtual_cv;
+        m_clock::time_point m_virtual_limit;
+        bool m_virtual_busy;
+};
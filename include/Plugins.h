@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <stdexcept>
+
+// Version of the interface between the program and its plugins: a plugin built for another version is refused
+#define SLOWCONTROL_PLUGIN_API 1
+
+/*
+ * Loader of the optional parts of the program, built as shared libraries (libSlowControlPlugin_NAME.so)
+ * and loaded with dlopen the first time they are needed, so that their dependencies (e.g. ROOT)
+ * are neither linked nor initialised by a run which does not use them.
+ *
+ * Each plugin defines `extern "C" int slowControlPluginAPI()`, returning SLOWCONTROL_PLUGIN_API, and
+ * its entry points (see LogSink.h and ReplaySetupManager.h). Plugins use the symbols of the program,
+ * which exports them.
+ *
+ * Libraries are looked for in the directory set with setDirectory() (by default, "plugins" next to
+ * the executable). They stay loaded until the program exits: the objects they created may be
+ * destroyed at any time before that.
+ *
+ * All public functions are thread-safe.
+ */
+class PluginLoader {
+
+    public:
+
+        class plugin_error: public std::runtime_error {
+            using std::runtime_error::runtime_error;
+        };
+
+        static PluginLoader& get();
+
+        /*
+         * Directory of the plugins. Empty: "plugins" next to the executable
+         * LOCKS: this
+         */
+        void setDirectory(std::string directory);
+
+        /*
+         * Address of `symbol` in plugin `plugin`, loaded if needed.
+         * Throws plugin_error if the plugin cannot be loaded, or does not define `symbol`.
+         * LOCKS: this
+         */
+        void* getSymbol(const std::string& plugin, const std::string& symbol);
+
+        /*
+         * Same, cast to a function pointer of type F
+         */
+        template<typename F>
+        F getFunction(const std::string& plugin, const std::string& symbol) {
+            return reinterpret_cast<F>(getSymbol(plugin, symbol));
+        }
+
+        /*
+         * Time spent loading plugins so far (dlopen, including the initialisation of their dependencies)
+         * LOCKS: this
+         */
+        std::chrono::microseconds getLoadTime();
+
+    private:
+
+        PluginLoader();
+        PluginLoader(const PluginLoader&) = delete;
+        PluginLoader& operator=(const PluginLoader&) = delete;
+
+        /*
+         * Load a plugin and check its version. Must be called with the lock held.
+         */
+        void* load(const std::string& plugin);
+
+        std::mutex m_mtx;
+        std::string m_directory;
+        std::map<std::string, void*> m_handles;
+        std::chrono::microseconds m_load_time;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <map>
+#include <utility>
+#include <cstdint>
+#include <ostream>
+
+/*
+ * Mutex wrapper recording, for each locking call site, how long threads waited
+ * to acquire the lock and how long they held it.
+ *
+ * Statistics are only modified while the wrapped mutex is held, so they do not
+ * need any additional protection. Reading them takes the lock.
+ *
+ * Holds and waits longer than the threshold are reported on std::cerr with the
+ * call site responsible (the owner, in the case of a long wait).
+ */
+class ProfiledMutex {
+
+    public:
+
+        using m_clock = std::chrono::steady_clock;
+
+        struct Stats {
+            Stats(): n_locks(0), n_long_holds(0), total_wait(0), max_wait(0), total_hold(0), max_hold(0) {}
+
+            void add(m_clock::duration wait, m_clock::duration hold, bool long_hold);
+
+            std::uint64_t n_locks;
+            std::uint64_t n_long_holds;
+            m_clock::duration total_wait;
+            m_clock::duration max_wait;
+            m_clock::duration total_hold;
+            m_clock::duration max_hold;
+        };
+
+        // Call site: function name and line number
+        typedef std::pair<const char*, int> Site;
+
+        ProfiledMutex(std::string name, std::chrono::microseconds threshold = std::chrono::milliseconds(50));
+
+        // Lockable interface: usable with std::lock_guard, but without call site information
+        void lock() { lock(Site("unknown", 0)); }
+        bool try_lock() { return try_lock(Site("unknown", 0)); }
+        void unlock();
+
+        void lock(Site site);
+        bool try_lock(Site site);
+
+        const std::string& getName() const { return m_name; }
+        void setThreshold(std::chrono::microseconds threshold) { m_threshold = threshold; }
+
+        /*
+         * Return the statistics accumulated since the last call, and reset them
+         * LOCKS: this
+         */
+        Stats popIntervalStats();
+
+        /*
+         * Return the statistics accumulated since construction, per call site
+         * LOCKS: this
+         */
+        std::map<std::string, Stats> getSiteStats();
+
+        /*
+         * Print a summary of the per-site statistics
+         * LOCKS: this
+         */
+        void printSummary(std::ostream& out);
+
+        static std::string siteToString(Site site);
+
+    private:
+
+        std::mutex m_mtx;
+        const std::string m_name;
+        std::chrono::microseconds m_threshold;
+
+        // Current owner, also read (without the lock) by waiting threads for reporting
+        std::atomic<const char*> m_owner_function;
+        std::atomic<int> m_owner_line;
+
+        // Only accessed while m_mtx is held
+        m_clock::time_point m_acquired;
+        m_clock::duration m_owner_wait;
+        Stats m_interval;
+        std::map<Site, Stats> m_sites;
+};
+
+/*
+ * RAII lock on a ProfiledMutex, recording the site where it was constructed
+ */
+class ProfiledLock {
+
+    public:
+
+        ProfiledLock(ProfiledMutex& mtx, const char* function = __builtin_FUNCTION(), int line = __builtin_LINE()):
+            m_mtx(mtx)
+        {
+            m_mtx.lock(ProfiledMutex::Site(function, line));
+        }
+        ~ProfiledLock() { m_mtx.unlock(); }
+
+        ProfiledLock(const ProfiledLock&) = delete;
+        ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+    private:
+
+        ProfiledMutex& m_mtx;
+};
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <vector>
+#include <functional>
 
 #include "SetupManager.h"
 
@@ -14,18 +15,20 @@
 #include "Event.h"
 #include "Scaler.h"
 
-class Interface;
+class ConditionManager;
 
 class RealSetupManager: public SetupManager {
     public:
 
-        RealSetupManager(Interface& m_interface);
+        RealSetupManager(ConditionManager& m_conditions);
         
         /*
          * Destructor: turn the HV off
          */
         virtual ~RealSetupManager() override;
 
+        // Each CAENET exchange is split into bus requests (send the command, poll the answer, read it),
+        // with the waits for the bridge and the crate in between, on the calling thread
         virtual bool setHVPMT(std::size_t id) override;
         virtual bool switchHVPMTON(std::size_t id) override;
         virtual bool switchHVPMTOFF(std::size_t id) override;
@@ -45,8 +48,9 @@ class RealSetupManager: public SetupManager {
         virtual void setTDCWindowWidth(int width) override;
         virtual unsigned int getTDCStatus() override;
         virtual int getTDCNEvents() override;
-        virtual event getTDCEvent() override;
+        virtual void getTDCEvent(event& e) override;
         virtual void configureTDC() override;
+        virtual void setTDCAlmostFullLevel(unsigned int words) override;
 
         // Scaler
         virtual void resetScaler() override;
@@ -54,12 +58,21 @@ class RealSetupManager: public SetupManager {
 
     private:
 
+        /*
+         * Wait `delay` (us), then run `step` as a request of its own on the bus
+         */
+        int runHVStep(unsigned int delay, std::function<int()> step);
+
         UsbController m_controller;
         hv m_hvpmt;
         discri m_discri;
         ttcVi m_TTC;
         tdc m_TDC;
         scaler m_scaler;
+
+        // Filled by hv::readResponse() (4 channels x 4 values), so that reading the HV does not allocate
+        double m_hv_values[4][4];
+        double* m_hv_rows[4];
         
-        Interface& m_interface;
+        ConditionManager& m_conditions;
 };
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+#include "SetupManager.h"
+#include "Event.h"
+#include "DAQClock.h"
+
+class ConditionManager;
+
+/*
+ * Sequential reader of the events of a file. ROOT files are read by the "root" plugin
+ * (see PluginLoader), which defines
+ * `extern "C" ReplaySource* slowControlCreateReplaySource(const std::string& fileName)`.
+ */
+class ReplaySource {
+    public:
+        virtual ~ReplaySource() {}
+
+        virtual std::uint64_t getNEvents() const = 0;
+        /*
+         * Read the next event into `e`
+         * Return: false at the end of the file
+         */
+        virtual bool next(event& e) = 0;
+        virtual void rewind() = 0;
+};
+
+/*
+ * Replay a recorded run through the SetupManager interface, to reproduce the load of a real
+ * run on the readout, the logger and the interface without the boards.
+ *
+ * The events are read from events_run_N.root or events_run_N.evcol. They are "triggered" at
+ * their recorded time (evenly spread over each recorded second, the resolution of event::time),
+ * `speed` times faster than recorded, or as fast as the readout takes them if `speed` is 0.
+ * Triggered events wait in a FIFO until read with getTDCEvent(). The replay starts when the
+ * trigger is started, pauses while it is stopped (e.g. backpressure when the FIFO is almost
+ * full), and starts over from the beginning of the file at configureTDC().
+ *
+ * The scaler counts and the HV values are taken from the 1 s conditions log of the same run
+ * (cont_log_run_N.csv next to the event file, or `conditions_file`), at the same replay time:
+ * the recorded scaler rates are integrated into counts. Without conditions log, the TTC scaler
+ * counts the triggered events and the other values are 0.
+ *
+ * All the methods may be called concurrently (they are called under different hardware locks).
+ * Throws std::ios_base::failure if the event file cannot be read.
+ */
+class ReplaySetupManager: public SetupManager {
+
+    public:
+
+        // Number of events in the FIFO above which it reports almost full
+        static const std::size_t AlmostFullLevel = 16384;
+
+        ReplaySetupManager(ConditionManager& m_conditions, std::string fileName, double speed, std::string conditions_file = "");
+
+        virtual ~ReplaySetupManager() override;
+
+        virtual bool setHVPMT(std::size_t id) override;
+        virtual bool switchHVPMTON(std::size_t id) override;
+        virtual bool switchHVPMTOFF(std::size_t id) override;
+        // Recorded read values
+        virtual std::vector< std::pair<double, double> > getHVPMTValue() override;
+
+        // Channel 7 pauses the replay, any other channel resumes it
+        virtual void setTrigger(int channel, int randomFrequency) override;
+        virtual void resetTrigger() override;
+        // Number of the last triggered event + 1, so that the readout sees the TDC and the TTC in sync
+        virtual std::int64_t getTTCEventNumber() override;
+
+        virtual bool propagateDiscriSettings() override;
+
+        virtual void setTDCWindowOffset(int offset) override;
+        virtual void setTDCWindowWidth(int width) override;
+        // Data ready and almost full bits, from the number of events in the FIFO
+        virtual unsigned int getTDCStatus() override;
+        // Exact number of events in the FIFO
+        virtual int getTDCNEvents() override;
+        // Next event of the FIFO (its memory is swapped with the one of `e`)
+        virtual void getTDCEvent(event& e) override;
+        // Rewind the replay
+        virtual void configureTDC() override;
+        // No effect: the replay reports almost full from AlmostFullLevel events
+        virtual void setTDCAlmostFullLevel(unsigned int words) override;
+
+        virtual void resetScaler() override;
+        virtual int getScalerCount(ScalerChannel channel) override;
+
+    private:
+
+        // Virtual in simulations (see VirtualTime)
+        using m_clock = DAQClock;
+
+        struct ReplayEvent {
+            event evt;
+            // Recorded time (ms) at which it is triggered
+            double trigger_time;
+        };
+
+        /*
+         * Back to the beginning of the file, trigger stopped
+         */
+        void rewind();
+        /*
+         * Read the events of the next recorded second
+         * Return: false at the end of the file
+         */
+        bool readSecond();
+        /*
+         * Advance the replay time and trigger the events up to it
+         */
+        void update();
+        /*
+         * Recorded scaler count of a channel, integrated up to the replay time (row `m_row`)
+         */
+        double getRecordedCount(ScalerChannel channel) const;
+
+        void loadConditions(std::string conditions_file);
+
+        ConditionManager& m_conditions;
+        double m_speed;
+
+        std::mutex m_mtx;
+        std::shared_ptr<ReplaySource> m_source;
+        // Next event of the file, not yet in m_events
+        event m_next;
+        bool m_has_next;
+        std::int64_t m_last_second;
+        bool m_end_reported;
+
+        // Events read from the file: the first m_n_triggered are in the FIFO
+        std::deque<ReplayEvent> m_events;
+        std::size_t m_n_triggered;
+        // Events triggered since the beginning of the file
+        std::uint64_t m_n_replayed;
+        std::int64_t m_ttc_number;
+
+        bool m_running;
+        // Replay time, in recorded ms since epoch
+        double m_replay_time;
+        m_clock::time_point m_last_update;
+
+        // Conditions log: timestamps (ms), and per row the integrated scaler counts and the HV read values
+        std::vector<double> m_cond_time;
+        std::vector<std::vector<double>> m_cond_counts;
+        std::vector<std::vector<double>> m_cond_hv;
+        // Last row at or before the replay time
+        std::size_t m_row;
+        std::vector<double> m_scaler_offset;
+};
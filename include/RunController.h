@@ -0,0 +1,186 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <functional>
+#include <utility>
+#include <stdexcept>
+#include <cstdint>
+
+#include "Utils.h"
+#include "PeriodicScheduler.h"
+
+class ConditionManager;
+class LoggingManager;
+class TSDBSpool;
+class OnlineAnalysis;
+
+/*
+ * RunController: owns the ConditionManager and the LoggingManager, and implements
+ * the run state machine (configure/start/stop).
+ * Also owns the OpenTSDB spool (if the tsdb sink is enabled), which lives across runs so that the datapoints of a run
+ * keep being replayed after it has stopped, and the online analysis of the TDC events.
+ *
+ * It does not depend on Qt: the graphical Interface and the control socket of the
+ * headless daemon are both clients of this class.
+ * Transitions are serialised, so that several clients can drive the same controller.
+ */
+class RunController {
+
+    public:
+
+        class run_control_error: public std::runtime_error {
+            using std::runtime_error::runtime_error;
+        };
+
+        RunController(const Arguments& m_args);
+
+        /*
+         * Destructor: stops the run if one is ongoing
+         */
+        ~RunController();
+
+        ConditionManager& getConditions() { return *m_conditions; }
+        const Arguments& getArguments() const { return m_args; }
+        // Null if disabled (negative reference channel)
+        std::shared_ptr<OnlineAnalysis> getAnalysis() { return m_analysis; }
+
+        /*
+         * Define states of the state machine.
+         * Possible transitions (defined in source file):
+         *  idle -> configured
+         *  configured -> running
+         *  running -> idle
+         *  configured -> idle
+         */
+        enum class State {
+            idle,
+            configured,
+            running
+        };
+
+        /*
+         * Get current state
+         */
+        State getState() const { return m_state; }
+
+        /*
+         * Get the run number of the current (or last) run
+         */
+        std::uint32_t getRunNumber() const { return m_run_number; }
+
+        /*
+         * Convert the state to a string
+         */
+        static std::string stateToString(State state);
+
+        /*
+         * Called after each change of state, from the thread of the client which made it,
+         * so that the other clients can follow. It must only post a notification. Null to remove it.
+         * LOCKS: listener
+         */
+        void setStateListener(std::function<void()> listener);
+
+        /*
+         * Check if transition from `state_from` to `state_to` is allowed
+         */
+        static bool checkTransition(State state_from, State state_to);
+
+        /*
+         * Return true if log files for run `run_number` already exist in the log directory
+         */
+        bool runFilesExist(std::uint32_t run_number) const;
+
+        /*
+         * Configure the run, change state to "configured":
+         * - propagate discriminator settings
+         * - reset the trigger and configure the TDC
+         * - create the LoggingManager
+         * Trigger channel and frequency must have been set in the ConditionManager before.
+         * Throws run_control_error if not idle.
+         * LOCKS: Discri, TTC, TDC, HV
+         */
+        void configureRun(std::uint32_t run_number);
+
+        /*
+         * Start the run, change state to "running":
+         * start logging, TDC reading, trigger and scaler daemon
+         * Throws run_control_error if not configured.
+         * LOCKS: TTC
+         */
+        void startRun();
+
+        /*
+         * Stop the run (if any), change state to "idle"
+         * LOCKS: TTC, TDC, HV
+         */
+        void stopRun();
+
+        /*
+         * Log the current conditions, if a run is configured or ongoing
+         * LOCKS: HV, Discri
+         */
+        void updateConditionLog();
+
+        /*
+         * Execute a text command (see `help` command) and return the answer.
+         * Answers start with "OK" or "ERROR".
+         * Used by the control socket.
+         */
+        std::string executeCommand(const std::string& command);
+
+        /*
+         * Called by requestQuit(), from the thread of the client, for an application which does
+         * not poll quitRequested(). It must only post the request. Null to remove it.
+         * LOCKS: listener
+         */
+        void setQuitHandler(std::function<void()> handler);
+
+        /*
+         * Ask the application to quit (from a client)
+         * LOCKS: listener
+         */
+        void requestQuit();
+        bool quitRequested() const { return m_quit; }
+
+    private:
+
+        /*
+         * Change state to `state`.
+         * Throws run_control_error if transition from current state is not allowed.
+         */
+        void setState(State state);
+
+        std::string statusString();
+
+        Arguments m_args;
+
+        std::shared_ptr<ConditionManager> m_conditions;
+        std::shared_ptr<LoggingManager> m_logging_manager;
+        // Null if the tsdb sink is disabled or the spool directory cannot be used: nothing is sent to OpenTSDB then
+        std::shared_ptr<TSDBSpool> m_tsdb_spool;
+        std::shared_ptr<OnlineAnalysis> m_analysis;
+        // Task sampling the conditions during the run, on the scheduler of the ConditionManager
+        PeriodicScheduler::TaskId m_logger_task;
+
+        // Transitions are defined in .cc file
+        static const std::vector< std::pair<State, State> > m_transitions;
+        std::atomic<State> m_state;
+        std::atomic<std::uint32_t> m_run_number;
+        std::atomic<bool> m_quit;
+
+        // Time (s) from the start of the process to the end of the constructor, and taken by the last configureRun()
+        double m_startup_time;
+        std::atomic<double> m_configure_time;
+
+        std::mutex m_listener_mtx;
+        std::function<void()> m_state_listener;
+        std::function<void()> m_quit_handler;
+
+        // Serialises transitions and access to the LoggingManager
+        std::mutex m_run_mtx;
+};
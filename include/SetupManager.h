@@ -11,6 +11,8 @@ class SetupManager {
     public:
         virtual ~SetupManager() {};
 
+        // The HV methods are called outside the bus thread (see BusScheduler), with the HV lock held:
+        // an exchange with the HV crate waits for its answers without holding the bus
         virtual bool setHVPMT(std::size_t id) = 0;
         virtual bool switchHVPMTON(std::size_t id) = 0;
         virtual bool switchHVPMTOFF(std::size_t id) = 0;
@@ -26,8 +28,11 @@ class SetupManager {
         virtual void setTDCWindowWidth(int width) = 0;
         virtual unsigned int getTDCStatus() = 0;
         virtual int getTDCNEvents() = 0;
-        virtual event getTDCEvent() = 0;
+        // Read the next event into `e` (cleared first, its memory is reused)
+        virtual void getTDCEvent(event& e) = 0;
         virtual void configureTDC() = 0;
+        // Number of words in the output buffer from which the TDC reports almost full
+        virtual void setTDCAlmostFullLevel(unsigned int words) = 0;
 
         virtual void resetScaler() = 0;
         virtual int getScalerCount(ScalerChannel channel) = 0;
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#include "ThreadUtils.h"
+
+typedef std::map<std::string, std::string> TSTags_t;
+
+/*
+ * Store-and-forward buffer for OpenTSDB datapoints.
+ *
+ * Datapoints are always appended to a local spool, then replayed in bulk to the
+ * /api/put HTTP endpoint of OpenTSDB by a background thread, whenever the server is
+ * reachable. Nothing is lost if the server is down, even for a whole run, or if the
+ * program is restarted: the spool is picked up where it was left.
+ *
+ * On disk (directory `directory`):
+ * - segment_SEQ.spool: append-only segments, one datapoint per line in the JSON
+ *   format of /api/put. A new segment is started once the current one is full.
+ * - checkpoint: segment and offset up to which datapoints have been replayed, updated
+ *   (atomically) after each successful batch. Fully replayed segments are removed.
+ * Disk usage is bounded by `max_bytes`: beyond that, the oldest segments are removed
+ * even if not replayed, and counted as dropped.
+ *
+ * All public functions are thread-safe.
+ */
+class TSDBSpool {
+
+    public:
+
+        struct Stats {
+            std::uint64_t spooled_points;
+            std::uint64_t replayed_points;
+            // Points refused by the server (malformed), skipped so that replay does not get stuck
+            std::uint64_t rejected_points;
+            std::uint64_t dropped_bytes;
+            std::uint64_t backlog_bytes;
+            // Points replayed per second, over the last few seconds
+            double replay_rate;
+            bool server_up;
+        };
+
+        /*
+         * Throws std::ios_base::failure if the spool directory cannot be used
+         */
+        TSDBSpool(std::string directory, std::string host, int port, std::uint64_t max_bytes, ThreadSettings settings);
+
+        /*
+         * Stops the replay: the remaining datapoints stay in the spool for the next start
+         */
+        ~TSDBSpool();
+
+        TSDBSpool(const TSDBSpool&) = delete;
+        TSDBSpool& operator=(const TSDBSpool&) = delete;
+
+        /*
+         * Append `n_points` datapoints, formatted with appendPoint()
+         * LOCKS: this
+         */
+        void append(const std::string& lines, std::size_t n_points);
+
+        /*
+         * LOCKS: this
+         */
+        Stats getStats();
+
+        /*
+         * Beginning of the line of a datapoint of time series `metric` with tags `tags`:
+         * computed once per time series
+         */
+        static std::string pointPrefix(std::string metric, const TSTags_t& tags);
+
+        /*
+         * Append the line of a datapoint to `lines`. Returns false (and does nothing) if
+         * `value` is not finite, since OpenTSDB does not accept it.
+         */
+        static bool appendPoint(std::string& lines, const std::string& prefix, std::uint64_t timestamp, double value);
+
+    private:
+
+        void run();
+
+        // The following are called with m_mtx held
+        std::string segmentName(std::uint64_t seq) const;
+        void openSegment(std::uint64_t seq);
+        void removeSegment(std::uint64_t seq);
+        void saveCheckpoint();
+        std::uint64_t backlogBytes() const;
+        void updateReplayRate();
+        /*
+         * Read the next datapoints to replay into a JSON array, and return the number of points.
+         * `end_offset` is set to the offset (in the checkpoint segment) following the last point.
+         */
+        std::size_t readBatch(std::string& body, std::uint64_t& end_offset);
+        /*
+         * Move the checkpoint to `end_offset`, and to the next segment if the current one is done
+         */
+        void advance(std::uint64_t end_offset);
+
+        const std::string m_directory;
+        const std::string m_host;
+        const int m_port;
+        const std::uint64_t m_max_bytes;
+        const std::uint64_t m_segment_size;
+
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+
+        // Size of each segment, by sequence number
+        std::map<std::uint64_t, std::uint64_t> m_segments;
+        std::uint64_t m_write_seq;
+        int m_write_fd;
+        std::uint64_t m_read_seq;
+        std::uint64_t m_read_offset;
+
+        Stats m_stats;
+        std::uint64_t m_last_replayed_points;
+        std::chrono::steady_clock::time_point m_last_stats_time;
+
+        std::atomic<bool> m_running;
+        std::thread m_thread;
+};
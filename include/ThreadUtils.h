@@ -0,0 +1,71 @@
+#pragma once
+
+#include <thread>
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+#include "Utils.h"
+
+/*
+ * Placement of a daemon thread, applied when the thread starts
+ */
+struct ThreadSettings {
+    ThreadSettings(std::string name = "", std::vector<int> cpus = {}, int rt_priority = 0):
+        name(name),
+        cpus(cpus),
+        rt_priority(rt_priority)
+    {}
+
+    // Thread name, as seen by `top -H` or `ps -L` (prefixed with "sc-", truncated to 15 characters)
+    std::string name;
+    // CPUs the thread may run on. Empty: all CPUs the process was started with
+    std::vector<int> cpus;
+    // If > 0, use real-time SCHED_FIFO scheduling with this priority (needs CAP_SYS_NICE)
+    int rt_priority;
+};
+
+/*
+ * Build the settings of thread `name` from the command line arguments
+ */
+ThreadSettings makeThreadSettings(const Arguments& m_args, std::string name);
+
+/*
+ * Time (in seconds) since the process was started, including the loading of its libraries
+ * before main(). Resolution: one clock tick (usually 10 ms). 0 if unknown.
+ */
+double getProcessAge();
+
+/*
+ * Apply settings to the calling thread, and account its CPU time under its name
+ * for as long as the object lives. Create one at the start of each daemon thread.
+ */
+class ThreadScope {
+    public:
+        ThreadScope(const ThreadSettings& settings);
+        ~ThreadScope();
+
+        ThreadScope(const ThreadScope&) = delete;
+        ThreadScope& operator=(const ThreadScope&) = delete;
+
+        /*
+         * CPU time (in seconds) used by each named thread since the start of the program,
+         * including threads which have finished
+         */
+        static std::map<std::string, double> getCPUTimes();
+
+    private:
+        std::string m_name;
+};
+
+/*
+ * Start a thread running `function` with the given settings
+ */
+template<typename F>
+std::thread startThread(ThreadSettings settings, F function) {
+    return std::thread([settings, function]() {
+                ThreadScope scope(settings);
+                function();
+            });
+}
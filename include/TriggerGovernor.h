@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "DAQClock.h"
+
+/*
+ * Closed-loop control of the trigger rate by the TDC daemon, so that the trigger stays at the
+ * capacity of the readout instead of being stopped and restarted at each poll.
+ *
+ * Two loops, each with hysteresis, are driven by the almost full status of the TDC (whose level
+ * is programmed at configureTDC()) and by the occupancy of its FIFO, smoothed over SmoothingTime:
+ * - inhibit: the trigger is stopped when the TDC is almost full, and restarted only once it is
+ *   no longer almost full, the FIFO is down to the low watermark, and it has been stopped for
+ *   MinInhibit at least;
+ * - throttle (random trigger only): the random frequency setting is stepped down (at most once per
+ *   StepDownInterval) after an inhibit, or while the smoothed occupancy is above the high watermark
+ *   and rising. It is stepped back up towards the requested setting once the smoothed occupancy
+ *   stayed below the low watermark, without any inhibit, for StepUpInterval. A step up followed by
+ *   a step down within StepUpInterval doubles the wait before the next step up (up to 16 times).
+ * The steps of the TTCvi random frequencies are coarse (see FakeSetupManager): the rate settles on
+ * the highest setting that the readout can take, or alternates slowly between two adjacent ones.
+ *
+ * Not thread-safe: updated by the TDC daemon with the TTC lock held, and read under the same lock.
+ */
+class TriggerGovernor {
+    public:
+
+        using m_clock = DAQClock;
+
+        static const m_clock::duration SmoothingTime;
+        static const m_clock::duration MinInhibit;
+        static const m_clock::duration StepDownInterval;
+        static const m_clock::duration StepUpInterval;
+
+        struct Stats {
+            // Times the trigger was inhibited, and for how long in total (s)
+            std::uint64_t n_inhibits;
+            double inhibit_time;
+            // Steps of the random frequency setting
+            std::uint64_t n_steps_down;
+            std::uint64_t n_steps_up;
+        };
+
+        /*
+         * Watermarks in events of the TDC FIFO. No throttle if `throttle` is false (inhibit only).
+         */
+        TriggerGovernor(std::size_t low_watermark, std::size_t high_watermark, bool throttle);
+
+        /*
+         * Back to the requested frequency, not inhibited, and the statistics to 0
+         */
+        void reset();
+
+        /*
+         * Take a new reading of the TDC: its almost full status, and the number of events in its FIFO.
+         * `requested` is the random frequency setting asked for, < 0 if the random trigger is not used.
+         * Return: whether the trigger must be set again (see isInhibited() and getFrequency())
+         */
+        bool update(m_clock::time_point now, bool almost_full, std::size_t fifo_events, int requested);
+
+        bool isInhibited() const { return m_inhibited; }
+        /*
+         * Random frequency setting to use, when `requested` is asked for
+         */
+        int getFrequency(int requested) const { return std::max(requested - m_throttle, 0); }
+        // Number of steps below the requested setting
+        int getThrottle() const { return m_throttle; }
+        double getSmoothedOccupancy() const { return m_occupancy; }
+        Stats getStats(m_clock::time_point now) const;
+
+    private:
+
+        std::size_t m_low_watermark;
+        std::size_t m_high_watermark;
+        bool m_throttle_enabled;
+
+        bool m_started;
+        m_clock::time_point m_last_update;
+        double m_occupancy;
+        double m_last_occupancy;
+
+        bool m_inhibited;
+        m_clock::time_point m_inhibit_start;
+        // Inhibit since the last step down, to step down once per inhibit episode at most
+        bool m_pressure;
+
+        int m_throttle;
+        m_clock::time_point m_last_step;
+        bool m_last_step_up;
+        m_clock::duration m_step_up_wait;
+        // Since when the smoothed occupancy is below the low watermark without inhibit
+        bool m_calm;
+        m_clock::time_point m_calm_start;
+
+        Stats m_stats;
+};
@@ -5,6 +5,8 @@
 #include <QSpinBox>
 #include <QGridLayout>
 
+#include "ConditionManager.h"
+
 class Interface;
 
 class Trigger_TDC_Group: public QGroupBox {
@@ -22,38 +24,43 @@ class Trigger_TDC_Group: public QGroupBox {
         
     private:
         /*
-         * Update the status flag (OK, back-pressure, fatal) and the counters
-         * LOCKS: TTC, TDC
+         * Update the status flag (OK, back-pressure, fatal) and the counters from `status`,
+         * changing only the labels of the values which changed
+         */
+        void notifyUpdate(const ConditionManager::Status& status);
+
+        /*
+         * Propagate trigger settings to ConditionManager, before configuring the run
+         * LOCKS: TTC
          */
-        void notifyUpdate();
+        void propagateTriggerSettings();
 
         /*
          * Called when the run is configured
-         * - propagate trigger settings to ConditionManager
-         * - configure the TDC
-         * LOCKS: TTC, TDC
+         * - freeze trigger configuration, showing the settings used for the run
+         * LOCKS: TTC
          */
         void atConfigureRun();
 
         /*
          * Called when the run is started
-         * - start TDC reading
-         * - start TTC
          * - Show the TDC label
-         * LOCKS: TTC, TDC
          */
         void atStartRun();
 
         /*
          * Called when the run is stopped
-         * - stop TDC reading
-         * - stop TTC
+         * - unfreeze trigger configuration
          * - Hide the TDC label
-         * LOCKS: TTC, TDC
          */
         void atStopRun();
+
         
         Interface& m_interface;
+
+        // Values currently displayed (not valid before the first update of a run)
+        ConditionManager::Status m_displayed;
+        bool m_displayed_valid;
         
         QGridLayout *m_status_layout;
         QSpinBox *m_triggerChannel_box;
@@ -5,8 +5,13 @@
 #include <ctime>
 #include <cstdint>
 #include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include <sstream>
 #include <chrono>
 #include <iostream>
+#include <algorithm>
 
 #include <json/json.h>
 
@@ -30,7 +35,40 @@ class Arguments {
     public:
         Arguments(int argc, char **argv):
             log_path("./"),
-            use_fake_setup(false)
+            use_fake_setup(false),
+            lock_threshold(50),
+            socket_path(""),
+            tdc_rt_priority(0),
+            sample_period(10),
+            ring_length(6000),
+            event_buffer_size(200000),
+            filter_empty(false),
+            filter_time_min(0),
+            filter_time_max(std::numeric_limits<unsigned int>::max()),
+            filter_prescale(1),
+            tdc_almost_full(4096),
+            governor_low(100),
+            governor_high(400),
+            trigger_throttle(true),
+            hv_period(100),
+            scaler_period(5000),
+            sinks({ "csv", "root", "tsdb" }),
+            plugin_path(""),
+            tsdb_host("localhost"),
+            tsdb_port(4242),
+            tsdb_spool_path(""),
+            tsdb_spool_size(512),
+            analysis_reference(22),
+            analysis_channels(32),
+            coincidence_window(200),
+            replay_file(""),
+            replay_speed(1),
+            replay_conditions(""),
+            driver_log(""),
+            log_rate_limit(20),
+            gui_refresh_period(250),
+            simulate_hours(0),
+            simulate_random(-1)
         {
             for (std::size_t i = 1; i < argc; i++)
                 parseArgument(argv[i]);
@@ -38,17 +76,226 @@ class Arguments {
 
         std::string log_path;
         bool use_fake_setup;
+        // Hold/wait time (ms) above which hardware lock usage is reported
+        std::uint32_t lock_threshold;
+        // Path of the control socket (empty: no socket, except for the headless daemon)
+        std::string socket_path;
+        // CPUs on which each daemon thread (hv, tdc, scaler, bus, logger, tsdb, tsdb-replay, gui, socket) may run
+        std::map<std::string, std::vector<int>> thread_cpus;
+        // SCHED_FIFO priority of the TDC readout thread (0: normal scheduling)
+        int tdc_rt_priority;
+        // Period (ms) at which the logger samples the conditions into its in-memory ring
+        std::uint32_t sample_period;
+        // Number of samples kept in the ring, dumped to disk around TDC errors and backpressure
+        std::size_t ring_length;
+        // TDC events read and not yet taken by the logger at most
+        std::size_t event_buffer_size;
+        // Filter of the events before they are written (see EventFilter): drop the events without hits,
+        // keep the hits on filter_channels only (empty: all) and within [filter_time_min, filter_time_max]
+        // (TDC counts), and one event of filter_prescale
+        bool filter_empty;
+        std::vector<int> filter_channels;
+        unsigned int filter_time_min;
+        unsigned int filter_time_max;
+        std::uint32_t filter_prescale;
+        // Almost full level of the TDC (words), from which the trigger is inhibited, and watermarks (events in the
+        // TDC FIFO) of the trigger governor (see TriggerGovernor), which may also throttle the random trigger
+        unsigned int tdc_almost_full;
+        std::size_t governor_low;
+        std::size_t governor_high;
+        bool trigger_throttle;
+        // Period (ms) at which the HV values and the scaler rates are read from the boards
+        std::uint32_t hv_period;
+        std::uint32_t scaler_period;
+        // Outputs of the runs (csv, root, columnar, tsdb), loaded as plugins from plugin_path
+        // (empty: "plugins" next to the executable) when a run first uses them
+        std::set<std::string> sinks;
+        std::string plugin_path;
+        // OpenTSDB server, and spool where datapoints are kept until it receives them
+        // (empty path: 'tsdb_spool' in the log directory, size in MB)
+        std::string tsdb_host;
+        int tsdb_port;
+        std::string tsdb_spool_path;
+        std::uint64_t tsdb_spool_size;
+        // Online analysis: reference channel (< 0: no analysis), number of channels analysed (and shown in the live histograms),
+        // and half-width of the coincidence window (TDC counts)
+        int analysis_reference;
+        std::size_t analysis_channels;
+        std::int32_t coincidence_window;
+        // Replay this recorded run instead of using the boards (empty: no replay), at replay_speed
+        // times the recorded pace (0: as fast as possible), with the scaler and HV values of replay_conditions
+        // (empty: cont_log_run_N.csv next to the event file)
+        std::string replay_file;
+        double replay_speed;
+        std::string replay_conditions;
+        // Write the messages of the drivers and daemons to this file as binary records (empty: console),
+        // and messages per second at most from each place in the code (0: no limit)
+        std::string driver_log;
+        unsigned int log_rate_limit;
+        // Time (ms) between two refreshes of the interface at least; it is only refreshed when something changed
+        std::uint32_t gui_refresh_period;
+        // Headless daemon only: simulate a run of simulate_hours in virtual time (0: no simulation, see VirtualTime),
+        // with the random trigger at frequency setting simulate_random (< 0: physics trigger)
+        double simulate_hours;
+        int simulate_random;
+
+        std::string getTSDBSpoolPath() const {
+            return tsdb_spool_path.empty() ? log_path + "/tsdb_spool" : tsdb_spool_path;
+        }
 
     private:
+        // Parse a list of CPUs or channels such as "1", "0,2" or "0-3"
+        static std::vector<int> parseList(std::string list) {
+            std::vector<int> cpus;
+            std::istringstream input(list);
+            std::string item;
+            while (std::getline(input, item, ',')) {
+                std::size_t dash = item.find('-');
+                if (dash == std::string::npos) {
+                    cpus.push_back(std::stoi(item));
+                } else {
+                    for (int cpu = std::stoi(item.substr(0, dash)); cpu <= std::stoi(item.substr(dash + 1)); cpu++)
+                        cpus.push_back(cpu);
+                }
+            }
+            return cpus;
+        }
+
         void parseArgument(std::string arg) {
+            std::string value;
+            std::size_t eq_pos = arg.find('=');
+            if (arg.compare(0, 2, "--") == 0 && eq_pos != std::string::npos) {
+                value = arg.substr(eq_pos + 1);
+                arg = arg.substr(0, eq_pos);
+            }
+
             if (arg == "-f" || arg == "--fake") {
                 std::cout << "Will use fake setup no matter what." << std::endl;
                 use_fake_setup = true;
                 return;
+            } else if (arg == "--lock-threshold") {
+                lock_threshold = std::stoul(value);
+                std::cout << "Will report hardware locks held or waited for more than " << lock_threshold << " ms." << std::endl;
+            } else if (arg == "--socket") {
+                socket_path = value;
+            } else if (arg.compare(0, 7, "--cpus-") == 0) {
+                thread_cpus[arg.substr(7)] = parseList(value);
+                std::cout << "Will run thread " << arg.substr(7) << " on CPUs " << value << std::endl;
+            } else if (arg == "--tdc-rt-priority") {
+                tdc_rt_priority = std::stoi(value);
+            } else if (arg == "--sample-period") {
+                sample_period = std::max(std::stoul(value), 1ul);
+            } else if (arg == "--ring-length") {
+                ring_length = std::max(std::stoul(value), 1ul);
+            } else if (arg == "--event-buffer") {
+                event_buffer_size = std::stoul(value);
+            } else if (arg == "--filter-empty") {
+                filter_empty = true;
+            } else if (arg == "--filter-channels") {
+                filter_channels = parseList(value);
+            } else if (arg == "--filter-window") {
+                std::size_t colon = value.find(':');
+                filter_time_min = std::stoul(value.substr(0, colon));
+                if (colon != std::string::npos)
+                    filter_time_max = std::stoul(value.substr(colon + 1));
+            } else if (arg == "--filter-prescale") {
+                filter_prescale = std::max(std::stoul(value), 1ul);
+            } else if (arg == "--tdc-almost-full") {
+                tdc_almost_full = std::min(std::max(std::stoul(value), 1ul), 32735ul);
+            } else if (arg == "--governor-watermarks") {
+                std::size_t colon = value.find(':');
+                governor_low = std::stoul(value.substr(0, colon));
+                if (colon != std::string::npos)
+                    governor_high = std::stoul(value.substr(colon + 1));
+                governor_high = std::max(governor_high, governor_low);
+            } else if (arg == "--no-trigger-throttle") {
+                trigger_throttle = false;
+            } else if (arg == "--hv-period") {
+                hv_period = std::max(std::stoul(value), 1ul);
+            } else if (arg == "--scaler-period") {
+                scaler_period = std::max(std::stoul(value), 1ul);
+            } else if (arg == "--sinks") {
+                sinks.clear();
+                std::istringstream input(value);
+                std::string sink;
+                while (std::getline(input, sink, ','))
+                    if (!sink.empty())
+                        sinks.insert(sink);
+            } else if (arg == "--columnar-events") {
+                sinks.insert("columnar");
+            } else if (arg == "--plugin-dir") {
+                plugin_path = value;
+            } else if (arg == "--tsdb") {
+                std::size_t colon = value.rfind(':');
+                tsdb_host = value.substr(0, colon);
+                if (colon != std::string::npos)
+                    tsdb_port = std::stoi(value.substr(colon + 1));
+            } else if (arg == "--tsdb-spool") {
+                tsdb_spool_path = value;
+            } else if (arg == "--tsdb-spool-size") {
+                tsdb_spool_size = std::max(std::stoull(value), 1ull);
+            } else if (arg == "--reference-channel") {
+                analysis_reference = std::stoi(value);
+            } else if (arg == "--analysis-channels") {
+                analysis_channels = std::min(std::max(std::stoul(value), 1ul), 64ul);
+            } else if (arg == "--coincidence-window") {
+                coincidence_window = std::max(std::stoi(value), 0);
+            } else if (arg == "--replay") {
+                replay_file = value;
+                std::cout << "Will replay the events of " << replay_file << " instead of using the setup." << std::endl;
+            } else if (arg == "--replay-speed") {
+                replay_speed = std::max(std::stod(value), 0.);
+            } else if (arg == "--replay-conditions") {
+                replay_conditions = value;
+            } else if (arg == "--driver-log") {
+                driver_log = value;
+            } else if (arg == "--log-rate-limit") {
+                log_rate_limit = std::stoul(value);
+            } else if (arg == "--gui-refresh") {
+                gui_refresh_period = std::stoul(value);
+            } else if (arg == "--simulate") {
+                simulate_hours = std::max(std::stod(value), 0.);
+                // The simulated setup, unless a run is replayed
+                use_fake_setup = true;
+            } else if (arg == "--simulate-random") {
+                simulate_random = std::stoi(value);
             } else if (arg == "-h" || arg == "--help") {
                 std::cout << "--- Slow control interface for test beam at Louvain ---\n\n";
                 std::cout << "List of available options:\n";
                 std::cout << " - '-f'/'--fake': Use fake setup even if real setup is connected (default false)\n";
+                std::cout << " - '--lock-threshold=MS': Report hardware locks held or waited for longer than MS milliseconds (default 50)\n";
+                std::cout << " - '--socket=PATH': Accept run control commands on Unix socket PATH (default: none for the interface, /tmp/SlowControlTBL.sock for the daemon)\n";
+                std::cout << " - '--cpus-THREAD=LIST': Run daemon thread THREAD (hv, tdc, scaler, bus, logger, tsdb, tsdb-replay, socket, gui) on CPUs LIST (e.g. 2 or 0,1 or 0-3)\n";
+                std::cout << " - '--tdc-rt-priority=N': Run the TDC readout and VME bus threads with SCHED_FIFO priority N (needs CAP_SYS_NICE, default 0 = normal)\n";
+                std::cout << " - '--sample-period=MS': Sample the conditions every MS milliseconds into the logger's ring (default 10)\n";
+                std::cout << " - '--ring-length=N': Keep the last N samples, dumped to disk around TDC errors and backpressure (default 6000)\n";
+                std::cout << " - '--event-buffer=N': Keep at most N TDC events waiting for the logger, beyond which they wait in the TDC (default 200000)\n";
+                std::cout << " - '--filter-empty': Do not write the TDC events without any hit (after the channel mask and the time window)\n";
+                std::cout << " - '--filter-channels=LIST': Write the hits of channels LIST only (e.g. 0,1,22 or 0-31, default: all)\n";
+                std::cout << " - '--filter-window=MIN:MAX': Write the hits between MIN and MAX TDC counts only (default: all)\n";
+                std::cout << " - '--filter-prescale=N': Write one TDC event of N, among those left by the other filters (default 1)\n";
+                std::cout << " - '--tdc-almost-full=WORDS': Inhibit the trigger when the TDC output buffer holds WORDS words (1-32735, default 4096)\n";
+                std::cout << " - '--governor-watermarks=LOW:HIGH': Release the inhibit below LOW events in the TDC, throttle the random trigger above HIGH (default 100:400)\n";
+                std::cout << " - '--no-trigger-throttle': Never lower the random trigger frequency, only inhibit the trigger when the TDC is almost full\n";
+                std::cout << " - '--hv-period=MS': Read the HV values every MS milliseconds (default 100)\n";
+                std::cout << " - '--scaler-period=MS': Read the scaler every MS milliseconds (default 5000)\n";
+                std::cout << " - '--sinks=LIST': Outputs of the runs, among csv (conditions), root (TDC events), columnar (TDC events in events_run_N.evcol) and tsdb (OpenTSDB), e.g. csv,root (default csv,root,tsdb)\n";
+                std::cout << " - '--columnar-events': Also write the TDC events to a columnar file events_run_N.evcol, for fast offline analysis (same as adding columnar to the sinks)\n";
+                std::cout << " - '--plugin-dir=DIR': Load the sinks from DIR (default: plugins next to the executable)\n";
+                std::cout << " - '--tsdb=HOST:PORT': Send the conditions to the OpenTSDB server at HOST:PORT (default localhost:4242)\n";
+                std::cout << " - '--tsdb-spool=DIR': Keep the datapoints not yet received by OpenTSDB in DIR (default: tsdb_spool in the log directory)\n";
+                std::cout << " - '--tsdb-spool-size=MB': Disk space used by the spool at most, the oldest datapoints are dropped beyond (default 512)\n";
+                std::cout << " - '--reference-channel=N': Reference channel of the online timing analysis, -1 to disable it (default 22)\n";
+                std::cout << " - '--analysis-channels=N': Analyse and display TDC channels 0 to N-1, at most 64 (default 32)\n";
+                std::cout << " - '--coincidence-window=COUNTS': Hits within COUNTS TDC counts of the reference are in coincidence (default 200)\n";
+                std::cout << " - '--replay=FILE': Replay the events of a recorded run (events_run_N.root or .evcol) instead of using the setup (default: none)\n";
+                std::cout << " - '--replay-speed=X': Replay X times faster than recorded, 0 for as fast as the readout goes (default 1)\n";
+                std::cout << " - '--replay-conditions=CSV': Replay the scaler and HV values of CSV (default: cont_log_run_N.csv next to the event file)\n";
+                std::cout << " - '--driver-log=FILE': Write the messages of the drivers and daemons to FILE as binary records instead of the console (default: console)\n";
+                std::cout << " - '--log-rate-limit=N': Let each driver or daemon message through at most N times per second, 0 for no limit (default 20)\n";
+                std::cout << " - '--gui-refresh=MS': Refresh the interface at most every MS milliseconds, when the daemons report changes (default 250)\n";
+                std::cout << " - '--simulate=HOURS': Daemon only: simulate a run of HOURS hours with the fake setup (or the replay) in virtual time, as fast as possible, then quit (default: none)\n";
+                std::cout << " - '--simulate-random=N': Use the random trigger at frequency setting N (0-7) in the simulation (default: physics trigger)\n";
                 std::cout << " - '-h'/'--help': Display this help\n";
                 std::cout << " - Unnamed argument: specify path to directory where log files will be stored (fault to current directory)\n\n";
             } else {
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+
+#include "ThreadUtils.h"
+
+/*
+ * Pool of worker threads with one task queue each.
+ *
+ * Tasks are spread over the queues when submitted. Each worker takes tasks from the back
+ * of its own queue, and once it is empty, steals from the front of the others: workers
+ * which got cheaper tasks help the others, without any central queue to contend on.
+ * Tasks get the index of the worker running them, e.g. to accumulate into per-worker
+ * results which are merged at the end without locking.
+ */
+class WorkStealingPool {
+    public:
+        typedef std::function<void(std::size_t worker)> Task;
+
+        /*
+         * Start `n_workers` threads (at least one), named after `settings`
+         */
+        WorkStealingPool(std::size_t n_workers, ThreadSettings settings);
+        /*
+         * Waits for the submitted tasks to complete
+         */
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        void submit(Task task);
+
+        /*
+         * Wait until all submitted tasks have completed
+         */
+        void wait();
+
+        std::size_t getNWorkers() const { return m_workers.size(); }
+        // Number of tasks run by another worker than the one they were submitted to
+        std::size_t getNStolen() const { return m_n_stolen; }
+
+    private:
+        struct Worker {
+            std::mutex mtx;
+            std::deque<Task> tasks;
+        };
+
+        void run(std::size_t index);
+        /*
+         * Take a task from the queue of worker `index`, or steal one
+         * LOCKS: queues
+         */
+        bool takeTask(std::size_t index, Task& task);
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread> m_threads;
+        std::atomic<std::size_t> m_next_worker;
+        std::atomic<std::size_t> m_n_queued;
+        std::atomic<std::size_t> m_n_stolen;
+
+        // Guards m_n_pending and m_stop, and the sleeping of idle workers
+        std::mutex m_mtx;
+        std::condition_variable m_work_cv;
+        std::condition_variable m_done_cv;
+        std::size_t m_n_pending;
+        bool m_stop;
+};
@@ -0,0 +1,164 @@
+#!/usr/bin/env python
+"""
+Read the columnar event files (.evcol) written by the slow control (--columnar-events)
+or by export_columnar, into numpy arrays. See include/ColumnarEvents.h for the format.
+
+    from columnar_events import ColumnarEventFile
+    f = ColumnarEventFile("events_run_42.evcol")
+    for columns in f.row_groups():
+        leading = columns["hit_leading"] == 1
+        ...
+
+Or from the command line, print a summary and the hit-time range of each channel:
+
+Usage: columnar_events.py events_run_N.evcol
+"""
+
+from __future__ import print_function
+
+import sys
+import struct
+
+import numpy as np
+
+MAGIC = b"SCEVCOL1"
+FOOTER_ENTRY = struct.Struct("<QQII")
+FOOTER_TAIL = struct.Struct("<IQ8s")
+ROW_GROUP_HEADER = struct.Struct("<IIII")
+COLUMN_HEADER = struct.Struct("<BBI")
+
+PLAIN, VARINT, DELTA, DICTIONARY, BIT_PACKED = range(5)
+
+# Name, dtype and number of rows ("events", "hits" or "tdc_errors") of each column id
+COLUMNS = {
+    0: ("event_number", np.uint32, "events"),
+    1: ("event_time", np.int64, "events"),
+    2: ("error_code", np.int32, "events"),
+    3: ("n_hits", np.uint32, "events"),
+    4: ("n_tdc_errors", np.uint32, "events"),
+    5: ("hit_event", np.uint64, "hits"),
+    6: ("hit_channel", np.uint8, "hits"),
+    7: ("hit_time", np.uint32, "hits"),
+    8: ("hit_leading", np.uint8, "hits"),
+    9: ("tdc_error", np.uint32, "tdc_errors"),
+}
+
+def _varints(data, n):
+    """Decode n LEB128 varints, return (values as uint64, number of bytes used)"""
+    if n == 0:
+        return np.zeros(0, dtype=np.uint64), 0
+    raw = np.frombuffer(data, dtype=np.uint8)
+    ends = np.flatnonzero(raw < 0x80)[:n]
+    if len(ends) < n:
+        raise ValueError("Truncated varint column")
+    n_bytes = int(ends[-1]) + 1
+    # Fast path: every value fits in one byte
+    if n_bytes == n:
+        return raw[:n].astype(np.uint64), n_bytes
+    starts = np.empty_like(ends)
+    starts[0] = 0
+    starts[1:] = ends[:-1] + 1
+    lengths = ends - starts + 1
+    values = np.zeros(n, dtype=np.uint64)
+    for k in range(int(lengths.max())):
+        mask = lengths > k
+        values[mask] |= (raw[starts[mask] + k] & 0x7F).astype(np.uint64) << np.uint64(7 * k)
+    return values, n_bytes
+
+def _unzigzag(values):
+    values = values.astype(np.uint64)
+    return (values >> np.uint64(1)).astype(np.int64) ^ -(values & np.uint64(1)).astype(np.int64)
+
+def _decode(data, encoding, n, dtype):
+    # Empty column: no payload (or an ignored dictionary size in older files)
+    if n == 0:
+        return np.zeros(0, dtype=dtype)
+    if encoding == PLAIN:
+        return np.frombuffer(data, dtype="<u4", count=n).astype(dtype)
+    if encoding == VARINT:
+        return _varints(data, n)[0].astype(dtype)
+    if encoding == DELTA:
+        return np.cumsum(_unzigzag(_varints(data, n)[0])).astype(dtype)
+    if encoding == DICTIONARY:
+        size = ord(data[0:1]) + 1
+        dictionary, used = _varints(data[1:], size)
+        indices = np.frombuffer(data, dtype=np.uint8, count=n, offset=1 + used)
+        return _unzigzag(dictionary).astype(dtype)[indices]
+    if encoding == BIT_PACKED:
+        bits = np.unpackbits(np.frombuffer(data, dtype=np.uint8), bitorder="little")
+        return bits[:n].astype(dtype)
+    raise ValueError("Unknown encoding %d" % encoding)
+
+class ColumnarEventFile(object):
+    def __init__(self, file_name):
+        self.file_name = file_name
+        with open(file_name, "rb") as f:
+            f.seek(0, 2)
+            size = f.tell()
+            f.seek(size - FOOTER_TAIL.size)
+            n_row_groups, footer_offset, magic = FOOTER_TAIL.unpack(f.read(FOOTER_TAIL.size))
+            if magic != MAGIC or footer_offset + n_row_groups * FOOTER_ENTRY.size + FOOTER_TAIL.size != size:
+                raise ValueError("%s is not a complete columnar event file" % file_name)
+            f.seek(footer_offset)
+            footer = f.read(n_row_groups * FOOTER_ENTRY.size)
+        self.groups = [FOOTER_ENTRY.unpack_from(footer, i * FOOTER_ENTRY.size) for i in range(n_row_groups)]
+        offsets = [group[0] for group in self.groups] + [footer_offset]
+        self.sizes = [offsets[i + 1] - offsets[i] for i in range(n_row_groups)]
+
+    @property
+    def n_events(self):
+        return sum(group[2] for group in self.groups)
+
+    @property
+    def n_hits(self):
+        return sum(group[3] for group in self.groups)
+
+    def read_row_group(self, index):
+        """Return a dict of numpy arrays (see COLUMNS), plus "first_event" """
+        offset, first_event = self.groups[index][0:2]
+        with open(self.file_name, "rb") as f:
+            f.seek(offset)
+            data = f.read(self.sizes[index])
+        n_rows = dict(zip(("events", "hits", "tdc_errors"), ROW_GROUP_HEADER.unpack_from(data, 0)))
+        n_columns = ROW_GROUP_HEADER.unpack_from(data, 0)[3]
+        pos = ROW_GROUP_HEADER.size
+        columns = {"first_event": first_event}
+        for _ in range(n_columns):
+            column, encoding, size = COLUMN_HEADER.unpack_from(data, pos)
+            pos += COLUMN_HEADER.size
+            if column in COLUMNS:
+                name, dtype, rows = COLUMNS[column]
+                columns[name] = _decode(data[pos:pos + size], encoding, n_rows[rows], dtype)
+            pos += size
+        return columns
+
+    def row_groups(self):
+        for index in range(len(self.groups)):
+            yield self.read_row_group(index)
+
+def main(argv):
+    if len(argv) != 1:
+        print(__doc__)
+        return 1
+    f = ColumnarEventFile(argv[0])
+    print("%d events, %d hits in %d row groups" % (f.n_events, f.n_hits, len(f.groups)))
+
+    counts = np.zeros(128, dtype=np.int64)
+    t_min = np.full(128, np.iinfo(np.int64).max)
+    t_max = np.full(128, -1)
+    n_errors = 0
+    for columns in f.row_groups():
+        channel = columns["hit_channel"].astype(np.intp)
+        time = columns["hit_time"].astype(np.int64)
+        counts += np.bincount(channel, minlength=128)
+        np.minimum.at(t_min, channel, time)
+        np.maximum.at(t_max, channel, time)
+        n_errors += np.count_nonzero(columns["error_code"])
+
+    print("%d events with an error code" % n_errors)
+    for channel in np.flatnonzero(counts):
+        print("Channel %3d: %10d hits, time %d to %d" % (channel, counts[channel], t_min[channel], t_max[channel]))
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
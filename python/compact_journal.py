@@ -0,0 +1,49 @@
+#!/usr/bin/env python
+"""
+Rebuild the condition log of a run from its conditions journal, e.g. after a crash
+(the journal is compacted automatically at the end of a normal run).
+
+Usage: compact_journal.py cond_journal_run_N.jsonl [cond_log_run_N.json]
+"""
+
+import sys
+import json
+
+def compact(journal_name):
+    root = {}
+    conditions = []
+    with open(journal_name) as journal:
+        for line_number, line in enumerate(journal, 1):
+            if not line.strip():
+                continue
+            try:
+                record = json.loads(line)
+            except ValueError:
+                # The last line may be truncated if the program crashed while writing it
+                sys.stderr.write("Warning: skipping corrupt record at line %d\n" % line_number)
+                continue
+            record_type = record.pop("record", None)
+            if record_type == "conditions":
+                conditions.append(record)
+            else:
+                root.update(record)
+    root["conditions"] = conditions
+    root["conditions_changed"] = len(conditions) > 1
+    return root
+
+def main(argv):
+    if len(argv) not in (1, 2):
+        print(__doc__)
+        return 1
+    journal_name = argv[0]
+    if len(argv) == 2:
+        output_name = argv[1]
+    else:
+        output_name = journal_name.replace("cond_journal_", "cond_log_").replace(".jsonl", ".json")
+    with open(output_name, "w") as output:
+        json.dump(compact(journal_name), output, indent=3, sort_keys=True)
+    print("Wrote " + output_name)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
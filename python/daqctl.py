@@ -0,0 +1,52 @@
+#!/usr/bin/env python
+"""
+Send commands to the slow control through its control socket.
+
+Usage: daqctl.py [-s SOCKET] COMMAND [ARGS...]
+   or: daqctl.py [-s SOCKET]   (read one command per line on stdin, e.g. to script a campaign)
+
+Run 'daqctl.py help' for the list of commands.
+"""
+
+import sys
+import socket
+
+DEFAULT_SOCKET = "/tmp/SlowControlTBL.sock"
+
+def send_command(sock, command):
+    sock.sendall((command.strip() + "\n").encode())
+    answer = b""
+    while not answer.endswith(b"\n"):
+        chunk = sock.recv(4096)
+        if not chunk:
+            break
+        answer += chunk
+    return answer.decode().strip()
+
+def main(argv):
+    path = DEFAULT_SOCKET
+    if len(argv) > 1 and argv[0] == "-s":
+        path = argv[1]
+        argv = argv[2:]
+
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    sock.connect(path)
+
+    if argv:
+        commands = [" ".join(argv)]
+    else:
+        commands = (line for line in sys.stdin if line.strip() and not line.startswith("#"))
+
+    status = 0
+    for command in commands:
+        answer = send_command(sock, command)
+        print(answer)
+        if not answer.startswith("OK"):
+            status = 1
+            break
+
+    sock.close()
+    return status
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
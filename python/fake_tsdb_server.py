@@ -0,0 +1,111 @@
+#!/usr/bin/env python
+"""
+Stand-in for the HTTP API of OpenTSDB, to try the spool of datapoints without HBase.
+
+Accepts POST /api/put and counts the datapoints received. Send SIGUSR1 to switch it
+between up and down: when down, requests are answered with 503, as OpenTSDB does when
+HBase is unreachable.
+
+Usage: fake_tsdb_server.py [--port=4242] [--down] [--verbose]
+"""
+
+import sys
+import json
+import signal
+import threading
+
+try:
+    from BaseHTTPServer import HTTPServer, BaseHTTPRequestHandler
+except ImportError:
+    from http.server import HTTPServer, BaseHTTPRequestHandler
+
+class State(object):
+    def __init__(self, up, verbose):
+        self.up = up
+        self.verbose = verbose
+        self.n_points = 0
+        self.n_requests = 0
+        self.lock = threading.Lock()
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def reply(self, status, body=""):
+        body = body.encode("utf-8")
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        body = self.rfile.read(length)
+        state = self.server.state
+
+        if not state.up:
+            self.reply(503, '{"error":{"code":503,"message":"fake server is down"}}')
+            return
+        if self.path.split("?")[0] != "/api/put":
+            self.reply(404)
+            return
+
+        try:
+            points = json.loads(body.decode("utf-8"))
+        except ValueError:
+            self.reply(400, '{"error":{"code":400,"message":"invalid JSON"}}')
+            return
+        if isinstance(points, dict):
+            points = [points]
+        for point in points:
+            if not all(key in point for key in ("metric", "timestamp", "value", "tags")) or not point["tags"]:
+                self.reply(400, '{"error":{"code":400,"message":"invalid datapoint"}}')
+                return
+
+        with state.lock:
+            state.n_points += len(points)
+            state.n_requests += 1
+            n_points = state.n_points
+        if state.verbose:
+            sys.stdout.write("Received %d datapoints (total %d)\n" % (len(points), n_points))
+            sys.stdout.flush()
+        self.reply(204)
+
+    def log_message(self, format, *args):
+        pass
+
+def main(argv):
+    port = 4242
+    up = True
+    verbose = False
+    for arg in argv:
+        if arg.startswith("--port="):
+            port = int(arg.split("=", 1)[1])
+        elif arg == "--down":
+            up = False
+        elif arg == "--verbose":
+            verbose = True
+        else:
+            print(__doc__)
+            return 1
+
+    server = HTTPServer(("", port), Handler)
+    server.state = State(up, verbose)
+
+    def toggle(signum, frame):
+        server.state.up = not server.state.up
+        sys.stdout.write("Fake OpenTSDB is now %s (%d datapoints received)\n" % ("up" if server.state.up else "down", server.state.n_points))
+        sys.stdout.flush()
+    signal.signal(signal.SIGUSR1, toggle)
+
+    sys.stdout.write("Fake OpenTSDB listening on port %d, %s\n" % (port, "up" if up else "down"))
+    sys.stdout.flush()
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    sys.stdout.write("%d datapoints received in %d requests\n" % (server.state.n_points, server.state.n_requests))
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
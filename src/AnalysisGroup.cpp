@@ -0,0 +1,86 @@
+#include <QString>
+#include <QStringList>
+#include <QGroupBox>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QTableWidget>
+#include <QTableWidgetItem>
+#include <QHeaderView>
+
+#include <cmath>
+
+#include "AnalysisGroup.h"
+#include "Interface.h"
+#include "OnlineAnalysis.h"
+
+AnalysisGroup::AnalysisGroup(Interface& m_interface, std::shared_ptr<OnlineAnalysis> analysis):
+    m_interface(m_interface),
+    m_analysis(analysis),
+    m_displayed_timestamp(0),
+    QGroupBox("Online analysis", &m_interface) {
+
+        QVBoxLayout *analysis_layout = new QVBoxLayout();
+
+        m_reference_label = new QLabel();
+        analysis_layout->addWidget(m_reference_label);
+        m_multiplicity_label = new QLabel();
+        m_multiplicity_label->setWordWrap(true);
+        analysis_layout->addWidget(m_multiplicity_label);
+
+        /* -- One row per channel -- */
+        m_table = new QTableWidget(m_analysis->getNChannels(), 4);
+        m_table->setHorizontalHeaderLabels(QStringList() << "Occupancy" << "dt mean" << "dt RMS" << "Coinc. (Hz)");
+        QStringList channels;
+        for (std::size_t channel = 0; channel < m_analysis->getNChannels(); channel++) {
+            channels << ("Ch " + QString::number(channel) + (static_cast<int>(channel) == m_analysis->getReference() ? " (ref)" : ""));
+            for (int column = 0; column < 4; column++) {
+                QTableWidgetItem *item = new QTableWidgetItem();
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                m_table->setItem(channel, column, item);
+            }
+        }
+        m_table->setVerticalHeaderLabels(channels);
+        m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        analysis_layout->addWidget(m_table);
+
+        setLayout(analysis_layout);
+        atStopRun();
+}
+
+void AnalysisGroup::notifyUpdate() {
+    OnlineAnalysis::Results results = m_analysis->getResults();
+    if (results.timestamp == m_displayed_timestamp)
+        return;
+    m_displayed_timestamp = results.timestamp;
+
+    m_reference_label->setText("Events with reference (ch " + QString::number(m_analysis->getReference()) + "): "
+            + QString::number(results.getReferenceRate(), 'f', 1) + " Hz, window +-" + QString::number(m_analysis->getWindow()));
+
+    // Multiplicity histogram, up to the highest non-empty bin
+    QString multiplicity = "Channels in coincidence: mean " + QString::number(results.getMeanMultiplicity(), 'f', 2);
+    std::size_t last = results.multiplicity.size();
+    while (last > 0 && results.multiplicity[last - 1] == 0)
+        last--;
+    for (std::size_t m = 0; m < last; m++)
+        multiplicity += (m == 0 ? " (" : ", ") + QString::number(m) + ": " + QString::number(results.multiplicity[m]);
+    if (last > 0)
+        multiplicity += ")";
+    m_multiplicity_label->setText(multiplicity);
+
+    for (std::size_t channel = 0; channel < m_analysis->getNChannels(); channel++) {
+        m_table->item(channel, 0)->setText(QString::number(results.occupancy[channel], 'f', 3));
+        m_table->item(channel, 1)->setText(std::isnan(results.dt_mean[channel]) ? "-" : QString::number(results.dt_mean[channel], 'f', 1));
+        m_table->item(channel, 2)->setText(std::isnan(results.dt_rms[channel]) ? "-" : QString::number(results.dt_rms[channel], 'f', 1));
+        m_table->item(channel, 3)->setText(QString::number(results.coincidence_rate[channel], 'f', 1));
+    }
+}
+
+void AnalysisGroup::atStopRun() {
+    m_displayed_timestamp = 0;
+    m_reference_label->setText("Events with reference (ch " + QString::number(m_analysis->getReference()) + "): -");
+    m_multiplicity_label->setText("Channels in coincidence: -");
+    for (std::size_t channel = 0; channel < m_analysis->getNChannels(); channel++)
+        for (int column = 0; column < 4; column++)
+            m_table->item(channel, column)->setText("-");
+}
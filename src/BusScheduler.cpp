@@ -0,0 +1,135 @@
+#include <iomanip>
+
+#include "BusScheduler.h"
+
+namespace {
+    double toMs(BusScheduler::m_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d).count() / 1000.;
+    }
+}
+
+// Static
+const std::vector<std::string> BusScheduler::PriorityNames = { "readout", "trigger", "scaler", "hv", "control" };
+const std::vector<std::chrono::milliseconds> BusScheduler::MaxWait = {
+    std::chrono::milliseconds(0),
+    std::chrono::milliseconds(5),
+    std::chrono::milliseconds(50),
+    std::chrono::milliseconds(100),
+    std::chrono::milliseconds(200)
+};
+
+void BusScheduler::Stats::add(m_clock::duration wait, m_clock::duration run) {
+    n_requests++;
+    total_wait += wait;
+    total_run += run;
+    if (wait > max_wait)
+        max_wait = wait;
+    if (run > max_run)
+        max_run = run;
+}
+
+BusScheduler::BusScheduler(ThreadSettings settings):
+    m_stop(false),
+    m_n_queued(0),
+    m_queues(NPriorities),
+    m_interval(NPriorities),
+    m_total(NPriorities)
+{
+    m_thread = startThread(settings, [this]() { run(); });
+}
+
+BusScheduler::~BusScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+void BusScheduler::submit(Priority priority, std::function<void()> function) {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_queues[static_cast<std::size_t>(priority)].push_back({ std::move(function), m_clock::now() });
+        m_n_queued++;
+    }
+    m_cv.notify_one();
+}
+
+std::size_t BusScheduler::pickClass(m_clock::time_point now) const {
+    std::size_t highest = NPriorities;
+    std::size_t overdue = NPriorities;
+    m_clock::duration longest_wait(0);
+
+    for (std::size_t cls = 0; cls < NPriorities; cls++) {
+        if (m_queues[cls].empty())
+            continue;
+        if (highest == NPriorities)
+            highest = cls;
+
+        m_clock::duration wait = now - m_queues[cls].front().submitted;
+        if (MaxWait[cls].count() > 0 && wait > MaxWait[cls] && wait > longest_wait) {
+            overdue = cls;
+            longest_wait = wait;
+        }
+    }
+
+    return (overdue != NPriorities) ? overdue : highest;
+}
+
+void BusScheduler::run() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+
+    while (true) {
+        m_cv.wait(lock, [this]() { return m_stop || m_n_queued > 0; });
+        if (m_n_queued == 0)
+            // Stopping, and everything was drained
+            break;
+
+        m_clock::time_point start = m_clock::now();
+        std::size_t cls = pickClass(start);
+        Request request = std::move(m_queues[cls].front());
+        m_queues[cls].pop_front();
+        m_n_queued--;
+
+        lock.unlock();
+        request.function();
+        m_clock::time_point stop = m_clock::now();
+        lock.lock();
+
+        m_interval[cls].add(start - request.submitted, stop - start);
+        m_total[cls].add(start - request.submitted, stop - start);
+    }
+}
+
+std::vector<BusScheduler::Stats> BusScheduler::popIntervalStats() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    std::vector<Stats> stats(NPriorities);
+    std::swap(stats, m_interval);
+
+    return stats;
+}
+
+void BusScheduler::printSummary(std::ostream& out) {
+    std::vector<Stats> stats;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        stats = m_total;
+    }
+
+    out << "VME bus:" << std::endl;
+    std::size_t longest = NPriorities;
+    for (std::size_t cls = 0; cls < NPriorities; cls++) {
+        if (stats[cls].n_requests == 0)
+            continue;
+        out << "  " << std::left << std::setw(10) << PriorityNames[cls] << std::right
+            << " n=" << stats[cls].n_requests
+            << " wait avg/max=" << toMs(stats[cls].total_wait) / stats[cls].n_requests << "/" << toMs(stats[cls].max_wait) << " ms"
+            << " run avg/max=" << toMs(stats[cls].total_run) / stats[cls].n_requests << "/" << toMs(stats[cls].max_run) << " ms" << std::endl;
+        if (cls != static_cast<std::size_t>(Priority::Readout) && (longest == NPriorities || stats[cls].max_run > stats[longest].max_run))
+            longest = cls;
+    }
+    if (longest != NPriorities)
+        out << "  longest request ahead of the readout: " << toMs(stats[longest].max_run) << " ms (" << PriorityNames[longest] << ")" << std::endl;
+}
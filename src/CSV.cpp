@@ -0,0 +1,126 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "CSV.h"
+
+CSV::CSV(std::string fileName, std::size_t flush_lines, std::chrono::milliseconds flush_interval):
+    m_frozen(false),
+    m_flush_lines(flush_lines),
+    m_flush_interval(flush_interval),
+    m_lines_since_flush(0),
+    m_last_flush(m_clock::now())
+{
+    m_file.open(fileName);
+    if (!m_file.is_open())
+        throw std::ios_base::failure("Could not open file " + fileName);
+}
+
+CSV::~CSV() {
+    m_file.flush();
+    m_file.close();
+}
+
+CSV::Field CSV::addField(const std::string& field) {
+    auto it = std::find(m_fields.begin(), m_fields.end(), field);
+    if (it != m_fields.end()) {
+        std::cout << "Warning: tried to add already present field " << field << " in CSV." << std::endl;
+        return it - m_fields.begin();
+    }
+
+    if (m_frozen) {
+        std::cout << "Warning: tried to add field to frozen CSV." << std::endl;
+        return m_fields.size();
+    }
+
+    m_fields.push_back(field);
+    return m_fields.size() - 1;
+}
+
+void CSV::freeze() {
+    m_frozen = true;
+
+    m_values.assign(m_fields.size() * ValueSize, 0);
+    m_lengths.assign(m_fields.size(), 0);
+    // Every value plus its separator fits in the line without reallocation
+    m_line.reserve(m_fields.size() * (ValueSize + 1) + 1);
+
+    for (const auto& field: m_fields) {
+        m_file << field << ",";
+    }
+    m_file << "\n";
+    m_file.flush();
+}
+
+bool CSV::checkField(Field field) {
+    if (!m_frozen) {
+        std::cout << "Warning: tried to set field in a non-frozen CSV." << std::endl;
+        return false;
+    }
+
+    if (field >= m_fields.size()) {
+        std::cout << "Warning: field " << field << " does not exist." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void CSV::formatSigned(Field field, std::int64_t content) {
+    // Negate in unsigned arithmetic, to handle the most negative value
+    formatUnsigned(field, ~static_cast<std::uint64_t>(content) + 1, true);
+}
+
+void CSV::formatUnsigned(Field field, std::uint64_t content, bool negative) {
+    char digits[ValueSize];
+    std::size_t n_digits = 0;
+    do {
+        digits[n_digits++] = '0' + content % 10;
+        content /= 10;
+    } while (content);
+
+    char* value = &m_values[field * ValueSize];
+    std::size_t length = 0;
+    if (negative)
+        value[length++] = '-';
+    while (n_digits)
+        value[length++] = digits[--n_digits];
+
+    m_lengths[field] = length;
+}
+
+void CSV::formatDouble(Field field, double content) {
+    // Same representation as the default std::ostream formatting
+    int length = std::snprintf(&m_values[field * ValueSize], ValueSize, "%g", content);
+    m_lengths[field] = length > 0 ? std::min<std::size_t>(length, ValueSize - 1) : 0;
+}
+
+void CSV::putLine() {
+    if (!m_frozen) {
+        std::cout << "Warning: tried to output a non-frozen CSV." << std::endl;
+        return;
+    }
+
+    m_line.clear();
+    for (std::size_t field = 0; field < m_fields.size(); field++) {
+        m_line.append(&m_values[field * ValueSize], m_lengths[field]);
+        m_line.push_back(',');
+    }
+    m_line.push_back('\n');
+
+    m_file.write(m_line.data(), m_line.size());
+
+    std::fill(m_lengths.begin(), m_lengths.end(), 0);
+
+    m_lines_since_flush++;
+    if ((m_flush_lines && m_lines_since_flush >= m_flush_lines) ||
+        (m_flush_interval.count() && m_clock::now() - m_last_flush >= m_flush_interval))
+        flush();
+}
+
+void CSV::flush() {
+    m_file.flush();
+    m_lines_since_flush = 0;
+    m_last_flush = m_clock::now();
+}
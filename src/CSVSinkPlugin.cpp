@@ -0,0 +1,68 @@
+#include "LogSink.h"
+#include "Plugins.h"
+#include "CSV.h"
+
+/*
+ * Plugin "csv": write the conditions to a CSV file (see LogSink.h)
+ */
+
+namespace {
+
+class CSVSink: public LogSink {
+    public:
+        CSVSink(std::string fileName, const LogLayout& layout);
+        virtual ~CSVSink() override {};
+
+        virtual void write(const LogRecord& record) override;
+
+    private:
+        CSV m_csv;
+        CSV::Field m_timestamp;
+        CSV::Field m_n_samples;
+        std::vector<CSV::Field> m_mean;
+        std::vector<CSV::Field> m_min;
+        std::vector<CSV::Field> m_max;
+        std::vector<CSV::Field> m_values;
+};
+
+CSVSink::CSVSink(std::string fileName, const LogLayout& layout):
+    // Flushed every 10 lines, or after 1 s at most: the file stays readable while the run is ongoing
+    m_csv(fileName, 10, std::chrono::milliseconds(1000))
+{
+    m_timestamp = m_csv.addField("timestamp");
+    m_n_samples = m_csv.addField("n_samples");
+    for (const auto& channel: layout.sampled) {
+        m_mean.push_back(m_csv.addField(channel.name));
+        m_min.push_back(m_csv.addField(channel.name + "_min"));
+        m_max.push_back(m_csv.addField(channel.name + "_max"));
+    }
+    for (const auto& channel: layout.values)
+        m_values.push_back(m_csv.addField(channel.name));
+
+    m_csv.freeze();
+}
+
+void CSVSink::write(const LogRecord& record) {
+    m_csv.setField(m_timestamp, record.timestamp);
+    m_csv.setField(m_n_samples, record.n_samples);
+
+    for (std::size_t ch = 0; ch < m_mean.size(); ch++) {
+        m_csv.setField(m_mean[ch], record.mean[ch]);
+        m_csv.setField(m_min[ch], record.min[ch]);
+        m_csv.setField(m_max[ch], record.max[ch]);
+    }
+    for (std::size_t ch = 0; ch < m_values.size(); ch++)
+        m_csv.setField(m_values[ch], record.values[ch]);
+
+    m_csv.putLine();
+}
+
+}
+
+extern "C" int slowControlPluginAPI() {
+    return SLOWCONTROL_PLUGIN_API;
+}
+
+extern "C" LogSink* slowControlCreateSink(const SinkContext& context) {
+    return new CSVSink(context.file_name, *context.layout);
+}
@@ -0,0 +1,518 @@
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "ColumnarEvents.h"
+
+namespace {
+
+    const char Magic[] = "SCEVCOL1";
+    const std::size_t MagicSize = 8;
+    const std::size_t FooterEntrySize = 24;
+    // Number of row groups, offset of the footer, magic
+    const std::size_t FooterTailSize = 4 + 8 + MagicSize;
+
+    enum Column: std::uint8_t {
+        EventNumber = 0,
+        EventTime = 1,
+        ErrorCode = 2,
+        NHits = 3,
+        NTDCErrors = 4,
+        HitEvent = 5,
+        HitChannel = 6,
+        HitTime = 7,
+        HitLeading = 8,
+        TDCError = 9
+    };
+    const std::uint32_t NColumns = 10;
+
+    enum Encoding: std::uint8_t {
+        Plain = 0,
+        Varint = 1,
+        Delta = 2,
+        Dictionary = 3,
+        BitPacked = 4
+    };
+
+    //--- Encoding
+
+    void putU32(std::string& out, std::uint32_t value) {
+        for (int i = 0; i < 4; i++)
+            out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+
+    void putU64(std::string& out, std::uint64_t value) {
+        for (int i = 0; i < 8; i++)
+            out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+
+    void putVarint(std::string& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    std::uint64_t zigzag(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    std::int64_t unzigzag(std::uint64_t value) {
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    template<typename T>
+    void encodePlain(std::string& out, const std::vector<T>& values) {
+        for (T value: values)
+            putU32(out, static_cast<std::uint32_t>(value));
+    }
+
+    template<typename T>
+    void encodeVarint(std::string& out, const std::vector<T>& values) {
+        for (T value: values)
+            putVarint(out, static_cast<std::uint64_t>(value));
+    }
+
+    template<typename T>
+    void encodeDelta(std::string& out, const std::vector<T>& values) {
+        std::int64_t previous = 0;
+        for (T value: values) {
+            putVarint(out, zigzag(static_cast<std::int64_t>(value) - previous));
+            previous = static_cast<std::int64_t>(value);
+        }
+    }
+
+    /*
+     * Returns false (and writes nothing) if there are more than 256 distinct values.
+     * Writes nothing for an empty column: it has no dictionary.
+     */
+    template<typename T>
+    bool encodeDictionary(std::string& out, const std::vector<T>& values) {
+        if (values.empty())
+            return true;
+
+        std::vector<T> dictionary;
+        for (T value: values) {
+            if (std::find(dictionary.begin(), dictionary.end(), value) == dictionary.end()) {
+                if (dictionary.size() == 256)
+                    return false;
+                dictionary.push_back(value);
+            }
+        }
+
+        out += static_cast<char>(dictionary.size() - 1);
+        for (T value: dictionary)
+            putVarint(out, zigzag(static_cast<std::int64_t>(value)));
+
+        for (T value: values)
+            out += static_cast<char>(std::find(dictionary.begin(), dictionary.end(), value) - dictionary.begin());
+        return true;
+    }
+
+    void encodeBits(std::string& out, const std::vector<std::uint8_t>& values) {
+        for (std::size_t i = 0; i < values.size(); i += 8) {
+            std::uint8_t byte = 0;
+            for (std::size_t bit = 0; bit < 8 && i + bit < values.size(); bit++)
+                byte |= (values[i + bit] ? 1 : 0) << bit;
+            out += static_cast<char>(byte);
+        }
+    }
+
+    template<typename T>
+    void writeColumn(std::string& out, Column column, Encoding encoding, const std::vector<T>& values) {
+        out += static_cast<char>(column);
+        std::size_t encoding_pos = out.size();
+        out += static_cast<char>(encoding);
+        std::size_t size_pos = out.size();
+        putU32(out, 0);
+        std::size_t start = out.size();
+
+        switch (encoding) {
+            case Plain:
+                encodePlain(out, values);
+                break;
+            case Varint:
+                encodeVarint(out, values);
+                break;
+            case Dictionary:
+                if (encodeDictionary(out, values))
+                    break;
+                // Too many distinct values: fall back to delta
+                out[encoding_pos] = static_cast<char>(Delta);
+                encodeDelta(out, values);
+                break;
+            case Delta:
+                encodeDelta(out, values);
+                break;
+            default:
+                break;
+        }
+
+        std::uint32_t size = out.size() - start;
+        for (int i = 0; i < 4; i++)
+            out[size_pos + i] = static_cast<char>((size >> (8 * i)) & 0xFF);
+    }
+
+    void writeBitColumn(std::string& out, Column column, const std::vector<std::uint8_t>& values) {
+        out += static_cast<char>(column);
+        out += static_cast<char>(BitPacked);
+        putU32(out, (values.size() + 7) / 8);
+        encodeBits(out, values);
+    }
+
+    //--- Decoding
+
+    class Cursor {
+        public:
+            Cursor(const char* data, std::size_t size):
+                m_pos(reinterpret_cast<const std::uint8_t*>(data)),
+                m_end(reinterpret_cast<const std::uint8_t*>(data) + size)
+            {}
+
+            std::uint8_t getU8() {
+                check(1);
+                return *m_pos++;
+            }
+
+            std::uint32_t getU32() {
+                check(4);
+                std::uint32_t value = 0;
+                for (int i = 0; i < 4; i++)
+                    value |= static_cast<std::uint32_t>(*m_pos++) << (8 * i);
+                return value;
+            }
+
+            std::uint64_t getU64() {
+                check(8);
+                std::uint64_t value = 0;
+                for (int i = 0; i < 8; i++)
+                    value |= static_cast<std::uint64_t>(*m_pos++) << (8 * i);
+                return value;
+            }
+
+            std::uint64_t getVarint() {
+                std::uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7) {
+                    std::uint8_t byte = getU8();
+                    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                    if (!(byte & 0x80))
+                        return value;
+                }
+                throw std::ios_base::failure("Invalid varint in columnar file");
+            }
+
+            std::size_t remaining() const {
+                return m_end - m_pos;
+            }
+
+            Cursor sub(std::size_t size) {
+                check(size);
+                Cursor cursor(reinterpret_cast<const char*>(m_pos), size);
+                m_pos += size;
+                return cursor;
+            }
+
+        private:
+            void check(std::size_t size) const {
+                if (static_cast<std::size_t>(m_end - m_pos) < size)
+                    throw std::ios_base::failure("Truncated columnar file");
+            }
+
+            const std::uint8_t* m_pos;
+            const std::uint8_t* m_end;
+    };
+
+    template<typename T>
+    void decodeColumn(Cursor data, Encoding encoding, std::size_t n_rows, std::vector<T>& values) {
+        values.resize(n_rows);
+
+        switch (encoding) {
+            case Plain:
+                for (std::size_t i = 0; i < n_rows; i++)
+                    values[i] = static_cast<T>(data.getU32());
+                break;
+            case Varint:
+                for (std::size_t i = 0; i < n_rows; i++)
+                    values[i] = static_cast<T>(data.getVarint());
+                break;
+            case Delta: {
+                std::int64_t value = 0;
+                for (std::size_t i = 0; i < n_rows; i++) {
+                    value += unzigzag(data.getVarint());
+                    values[i] = static_cast<T>(value);
+                }
+                break;
+            }
+            case Dictionary: {
+                // Empty column: no dictionary (files written before may have a size byte, ignored)
+                if (n_rows == 0)
+                    break;
+                std::size_t dictionary_size = data.getU8() + 1;
+                // At least one byte per entry and per index
+                if (data.remaining() < dictionary_size + n_rows)
+                    throw std::ios_base::failure("Invalid dictionary size in columnar file");
+                T dictionary[256];
+                for (std::size_t i = 0; i < dictionary_size; i++)
+                    dictionary[i] = static_cast<T>(unzigzag(data.getVarint()));
+                for (std::size_t i = 0; i < n_rows; i++) {
+                    std::uint8_t index = data.getU8();
+                    if (index >= dictionary_size)
+                        throw std::ios_base::failure("Invalid dictionary index in columnar file");
+                    values[i] = dictionary[index];
+                }
+                break;
+            }
+            case BitPacked:
+                for (std::size_t i = 0; i < n_rows; i += 8) {
+                    std::uint8_t byte = data.getU8();
+                    for (std::size_t bit = 0; bit < 8 && i + bit < n_rows; bit++)
+                        values[i + bit] = static_cast<T>((byte >> bit) & 1);
+                }
+                break;
+            default:
+                throw std::ios_base::failure("Unknown encoding in columnar file");
+        }
+    }
+}
+
+//--- EventColumns
+
+void EventColumns::clear() {
+    event_number.clear();
+    event_time.clear();
+    error_code.clear();
+    n_hits.clear();
+    n_tdc_errors.clear();
+    hit_event.clear();
+    hit_channel.clear();
+    hit_time.clear();
+    hit_leading.clear();
+    tdc_error.clear();
+    first_event = 0;
+}
+
+//--- ColumnarEventWriter
+
+const std::size_t ColumnarEventWriter::DefaultRowGroupSize;
+
+ColumnarEventWriter::ColumnarEventWriter(std::string fileName, std::size_t row_group_size):
+    m_file_name(fileName),
+    m_file(fileName, std::ios::binary | std::ios::trunc),
+    m_closed(false),
+    m_offset(0),
+    m_row_group_size(std::max<std::size_t>(row_group_size, 1)),
+    m_n_events(0)
+{
+    if (!m_file.is_open())
+        throw std::ios_base::failure("Could not open file " + fileName);
+
+    m_columns.clear();
+    writeBytes(std::string(Magic, MagicSize));
+}
+
+ColumnarEventWriter::~ColumnarEventWriter() {
+    try {
+        close();
+    } catch (std::ios_base::failure& e) {
+        std::cerr << "Warning: " << e.what() << std::endl;
+    }
+}
+
+void ColumnarEventWriter::write(const event& e) {
+    m_columns.event_number.push_back(e.eventNumber);
+    m_columns.event_time.push_back(e.time);
+    m_columns.error_code.push_back(e.errorCode);
+    m_columns.n_hits.push_back(e.hits.size());
+    m_columns.n_tdc_errors.push_back(e.tdcErrors.size());
+
+    for (const auto& h: e.hits) {
+        m_columns.hit_event.push_back(m_n_events);
+        m_columns.hit_channel.push_back(h.channel);
+        m_columns.hit_time.push_back(h.time);
+        m_columns.hit_leading.push_back(h.leading);
+    }
+    for (int error: e.tdcErrors)
+        m_columns.tdc_error.push_back(error);
+
+    m_n_events++;
+    if (m_columns.getNEvents() >= m_row_group_size)
+        writeRowGroup();
+}
+
+void ColumnarEventWriter::writeRowGroup() {
+    if (m_columns.getNEvents() == 0)
+        return;
+
+    m_row_groups.push_back({ m_offset, m_columns.first_event, static_cast<std::uint32_t>(m_columns.getNEvents()), static_cast<std::uint32_t>(m_columns.getNHits()) });
+
+    m_buffer.clear();
+    putU32(m_buffer, m_columns.getNEvents());
+    putU32(m_buffer, m_columns.getNHits());
+    putU32(m_buffer, m_columns.tdc_error.size());
+    putU32(m_buffer, NColumns);
+
+    writeColumn(m_buffer, EventNumber, Delta, m_columns.event_number);
+    writeColumn(m_buffer, EventTime, Delta, m_columns.event_time);
+    writeColumn(m_buffer, ErrorCode, Dictionary, m_columns.error_code);
+    writeColumn(m_buffer, NHits, Varint, m_columns.n_hits);
+    writeColumn(m_buffer, NTDCErrors, Varint, m_columns.n_tdc_errors);
+    writeColumn(m_buffer, HitEvent, Delta, m_columns.hit_event);
+    writeColumn(m_buffer, HitChannel, Dictionary, m_columns.hit_channel);
+    writeColumn(m_buffer, HitTime, Plain, m_columns.hit_time);
+    writeBitColumn(m_buffer, HitLeading, m_columns.hit_leading);
+    writeColumn(m_buffer, TDCError, Varint, m_columns.tdc_error);
+
+    writeBytes(m_buffer);
+
+    m_columns.clear();
+    m_columns.first_event = m_n_events;
+}
+
+void ColumnarEventWriter::writeBytes(const std::string& bytes) {
+    m_file.write(bytes.data(), bytes.size());
+    if (!m_file)
+        throw std::ios_base::failure("Could not write to " + m_file_name);
+    m_offset += bytes.size();
+}
+
+void ColumnarEventWriter::close() {
+    if (m_closed)
+        return;
+    m_closed = true;
+
+    writeRowGroup();
+
+    std::uint64_t footer_offset = m_offset;
+    m_buffer.clear();
+    for (const auto& row_group: m_row_groups) {
+        putU64(m_buffer, row_group.offset);
+        putU64(m_buffer, row_group.first_event);
+        putU32(m_buffer, row_group.n_events);
+        putU32(m_buffer, row_group.n_hits);
+    }
+    putU32(m_buffer, m_row_groups.size());
+    putU64(m_buffer, footer_offset);
+    m_buffer.append(Magic, MagicSize);
+    writeBytes(m_buffer);
+
+    m_file.close();
+}
+
+//--- ColumnarEventReader
+
+ColumnarEventReader::ColumnarEventReader(std::string fileName):
+    m_file_name(fileName),
+    m_fd(-1),
+    m_n_events(0),
+    m_n_hits(0)
+{
+    m_fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0)
+        throw std::ios_base::failure("Could not open file " + fileName + ": " + std::strerror(errno));
+
+    try {
+        struct stat info;
+        if (::fstat(m_fd, &info) != 0 || static_cast<std::uint64_t>(info.st_size) < MagicSize + FooterTailSize)
+            throw std::ios_base::failure(fileName + " is not a columnar event file");
+        std::uint64_t file_size = info.st_size;
+
+        std::string tail(FooterTailSize, '\0');
+        if (::pread(m_fd, &tail[0], tail.size(), file_size - tail.size()) != static_cast<ssize_t>(tail.size()))
+            throw std::ios_base::failure("Could not read " + fileName);
+        Cursor tail_cursor(tail.data(), tail.size());
+        std::uint32_t n_row_groups = tail_cursor.getU32();
+        std::uint64_t footer_offset = tail_cursor.getU64();
+        if (tail.compare(12, MagicSize, Magic) != 0 || footer_offset + n_row_groups * FooterEntrySize + FooterTailSize != file_size)
+            throw std::ios_base::failure(fileName + " is not a complete columnar event file (was the writer closed?)");
+
+        std::string footer(n_row_groups * FooterEntrySize, '\0');
+        if (n_row_groups && ::pread(m_fd, &footer[0], footer.size(), footer_offset) != static_cast<ssize_t>(footer.size()))
+            throw std::ios_base::failure("Could not read " + fileName);
+        Cursor footer_cursor(footer.data(), footer.size());
+        for (std::uint32_t i = 0; i < n_row_groups; i++) {
+            RowGroupInfo info;
+            info.offset = footer_cursor.getU64();
+            info.first_event = footer_cursor.getU64();
+            info.n_events = footer_cursor.getU32();
+            info.n_hits = footer_cursor.getU32();
+            info.size = 0;
+            m_row_groups.push_back(info);
+            m_n_events += info.n_events;
+            m_n_hits += info.n_hits;
+        }
+        for (std::size_t i = 0; i < m_row_groups.size(); i++)
+            m_row_groups[i].size = ((i + 1 < m_row_groups.size()) ? m_row_groups[i + 1].offset : footer_offset) - m_row_groups[i].offset;
+    } catch (...) {
+        ::close(m_fd);
+        throw;
+    }
+}
+
+ColumnarEventReader::~ColumnarEventReader() {
+    ::close(m_fd);
+}
+
+void ColumnarEventReader::readRowGroup(std::size_t row_group, EventColumns& columns) const {
+    const RowGroupInfo& info = m_row_groups.at(row_group);
+
+    std::string data(info.size, '\0');
+    if (::pread(m_fd, &data[0], data.size(), info.offset) != static_cast<ssize_t>(data.size()))
+        throw std::ios_base::failure("Could not read " + m_file_name);
+
+    Cursor cursor(data.data(), data.size());
+    std::size_t n_events = cursor.getU32();
+    std::size_t n_hits = cursor.getU32();
+    std::size_t n_tdc_errors = cursor.getU32();
+    std::uint32_t n_columns = cursor.getU32();
+
+    columns.clear();
+    columns.first_event = info.first_event;
+
+    for (std::uint32_t i = 0; i < n_columns; i++) {
+        Column column = static_cast<Column>(cursor.getU8());
+        Encoding encoding = static_cast<Encoding>(cursor.getU8());
+        Cursor column_data = cursor.sub(cursor.getU32());
+
+        switch (column) {
+            case EventNumber:
+                decodeColumn(column_data, encoding, n_events, columns.event_number);
+                break;
+            case EventTime:
+                decodeColumn(column_data, encoding, n_events, columns.event_time);
+                break;
+            case ErrorCode:
+                decodeColumn(column_data, encoding, n_events, columns.error_code);
+                break;
+            case NHits:
+                decodeColumn(column_data, encoding, n_events, columns.n_hits);
+                break;
+            case NTDCErrors:
+                decodeColumn(column_data, encoding, n_events, columns.n_tdc_errors);
+                break;
+            case HitEvent:
+                decodeColumn(column_data, encoding, n_hits, columns.hit_event);
+                break;
+            case HitChannel:
+                decodeColumn(column_data, encoding, n_hits, columns.hit_channel);
+                break;
+            case HitTime:
+                decodeColumn(column_data, encoding, n_hits, columns.hit_time);
+                break;
+            case HitLeading:
+                decodeColumn(column_data, encoding, n_hits, columns.hit_leading);
+                break;
+            case TDCError:
+                decodeColumn(column_data, encoding, n_tdc_errors, columns.tdc_error);
+                break;
+            default:
+                // Column added by a later version: skip it
+                break;
+        }
+    }
+}
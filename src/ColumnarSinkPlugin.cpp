@@ -0,0 +1,33 @@
+#include "LogSink.h"
+#include "Plugins.h"
+#include "ColumnarEvents.h"
+
+/*
+ * Plugin "columnar": write the TDC events to a columnar file (see ColumnarEventWriter)
+ */
+
+namespace {
+
+class ColumnarSink: public LogSink {
+    public:
+        ColumnarSink(std::string fileName): m_writer(fileName) {}
+        virtual ~ColumnarSink() override {};
+
+        virtual void write(const LogRecord& record) override {
+            for (const auto& e: record.events)
+                m_writer.write(*e);
+        }
+
+    private:
+        ColumnarEventWriter m_writer;
+};
+
+}
+
+extern "C" int slowControlPluginAPI() {
+    return SLOWCONTROL_PLUGIN_API;
+}
+
+extern "C" LogSink* slowControlCreateSink(const SinkContext& context) {
+    return new ColumnarSink(context.file_name);
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <fstream>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <json/reader.h>
+#include <json/writer.h>
+
+#include "ConditionJournal.h"
+
+ConditionJournal::ConditionJournal(std::string fileName, std::size_t sync_records, std::chrono::milliseconds sync_interval):
+    m_file_name(fileName),
+    m_sync_records(sync_records),
+    m_sync_interval(sync_interval),
+    m_unsynced_records(0)
+{
+    m_fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+        throw std::ios_base::failure("Could not open file " + fileName + ": " + std::strerror(errno));
+}
+
+ConditionJournal::~ConditionJournal() {
+    syncUnlocked();
+    ::close(m_fd);
+}
+
+void ConditionJournal::append(std::string type, Json::Value record) {
+    record["record"] = type;
+
+    // One line per record
+    Json::FastWriter writer;
+    std::string line = writer.write(record);
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    const char* data = line.data();
+    std::size_t remaining = line.size();
+    while (remaining) {
+        ssize_t written = ::write(m_fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::ios_base::failure("Could not write to " + m_file_name + ": " + std::strerror(errno));
+        }
+        data += written;
+        remaining -= written;
+    }
+
+    if (m_unsynced_records == 0)
+        m_first_unsynced = m_clock::now();
+    m_unsynced_records++;
+
+    if ((m_sync_records && m_unsynced_records >= m_sync_records) || m_clock::now() - m_first_unsynced >= m_sync_interval)
+        syncUnlocked();
+}
+
+void ConditionJournal::syncIfDue() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_unsynced_records && m_clock::now() - m_first_unsynced >= m_sync_interval)
+        syncUnlocked();
+}
+
+void ConditionJournal::sync() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    syncUnlocked();
+}
+
+void ConditionJournal::syncUnlocked() {
+    if (!m_unsynced_records)
+        return;
+
+    if (::fsync(m_fd) != 0)
+        std::cerr << "Warning: could not synchronise " << m_file_name << ": " << std::strerror(errno) << std::endl;
+    m_unsynced_records = 0;
+}
+
+void ConditionJournal::compact(std::string journal_name, std::string output_name) {
+    std::ifstream journal(journal_name);
+    if (!journal.is_open())
+        throw std::ios_base::failure("Could not open file " + journal_name);
+
+    std::ofstream output(output_name);
+    if (!output.is_open())
+        throw std::ios_base::failure("Could not open file " + output_name);
+
+    // Members of the end-of-run layout other than the list of conditions
+    Json::Value root(Json::objectValue);
+    std::size_t n_conditions = 0;
+
+    Json::Reader reader;
+    Json::StyledWriter writer;
+
+    output << "{\n\"conditions\" : [\n";
+
+    std::string line;
+    std::size_t line_number = 0;
+    while (std::getline(journal, line)) {
+        line_number++;
+        if (line.empty())
+            continue;
+
+        Json::Value record;
+        // The last line may be truncated if the program crashed while writing it
+        if (!reader.parse(line, record, false) || !record.isObject()) {
+            std::cerr << "Warning: skipping corrupt record at line " << line_number << " of " << journal_name << std::endl;
+            continue;
+        }
+
+        std::string type = record["record"].asString();
+        record.removeMember("record");
+
+        if (type == "conditions") {
+            if (n_conditions)
+                output << ",\n";
+            std::string condition = writer.write(record);
+            output << condition.substr(0, condition.size() - 1);
+            n_conditions++;
+        } else {
+            // "start" and "stop" records hold members of the root
+            for (const auto& name: record.getMemberNames())
+                root[name] = record[name];
+        }
+    }
+
+    // As before, true if the conditions were updated during the run
+    root["conditions_changed"] = n_conditions > 1;
+
+    output << "\n]";
+    for (const auto& name: root.getMemberNames()) {
+        std::string value = writer.write(root[name]);
+        output << ",\n\"" << name << "\" : " << value.substr(0, value.size() - 1);
+    }
+    output << "\n}\n";
+
+    if (!output.good())
+        throw std::ios_base::failure("Could not write to " + output_name);
+}
@@ -5,9 +5,10 @@
 #include <cstddef>
 
 #include "ConditionManager.h"
-#include "Interface.h"
 
 #include "VmeUsbBridge.h"
+#include "Logger.h"
+#include "Plugins.h"
 #include "Event.h"
 
 // Static
@@ -21,10 +22,19 @@ const std::map<ScalerChannel, std::pair<std::string, double>> ConditionManager::
 };
 
 
-ConditionManager::ConditionManager(Interface& m_interface, bool use_fake_setup):
-    m_interface(m_interface),
-    m_HV_daemon_running(false),
-    m_TDC_daemon_running(false),
+ConditionManager::ConditionManager(const Arguments& m_args):
+    m_hv_mtx("hv", std::chrono::milliseconds(m_args.lock_threshold)),
+    m_discri_mtx("discri", std::chrono::milliseconds(m_args.lock_threshold)),
+    m_ttc_mtx("ttc", std::chrono::milliseconds(m_args.lock_threshold)),
+    m_tdc_mtx("tdc", std::chrono::milliseconds(m_args.lock_threshold)),
+    m_scaler_mtx("scaler", std::chrono::milliseconds(m_args.lock_threshold)),
+    m_bus(makeThreadSettings(m_args, "bus")),
+    m_HV_thread_settings(makeThreadSettings(m_args, "hv")),
+    m_HV_task(0),
+    m_TDC_thread_settings(makeThreadSettings(m_args, "tdc")),
+    m_TDC_task(0),
+    m_scaler_thread_settings(makeThreadSettings(m_args, "scaler")),
+    m_scaler_task(0),
     m_hvpmt({
             { 1350, 0, 0, true },
             { 1350, 0, 0, true },
@@ -39,36 +49,61 @@ ConditionManager::ConditionManager(Interface& m_interface, bool use_fake_setup):
     m_channelsMajority(2),
     m_triggerChannel(1),
     m_triggerRandomFrequency(0),
+    // Enough for the events waiting for the logger (it takes them every second), with typical hit multiplicities
+    m_TDC_eventPool(2048, 32),
+    // Full range of the 19-bit TDC measurements
+    m_TDC_liveHistograms(m_args.analysis_channels, 512, 1 << 19),
+    m_TDC_histogramWriter(m_TDC_liveHistograms.makeWriter()),
     m_TDC_offsetMinimum(5),
+    m_TDC_governor(m_args.governor_low, m_args.governor_high, m_args.trigger_throttle),
+    m_TDC_almostFullLevel(m_args.tdc_almost_full),
     m_TDC_backPressuring(false),
+    m_TDC_backPressureEpisodes(0),
     m_TDC_fatal(false),
     m_TDC_evtCounter(0),
     m_TDC_evtBuffer_flushSize(50),
-    m_scaler_interval(5000)
+    m_TDC_evtBuffer_maxSize(std::max<std::size_t>(m_args.event_buffer_size, m_TDC_evtBuffer_flushSize)),
+    m_TDC_FIFOEventCount(0),
+    m_TTC_eventNumber(0),
+    m_HV_interval(m_args.hv_period),
+    m_scaler_interval(m_args.scaler_period)
 {
     // No reliable way of knowing how many events we have
     // in the TDC buffer if there are more than 1000
     if (m_TDC_evtBuffer_flushSize > 1000)
         m_TDC_evtBuffer_flushSize = 1000;
 
+    // Messages of the drivers and of the daemons
+    logger::get().setRateLimit(m_args.log_rate_limit);
+    if (!m_args.driver_log.empty() && !logger::get().setBinaryOutput(m_args.driver_log))
+        std::cerr << "Could not open " << m_args.driver_log << ": driver messages stay on the console." << std::endl;
+
+    // Sinks and reader of ROOT files, loaded when first needed (the replay may need one right below)
+    PluginLoader::get().setDirectory(m_args.plugin_path);
+
     bool canTalkToBoards = false;
-    if (!use_fake_setup) {
+    if (!m_args.use_fake_setup && m_args.replay_file.empty()) {
         std::cout << "Checking if the PC is connected to board..." << std::endl;
         UsbController *dummy_controller = new UsbController(DEBUG);
         canTalkToBoards = (dummy_controller->getStatus() == 0);
         std::cout << "Deleting dummy USB controller..." << std::endl;
         delete dummy_controller;
     }
-    if (canTalkToBoards) {
+    if (!m_args.replay_file.empty()) {
+        std::cout << "Replaying a recorded run: actions on the setup will be ignored." << std::endl;
+        m_setup_manager = std::make_shared<ReplaySetupManager>(*this, m_args.replay_file, m_args.replay_speed, m_args.replay_conditions);
+    } else if (canTalkToBoards) {
         std::cout << "You are on 'the' machine connected to the boards and can take action on them." << std::endl;
-        m_setup_manager = std::make_shared<RealSetupManager>(m_interface);
+        m_setup_manager = std::make_shared<RealSetupManager>(*this);
     } else {
         std::cout << "WARNING : You are not on 'the' machine connected to the boards. Actions on the setup will be ignored." << std::endl;
-        m_setup_manager = std::make_shared<FakeSetupManager>(m_interface);
+        m_setup_manager = std::make_shared<FakeSetupManager>(*this);
     }
 
     for (const auto& reading: ScalerReadings)
-        m_scaler_rates[reading.first] = Rate<std::chrono::high_resolution_clock>(reading.second.second);
+        m_scaler_rates[reading.first] = Rate<DAQClock>(reading.second.second);
+
+    m_status = { m_hvpmt, 0, 0, 0, false, false, 0 };
 
     startHVDaemon();
 }
@@ -87,86 +122,130 @@ ConditionManager::~ConditionManager() {
     } catch(daemon_state_error) {};
 }
 
-bool ConditionManager::propagateHVPMTValue(std::size_t id) {
-    bool result = m_setup_manager->setHVPMT(id);
+ConditionManager::Status ConditionManager::getStatus() {
+    std::lock_guard<std::mutex> m_lock(m_status_mtx);
+    return m_status;
+}
+
+void ConditionManager::setStatusListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> m_lock(m_status_mtx);
+    m_status_listener = listener;
+}
 
-    return result;
+template<typename Update>
+void ConditionManager::publishStatus(Update update) {
+    // The listener is called with the lock held, so that it cannot be called any more once removed
+    std::lock_guard<std::mutex> m_lock(m_status_mtx);
+    if (update(m_status) && m_status_listener)
+        m_status_listener();
+}
+
+void ConditionManager::publishTDCStatus() {
+    std::int64_t event_count = m_TDC_evtCounter;
+    std::size_t offset = m_TDC_offsetMinimum();
+    std::int64_t fifo_count = m_TDC_FIFOEventCount;
+    bool back_pressure = m_TDC_backPressuring;
+    bool fatal = m_TDC_fatal;
+    std::uint64_t trigger_count = m_TTC_eventNumber;
+
+    publishStatus([&](Status& status) {
+                if (status.tdcEventCount == event_count && status.tdcOffset == offset && status.tdcFIFOEventCount == fifo_count
+                        && status.tdcBackPressure == back_pressure && status.tdcFatal == fatal && status.triggerEventNumber == trigger_count)
+                    return false;
+                status.tdcEventCount = event_count;
+                status.tdcOffset = offset;
+                status.tdcFIFOEventCount = fifo_count;
+                status.tdcBackPressure = back_pressure;
+                status.tdcFatal = fatal;
+                status.triggerEventNumber = trigger_count;
+                return true;
+            });
+}
+
+// The HV methods of the setup run the steps of their exchanges on the bus themselves (see SetupManager)
+
+bool ConditionManager::propagateHVPMTValue(std::size_t id) {
+    return m_setup_manager->setHVPMT(id);
 }
 
 bool ConditionManager::propagateHVPMTState(std::size_t id) {
-    if (getHVPMTSetState(id))
-        return m_setup_manager->switchHVPMTON(id);
-    else
-        return m_setup_manager->switchHVPMTOFF(id);
+    bool state = getHVPMTSetState(id);
+    return state ? m_setup_manager->switchHVPMTON(id) : m_setup_manager->switchHVPMTOFF(id);
 }
 
 bool ConditionManager::propagateDiscriSettings() {
-    return m_setup_manager->propagateDiscriSettings();
+    return m_bus.call(BusScheduler::Priority::Control, [this]() { return m_setup_manager->propagateDiscriSettings(); });
 }
 
 void ConditionManager::startTrigger() {
-    m_setup_manager->setTrigger(m_triggerChannel, m_triggerRandomFrequency);
+    int channel = m_triggerChannel;
+    int frequency = m_TDC_governor.getFrequency(m_triggerRandomFrequency);
+    m_bus.call(BusScheduler::Priority::Trigger, [this, channel, frequency]() { m_setup_manager->setTrigger(channel, frequency); });
 }
 
 void ConditionManager::stopTrigger() {
-    m_setup_manager->setTrigger(7, 0); // Channel 7 means disabled...
+    m_bus.call(BusScheduler::Priority::Trigger, [this]() { m_setup_manager->setTrigger(7, 0); }); // Channel 7 means disabled...
 }
 
 void ConditionManager::resetTrigger() {
-    m_setup_manager->resetTrigger();
+    m_bus.call(BusScheduler::Priority::Trigger, [this]() { m_setup_manager->resetTrigger(); });
 }
 
 std::uint64_t ConditionManager::getTriggerEventNumber() {
-    return m_setup_manager->getTTCEventNumber();
+    return m_bus.call(BusScheduler::Priority::Control, [this]() { return m_setup_manager->getTTCEventNumber(); });
+}
+
+void ConditionManager::resetScaler() {
+    m_bus.call(BusScheduler::Priority::Control, [this]() { m_setup_manager->resetScaler(); });
 }
 
 void ConditionManager::startHVDaemon() {
-    if (thread_handle_HV.joinable()) {
+    if (m_HV_task) {
         throw daemon_state_error("HV daemon was already running");
     }
-    m_HV_daemon_running = true;
-    thread_handle_HV = std::thread(&ConditionManager::daemonHV, std::ref(*this));
+    m_HV_task = m_scheduler.schedule(m_HV_thread_settings, std::chrono::milliseconds(m_HV_interval), [this]() { daemonHV(); return true; });
 }
 
 void ConditionManager::stopHVDaemon() {
-    if (!thread_handle_HV.joinable()) {
+    if (!m_HV_task) {
         throw daemon_state_error("HV daemon was not running");
     }
-    m_HV_daemon_running = false;
-    thread_handle_HV.join();
+    m_scheduler.cancel(m_HV_task);
+    m_HV_task = 0;
 }
 
 void ConditionManager::daemonHV() {
-    while (m_HV_daemon_running) {
-        // wait some time
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      
-        std::lock_guard<std::mutex> m_lock(m_hv_mtx);
-        std::vector< std::pair<double, double> > hv_values = m_setup_manager->getHVPMTValue();
-        for (std::size_t id = 0; id < hv_values.size(); id++) {
-            //m_hvpmt.at(id).readState = m_hvpmt.at(id).readState;
-            m_hvpmt.at(id).readValue = hv_values.at(id).first;
-            m_hvpmt.at(id).readCurrent = hv_values.at(id).second;
-        }
+    ProfiledLock m_lock(m_hv_mtx);
+    std::vector< std::pair<double, double> > hv_values = m_setup_manager->getHVPMTValue();
+    for (std::size_t id = 0; id < hv_values.size(); id++) {
+        //m_hvpmt.at(id).readState = m_hvpmt.at(id).readState;
+        m_hvpmt.at(id).readValue = hv_values.at(id).first;
+        m_hvpmt.at(id).readCurrent = hv_values.at(id).second;
     }
+
+    publishStatus([this](Status& status) {
+                if (status.hv == m_hvpmt)
+                    return false;
+                status.hv = m_hvpmt;
+                return true;
+            });
 }
 
 void ConditionManager::startTDCReading() {
-    if (thread_handle_TDC.joinable()) {
+    if (m_TDC_task) {
         throw daemon_state_error("TDC daemon was already running");
     }
     
-    m_TDC_daemon_running = true;
-    thread_handle_TDC = std::thread(&ConditionManager::daemonTDC, std::ref(*this));
+    m_TDC_task = m_scheduler.schedule(m_TDC_thread_settings, std::chrono::milliseconds(1), [this]() { return daemonTDC(); });
 }
 
 void ConditionManager::stopTDCReading() {
-    if (!thread_handle_TDC.joinable()) {
+    if (!m_TDC_task) {
         throw daemon_state_error("TDC daemon was not running");
     }
 
-    m_TDC_daemon_running = false;
-    thread_handle_TDC.join();
+    m_scheduler.cancel(m_TDC_task);
+    m_TDC_task = 0;
 }
 
 void ConditionManager::configureTDC() {
@@ -174,145 +253,196 @@ void ConditionManager::configureTDC() {
     m_TDC_evtCounter = 0;
     m_TDC_evtBuffer.clear();
     m_TDC_backPressuring = false;
+    m_TDC_backPressureEpisodes = 0;
     m_TDC_fatal = false;
+    m_TDC_liveHistograms.reset();
+    m_TDC_FIFOEventCount = 0;
+    m_TTC_eventNumber = 0;
+    {
+        ProfiledLock m_ttc_lock(m_ttc_mtx);
+        m_TDC_governor.reset();
+    }
+    publishTDCStatus();
     
-    m_setup_manager->configureTDC();
+    unsigned int almost_full_level = m_TDC_almostFullLevel;
+    m_bus.call(BusScheduler::Priority::Control, [this, almost_full_level]() {
+                m_setup_manager->configureTDC();
+                m_setup_manager->setTDCAlmostFullLevel(almost_full_level);
+            });
 }
 
 std::int64_t ConditionManager::getTDCFIFOEventCount() {
-    std::int64_t n_evt = m_setup_manager->getTDCNEvents();
-    unsigned int tdc_status = m_setup_manager->getTDCStatus();
+    std::int64_t n_evt = 0;
+    unsigned int tdc_status = 0;
+    m_bus.call(BusScheduler::Priority::Control, [this, &n_evt, &tdc_status]() {
+                n_evt = m_setup_manager->getTDCNEvents();
+                tdc_status = m_setup_manager->getTDCStatus();
+            });
     bool data_ready = tdc::dataReady(tdc_status);
     
     return (data_ready && n_evt == 0) ? 1000 : n_evt; 
 }
 
-void ConditionManager::daemonTDC() {
+bool ConditionManager::daemonTDC() {
+    MemoryScope memory_scope(MemoryTracker::Subsystem::Events);
 
-    while(m_TDC_daemon_running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    unsigned int tdc_status;
+    {
+        ProfiledLock m_lock(m_tdc_mtx);
+        tdc_status = m_bus.call(BusScheduler::Priority::Readout, [this]() { return m_setup_manager->getTDCStatus(); });
+    }
+    bool almost_full = tdc::isAlmostFull(tdc_status);
+    bool lost_trigger = tdc::lostTrig(tdc_status);
+    bool data_ready = tdc::dataReady(tdc_status);
+
+    if (lost_trigger) {
+        m_TDC_fatal = true;
+        vLog(ERROR, "TDC fatal error: lost triggers");
+        publishTDCStatus();
+        return false;
+    }
+
+    {
+        // Inhibit the trigger when the TDC is almost full, and keep the random trigger at the rate the
+        // readout can take (on the FIFO occupancy of the previous reading)
+        ProfiledLock m_TTC_lock(m_ttc_mtx);
+        int requested = (m_triggerChannel == 5) ? m_triggerRandomFrequency : -1;
+        if (m_TDC_governor.update(DAQClock::now(), almost_full, data_ready ? static_cast<std::size_t>(m_TDC_FIFOEventCount) : 0, requested)) {
+            if (m_TDC_governor.isInhibited()) {
+                stopTrigger();
+                m_TDC_backPressureEpisodes++;
+            } else {
+                startTrigger();
+            }
+        }
+        m_TDC_backPressuring = m_TDC_governor.isInhibited();
+    }
 
-        unsigned int tdc_status;
+    if (data_ready) {
+        
+        std::size_t n_evt = 0;
+        bool buffer_full = false;
+ 
+        // First check if the number of events is high enough that it's worth
+        // it to start an acquisition loop. The trigger count is read along, for the status.
         {
-            std::lock_guard<std::mutex> m_lock(m_tdc_mtx);
-            tdc_status = m_setup_manager->getTDCStatus();
+            ProfiledLock m_lock(m_tdc_mtx);
+            ProfiledLock m_ttc_lock(m_ttc_mtx);
+            buffer_full = (m_TDC_evtBuffer.size() + m_TDC_evtBuffer_flushSize > m_TDC_evtBuffer_maxSize);
+            m_bus.call(BusScheduler::Priority::Readout, [this, &n_evt]() {
+                        n_evt = m_setup_manager->getTDCNEvents();
+                        m_TTC_eventNumber = m_setup_manager->getTTCEventNumber();
+                    });
         }
-        bool almost_full = tdc::isAlmostFull(tdc_status);
-        bool lost_trigger = tdc::lostTrig(tdc_status);
-        bool data_ready = tdc::dataReady(tdc_status);
-
-        if (lost_trigger) {
-            m_TDC_fatal = true;
-            std::cout << "TDC fatal error: lost triggers" << std::endl;
-            break;
+        // n_evt = 0 with data ready: more than 1000 events
+        m_TDC_FIFOEventCount = (n_evt == 0) ? 1000 : n_evt;
+        // If the logger lags behind, the events wait in the TDC rather than in memory
+        if (n_evt < m_TDC_evtBuffer_flushSize / 2 || buffer_full) {
+            m_scheduler.delay(m_TDC_task, std::chrono::milliseconds(50));
+            publishTDCStatus();
+            return true;
         }
 
-        if (almost_full) {
+        ProfiledLock m_lock(m_tdc_mtx);
  
-            // Something bad has happened or is about to happen -> backpressure the TTC
-            std::lock_guard<std::mutex> m_TTC_lock(m_ttc_mtx);
-            stopTrigger();
-            m_TDC_backPressuring = true;
+        // n_evt = 0 can happen if actual number of events between 1000 and 1024
+        // Also, read at most m_TDC_evtBuffer_flushSize events at once
+        if (n_evt > m_TDC_evtBuffer_flushSize || n_evt == 0)
+            n_evt = m_TDC_evtBuffer_flushSize;
         
-        } else {
-
-            if (m_TDC_backPressuring) {
-                std::lock_guard<std::mutex> m_TTC_lock(m_ttc_mtx);
-                startTrigger();
-                m_TDC_backPressuring = false;
-            }
-            
+        // Read the whole burst in one bus request, so that slow control cannot delay it midway.
+        // The events are taken from the pool beforehand (no lock may be taken on the bus).
+        m_TDC_burst.clear();
+        for (std::size_t i = 0; i < n_evt; i++)
+            m_TDC_burst.push_back(m_TDC_eventPool.acquire());
+        std::size_t n_read = 0;
+        std::int64_t n_fifo = 0;
+        std::int64_t ttc_number = 0;
+        {
+            ProfiledLock m_ttc_lock(m_ttc_mtx);
+            m_bus.call(BusScheduler::Priority::Readout, [this, &n_read, &n_fifo, &ttc_number]() {
+                        MemoryScope memory_scope(MemoryTracker::Subsystem::Events);
+                        for (; n_read < m_TDC_burst.size(); n_read++) {
+                            event& evt = *m_TDC_burst[n_read];
+                            m_setup_manager->getTDCEvent(evt);
+                            if (evt.errorCode)
+                                break;
+                            // TDC buffer is a FIFO -> number of events still in buffer after the first one
+                            if (n_read == 0) {
+                                n_fifo = m_setup_manager->getTDCNEvents();
+                                ttc_number = m_setup_manager->getTTCEventNumber();
+                            }
+                        }
+                    });
         }
 
-        if (data_ready) {
+        for (std::size_t i = 0; i < m_TDC_burst.size() && i <= n_read; i++) {
             
-            std::size_t n_evt = 0;
- 
-            // First check if the number of events is high enough that it's worth
-            // it to start an acquisition loop
-            {
-                std::lock_guard<std::mutex> m_lock(m_tdc_mtx);
-                n_evt = m_setup_manager->getTDCNEvents();
-            }
-            if (n_evt < m_TDC_evtBuffer_flushSize / 2) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
-                continue;
-            }
+            EventPool::Handle& this_evt = m_TDC_burst[i];
 
-            std::lock_guard<std::mutex> m_lock(m_tdc_mtx);
+            // Data is corrupt -> stop saving it!
+            if (this_evt->errorCode) {
+                m_TDC_fatal = true;
+                vLog(ERROR, "TDC fatal error: event error code {}", this_evt->errorCode);
+                break;
+            }
  
-            // n_evt = 0 can happen if actual number of events between 1000 and 1024
-            // Also, read at most m_TDC_evtBuffer_flushSize events at once
-            if (n_evt > m_TDC_evtBuffer_flushSize || n_evt == 0)
-                n_evt = m_TDC_evtBuffer_flushSize;
-            
-            for (std::size_t i = 0; i < n_evt; i++) {
-                
-                event this_evt = m_setup_manager->getTDCEvent();
-
-                // Data is corrupt -> stop saving it!
-                if (this_evt.errorCode) {
+            // Check on the first event if TDC and TTC are in sync -> if not stop data taking!
+            if (i == 0) {
+                std::int64_t evt_offset = this_evt->eventNumber + n_fifo - ttc_number;
+                // Compute running minimum of offset over last X readings
+                // If offset becomes too large, stop TDC data reading
+                // Since the offset can only grow, using the running minimum is good enough
+                evt_offset = m_TDC_offsetMinimum(std::abs(evt_offset));
+                if (evt_offset > 3) {
                     m_TDC_fatal = true;
-                    std::cout << "TDC fatal error: event error code " << this_evt.errorCode << std::endl;
+                    vLog(ERROR, "TDC fatal error: out of sync with TTC. Offset: {}", evt_offset);
                     break;
                 }
- 
-                // Check on the first event if TDC and TTC are in sync -> if not stop data taking!
-                if (i == 0) {
-                    std::int64_t evt_offset = 0;
-                    {
-                        std::lock_guard<std::mutex> m_ttc_lock(m_ttc_mtx);
-                        // TDC buffer is a FIFO -> add number of events still in buffer
-                        evt_offset = this_evt.eventNumber + m_setup_manager->getTDCNEvents() - m_setup_manager->getTTCEventNumber();
-                    }
-                    // Compute running minimum of offset over last X readings
-                    // If offset becomes too large, stop TDC data reading
-                    // Since the offset can only grow, using the running minimum is good enough
-                    evt_offset = m_TDC_offsetMinimum(std::abs(evt_offset));
-                    if (evt_offset > 3) {
-                        m_TDC_fatal = true;
-                        std::cout << "TDC fatal error: out of sync with TTC. Offset: " << evt_offset << std::endl;
-                        break;
-                    }
-                }
-                
-                m_TDC_evtBuffer.push_back(this_evt);
-                m_TDC_evtCounter++;
             }
+            
+            m_TDC_histogramWriter.fill(*this_evt);
+            m_TDC_evtBuffer.push_back(std::move(this_evt));
+            m_TDC_evtCounter++;
         }
+        // Give the events not used back to the pool
+        m_TDC_burst.clear();
 
-        if (m_TDC_fatal)
-            break;
+        if (n_read > 0) {
+            // Still in the TDC after the burst (n_fifo was read after its first event)
+            m_TDC_FIFOEventCount = std::max<std::int64_t>(n_fifo - static_cast<std::int64_t>(n_read - 1), 0);
+            m_TTC_eventNumber = ttc_number;
+        }
+    } else {
+        m_TDC_FIFOEventCount = 0;
     }
 
+    publishTDCStatus();
+    return !m_TDC_fatal;
 }
 
 void ConditionManager::startScalerDaemon() {
-    if (thread_handle_scaler.joinable()) {
+    if (m_scaler_task) {
         throw daemon_state_error("Scaler daemon was already running");
     }
-    m_scaler_daemon_running = true;
-    thread_handle_scaler = std::thread(&ConditionManager::daemonScaler, std::ref(*this));
+    m_scaler_task = m_scheduler.schedule(m_scaler_thread_settings, std::chrono::milliseconds(m_scaler_interval), [this]() { daemonScaler(); return true; });
 }
 
 void ConditionManager::stopScalerDaemon() {
-    if (!thread_handle_scaler.joinable()) {
+    if (!m_scaler_task) {
         throw daemon_state_error("Scaler daemon was not running");
     }
-    m_scaler_daemon_running = false;
-    thread_handle_scaler.join();
+    m_scheduler.cancel(m_scaler_task);
+    m_scaler_task = 0;
 }
 
 void ConditionManager::daemonScaler() {
+    ProfiledLock m_lock(m_scaler_mtx);
 
-    while(m_scaler_daemon_running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(m_scaler_interval));
-        
-        std::lock_guard<std::mutex> m_lock(m_scaler_mtx);
-
-        for (const auto& reading: ScalerReadings) {
-            m_scaler_rates.at(reading.first).add(m_setup_manager->getScalerCount(reading.first));
-        }
+    for (const auto& reading: ScalerReadings) {
+        ScalerChannel channel = reading.first;
+        int count = m_bus.call(BusScheduler::Priority::Scaler, [this, channel]() { return m_setup_manager->getScalerCount(channel); });
+        m_scaler_rates.at(channel).add(count);
     }
 }
 
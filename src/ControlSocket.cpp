@@ -0,0 +1,108 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "ControlSocket.h"
+#include "RunController.h"
+#include "ThreadUtils.h"
+
+ControlSocket::ControlSocket(RunController& m_controller, std::string path):
+    m_controller(m_controller),
+    m_path(path),
+    m_listen_fd(-1),
+    m_running(false)
+{
+    sockaddr_un address;
+    if (m_path.size() >= sizeof(address.sun_path))
+        throw socket_error("Socket path too long: " + m_path);
+
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, m_path.c_str(), sizeof(address.sun_path) - 1);
+
+    m_listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listen_fd < 0)
+        throw socket_error("Could not create socket: " + std::string(std::strerror(errno)));
+
+    // Remove stale socket left by a previous instance
+    unlink(m_path.c_str());
+
+    if (bind(m_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(m_listen_fd, 4) < 0) {
+        std::string error(std::strerror(errno));
+        close(m_listen_fd);
+        throw socket_error("Could not listen on " + m_path + ": " + error);
+    }
+
+    std::cout << "Listening for commands on " << m_path << std::endl;
+
+    m_running = true;
+    thread_handle = startThread(makeThreadSettings(m_controller.getArguments(), "socket"), [this]() { serve(); });
+}
+
+ControlSocket::~ControlSocket() {
+    m_running = false;
+    if (thread_handle.joinable())
+        thread_handle.join();
+    
+    close(m_listen_fd);
+    unlink(m_path.c_str());
+}
+
+void ControlSocket::serve() {
+    while (m_running) {
+        // Wake up regularly to check whether we have to stop
+        pollfd listen_poll = { m_listen_fd, POLLIN, 0 };
+        if (poll(&listen_poll, 1, 200) <= 0)
+            continue;
+
+        int client_fd = accept(m_listen_fd, NULL, NULL);
+        if (client_fd < 0) {
+            std::cerr << "Warning: could not accept control connection: " << std::strerror(errno) << std::endl;
+            continue;
+        }
+
+        handleClient(client_fd);
+        close(client_fd);
+    }
+}
+
+void ControlSocket::handleClient(int client_fd) {
+    std::string buffer;
+    char chunk[256];
+
+    while (m_running) {
+        pollfd client_poll = { client_fd, POLLIN, 0 };
+        int ready = poll(&client_poll, 1, 200);
+        if (ready < 0)
+            return;
+        if (ready == 0)
+            continue;
+
+        ssize_t n_read = read(client_fd, chunk, sizeof(chunk));
+        if (n_read <= 0)
+            return; // Client disconnected
+        buffer.append(chunk, n_read);
+
+        std::size_t eol;
+        while ((eol = buffer.find('\n')) != std::string::npos) {
+            std::string command = buffer.substr(0, eol);
+            buffer.erase(0, eol + 1);
+            if (!command.empty() && command.back() == '\r')
+                command.pop_back();
+            if (command.empty())
+                continue;
+
+            std::cout << "Control socket command: " << command << std::endl;
+            std::string answer = m_controller.executeCommand(command) + "\n";
+            
+            if (send(client_fd, answer.c_str(), answer.size(), MSG_NOSIGNAL) < 0)
+                return;
+        }
+    }
+}
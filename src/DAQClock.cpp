@@ -0,0 +1,45 @@
+#include <atomic>
+
+#include "DAQClock.h"
+
+namespace {
+    std::atomic<bool> virtual_enabled(false);
+    // ns since enable()
+    std::atomic<std::int64_t> virtual_now(0);
+}
+
+const std::time_t VirtualTime::Epoch;
+
+void VirtualTime::enable() {
+    virtual_now = 0;
+    virtual_enabled = true;
+}
+
+bool VirtualTime::isEnabled() {
+    return virtual_enabled.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds VirtualTime::now() {
+    return std::chrono::nanoseconds(virtual_now.load());
+}
+
+void VirtualTime::advance(std::chrono::nanoseconds time) {
+    std::int64_t current = virtual_now.load();
+    while (current < time.count() && !virtual_now.compare_exchange_weak(current, time.count())) {}
+}
+
+DAQClock::time_point DAQClock::now() {
+    if (VirtualTime::isEnabled())
+        return time_point(VirtualTime::now());
+    return time_point(std::chrono::duration_cast<duration>(std::chrono::steady_clock::now().time_since_epoch()));
+}
+
+DAQSystemClock::time_point DAQSystemClock::now() {
+    if (VirtualTime::isEnabled())
+        return time_point(std::chrono::seconds(VirtualTime::Epoch) + VirtualTime::now());
+    return time_point(std::chrono::duration_cast<duration>(std::chrono::system_clock::now().time_since_epoch()));
+}
+
+std::time_t DAQSystemClock::to_time_t(const time_point& time) {
+    return static_cast<std::time_t>(std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count());
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+
+#include "Decimation.h"
+
+//--- SampleRing
+
+SampleRing::SampleRing(std::size_t n_channels, std::size_t length):
+    m_n_channels(n_channels),
+    m_length(std::max<std::size_t>(length, 1)),
+    m_head(0),
+    m_size(0),
+    m_timestamps(m_length, 0),
+    m_values(m_length * n_channels, 0)
+{}
+
+void SampleRing::push(std::uint64_t timestamp, const std::vector<double>& values) {
+    m_timestamps[m_head] = timestamp;
+    std::copy_n(values.begin(), m_n_channels, m_values.begin() + m_head * m_n_channels);
+
+    m_head = (m_head + 1) % m_length;
+    if (m_size < m_length)
+        m_size++;
+}
+
+void SampleRing::clear() {
+    m_head = 0;
+    m_size = 0;
+}
+
+//--- DecimationTier
+
+DecimationTier::DecimationTier(std::size_t n_channels, std::uint64_t period):
+    m_period(std::max<std::uint64_t>(period, 1)),
+    m_started(false),
+    m_origin(0),
+    m_start(0),
+    m_last(0),
+    m_n(0),
+    m_min(n_channels, 0),
+    m_max(n_channels, 0),
+    m_sum(n_channels, 0),
+    m_result_start(0),
+    m_result_stop(0),
+    m_result_n(0),
+    m_result_min(n_channels, 0),
+    m_result_max(n_channels, 0),
+    m_result_mean(n_channels, 0)
+{}
+
+bool DecimationTier::add(std::uint64_t timestamp, const std::vector<double>& values) {
+    if (!m_started) {
+        m_started = true;
+        m_origin = timestamp;
+        m_start = timestamp;
+    }
+
+    // The sample reaching the end of the interval starts the next one
+    bool completed = false;
+    if (timestamp >= m_start + m_period) {
+        if (m_n > 0) {
+            complete(m_start + m_period);
+            completed = true;
+        }
+        m_start = m_origin + (timestamp - m_origin) / m_period * m_period;
+    }
+
+    if (m_n == 0) {
+        std::copy_n(values.begin(), m_min.size(), m_min.begin());
+        std::copy_n(values.begin(), m_max.size(), m_max.begin());
+        std::copy_n(values.begin(), m_sum.size(), m_sum.begin());
+    } else {
+        for (std::size_t ch = 0; ch < m_sum.size(); ch++) {
+            m_min[ch] = std::min(m_min[ch], values[ch]);
+            m_max[ch] = std::max(m_max[ch], values[ch]);
+            m_sum[ch] += values[ch];
+        }
+    }
+    m_last = timestamp;
+    m_n++;
+
+    return completed;
+}
+
+bool DecimationTier::finish() {
+    if (m_n == 0)
+        return false;
+
+    complete(m_last);
+    return true;
+}
+
+void DecimationTier::complete(std::uint64_t stop) {
+    m_result_start = m_start;
+    m_result_stop = stop;
+    m_result_n = m_n;
+    for (std::size_t ch = 0; ch < m_sum.size(); ch++) {
+        m_result_min[ch] = m_min[ch];
+        m_result_max[ch] = m_max[ch];
+        m_result_mean[ch] = m_sum[ch] / m_n;
+    }
+
+    m_n = 0;
+}
@@ -36,7 +36,7 @@ DiscriSettingsWindow::DiscriSettingsWindow(Interface& m_interface):
         label_include->setAlignment(Qt::AlignCenter);
         discri_boxLayout->addWidget(label_include, vPos_settingLabels, hPos_include);
 
-        std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getDiscriLock());
+        ProfiledLock m_lock(m_interface.m_conditions->getDiscriLock());
         
         // Display the channel settings themselves
         int vPos_channel = 0;
@@ -105,7 +105,7 @@ void DiscriSettingsWindow::closeEvent(QCloseEvent *event) {
 // Propagate the setting to the condition manager and to the setup
 void DiscriSettingsWindow::propagate() {
         
-    std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getDiscriLock());
+    ProfiledLock m_lock(m_interface.m_conditions->getDiscriLock());
     
     // Majority
     m_interface.m_conditions->setChannelsMajority(m_box_majority->value());
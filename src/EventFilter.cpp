@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <limits>
+
+#include "EventFilter.h"
+
+EventFilter::Settings::Settings():
+    drop_empty(false),
+    time_min(0),
+    time_max(std::numeric_limits<unsigned int>::max()),
+    prescale(1)
+{}
+
+EventFilter::EventFilter(const Settings& settings):
+    m_settings(settings),
+    m_prescale_count(0),
+    m_counts()
+{
+    m_settings.prescale = std::max<std::uint32_t>(m_settings.prescale, 1);
+    for (int channel: m_settings.channels) {
+        if (channel < 0)
+            continue;
+        if (static_cast<std::size_t>(channel) >= m_channel_mask.size())
+            m_channel_mask.resize(channel + 1, false);
+        m_channel_mask[channel] = true;
+    }
+    // A mask without any valid channel removes all the hits
+    if (!m_settings.channels.empty() && m_channel_mask.empty())
+        m_channel_mask.push_back(false);
+
+    m_active = m_settings.drop_empty || !m_channel_mask.empty() || m_settings.time_min > 0
+        || m_settings.time_max < std::numeric_limits<unsigned int>::max() || m_settings.prescale > 1;
+}
+
+void EventFilter::apply(std::vector<EventPool::Handle>& events) {
+    m_counts.events_in += events.size();
+    for (const auto& evt: events)
+        m_counts.hits_in += evt->hits.size();
+
+    if (!m_active) {
+        m_counts.events_kept += events.size();
+        return;
+    }
+
+    // The events kept are moved to the front: those dropped are either overwritten or erased
+    std::size_t n_kept = 0;
+    for (std::size_t i = 0; i < events.size(); i++) {
+        event& evt = *events[i];
+
+        if (evt.tdcErrors.empty()) {
+            // Zero suppression, in place
+            std::size_t n_hits = evt.hits.size();
+            std::size_t n_masked = 0;
+            evt.hits.erase(std::remove_if(evt.hits.begin(), evt.hits.end(), [this, &n_masked](const hit& h) {
+                        if (keepHit(h))
+                            return false;
+                        if (!m_channel_mask.empty() && (h.channel >= m_channel_mask.size() || !m_channel_mask[h.channel]))
+                            n_masked++;
+                        return true;
+                    }), evt.hits.end());
+            m_counts.hits_masked += n_masked;
+            m_counts.hits_outside_window += n_hits - evt.hits.size() - n_masked;
+
+            if (m_settings.drop_empty && evt.hits.empty()) {
+                m_counts.events_empty++;
+                continue;
+            }
+            bool prescaled = (m_prescale_count != 0);
+            m_prescale_count = (m_prescale_count + 1) % m_settings.prescale;
+            if (prescaled) {
+                m_counts.events_prescaled++;
+                continue;
+            }
+        }
+
+        if (i != n_kept)
+            events[n_kept] = std::move(events[i]);
+        n_kept++;
+    }
+    events.erase(events.begin() + n_kept, events.end());
+    m_counts.events_kept += n_kept;
+}
@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "EventPool.h"
+#include "MemoryTracker.h"
+
+void EventPool::Recycler::operator()(event* e) const {
+    if (m_pool)
+        m_pool->release(e);
+    else
+        delete e;
+}
+
+EventPool::EventPool(std::size_t n_events, std::size_t n_hits):
+    m_n_hits(n_hits)
+{
+    allocate(n_events);
+}
+
+void EventPool::allocate(std::size_t n_events) {
+    MemoryScope scope(MemoryTracker::Subsystem::Events);
+
+    // Reserve first, so that releasing events never allocates
+    m_events.reserve(m_events.size() + n_events);
+    m_available.reserve(m_events.size() + n_events);
+
+    for (std::size_t i = 0; i < n_events; i++) {
+        m_events.emplace_back(new event());
+        m_events.back()->hits.reserve(m_n_hits);
+        m_available.push_back(m_events.back().get());
+    }
+}
+
+EventPool::Handle EventPool::acquire() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    // Grow by half: amortised, like a vector
+    if (m_available.empty())
+        allocate(std::max<std::size_t>(m_events.size() / 2, 1));
+
+    event* e = m_available.back();
+    m_available.pop_back();
+    return Handle(e, Recycler(this));
+}
+
+void EventPool::release(event* e) {
+    // Cleared by the thread giving the event back, not by the one acquiring it (the TDC reader)
+    e->clear();
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_available.push_back(e);
+}
+
+std::size_t EventPool::getNAllocated() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_events.size();
+}
+
+std::size_t EventPool::getNAvailable() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_available.size();
+}
@@ -1,73 +1,204 @@
 #include "FakeSetupManager.h"
-#include "Interface.h"
 #include "ConditionManager.h"
+#include "TDC.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 
-FakeSetupManager::FakeSetupManager(Interface& m_interface):
-    m_interface(m_interface)
-    { }
+namespace {
+
+// Frequencies (Hz) of the random trigger of the TTCvi, by frequency setting
+const double RandomRates[] = { 1, 100, 1000, 5000, 10000, 25000, 50000, 100000 };
+
+// Leakage current, in scaler counts per second
+const double LeakRate = 50;
+
+const std::size_t ScalerSlots = static_cast<std::size_t>(ScalerChannel::Ileak) + 1;
+
+// Channels hit in each event, around HitTime (TDC counts)
+const unsigned int HitChannels[] = { 0, 1, 22 };
+const double HitTime = 10000;
+const double HitJitter = 20;
+
+// Words of an event in the output buffer: its hits, a header and a trailer
+const std::size_t WordsPerEvent = sizeof(HitChannels) / sizeof(HitChannels[0]) + 2;
+
+}
+
+constexpr double FakeSetupManager::CosmicRate;
+constexpr double FakeSetupManager::PMTRate;
+const std::size_t FakeSetupManager::DefaultAlmostFullLevel;
+const std::size_t FakeSetupManager::FIFOSize;
+
+FakeSetupManager::FakeSetupManager(ConditionManager& m_conditions):
+    m_conditions(m_conditions),
+    m_last_update(m_clock::now()),
+    m_trigger_rate(0),
+    m_trigger_fraction(0),
+    m_ttc_number(0),
+    m_n_fifo(0),
+    m_almost_full_level(DefaultAlmostFullLevel),
+    m_lost_trigger(false),
+    m_event_number(0),
+    m_scaler_counts(ScalerSlots, 0)
+{
+    for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
+        m_hv_set_values.push_back(m_conditions.getHVPMTSetValue(id));
+        m_hv_on.push_back(m_conditions.getHVPMTSetState(id));
+    }
+}
+
+void FakeSetupManager::update() {
+    m_clock::time_point now = m_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_last_update).count();
+    m_last_update = now;
+    if (elapsed <= 0)
+        return;
+
+    m_trigger_fraction += m_trigger_rate * elapsed;
+    double n_triggered = std::floor(m_trigger_fraction);
+    m_trigger_fraction -= n_triggered;
+
+    std::size_t n_new = static_cast<std::size_t>(n_triggered);
+    m_ttc_number += n_new;
+    if (m_n_fifo + n_new > FIFOSize) {
+        m_lost_trigger = true;
+        n_new = FIFOSize - m_n_fifo;
+    }
+    m_n_fifo += n_new;
+
+    m_scaler_counts[static_cast<std::size_t>(ScalerChannel::PM0)] += PMTRate * elapsed;
+    m_scaler_counts[static_cast<std::size_t>(ScalerChannel::PM1)] += PMTRate * elapsed;
+    m_scaler_counts[static_cast<std::size_t>(ScalerChannel::NIM)] += n_triggered;
+    m_scaler_counts[static_cast<std::size_t>(ScalerChannel::VME)] += n_triggered;
+    m_scaler_counts[static_cast<std::size_t>(ScalerChannel::TTC)] += n_triggered;
+    m_scaler_counts[static_cast<std::size_t>(ScalerChannel::Ileak)] += LeakRate * elapsed;
+}
 
 bool FakeSetupManager::setHVPMT(std::size_t id) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_hv_set_values.at(id) = m_conditions.getHVPMTSetValue(id);
     return true;
 }
 
 bool FakeSetupManager::switchHVPMTON(std::size_t id) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_hv_on.at(id) = true;
     return true;
 }
 
 bool FakeSetupManager::switchHVPMTOFF(std::size_t id) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_hv_on.at(id) = false;
     return true;
 }
 
 std::vector< std::pair<double, double> > FakeSetupManager::getHVPMTValue() {
+    std::lock_guard<std::mutex> lock(m_mtx);
     std::vector< std::pair<double, double> > hv_values;
-    for (std::size_t id = 0; id < m_interface.getConditions().getNHVPMT(); id++) {
-        hv_values.push_back(std::make_pair(0., 0.));
+    for (std::size_t id = 0; id < m_hv_set_values.size(); id++) {
+        double value = m_hv_on[id] ? m_hv_set_values[id] : 0.;
+        hv_values.push_back(std::make_pair(value, 0.));
     }
     return hv_values;
 }
 
 void FakeSetupManager::setTrigger(int channel, int frequency) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    if (channel == 7)
+        m_trigger_rate = 0;
+    else if (channel == 5 || channel == -1)
+        m_trigger_rate = RandomRates[static_cast<std::size_t>(frequency) % (sizeof(RandomRates) / sizeof(RandomRates[0]))];
+    else
+        m_trigger_rate = CosmicRate;
 }
 
 void FakeSetupManager::resetTrigger() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    m_ttc_number = 0;
 }
 
 std::int64_t FakeSetupManager::getTTCEventNumber() {
-    return 10;
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    return m_ttc_number;
 }
 
 bool FakeSetupManager::propagateDiscriSettings() {
     return true;
 }
 
-void FakeSetupManager::setTDCWindowOffset(int offset) {
+void FakeSetupManager::setTDCWindowOffset(int /*offset*/) {
 }
 
-void FakeSetupManager::setTDCWindowWidth(int width) {
+void FakeSetupManager::setTDCWindowWidth(int /*width*/) {
 }
 
 unsigned int FakeSetupManager::getTDCStatus() {
-    return 1;
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+
+    unsigned int status = 0;
+    if (m_n_fifo > 0)
+        status |= v1190::status::DataReady::mask;
+    if (m_n_fifo * WordsPerEvent >= m_almost_full_level)
+        status |= v1190::status::AlmostFull::mask;
+    if (m_n_fifo >= FIFOSize)
+        status |= v1190::status::Full::mask;
+    if (m_lost_trigger)
+        status |= v1190::status::TriggerLost::mask;
+    return status;
 }
 
 int FakeSetupManager::getTDCNEvents() {
-    return 10;
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    return static_cast<int>(m_n_fifo);
 }
 
-event FakeSetupManager::getTDCEvent() {
-    event m_event;
-    m_event.errorCode = 0;
-    return m_event;
+void FakeSetupManager::getTDCEvent(event& e) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    e.clear();
+    if (m_n_fifo == 0)
+        // Nothing to read: not a valid event
+        return;
+
+    std::normal_distribution<double> jitter(HitTime, HitJitter);
+    e.eventNumber = m_event_number++;
+    e.time = DAQSystemClock::to_time_t(DAQSystemClock::now());
+    e.errorCode = 0;
+    for (unsigned int channel: HitChannels)
+        e.hits.push_back({ channel, static_cast<unsigned int>(std::max(jitter(m_random), 0.)), true });
+    m_n_fifo--;
 }
 
 void FakeSetupManager::configureTDC() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    m_n_fifo = 0;
+    m_lost_trigger = false;
+    m_event_number = 0;
+    m_random.seed(std::mt19937::default_seed);
+}
+
+void FakeSetupManager::setTDCAlmostFullLevel(unsigned int words) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_almost_full_level = std::min<std::size_t>(std::max(words, 1u), 32735);
 }
 
 void FakeSetupManager::resetScaler() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    std::fill(m_scaler_counts.begin(), m_scaler_counts.end(), 0);
 }
 
 int FakeSetupManager::getScalerCount(ScalerChannel channel) {
-    return static_cast<int>(channel);
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    double count = m_scaler_counts.at(static_cast<std::size_t>(channel));
+    // 32-bit counter, as on the board
+    return static_cast<int>(static_cast<std::uint32_t>(static_cast<std::uint64_t>(count)));
 }
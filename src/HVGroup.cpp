@@ -33,7 +33,7 @@ HVGroup::HVGroup(Interface& m_interface):
 
         //m_layout->addWidget(toplabel_read_state, 0, 4);
     
-        std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getHVLock());
+        ProfiledLock m_lock(m_interface.m_conditions->getHVLock());
 
         for (int hv_id = 0; hv_id < m_interface.m_conditions->getNHVPMT(); hv_id++) {
 
@@ -63,6 +63,9 @@ HVGroup::HVGroup(Interface& m_interface):
 
             hventry.readCurrent_label = new QLabel(QString::number(m_interface.m_conditions->getHVPMTReadCurrent(hv_id)));
             hventry.readCurrent_label->setAlignment(Qt::AlignCenter);
+
+            hventry.displayed = { setHVValue, m_interface.m_conditions->getHVPMTReadValue(hv_id), m_interface.m_conditions->getHVPMTReadCurrent(hv_id), hventry.cb_set_state->isChecked() };
+            hventry.displayedInRange = false;
             
             m_hventries.push_back(hventry);
 
@@ -95,9 +98,7 @@ HVGroup::HVGroup(Interface& m_interface):
         setLayout(m_layout);
 }
 
-void HVGroup::notifyUpdate() {
-    std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getHVLock());
-
+void HVGroup::notifyUpdate(const ConditionManager::Status& status) {
     //if (m_interface.m_conditions->getHVPMTReadState(0)) {
     //    m_on_btn->hide();
     //    m_off_btn->show();
@@ -105,20 +106,26 @@ void HVGroup::notifyUpdate() {
     //    m_off_btn->hide();
     //    m_on_btn->show();
     //}
-    for (int hv_id = 0; hv_id < m_interface.m_conditions->getNHVPMT(); hv_id++) {
-        if (std::abs(m_interface.m_conditions->getHVPMTReadValue(hv_id) - m_interface.m_conditions->getHVPMTSetValue(hv_id))/float(m_interface.m_conditions->getHVPMTSetValue(hv_id)) > 0.05) {
-            m_hventries.at(hv_id).readValue_label->setStyleSheet("QLabel { background-color : red; }");
-        } else {
-            m_hventries.at(hv_id).readValue_label->setStyleSheet("QLabel { background-color : green; }");
+    for (std::size_t hv_id = 0; hv_id < status.hv.size() && hv_id < m_hventries.size(); hv_id++) {
+        const ConditionManager::HVPMT& hv = status.hv.at(hv_id);
+        HVEntry& hventry = m_hventries.at(hv_id);
+
+        // Changing the style sheet re-polishes the label: only do it when the colour changes
+        bool in_range = !(std::abs(hv.readValue - hv.setValue)/float(hv.setValue) > 0.05);
+        if (in_range != hventry.displayedInRange) {
+            hventry.readValue_label->setStyleSheet(in_range ? "QLabel { background-color : green; }" : "QLabel { background-color : red; }");
+            hventry.displayedInRange = in_range;
         }
-        m_hventries.at(hv_id).readValue_label->setText(QString::number(m_interface.m_conditions->getHVPMTReadValue(hv_id)));
-        m_hventries.at(hv_id).readCurrent_label->setText(QString::number(m_interface.m_conditions->getHVPMTReadCurrent(hv_id)));
+        if (hv.readValue != hventry.displayed.readValue)
+            hventry.readValue_label->setText(QString::number(hv.readValue));
+        if (hv.readCurrent != hventry.displayed.readCurrent)
+            hventry.readCurrent_label->setText(QString::number(hv.readCurrent));
+        hventry.displayed = hv;
     }
-
 }
 
 void HVGroup::switchON() {
-    std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getHVLock());
+    ProfiledLock m_lock(m_interface.m_conditions->getHVLock());
 
     // Propagate the new states to the Condition manager
     // Condition manager will tell setup manager to actually set the right state
@@ -132,7 +139,7 @@ void HVGroup::switchON() {
 }
 
 /*void HVGroup::switchOFF() {
-    std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getHVLock());
+    ProfiledLock m_lock(m_interface.m_conditions->getHVLock());
 
     // Update Condition manager with new HV states
     for (std::size_t id = 0; id < m_hventries.size(); id++) {
@@ -144,7 +151,7 @@ void HVGroup::switchON() {
 }*/
 
 void HVGroup::setHV() {
-    std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getHVLock());
+    ProfiledLock m_lock(m_interface.m_conditions->getHVLock());
 
     // Update Condition manager with new HV set values
     for (std::size_t id = 0; id < m_hventries.size(); id++) {
@@ -0,0 +1,57 @@
+#include <QPainter>
+#include <QPaintEvent>
+#include <QFontMetrics>
+
+#include <algorithm>
+
+#include "HistogramWidget.h"
+
+HistogramWidget::HistogramWidget(QString title, QString x_label, QWidget* parent):
+    QWidget(parent),
+    m_title(title),
+    m_x_label(x_label),
+    m_x_min(0),
+    m_x_max(0)
+{
+    setMinimumSize(240, 120);
+}
+
+void HistogramWidget::setData(const std::vector<double>& values, double x_min, double x_max) {
+    m_values = values;
+    m_x_min = x_min;
+    m_x_max = x_max;
+    update();
+}
+
+void HistogramWidget::paintEvent(QPaintEvent*) {
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+
+    int line_height = painter.fontMetrics().height();
+    QRect plot = rect().adjusted(4, line_height + 4, -4, -line_height - 4);
+
+    double max = m_values.empty() ? 0 : *std::max_element(m_values.begin(), m_values.end());
+    painter.setPen(Qt::black);
+    painter.drawText(rect().adjusted(4, 2, -4, 0), Qt::AlignLeft | Qt::AlignTop, m_title);
+    painter.drawText(rect().adjusted(4, 2, -4, 0), Qt::AlignRight | Qt::AlignTop, "max " + QString::number(max, 'g', 4));
+
+    // Bars, scaled to the highest bin
+    if (max > 0 && plot.width() > 0) {
+        double bar_width = static_cast<double>(plot.width()) / m_values.size();
+        for (std::size_t i = 0; i < m_values.size(); i++) {
+            int height = static_cast<int>(plot.height() * m_values[i] / max + 0.5);
+            if (height <= 0)
+                continue;
+            QRectF bar(plot.left() + i * bar_width, plot.bottom() - height, std::max(bar_width, 1.), height);
+            painter.fillRect(bar, QColor(70, 110, 180));
+        }
+    }
+
+    painter.setPen(Qt::gray);
+    painter.drawLine(plot.bottomLeft(), plot.bottomRight());
+    painter.setPen(Qt::black);
+    QRect axis = rect().adjusted(4, 0, -4, -2);
+    painter.drawText(axis, Qt::AlignLeft | Qt::AlignBottom, QString::number(m_x_min, 'g', 6));
+    painter.drawText(axis, Qt::AlignHCenter | Qt::AlignBottom, m_x_label);
+    painter.drawText(axis, Qt::AlignRight | Qt::AlignBottom, QString::number(m_x_max, 'g', 6));
+}
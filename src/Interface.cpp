@@ -14,61 +14,22 @@
 #include <cstdint>
 
 #include "Interface.h"
-#include "LoggingManager.h"
+#include "RunController.h"
 #include "ConditionManager.h"
 #include "HVGroup.h"
 #include "Trigger_TDC_Group.h"
+#include "AnalysisGroup.h"
+#include "LiveHistogramsGroup.h"
 #include "DiscriSettingsWindow.h"
 
-// Static
-const std::vector< std::pair<Interface::State, Interface::State> > Interface::m_transitions = {
-    { Interface::State::idle, Interface::State::configured },
-    { Interface::State::configured, Interface::State::running },
-    { Interface::State::running, Interface::State::idle },
-    { Interface::State::configured, Interface::State::idle }
-};
-
-// Static
-std::string Interface::stateToString(Interface::State state) {
-    switch(state) {
-        case State::idle:
-            return "idle";
-        case State::configured:
-            return "configured";
-        case State::running:
-            return "running";
-        default:
-            return "Unknown state!";
-    }
-}
-
-// Static
-bool Interface::checkTransition(Interface::State state_from, Interface::State state_to) { 
-    return std::find(m_transitions.begin(), m_transitions.end(), std::pair<State, State>( { state_from, state_to } ) ) != m_transitions.end();
-}
-
-bool Interface::setState(Interface::State state) {
-    if( state == m_state ) {
-        std::cout << "Interface is already in state " << stateToString(m_state) << std::endl;
-        return false;
-    }
- 
-    if( !checkTransition(m_state, state) ) { 
-        throw std::runtime_error("Transition from " + stateToString(m_state) + " to " + stateToString(state) + " is not allowed.");
-    }
- 
-    std::cout << "Changing Interface state from " << stateToString(m_state) << " to " << stateToString(state) << std::endl;
-
-    m_state = state;
-
-    return true;
-}
-
-Interface::Interface(Arguments m_args, QWidget *parent): 
+Interface::Interface(RunController& m_controller, QWidget *parent): 
     QWidget(parent),
-    m_args(m_args),
-    m_conditions(new ConditionManager(*this, m_args.use_fake_setup)),
-    m_state(State::idle)
+    m_controller(m_controller),
+    m_conditions(&m_controller.getConditions()),
+    m_displayed_state(RunController::State::idle),
+    m_analysis_group(nullptr),
+    m_refresh_period(m_controller.getArguments().gui_refresh_period),
+    m_refresh_pending(false)
     {
 
         std::cout << "Creating Interface. Qt version: " << qVersion() << "." << std::endl;
@@ -107,6 +68,13 @@ Interface::Interface(Arguments m_args, QWidget *parent):
         /* ------ TDC & TTC control box -----  */
         m_ttc_tdc_group = new Trigger_TDC_Group(*this);
 
+        /* ------ Online analysis box -----  */
+        if (m_controller.getAnalysis().get())
+            m_analysis_group = new AnalysisGroup(*this, m_controller.getAnalysis());
+
+        /* ------ Live histograms box (refreshed by its own timer) -----  */
+        m_live_histograms_group = new LiveHistogramsGroup(*this);
+
         /* ----- Discri tuner & scaler reset ----- */
         QVBoxLayout *discri_scaler_layout = new QVBoxLayout();
         m_discriTunerBtn = new QPushButton("Discriminator Settings");
@@ -124,6 +92,9 @@ Interface::Interface(Arguments m_args, QWidget *parent):
         master_grid->addLayout(discri_scaler_layout, 1, 0);
         master_grid->addWidget(m_ttc_tdc_group, 1, 1);
         master_grid->addWidget(quit, 2, 0);
+        if (m_analysis_group)
+            master_grid->addWidget(m_analysis_group, 0, 2, 3, 1);
+        master_grid->addWidget(m_live_histograms_group, 0, 3, 3, 1);
 
         setLayout(master_grid);
 
@@ -133,137 +104,170 @@ Interface::Interface(Arguments m_args, QWidget *parent):
         connect(m_stopBtn, &QPushButton::clicked, this, &Interface::stopRun);
         connect(m_discriTunerBtn, &QPushButton::clicked, this, &Interface::showDiscriSettingsWindow);
         connect(scaler_resetBtn, &QPushButton::clicked, this, [&](){
-                    std::lock_guard<std::mutex> m_lock(m_conditions->getScalerLock());
+                    ProfiledLock m_lock(m_conditions->getScalerLock());
                     m_conditions->resetScaler();
                 }
             );
         connect(quit, &QPushButton::clicked, this, &Interface::quit);
 
-        m_timer = new QTimer(this);
-        connect(m_timer, &QTimer::timeout, this, &Interface::notifyUpdate);
-        m_timer->start(250);
+        /* ----- Refresh when notified by the daemons or by another client ----- */
+        notifyUpdate();
+        m_controller.setStateListener([this]() { postRefresh(); });
+        m_conditions->setStatusListener([this]() { postRefresh(); });
+        m_controller.setQuitHandler([this]() { QMetaObject::invokeMethod(this, "quitFromClient", Qt::QueuedConnection); });
     }
 
+Interface::~Interface() {
+    m_controller.setQuitHandler(nullptr);
+    m_controller.setStateListener(nullptr);
+    m_conditions->setStatusListener(nullptr);
+}
+
 ConditionManager& Interface::getConditions() {
     return *m_conditions;
 }
 
+void Interface::postRefresh() {
+    if (!m_refresh_pending.exchange(true))
+        QMetaObject::invokeMethod(this, "refresh", Qt::QueuedConnection);
+}
+
+void Interface::refresh() {
+    if (m_last_refresh.isValid()) {
+        qint64 wait = m_refresh_period - m_last_refresh.elapsed();
+        if (wait > 0) {
+            QTimer::singleShot(wait, this, &Interface::refresh);
+            return;
+        }
+    }
+
+    // Changes published from now on need another refresh
+    m_refresh_pending = false;
+    m_last_refresh.start();
+    notifyUpdate();
+}
+
 void Interface::notifyUpdate() {
+    syncRunState();
+
+    // Values published by the daemons: no hardware lock is taken
+    ConditionManager::Status status = m_conditions->getStatus();
+
     // Update HV values
-    m_hv_group->notifyUpdate();
+    m_hv_group->notifyUpdate(status);
 
-    if (m_state == State::running) {
+    if (m_displayed_state == RunController::State::running) {
         // Update TDC status flags
-        m_ttc_tdc_group->notifyUpdate();
+        m_ttc_tdc_group->notifyUpdate(status);
+
+        if (m_analysis_group)
+            m_analysis_group->notifyUpdate();
     }
 }
 
+void Interface::syncRunState() {
+    RunController::State state = m_controller.getState();
+    if (state == m_displayed_state)
+        return;
+
+    switch(state) {
+        case RunController::State::idle:
+            m_startBtn->setDisabled(true);
+            m_stopBtn->setDisabled(true);
+            m_configureBtn->setDisabled(false);
+            
+            m_ttc_tdc_group->atStopRun();
+            if (m_analysis_group)
+                m_analysis_group->atStopRun();
+            m_live_histograms_group->atStopRun();
+
+            m_runNumberLabel->hide();
+            m_runNumberSpin->setValue(m_controller.getRunNumber() + 1);
+            m_runNumberSpin->show();
+            break;
+        
+        case RunController::State::configured:
+        case RunController::State::running:
+            m_startBtn->setDisabled(state == RunController::State::running);
+            m_stopBtn->setDisabled(false);
+            m_configureBtn->setDisabled(true);
+            
+            if (m_displayed_state == RunController::State::idle)
+                m_ttc_tdc_group->atConfigureRun();
+            if (state == RunController::State::running) {
+                m_ttc_tdc_group->atStartRun();
+                m_live_histograms_group->atStartRun();
+            }
+
+            m_runNumberSpin->hide();
+            m_runNumberLabel->setText(QString::number(m_controller.getRunNumber()));
+            m_runNumberLabel->show();
+            break;
+    }
+
+    m_displayed_state = state;
+}
+
 void Interface::updateConditionLog() {
-    if (m_state != State::idle)
-        m_logging_manager->updateConditionManagerLog();
+    m_controller.updateConditionLog();
 }
 
 void Interface::configureRun() {
     std::uint32_t run_number = m_runNumberSpin->value();
 
     // Check if we can start with the given run number
-    if (LoggingManager::checkRunNumber(run_number)) {
+    if (m_controller.runFilesExist(run_number)) {
         QMessageBox msgBox(QMessageBox::Warning, "Warning", "Warning: log files for run number " + QString::number(run_number) + " already exist. Do you want to go on and overwrite them?", QMessageBox::Ok | QMessageBox::Cancel);
         msgBox.setDefaultButton(QMessageBox::Cancel);
         if (msgBox.exec() == QMessageBox::Cancel)
             return;
     }
 
-    m_startBtn->setDisabled(false);
-    m_stopBtn->setDisabled(false);
-    m_configureBtn->setDisabled(true);
-
-    m_runNumberSpin->hide();
-    m_runNumberLabel->setText(QString::number(run_number));
-    m_runNumberLabel->show();
-    
-    {
-        std::lock_guard<std::mutex> m_lock(m_conditions->getDiscriLock());
-        m_conditions->propagateDiscriSettings();
+    try {
+        m_ttc_tdc_group->propagateTriggerSettings();
+        m_controller.configureRun(run_number);
+    } catch (RunController::run_control_error& e) {
+        std::cerr << "Could not configure run: " << e.what() << std::endl;
     }
-
-    m_logging_manager = std::make_shared<LoggingManager>(*this, run_number, m_args.log_path);
-    
-    m_ttc_tdc_group->atConfigureRun();
-
-    m_state = State::configured;
     
     notifyUpdate();
 }
 
 void Interface::startRun() {
-    m_startBtn->setDisabled(true);
-    m_stopBtn->setDisabled(false);
-    m_configureBtn->setDisabled(true);
-
-    // Start continuous logging
-    thread_handler = std::thread(&LoggingManager::run, std::ref(*m_logging_manager));
-    
-    m_ttc_tdc_group->atStartRun();
-    m_conditions->startScalerDaemon();
-
-    //m_hv_group->setRunning();
-    
-    m_state = State::running;
+    try {
+        m_controller.startRun();
+    } catch (RunController::run_control_error& e) {
+        std::cerr << "Could not start run: " << e.what() << std::endl;
+    }
     
     notifyUpdate();
 }
     
 void Interface::stopRun() {
-    m_ttc_tdc_group->atStopRun();
-
-    if (m_state == State::running) {
-        // Stop logging
-        m_logging_manager->stop();
-        thread_handler.join();
-    
-        m_conditions->stopScalerDaemon();
- 
-        //m_hv_group->setNotRunning();
-    }
-
-    if (m_state == State::running || m_state == State::configured) {
-        m_startBtn->setDisabled(true);
-        m_stopBtn->setDisabled(true);
-        m_configureBtn->setDisabled(false);
-        
-        // Destroy logging manager
-        m_logging_manager.reset();
-
-        m_runNumberLabel->hide();
-        m_runNumberSpin->setValue(m_runNumberSpin->value() + 1);
-        m_runNumberSpin->show();
-    }
-
-    m_state = State::idle;
+    m_controller.stopRun();
 
     notifyUpdate();
 }
 
 void Interface::quit() {
-    if (m_state == State::idle) {
-        qApp->quit();
-    }
-
-    if (m_state == State::configured) {
-        stopRun();
-        qApp->quit();
-    }
-
-    if (m_state == State::running) {
+    if (m_controller.getState() == RunController::State::running) {
         QMessageBox msgBox(QMessageBox::Warning, "Warning", "Warning: a run is ongoing! Do you really want to quit?", QMessageBox::Ok | QMessageBox::Cancel);
         msgBox.setDefaultButton(QMessageBox::Cancel);
         if (msgBox.exec() == QMessageBox::Cancel)
             return;
+    }
 
+    if (m_controller.getState() != RunController::State::idle)
         stopRun();
-        qApp->quit();
-    }
+    
+    qApp->quit();
+}
+
+void Interface::quitFromClient() {
+    if (m_controller.getState() != RunController::State::idle)
+        stopRun();
+
+    qApp->quit();
 }
 
 // When clicking the "DiscriSetting button", open a pop up window
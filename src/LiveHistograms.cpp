@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include "LiveHistograms.h"
+
+LiveHistograms::LiveHistograms(std::size_t n_channels, std::size_t n_time_bins, std::uint32_t time_range):
+    m_n_channels(n_channels),
+    m_n_time_bins(std::max<std::size_t>(n_time_bins, 1)),
+    m_time_bin_width(std::max<std::uint32_t>((time_range + m_n_time_bins - 1) / m_n_time_bins, 1)),
+    m_n_counters(OccupancyCounters + m_n_channels * (1 + m_n_time_bins)),
+    m_baseline(m_n_counters, 0),
+    m_sums(m_n_counters, 0)
+{}
+
+void LiveHistograms::Writer::fill(const event& e) {
+    increment(EventsCounter);
+
+    const LiveHistograms& h = m_histograms;
+    for (const hit& this_hit: e.hits) {
+        increment(HitsCounter);
+        if (this_hit.channel >= h.m_n_channels) {
+            increment(OtherHitsCounter);
+            continue;
+        }
+        increment(OccupancyCounters + this_hit.channel);
+        std::size_t bin = std::min<std::size_t>(this_hit.time / h.m_time_bin_width, h.m_n_time_bins - 1);
+        increment(h.timeCounter(this_hit.channel, bin));
+    }
+}
+
+LiveHistograms::Writer LiveHistograms::makeWriter() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_shards.emplace_back(new Shard(m_n_counters));
+    return Writer(*m_shards.back(), *this);
+}
+
+void LiveHistograms::sumShards() {
+    std::fill(m_sums.begin(), m_sums.end(), 0);
+    for (const auto& shard: m_shards)
+        for (std::size_t i = 0; i < m_n_counters; i++)
+            m_sums[i] += shard->counters[i].load(std::memory_order_relaxed);
+}
+
+void LiveHistograms::getSnapshot(Snapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    sumShards();
+
+    // Counters only grow, but each one is read at a slightly different time: clamp at 0
+    auto count = [this](std::size_t counter) {
+        return m_sums[counter] > m_baseline[counter] ? m_sums[counter] - m_baseline[counter] : 0;
+    };
+
+    snapshot.n_channels = m_n_channels;
+    snapshot.n_time_bins = m_n_time_bins;
+    snapshot.time_bin_width = m_time_bin_width;
+    snapshot.n_events = count(EventsCounter);
+    snapshot.n_hits = count(HitsCounter);
+    snapshot.n_other_hits = count(OtherHitsCounter);
+    snapshot.occupancy.resize(m_n_channels);
+    snapshot.time.resize(m_n_channels * m_n_time_bins);
+    for (std::size_t channel = 0; channel < m_n_channels; channel++) {
+        snapshot.occupancy[channel] = count(OccupancyCounters + channel);
+        for (std::size_t bin = 0; bin < m_n_time_bins; bin++)
+            snapshot.time[channel * m_n_time_bins + bin] = count(timeCounter(channel, bin));
+    }
+}
+
+void LiveHistograms::reset() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    sumShards();
+    m_baseline = m_sums;
+}
@@ -0,0 +1,93 @@
+#include <QString>
+#include <QGroupBox>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QSpinBox>
+#include <QTimer>
+
+#include "LiveHistogramsGroup.h"
+#include "HistogramWidget.h"
+#include "Interface.h"
+#include "ConditionManager.h"
+
+LiveHistogramsGroup::LiveHistogramsGroup(Interface& m_interface):
+    m_interface(m_interface),
+    m_last_n_events(0),
+    QGroupBox("TDC live histograms", &m_interface) {
+
+        LiveHistograms& histograms = m_interface.m_conditions->getTDCLiveHistograms();
+
+        QVBoxLayout *histograms_layout = new QVBoxLayout();
+
+        QHBoxLayout *channel_layout = new QHBoxLayout();
+        QLabel *channel_label = new QLabel("Hit times of channel");
+        m_channel_box = new QSpinBox();
+        m_channel_box->setRange(0, static_cast<int>(histograms.getNChannels()) - 1);
+        m_summary_label = new QLabel();
+        channel_layout->addWidget(channel_label);
+        channel_layout->addWidget(m_channel_box);
+        channel_layout->addStretch();
+        channel_layout->addWidget(m_summary_label);
+        histograms_layout->addLayout(channel_layout);
+
+        m_time_plot = new HistogramWidget("Hit time", "TDC counts");
+        m_occupancy_plot = new HistogramWidget("Hits per event", "channel");
+        m_rate_plot = new HistogramWidget("Event rate (Hz)", "time (s)");
+        histograms_layout->addWidget(m_time_plot);
+        histograms_layout->addWidget(m_occupancy_plot);
+        histograms_layout->addWidget(m_rate_plot);
+        setLayout(histograms_layout);
+
+        m_timer = new QTimer(this);
+        connect(m_timer, &QTimer::timeout, this, &LiveHistogramsGroup::refresh);
+        connect(m_channel_box, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &LiveHistogramsGroup::refresh);
+}
+
+void LiveHistogramsGroup::refresh() {
+    if (!m_timer->isActive())
+        return;
+
+    m_interface.m_conditions->getTDCLiveHistograms().getSnapshot(m_snapshot);
+
+    // Event rate since the last refresh
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - m_last_refresh).count();
+    if (seconds > 0.5 * RefreshPeriod / 1000.) {
+        double rate = m_snapshot.n_events >= m_last_n_events ? (m_snapshot.n_events - m_last_n_events) / seconds : 0;
+        m_rates.push_back(rate);
+        if (m_rates.size() > RateHistoryLength)
+            m_rates.pop_front();
+        m_last_n_events = m_snapshot.n_events;
+        m_last_refresh = now;
+    }
+
+    // Nothing to repaint if the window is hidden
+    if (!isVisible())
+        return;
+
+    m_summary_label->setText(QString::number(m_snapshot.n_events) + " events, " + QString::number(m_snapshot.n_hits) + " hits");
+
+    std::size_t channel = m_channel_box->value();
+    m_values.assign(m_snapshot.time.begin() + channel * m_snapshot.n_time_bins, m_snapshot.time.begin() + (channel + 1) * m_snapshot.n_time_bins);
+    m_time_plot->setData(m_values, 0, static_cast<double>(m_snapshot.n_time_bins) * m_snapshot.time_bin_width);
+
+    m_values.resize(m_snapshot.n_channels);
+    for (std::size_t i = 0; i < m_snapshot.n_channels; i++)
+        m_values[i] = m_snapshot.n_events ? static_cast<double>(m_snapshot.occupancy[i]) / m_snapshot.n_events : 0;
+    m_occupancy_plot->setData(m_values, 0, m_snapshot.n_channels);
+
+    m_values.assign(m_rates.begin(), m_rates.end());
+    m_rate_plot->setData(m_values, -static_cast<double>(m_rates.size()) * RefreshPeriod / 1000., 0);
+}
+
+void LiveHistogramsGroup::atStartRun() {
+    m_rates.clear();
+    m_last_n_events = 0;
+    m_last_refresh = std::chrono::steady_clock::now();
+    m_timer->start(RefreshPeriod);
+}
+
+void LiveHistogramsGroup::atStopRun() {
+    m_timer->stop();
+}
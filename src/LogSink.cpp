@@ -0,0 +1,86 @@
+#include <iostream>
+#include <algorithm>
+
+#include "LogSink.h"
+#include "Plugins.h"
+
+//--- Sink plugins
+
+std::shared_ptr<LogSink> createSink(const std::string& plugin, const SinkContext& context) {
+    typedef LogSink* (*CreateFunction)(const SinkContext&);
+    CreateFunction create = PluginLoader::get().getFunction<CreateFunction>(plugin, "slowControlCreateSink");
+    return std::shared_ptr<LogSink>(create(context));
+}
+
+//--- AsyncPublisher
+
+AsyncPublisher::AsyncPublisher(ThreadSettings settings, MemoryTracker::Subsystem subsystem, std::size_t max_queue):
+    m_subsystem(subsystem),
+    m_max_queue(std::max<std::size_t>(max_queue, 1)),
+    m_stop(false),
+    m_n_dropped(0)
+{
+    m_thread = startThread(settings, [this]() { run(); });
+}
+
+AsyncPublisher::~AsyncPublisher() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+
+    if (m_n_dropped)
+        std::cerr << "Warning: " << m_n_dropped << " records were dropped because a sink was too slow." << std::endl;
+}
+
+void AsyncPublisher::publish(std::shared_ptr<LogSink> sink, const LogRecord& record) {
+    MemoryScope memory_scope(m_subsystem);
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+
+        // Keep the most recent records
+        if (m_queue.size() >= m_max_queue) {
+            m_queue.pop_front();
+            if (m_n_dropped++ == 0)
+                std::cerr << "Warning: a sink is too slow, dropping records." << std::endl;
+        }
+
+        m_queue.emplace_back();
+        m_queue.back().first = sink;
+        LogRecord& copy = m_queue.back().second;
+        copy.timestamp = record.timestamp;
+        copy.n_samples = record.n_samples;
+        copy.mean = record.mean;
+        copy.min = record.min;
+        copy.max = record.max;
+        copy.values = record.values;
+    }
+    m_cv.notify_one();
+}
+
+std::size_t AsyncPublisher::getNDropped() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_n_dropped;
+}
+
+void AsyncPublisher::run() {
+    MemoryScope memory_scope(m_subsystem);
+    std::unique_lock<std::mutex> lock(m_mtx);
+
+    while (true) {
+        m_cv.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+
+        // Publish the remaining records before stopping
+        if (m_queue.empty())
+            break;
+
+        auto entry = std::move(m_queue.front());
+        m_queue.pop_front();
+
+        lock.unlock();
+        entry.first->write(entry.second);
+        lock.lock();
+    }
+}
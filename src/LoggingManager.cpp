@@ -4,35 +4,57 @@
 #include <chrono>
 #include <atomic>
 #include <exception>
-
-#include <json/writer.h>
+#include <cstdio>
+#include <algorithm>
 
 #include "LoggingManager.h"
 #include "ConditionManager.h"
-#include "Interface.h"
 #include "Utils.h"
-#include "PythonDB.h"
+#include "TSDBSpool.h"
+#include "Logger.h"
+#include "MemoryTracker.h"
+
+namespace {
+
+EventFilter::Settings makeFilterSettings(const Arguments& m_args) {
+    EventFilter::Settings settings;
+    settings.drop_empty = m_args.filter_empty;
+    settings.channels = m_args.filter_channels;
+    settings.time_min = m_args.filter_time_min;
+    settings.time_max = m_args.filter_time_max;
+    settings.prescale = m_args.filter_prescale;
+    return settings;
+}
 
-LoggingManager::LoggingManager(Interface& m_interface, std::uint32_t run_number, std::string m_path, std::uint32_t m_continuous_log_time):
-    m_interface(m_interface),
+}
+
+// Static
+const std::vector<std::string> LoggingManager::ThreadNames = { "hv", "tdc", "scaler", "bus", "logger", "tsdb", "tsdb-replay", "gui", "socket" };
+const std::uint64_t LoggingManager::FastTierPeriod = 1000;
+const std::uint64_t LoggingManager::SlowTierPeriod = 60000;
+
+LoggingManager::LoggingManager(ConditionManager& m_conditions, std::uint32_t run_number, const Arguments& m_args, std::shared_ptr<TSDBSpool> tsdb_spool, std::shared_ptr<OnlineAnalysis> analysis):
+    m_conditions(m_conditions),
+    m_log_path(m_args.log_path),
+    m_sample_time(m_args.sample_period),
+    m_ring_length(m_args.ring_length),
     m_run_number(run_number),
-    m_log_path(m_path),
-    m_conditions(m_interface.getConditions()),
-    is_running(true),
-    m_continuous_log_time(m_continuous_log_time),
-    m_condition_json_list(Json::arrayValue),
-    m_TDC_eventBuffer_flushSize(500)
+    m_tsdb_thread_settings(makeThreadSettings(m_args, "tsdb")),
+    m_sinks(m_args.sinks),
+    m_dump_pending(false),
+    m_dump_countdown(0),
+    m_n_dumps(0),
+    m_last_TDC_fatal(false),
+    m_last_TDC_backPressureEpisodes(0),
+    m_tsdb_spool(tsdb_spool),
+    m_analysis(analysis),
+    m_event_filter(makeFilterSettings(m_args))
 {
     std::cout << "Creating LoggingManager for run number " << run_number << "." << std::endl;
 
-    // Try to connect to OpenTSDB client
-    try {
-        m_DB = std::make_shared<OpenTSDBInterface>();
-    } catch (OpenTSDBInterface::initialise_error& e) {
-        std::cerr << "Warning when starting LoggingManager: " << e.what() << std::endl;
-        m_DB.reset();
-    }
-    
+    if (m_analysis.get())
+        m_analysis->reset();
+
     initConditionManagerLog();
     initContinuousLog();
 }
@@ -40,8 +62,9 @@ LoggingManager::LoggingManager(Interface& m_interface, std::uint32_t run_number,
 LoggingManager::~LoggingManager() {
     std::cout << "Destroying LoggingManager." << std::endl;
     
-    finalizeConditionManagerLog();
+    // The continuous log first: its last record gives the final counts of the event filter
     finalizeContinuousLog();
+    finalizeConditionManagerLog();
 }
 
 bool LoggingManager::checkRunNumber(std::uint32_t number, std::string log_path) {
@@ -51,204 +74,422 @@ bool LoggingManager::checkRunNumber(std::uint32_t number, std::string log_path)
     if (std::ifstream(log_path + "/cond_log_run_" + std::to_string(number) + ".json")) {
         return true;
     }
+    if (std::ifstream(log_path + "/cond_journal_run_" + std::to_string(number) + ".jsonl")) {
+        return true;
+    }
     if (std::ifstream(log_path + "/events_run_" + std::to_string(number) + ".root")) {
         return true;
     }
+    if (std::ifstream(log_path + "/events_run_" + std::to_string(number) + ".evcol")) {
+        return true;
+    }
     return false;
 }
 
-void LoggingManager::run(){
-    std::cout << "Starting logger." << std::endl;
-    
-    auto logging_start = m_clock::now();
+void LoggingManager::sample() {
+    sampleConditions(m_clock::now());
+    m_condition_journal->syncIfDue();
+}
 
-    // Fill the log once at start
-    updateContinuousLog(logging_start);
-    
-    while(is_running){
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-       
-        // Loop updating the continuous log every X
-        auto logging_stop = m_clock::now();
-        std::chrono::duration<double> logging_delta = logging_stop - logging_start;
-        if(std::chrono::duration_cast<std::chrono::milliseconds>(logging_delta).count() >= m_continuous_log_time){
-            logging_start = logging_stop;
-            updateContinuousLog(logging_stop);
+
+//--- Continuous logging
+
+LoggingManager::TierLog::TierLog(const LogLayout& layout, std::uint64_t period):
+    layout(layout),
+    tier(layout.sampled.size(), period)
+{
+    record.timestamp = 0;
+    record.n_samples = 0;
+    record.mean.assign(layout.sampled.size(), 0);
+    record.min.assign(layout.sampled.size(), 0);
+    record.max.assign(layout.sampled.size(), 0);
+    record.values.assign(layout.values.size(), 0);
+}
+
+void LoggingManager::initContinuousLog() {
+    // Define the channels sampled at high rate
+    TSTags_t run_tag = { { "run_number", std::to_string(m_run_number) } };
+    LogLayout layout;
+    for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
+        TSTags_t hv_tags = run_tag;
+        hv_tags["hv"] = std::to_string(id);
+        layout.sampled.push_back({ "hv_" + std::to_string(id) + "_setValue", "HVPMT.set", hv_tags });
+        layout.sampled.push_back({ "hv_" + std::to_string(id) + "_readValue", "HVPMT.read", hv_tags });
+    }
+    layout.sampled.push_back({ "tdc_nEvt", "TDC.nEvt", run_tag });
+    layout.sampled.push_back({ "tdc_offset", "TDC.offset", run_tag });
+    layout.sampled.push_back({ "tdc_nIntEvtBuffer", "TDC.nIntEvtBuffer", run_tag });
+    layout.sampled.push_back({ "tdc_backPressure", "TDC.backPressure", run_tag });
+    for (const auto& reading: ConditionManager::ScalerReadings)
+        layout.sampled.push_back({ reading.second.first, "Scaler." + reading.second.first, run_tag });
+
+    m_sample.assign(layout.sampled.size(), 0);
+    m_ring = std::make_shared<SampleRing>(layout.sampled.size(), m_ring_length);
+    m_slow_log = std::make_shared<TierLog>(layout, SlowTierPeriod);
+
+    // The 1 s tier also has the values not sampled at high rate (same order as in fillRecord())
+    layout.values.push_back({ "ttc_nEvt", "TTC.nEvt", run_tag });
+    layout.values.push_back({ "trigger_throttle", "Trigger.throttle", run_tag });
+    layout.values.push_back({ "trigger_inhibits", "Trigger.inhibits", run_tag });
+    layout.values.push_back({ "trigger_inhibit_s", "Trigger.inhibitTime", run_tag });
+    layout.values.push_back({ "trigger_occupancy", "Trigger.occupancy", run_tag });
+    layout.values.push_back({ "tdc_nFIFOEvtBuffer", "TDC.nFIFOEvtBuffer", run_tag });
+    for (ProfiledMutex* mtx: m_conditions.getAllLocks()) {
+        TSTags_t lock_tags = run_tag;
+        lock_tags["lock"] = mtx->getName();
+        layout.values.push_back({ "lock_" + mtx->getName() + "_maxWait_us", "Lock.maxWait", lock_tags });
+        layout.values.push_back({ "lock_" + mtx->getName() + "_maxHold_us", "Lock.maxHold", lock_tags });
+    }
+    for (const auto& priority: BusScheduler::PriorityNames) {
+        TSTags_t bus_tags = run_tag;
+        bus_tags["priority"] = priority;
+        layout.values.push_back({ "bus_" + priority + "_requests", "Bus.requests", bus_tags });
+        layout.values.push_back({ "bus_" + priority + "_maxWait_us", "Bus.maxWait", bus_tags });
+        layout.values.push_back({ "bus_" + priority + "_maxRun_us", "Bus.maxRun", bus_tags });
+    }
+    for (const auto& thread: ThreadNames) {
+        TSTags_t thread_tags = run_tag;
+        thread_tags["thread"] = thread;
+        layout.values.push_back({ "cpu_" + thread + "_s", "Thread.cpuTime", thread_tags });
+    }
+    layout.values.push_back({ "tsdb_spool_backlog_kB", "TSDB.backlog", run_tag });
+    layout.values.push_back({ "tsdb_spool_dropped_kB", "TSDB.dropped", run_tag });
+    layout.values.push_back({ "tsdb_replayed", "TSDB.replayed", run_tag });
+    layout.values.push_back({ "tsdb_replay_rate", "TSDB.replayRate", run_tag });
+    layout.values.push_back({ "tsdb_up", "TSDB.up", run_tag });
+    layout.values.push_back({ "log_suppressed", "Log.suppressed", run_tag });
+    layout.values.push_back({ "log_dropped", "Log.dropped", run_tag });
+    layout.values.push_back({ "mem_resident_MB", "Memory.resident", run_tag });
+    for (const char* subsystem: MemoryTracker::SubsystemNames) {
+        TSTags_t memory_tags = run_tag;
+        memory_tags["subsystem"] = subsystem;
+        layout.values.push_back({ std::string("mem_") + subsystem + "_kB", "Memory.allocated", memory_tags });
+    }
+    if (m_analysis.get()) {
+        layout.values.push_back({ "ana_referenceRate", "Analysis.referenceRate", run_tag });
+        layout.values.push_back({ "ana_multiplicity", "Analysis.multiplicity", run_tag });
+        for (std::size_t channel = 0; channel < m_analysis->getNChannels(); channel++) {
+            TSTags_t channel_tags = run_tag;
+            channel_tags["channel"] = std::to_string(channel);
+            std::string prefix = "ana_ch" + std::to_string(channel) + "_";
+            layout.values.push_back({ prefix + "occupancy", "Analysis.occupancy", channel_tags });
+            layout.values.push_back({ prefix + "dtMean", "Analysis.dtMean", channel_tags });
+            layout.values.push_back({ prefix + "dtRMS", "Analysis.dtRMS", channel_tags });
+            layout.values.push_back({ prefix + "coincidenceRate", "Analysis.coincidenceRate", channel_tags });
         }
     }
+    // Counts of the event filter since the start of the run
+    layout.values.push_back({ "filter_eventsIn", "Filter.eventsIn", run_tag });
+    layout.values.push_back({ "filter_eventsKept", "Filter.eventsKept", run_tag });
+    layout.values.push_back({ "filter_eventsEmpty", "Filter.eventsEmpty", run_tag });
+    layout.values.push_back({ "filter_eventsPrescaled", "Filter.eventsPrescaled", run_tag });
+    layout.values.push_back({ "filter_hitsIn", "Filter.hitsIn", run_tag });
+    layout.values.push_back({ "filter_hitsMasked", "Filter.hitsMasked", run_tag });
+    layout.values.push_back({ "filter_hitsOutsideWindow", "Filter.hitsOutsideWindow", run_tag });
+    m_fast_log = std::make_shared<TierLog>(layout, FastTierPeriod);
 
-    std::cout << "Stopping logger." << std::endl;
-}
+    // Create the sinks enabled for the run (their plugins are loaded on first use)
+    std::string run_string = std::to_string(m_run_number);
+    for (const auto& sink: m_sinks) {
+        if (sink != "csv" && sink != "root" && sink != "columnar" && sink != "tsdb")
+            std::cerr << "Warning: unknown sink " << sink << ", ignored." << std::endl;
+    }
+    if (m_sinks.count("csv")) {
+        m_fast_log->sinks.push_back(createSink("csv", { m_log_path + "/cont_log_run_" + run_string + ".csv", &m_fast_log->layout, nullptr, "" }));
+        m_slow_log->sinks.push_back(createSink("csv", { m_log_path + "/cont_log_1min_run_" + run_string + ".csv", &m_slow_log->layout, nullptr, "" }));
+    }
+    if (m_sinks.count("root"))
+        m_fast_log->sinks.push_back(createSink("root", { m_log_path + "/events_run_" + run_string + ".root", nullptr, nullptr, "" }));
+    if (m_sinks.count("columnar"))
+        m_fast_log->sinks.push_back(createSink("columnar", { m_log_path + "/events_run_" + run_string + ".evcol", nullptr, nullptr, "" }));
 
-void LoggingManager::stop() {
-    is_running = false;
+    if (m_sinks.count("tsdb") && m_tsdb_spool.get()) {
+        // Both tiers share the same thread, which formats the datapoints and writes them to the spool
+        auto tsdb_publisher = std::make_shared<AsyncPublisher>(m_tsdb_thread_settings, MemoryTracker::Subsystem::TSDB);
+        m_fast_log->sinks.push_back(std::make_shared<AsyncSink>(tsdb_publisher, createSink("tsdb", { "", &m_fast_log->layout, m_tsdb_spool, "" })));
+        m_slow_log->sinks.push_back(std::make_shared<AsyncSink>(tsdb_publisher, createSink("tsdb", { "", &m_slow_log->layout, m_tsdb_spool, ".1min" })));
+    }
 }
 
+void LoggingManager::sampleConditions(m_clock::time_point log_time, bool last_time) {
+    std::uint64_t time_now = timeNowStamp<m_clock>(log_time);
 
-//--- Continuous logging
-
-void LoggingManager::initContinuousLog() {
-    // Create all the time series for values to be monitored in-browser
-    if (m_DB.get()) {
+    // Fill the sample, in the same order as the channels defined in initContinuousLog()
+    std::size_t ch = 0;
+    {
+        ProfiledLock hv_lock(m_conditions.getHVLock());
         for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
-            m_timeSeries_HVPMT_readVal.push_back(
-                    m_DB->addTimeSeries(
-                        "HVPMT.read", 
-                        { 
-                            { "hv", std::to_string(id) },
-                            { "run_number", std::to_string(m_run_number) }
-                        }
-                    )
-                );
-            m_timeSeries_HVPMT_setVal.push_back(
-                    m_DB->addTimeSeries(
-                        "HVPMT.set", 
-                        { 
-                            { "hv", std::to_string(id) },
-                            { "run_number", std::to_string(m_run_number) }
-                        }
-                    )
-                );
+            m_sample[ch++] = m_conditions.getHVPMTSetValue(id);
+            m_sample[ch++] = m_conditions.getHVPMTReadValue(id);
         }
-
-        m_timeSeries_TDC_interfaceEventBufferCounter = m_DB->addTimeSeries("TDC.nIntEvtBuffer", { { "run_number", std::to_string(m_run_number) } });
-        m_timeSeries_TDC_FIFOEventBufferCounter = m_DB->addTimeSeries("TDC.nFIFOEvtBuffer", { { "run_number", std::to_string(m_run_number) } });
-        m_timeSeries_TDC_eventCounter = m_DB->addTimeSeries("TDC.nEvt", { { "run_number", std::to_string(m_run_number) } });
-        m_timeSeries_TDC_offset = m_DB->addTimeSeries("TDC.offset", { { "run_number", std::to_string(m_run_number) } });
-        m_timeSeries_TTC_eventCounter = m_DB->addTimeSeries("TTC.nEvt", { { "run_number", std::to_string(m_run_number) } });
-    
+    }
+    {
+        ProfiledLock tdc_lock(m_conditions.getTDCLock());
+        m_sample[ch++] = m_conditions.getTDCEventCount();
+        m_sample[ch++] = m_conditions.getTDCOffset();
+        m_sample[ch++] = m_conditions.getTDCEventBuffer().size();
+        m_sample[ch++] = m_conditions.checkTDCBackPressure();
+    }
+    {
+        ProfiledLock scaler_lock(m_conditions.getScalerLock());
         for (const auto& reading: ConditionManager::ScalerReadings)
-            m_timeSeries_scaler[reading.first] = m_DB->addTimeSeries("Scaler." + reading.second.first,  { { "run_number", std::to_string(m_run_number) } });
+            m_sample[ch++] = m_conditions.getScalerRate(reading.first);
     }
 
-    // Initialise the CSV file
-    m_continuous_log = std::make_shared<CSV>(m_log_path + "/cont_log_run_" + std::to_string(m_run_number) + ".csv");
+    m_ring->push(time_now, m_sample);
 
-    m_continuous_log->addField("timestamp");
-    for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
-        m_continuous_log->addField("hv_" + std::to_string(id) + "_setValue");
-        m_continuous_log->addField("hv_" + std::to_string(id) + "_readValue");
+    // Publish the tiers which completed an interval, and at the end of the run, the intervals still open
+    if (m_fast_log->tier.add(time_now, m_sample)) {
+        fillRecord(*m_fast_log, true);
+        publishRecord(*m_fast_log);
     }
-    m_continuous_log->addField("tdc_nEvt");
-    m_continuous_log->addField("tdc_offset");
-    m_continuous_log->addField("ttc_nEvt");
-    for (const auto& reading: ConditionManager::ScalerReadings)
-        m_continuous_log->addField(reading.second.first);
-    
-    m_continuous_log->freeze();
+    if (m_slow_log->tier.add(time_now, m_sample)) {
+        fillRecord(*m_slow_log, false);
+        publishRecord(*m_slow_log);
+    }
+    if (last_time && m_fast_log->tier.finish()) {
+        fillRecord(*m_fast_log, true);
+        publishRecord(*m_fast_log);
+    }
+    if (last_time && m_slow_log->tier.finish()) {
+        fillRecord(*m_slow_log, false);
+        publishRecord(*m_slow_log);
+    }
+
+    // Dump the ring around TDC fatal errors and backpressure episodes
+    bool tdc_fatal = m_conditions.checkTDCFatalError();
+    std::uint64_t backpressure_episodes = m_conditions.getTDCBackPressureEpisodes();
+    if (!m_dump_pending && (tdc_fatal && !m_last_TDC_fatal)) {
+        m_dump_pending = true;
+        m_dump_reason = "tdc_fatal";
+        m_dump_countdown = m_ring_length / 2;
+    } else if (!m_dump_pending && backpressure_episodes > m_last_TDC_backPressureEpisodes) {
+        m_dump_pending = true;
+        m_dump_reason = "backpressure";
+        m_dump_countdown = m_ring_length / 2;
+    }
+    m_last_TDC_fatal = tdc_fatal;
+    m_last_TDC_backPressureEpisodes = backpressure_episodes;
 
-    // Initialise the ROOT file
-    std::string root_file_name = m_log_path + "/events_run_" + std::to_string(m_run_number) + ".root";
-    m_root_file = new TFile(root_file_name.c_str(), "recreate");
-    m_tree = new TTree("Events", "Events");
-    m_tree->Branch("Event", &m_tmp_event);
+    if (m_dump_pending) {
+        if (m_dump_countdown == 0 || last_time)
+            dumpRing(m_dump_reason);
+        else
+            m_dump_countdown--;
+    }
 }
-    
-void LoggingManager::updateContinuousLog(m_clock::time_point log_time, bool last_time) {
-    std::uint64_t time_now = timeNowStamp<m_clock>(log_time);
-    
-    m_continuous_log->setField("timestamp", time_now);
-    
-    // Fill HV-related information
-    for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
-        std::lock_guard<std::mutex> hv_lock(m_conditions.getHVLock());
-        
-        m_continuous_log->setField("hv_" + std::to_string(id) + "_setValue", m_conditions.getHVPMTSetValue(id));
-        m_continuous_log->setField("hv_" + std::to_string(id) + "_readValue", m_conditions.getHVPMTReadValue(id));
-        
-        if (m_DB.get()) {
-            m_DB->putValue(m_timeSeries_HVPMT_setVal.at(id), m_conditions.getHVPMTSetValue(id), time_now);
-            m_DB->putValue(m_timeSeries_HVPMT_readVal.at(id), m_conditions.getHVPMTReadValue(id), time_now);
-        }
+
+void LoggingManager::fillRecord(TierLog& log, bool read_values) {
+    const DecimationTier& tier = log.tier;
+    LogRecord& record = log.record;
+
+    record.timestamp = tier.getStop();
+    record.n_samples = tier.getNSamples();
+    for (std::size_t ch = 0; ch < record.mean.size(); ch++) {
+        record.mean[ch] = tier.getMean(ch);
+        record.min[ch] = tier.getMin(ch);
+        record.max[ch] = tier.getMax(ch);
     }
 
-    // Fill TDC-related information
+    if (!read_values)
+        return;
+
+    // Same order as the values defined in initContinuousLog()
+    std::size_t ch = 0;
     {
-        std::lock_guard<std::mutex> tdc_lock(m_conditions.getTDCLock());
-
-        if (m_conditions.getTDCEventBuffer().size() >= m_TDC_eventBuffer_flushSize || last_time) {
-            for (const auto& e: m_conditions.getTDCEventBuffer()) {
-                m_tmp_event = e;
-                m_tree->Fill();
-            }
-            m_conditions.getTDCEventBuffer().clear();
-        }
- 
-        m_continuous_log->setField("tdc_nEvt", m_conditions.getTDCEventCount());
-        m_continuous_log->setField("tdc_offset", m_conditions.getTDCOffset());
-        
-        if (m_DB.get()) {
-            m_DB->putValue(m_timeSeries_TDC_interfaceEventBufferCounter, m_conditions.getTDCEventBuffer().size(), time_now);
-            m_DB->putValue(m_timeSeries_TDC_FIFOEventBufferCounter, m_conditions.getTDCFIFOEventCount(), time_now);
-            m_DB->putValue(m_timeSeries_TDC_eventCounter, m_conditions.getTDCEventCount(), time_now);
-            m_DB->putValue(m_timeSeries_TDC_offset, m_conditions.getTDCOffset(), time_now);
-        }
+        ProfiledLock tcc_lock(m_conditions.getTTCLock());
+        record.values[ch++] = m_conditions.getTriggerEventNumber();
+        // State of the trigger governor: steps below the requested random frequency, inhibits (dead time)
+        // since the start of the run, and smoothed occupancy of the TDC FIFO
+        const TriggerGovernor& governor = m_conditions.getTriggerGovernor();
+        TriggerGovernor::Stats governor_stats = governor.getStats(DAQClock::now());
+        record.values[ch++] = governor.getThrottle();
+        record.values[ch++] = governor_stats.n_inhibits;
+        record.values[ch++] = governor_stats.inhibit_time;
+        record.values[ch++] = governor.getSmoothedOccupancy();
     }
-
-    // Fill Trigger-related information
     {
-        std::lock_guard<std::mutex> tcc_lock(m_conditions.getTTCLock());
-        
-        std::uint64_t ttc_evt_count = m_conditions.getTriggerEventNumber();
-        
-        m_continuous_log->setField("ttc_nEvt", ttc_evt_count);
-        
-        if (m_DB.get()) {
-            m_DB->putValue(m_timeSeries_TTC_eventCounter, ttc_evt_count, time_now);
+        ProfiledLock tdc_lock(m_conditions.getTDCLock());
+        record.values[ch++] = m_conditions.getTDCFIFOEventCount();
+
+        // Take the events read by the TDC daemon: the (empty) buffer of the record,
+        // whose memory was allocated during previous swaps, is given back to the daemon
+        m_conditions.getTDCEventBuffer().swap(record.events);
+    }
+
+    // Lock usage statistics accumulated since the last record
+    for (ProfiledMutex* mtx: m_conditions.getAllLocks()) {
+        ProfiledMutex::Stats stats = mtx->popIntervalStats();
+        record.values[ch++] = std::chrono::duration_cast<std::chrono::microseconds>(stats.max_wait).count();
+        record.values[ch++] = std::chrono::duration_cast<std::chrono::microseconds>(stats.max_hold).count();
+    }
+
+    // Latency of the accesses to the setup, per priority class
+    for (const BusScheduler::Stats& stats: m_conditions.getBus().popIntervalStats()) {
+        record.values[ch++] = stats.n_requests;
+        record.values[ch++] = std::chrono::duration_cast<std::chrono::microseconds>(stats.max_wait).count();
+        record.values[ch++] = std::chrono::duration_cast<std::chrono::microseconds>(stats.max_run).count();
+    }
+
+    // CPU time used by each thread since the start of the program
+    auto cpu_times = ThreadScope::getCPUTimes();
+    for (const auto& thread: ThreadNames)
+        record.values[ch++] = cpu_times.count(thread) ? cpu_times.at(thread) : 0;
+
+    // State of the OpenTSDB spool
+    TSDBSpool::Stats tsdb_stats = TSDBSpool::Stats();
+    if (m_tsdb_spool.get())
+        tsdb_stats = m_tsdb_spool->getStats();
+    record.values[ch++] = tsdb_stats.backlog_bytes / 1024.;
+    record.values[ch++] = tsdb_stats.dropped_bytes / 1024.;
+    record.values[ch++] = tsdb_stats.replayed_points;
+    record.values[ch++] = tsdb_stats.replay_rate;
+    record.values[ch++] = tsdb_stats.server_up;
+
+    // Driver and daemon messages lost to the rate limit or to a full queue, since the start of the program
+    record.values[ch++] = logger::get().getSuppressed();
+    record.values[ch++] = logger::get().getDropped();
+
+    // Memory of the process, and allocated by each subsystem
+    record.values[ch++] = MemoryTracker::getResidentBytes() / (1024. * 1024.);
+    for (std::size_t subsystem = 0; subsystem < MemoryTracker::NSubsystems; subsystem++)
+        record.values[ch++] = MemoryTracker::getUsage(static_cast<MemoryTracker::Subsystem>(subsystem)).bytes / 1024.;
+
+    // Online analysis of the events of this record
+    if (m_analysis.get()) {
+        // A whole interval, or up to the end of the last sample of the last one
+        double duration = std::min(tier.getStop() - tier.getStart() + m_sample_time, tier.getPeriod()) / 1000.;
+        m_analysis->process(record.events, record.timestamp, duration);
+        OnlineAnalysis::Results results = m_analysis->getResults();
+        record.values[ch++] = results.getReferenceRate();
+        record.values[ch++] = results.getMeanMultiplicity();
+        for (std::size_t channel = 0; channel < m_analysis->getNChannels(); channel++) {
+            record.values[ch++] = results.occupancy[channel];
+            record.values[ch++] = results.dt_mean[channel];
+            record.values[ch++] = results.dt_rms[channel];
+            record.values[ch++] = results.coincidence_rate[channel];
         }
     }
-    
-    // Fill Scaler-related information
-    {
-        std::lock_guard<std::mutex> scaler_lock(m_conditions.getScalerLock());
-        
-        for (const auto& reading: ConditionManager::ScalerReadings) {
-            double rate = m_conditions.getScalerRate(reading.first);
-            m_continuous_log->setField(reading.second.first, rate);
-        
-            if (m_DB.get()) {
-                m_DB->putValue(m_timeSeries_scaler.at(reading.first), rate, time_now);
-            }
+
+    // Only the events left by the filter are written
+    m_event_filter.apply(record.events);
+    EventFilter::Counts filter_counts = m_event_filter.getCounts();
+    record.values[ch++] = filter_counts.events_in;
+    record.values[ch++] = filter_counts.events_kept;
+    record.values[ch++] = filter_counts.events_empty;
+    record.values[ch++] = filter_counts.events_prescaled;
+    record.values[ch++] = filter_counts.hits_in;
+    record.values[ch++] = filter_counts.hits_masked;
+    record.values[ch++] = filter_counts.hits_outside_window;
+}
+
+void LoggingManager::publishRecord(TierLog& log) {
+    for (auto& sink: log.sinks)
+        sink->write(log.record);
+
+    // Give the events back to the pool
+    log.record.events.clear();
+}
+
+void LoggingManager::dumpRing(std::string reason) {
+    std::string file_name = m_log_path + "/ring_dump_run_" + std::to_string(m_run_number) + "_" + std::to_string(m_n_dumps) + "_" + reason + ".csv";
+    std::cout << "Dumping the last " << m_ring->size() << " condition samples (" << reason << ") to " << file_name << std::endl;
+
+    m_dump_pending = false;
+    m_n_dumps++;
+
+    try {
+        CSV dump(file_name, 0);
+        CSV::Field timestamp = dump.addField("timestamp");
+        std::vector<CSV::Field> fields;
+        for (const auto& channel: m_fast_log->layout.sampled)
+            fields.push_back(dump.addField(channel.name));
+        dump.freeze();
+
+        for (std::size_t i = 0; i < m_ring->size(); i++) {
+            dump.setField(timestamp, m_ring->getTimestamp(i));
+            const double* values = m_ring->getValues(i);
+            for (std::size_t ch = 0; ch < fields.size(); ch++)
+                dump.setField(fields[ch], values[ch]);
+            dump.putLine();
         }
+    } catch (std::ios_base::failure& e) {
+        std::cerr << "Warning: could not dump condition samples: " << e.what() << std::endl;
     }
- 
- 
-    m_continuous_log->putLine();
 }
 
 void LoggingManager::finalizeContinuousLog() {
-    // Update continuous log one last time
-    updateContinuousLog(m_clock::now(), true);
+    // Sample one last time, and write all the tiers (and the pending dump, if any)
+    sampleConditions(m_clock::now(), true);
     
-    m_continuous_log.reset();
+    // Close the files, and wait for the records still queued for the database
+    m_fast_log.reset();
+    m_slow_log.reset();
+
+    // Summary of the hardware lock usage, to find which paths block the readout
+    std::cout << "Lock usage per call site:" << std::endl;
+    for (ProfiledMutex* mtx: m_conditions.getAllLocks())
+        mtx->printSummary(std::cout);
+    m_conditions.getBus().printSummary(std::cout);
 
-    m_tree->Write();
-    m_root_file->Close();
-    m_tree = NULL;
-    m_root_file = NULL;
+    EventFilter::Counts filter_counts = m_event_filter.getCounts();
+    std::cout << "Event filter: " << filter_counts.events_kept << " of " << filter_counts.events_in << " TDC events written, "
+        << filter_counts.events_empty << " empty and " << filter_counts.events_prescaled << " prescaled; "
+        << filter_counts.hits_masked << " hits masked and " << filter_counts.hits_outside_window << " outside the time window, of "
+        << filter_counts.hits_in << std::endl;
+
+    {
+        ProfiledLock ttc_lock(m_conditions.getTTCLock());
+        const TriggerGovernor& governor = m_conditions.getTriggerGovernor();
+        TriggerGovernor::Stats governor_stats = governor.getStats(DAQClock::now());
+        std::cout << "Trigger governor: inhibited " << governor_stats.n_inhibits << " times for " << governor_stats.inhibit_time << " s, random frequency stepped "
+            << governor_stats.n_steps_down << " times down and " << governor_stats.n_steps_up << " times up, "
+            << governor.getThrottle() << " steps below the requested setting at the end" << std::endl;
+    }
+
+    std::cout << "CPU time used per thread:" << std::endl;
+    for (const auto& cpu_time: ThreadScope::getCPUTimes())
+        std::cout << "  " << cpu_time.first << ": " << cpu_time.second << " s" << std::endl;
 }
 
 //--- ConditionManager logging
 
 void LoggingManager::initConditionManagerLog() {
+    MemoryScope memory_scope(MemoryTracker::Subsystem::JSON);
+
+    // Records are fsync'ed every 10 records, or 1 s after being written at most
+    m_condition_journal = std::make_shared<ConditionJournal>(m_log_path + "/cond_journal_run_" + std::to_string(m_run_number) + ".jsonl");
+
     auto start_time = m_clock::now();
-    m_condition_json_root["start_time_human"] = timeToString<m_clock>(start_time);
-    m_condition_json_root["start_time"] = timeToJson<m_clock>(start_time); 
-    updateConditionManagerLog(true, start_time);
+    Json::Value start_record;
+    start_record["run_number"] = m_run_number;
+    start_record["start_time_human"] = timeToString<m_clock>(start_time);
+    start_record["start_time"] = timeToJson<m_clock>(start_time); 
+    const EventFilter::Settings& filter_settings = m_event_filter.getSettings();
+    Json::Value filter_record;
+    filter_record["drop_empty"] = filter_settings.drop_empty;
+    filter_record["channels"] = Json::Value(Json::arrayValue);
+    for (int channel: filter_settings.channels)
+        filter_record["channels"].append(channel);
+    filter_record["time_min"] = filter_settings.time_min;
+    filter_record["time_max"] = filter_settings.time_max;
+    filter_record["prescale"] = filter_settings.prescale;
+    start_record["event_filter"] = filter_record;
+    m_condition_journal->append("start", start_record);
+
+    updateConditionManagerLog(start_time);
 }
 
-void LoggingManager::updateConditionManagerLog(bool first_time, m_clock::time_point log_time) {
+void LoggingManager::updateConditionManagerLog(m_clock::time_point log_time) {
+    MemoryScope memory_scope(MemoryTracker::Subsystem::JSON);
     std::cout << "Updating conditions log" << std::endl;
 
-    m_condition_json_root["conditions_changed"] = !first_time;
-    m_condition_json_root["run_number"] = m_run_number; 
-    
     Json::Value this_condition;
     Json::Value hv_values;
     Json::Value discri_values;
 
     { // Lock the HV using the conditions manager to read all the values at once
-        std::lock_guard<std::mutex> hv_lock(m_conditions.getHVLock());
+        ProfiledLock hv_lock(m_conditions.getHVLock());
         
         for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
             Json::Value this_value;
@@ -260,7 +501,7 @@ void LoggingManager::updateConditionManagerLog(bool first_time, m_clock::time_po
     } // End HV lock 
     
     { // Lock the Discriminator using the conditions manager to read all the values at once
-        std::lock_guard<std::mutex> discri_lock(m_conditions.getDiscriLock());
+        ProfiledLock discri_lock(m_conditions.getDiscriLock());
 
         for (std::size_t id = 0; id < m_conditions.getNDiscriChannels(); id++) {
             Json::Value this_value;
@@ -276,21 +517,34 @@ void LoggingManager::updateConditionManagerLog(bool first_time, m_clock::time_po
     this_condition["discri_values"] = discri_values;
     this_condition["time"] = timeToJson<m_clock>(log_time); 
     
-    m_condition_json_list.append(this_condition);
+    m_condition_journal->append("conditions", this_condition);
 }
 
 void LoggingManager::finalizeConditionManagerLog() {
+    MemoryScope memory_scope(MemoryTracker::Subsystem::JSON);
     auto stop_time = m_clock::now();
-    m_condition_json_root["stop_time_human"] = timeToString<m_clock>(stop_time);
-    m_condition_json_root["stop_time"] = timeToJson<m_clock>(stop_time); 
-    m_condition_json_root["conditions"] = m_condition_json_list;
-
-    Json::StyledWriter m_writer;
-
-    std::ofstream file_stream;
-    file_stream.open(m_log_path + "/cond_log_run_" + std::to_string(m_run_number) + ".json");
-    if(!file_stream.is_open())
-        throw std::ios_base::failure("Could not open file cond_log.json");
-    file_stream << m_writer.write(m_condition_json_root);
-    file_stream.close();
-}    
+    Json::Value stop_record;
+    stop_record["stop_time_human"] = timeToString<m_clock>(stop_time);
+    stop_record["stop_time"] = timeToJson<m_clock>(stop_time); 
+    EventFilter::Counts filter_counts = m_event_filter.getCounts();
+    Json::Value counts_record;
+    counts_record["events_in"] = Json::UInt64(filter_counts.events_in);
+    counts_record["events_kept"] = Json::UInt64(filter_counts.events_kept);
+    counts_record["events_empty"] = Json::UInt64(filter_counts.events_empty);
+    counts_record["events_prescaled"] = Json::UInt64(filter_counts.events_prescaled);
+    counts_record["hits_in"] = Json::UInt64(filter_counts.hits_in);
+    counts_record["hits_masked"] = Json::UInt64(filter_counts.hits_masked);
+    counts_record["hits_outside_window"] = Json::UInt64(filter_counts.hits_outside_window);
+    stop_record["event_filter_counts"] = counts_record;
+    m_condition_journal->append("stop", stop_record);
+    m_condition_journal.reset();
+
+    // Produce the end-of-run condition log from the journal, which is only removed on success
+    std::string journal_name = m_log_path + "/cond_journal_run_" + std::to_string(m_run_number) + ".jsonl";
+    try {
+        ConditionJournal::compact(journal_name, m_log_path + "/cond_log_run_" + std::to_string(m_run_number) + ".json");
+        std::remove(journal_name.c_str());
+    } catch (std::ios_base::failure& e) {
+        std::cerr << "Warning: could not compact the conditions journal " << journal_name << ": " << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,112 @@
+#include <atomic>
+#include <fstream>
+#include <cstdlib>
+#include <new>
+
+#include <unistd.h>
+
+#include "MemoryTracker.h"
+
+namespace {
+
+    // Counters of a subsystem, on their own cache line: they are updated by all the threads
+    struct alignas(64) Counters {
+        std::atomic<std::int64_t> bytes;
+        std::atomic<std::uint64_t> allocations;
+        std::atomic<std::uint64_t> allocated_bytes;
+    };
+
+    // Zero before any allocation (static storage)
+    Counters counters[MemoryTracker::NSubsystems];
+
+    thread_local MemoryTracker::Subsystem current_subsystem = MemoryTracker::Subsystem::Other;
+
+    // Put before each allocation. 16 bytes keep the alignment given by malloc
+    struct alignas(16) Header {
+        std::size_t size;
+        unsigned int subsystem;
+    };
+
+    void* allocate(std::size_t size) {
+        unsigned int subsystem = static_cast<unsigned int>(current_subsystem);
+        Header* header = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+        if (!header)
+            return nullptr;
+        header->size = size;
+        header->subsystem = subsystem;
+        counters[subsystem].bytes.fetch_add(size, std::memory_order_relaxed);
+        counters[subsystem].allocations.fetch_add(1, std::memory_order_relaxed);
+        counters[subsystem].allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+        return header + 1;
+    }
+
+    void deallocate(void* p) {
+        if (!p)
+            return;
+        Header* header = static_cast<Header*>(p) - 1;
+        counters[header->subsystem].bytes.fetch_sub(header->size, std::memory_order_relaxed);
+        std::free(header);
+    }
+
+}
+
+const char* const MemoryTracker::SubsystemNames[MemoryTracker::NSubsystems] = { "other", "events", "json", "root", "tsdb" };
+
+MemoryTracker::Usage MemoryTracker::getUsage(Subsystem subsystem) {
+    const Counters& c = counters[static_cast<std::size_t>(subsystem)];
+    return { c.bytes.load(std::memory_order_relaxed), c.allocations.load(std::memory_order_relaxed), c.allocated_bytes.load(std::memory_order_relaxed) };
+}
+
+MemoryTracker::Usage MemoryTracker::getTotalUsage() {
+    Usage total = { 0, 0, 0 };
+    for (std::size_t i = 0; i < NSubsystems; i++) {
+        Usage usage = getUsage(static_cast<Subsystem>(i));
+        total.bytes += usage.bytes;
+        total.allocations += usage.allocations;
+        total.allocated_bytes += usage.allocated_bytes;
+    }
+    return total;
+}
+
+std::uint64_t MemoryTracker::getResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    std::uint64_t size = 0, resident = 0;
+    if (!(statm >> size >> resident))
+        return 0;
+    return resident * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+MemoryScope::MemoryScope(MemoryTracker::Subsystem subsystem):
+    m_previous(current_subsystem)
+{
+    current_subsystem = subsystem;
+}
+
+MemoryScope::~MemoryScope() {
+    current_subsystem = m_previous;
+}
+
+// Replacements of the global allocation functions (the array forms use them)
+
+void* operator new(std::size_t size) {
+    if (void* p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    deallocate(p);
+}
+
+// Sized deallocation, used by libraries built for C++14 and later
+void operator delete(void* p, std::size_t) noexcept {
+    deallocate(p);
+}
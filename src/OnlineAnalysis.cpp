@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include "OnlineAnalysis.h"
+
+OnlineAnalysis::Results::Results(std::size_t n_channels):
+    timestamp(0),
+    duration(0),
+    n_events(0),
+    n_reference_events(0),
+    occupancy(n_channels, 0),
+    dt_mean(n_channels, std::numeric_limits<double>::quiet_NaN()),
+    dt_rms(n_channels, std::numeric_limits<double>::quiet_NaN()),
+    coincidence_rate(n_channels, 0),
+    multiplicity(n_channels + 1, 0)
+{}
+
+double OnlineAnalysis::Results::getMeanMultiplicity() const {
+    if (n_reference_events == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    double sum = 0;
+    for (std::size_t m = 0; m < multiplicity.size(); m++)
+        sum += static_cast<double>(m) * multiplicity[m];
+    return sum / n_reference_events;
+}
+
+OnlineAnalysis::OnlineAnalysis(int reference, std::size_t n_channels, std::int32_t window):
+    m_reference(reference),
+    m_n_channels(std::min(n_channels, MaxChannels)),
+    m_window(std::max(window, 0)),
+    m_channel_begin(m_n_channels + 1, 0),
+    m_n_hits(m_n_channels, 0),
+    m_fill(m_n_channels, 0),
+    m_work(m_n_channels),
+    m_results(m_n_channels)
+{}
+
+OnlineAnalysis::Results OnlineAnalysis::getResults() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_results;
+}
+
+void OnlineAnalysis::reset() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_results = Results(m_n_channels);
+}
+
+void OnlineAnalysis::process(const std::vector<EventPool::Handle>& events, std::uint64_t timestamp, double duration) {
+    m_work.timestamp = timestamp;
+    m_work.duration = duration;
+    m_work.n_events = events.size();
+
+    pack(events);
+    accumulate();
+
+    // The previous results become the work area of the next interval (no allocation)
+    std::lock_guard<std::mutex> lock(m_mtx);
+    std::swap(m_results, m_work);
+}
+
+void OnlineAnalysis::pack(const std::vector<EventPool::Handle>& events) {
+    m_event_t0.resize(events.size());
+    m_flat_channel.clear();
+    m_flat_dt.clear();
+    m_flat_event.clear();
+    std::fill(m_n_hits.begin(), m_n_hits.end(), 0);
+    // Number of relative times per channel
+    std::fill(m_fill.begin(), m_fill.end(), 0);
+
+    // Only pass over the events: reference time of each event, and relative times of its hits
+    for (std::size_t i = 0; i < events.size(); i++) {
+        const std::vector<hit>& hits = events[i]->hits;
+
+        std::int64_t t0 = -1;
+        for (const hit& h: hits) {
+            if (h.channel < m_n_channels)
+                m_n_hits[h.channel]++;
+            if (t0 < 0 && static_cast<int>(h.channel) == m_reference && h.leading)
+                t0 = h.time;
+        }
+        m_event_t0[i] = t0;
+
+        if (t0 < 0)
+            continue;
+        for (const hit& h: hits) {
+            if (!h.leading || h.channel >= m_n_channels || static_cast<int>(h.channel) == m_reference)
+                continue;
+            m_fill[h.channel]++;
+            m_flat_channel.push_back(h.channel);
+            m_flat_dt.push_back(static_cast<std::int32_t>(t0 - static_cast<std::int64_t>(h.time)));
+            m_flat_event.push_back(i);
+        }
+    }
+
+    m_channel_begin[0] = 0;
+    for (std::size_t c = 0; c < m_n_channels; c++)
+        m_channel_begin[c + 1] = m_channel_begin[c] + m_fill[c];
+    m_dt.resize(m_flat_dt.size());
+    m_dt_event.resize(m_flat_dt.size());
+
+    // Sort the relative times by channel
+    std::copy(m_channel_begin.begin(), m_channel_begin.end() - 1, m_fill.begin());
+    for (std::size_t j = 0; j < m_flat_dt.size(); j++) {
+        std::size_t k = m_fill[m_flat_channel[j]]++;
+        m_dt[k] = m_flat_dt[j];
+        m_dt_event[k] = m_flat_event[j];
+    }
+}
+
+void OnlineAnalysis::accumulate() {
+    std::size_t n_events = m_event_t0.size();
+    m_event_mask.assign(n_events, 0);
+
+    // |dt| <= window  <=>  (unsigned)(dt + window) <= 2 * window
+    const std::uint32_t window_width = 2 * static_cast<std::uint32_t>(m_window);
+
+    for (std::size_t c = 0; c < m_n_channels; c++) {
+        const std::int32_t* dt = m_dt.data() + m_channel_begin[c];
+        std::size_t n = m_channel_begin[c + 1] - m_channel_begin[c];
+
+        // Reductions over the relative times of the channel
+        std::int64_t sum = 0;
+        std::int64_t sum2 = 0;
+        std::uint64_t n_coincident = 0;
+        for (std::size_t k = 0; k < n; k++) {
+            std::int64_t value = dt[k];
+            sum += value;
+            sum2 += value * value;
+            n_coincident += static_cast<std::uint32_t>(dt[k] + m_window) <= window_width;
+        }
+
+        // Channels in coincidence in each event
+        const std::uint32_t* event = m_dt_event.data() + m_channel_begin[c];
+        for (std::size_t k = 0; k < n; k++)
+            m_event_mask[event[k]] |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(dt[k] + m_window) <= window_width) << c;
+
+        m_work.occupancy[c] = n_events ? static_cast<double>(m_n_hits[c]) / n_events : 0;
+        m_work.coincidence_rate[c] = m_work.duration > 0 ? n_coincident / m_work.duration : 0;
+        if (n) {
+            double mean = static_cast<double>(sum) / n;
+            m_work.dt_mean[c] = mean;
+            m_work.dt_rms[c] = std::sqrt(std::max(static_cast<double>(sum2) / n - mean * mean, 0.));
+        } else {
+            m_work.dt_mean[c] = std::numeric_limits<double>::quiet_NaN();
+            m_work.dt_rms[c] = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    std::fill(m_work.multiplicity.begin(), m_work.multiplicity.end(), 0);
+    m_work.n_reference_events = 0;
+    for (std::size_t i = 0; i < n_events; i++) {
+        if (m_event_t0[i] < 0)
+            continue;
+        m_work.n_reference_events++;
+        m_work.multiplicity[__builtin_popcountll(m_event_mask[i])]++;
+    }
+}
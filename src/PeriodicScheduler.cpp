@@ -0,0 +1,167 @@
+#include <vector>
+
+#include "PeriodicScheduler.h"
+
+PeriodicScheduler::Task::Task(m_clock::duration period, std::function<bool()> function):
+    period(period),
+    function(function),
+    next(m_clock::now() + period),
+    delayed(false),
+    cancelled(false),
+    finished(false)
+{}
+
+PeriodicScheduler::PeriodicScheduler():
+    m_last_id(0),
+    m_virtual_limit(m_clock::now()),
+    m_virtual_busy(false)
+{}
+
+PeriodicScheduler::~PeriodicScheduler() {
+    std::vector<TaskId> ids;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        for (const auto& task: m_tasks)
+            ids.push_back(task.first);
+    }
+    for (TaskId id: ids)
+        cancel(id);
+}
+
+PeriodicScheduler::TaskId PeriodicScheduler::schedule(ThreadSettings settings, m_clock::duration period, std::function<bool()> function) {
+    std::shared_ptr<Task> task = std::make_shared<Task>(period, function);
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    TaskId id = ++m_last_id;
+    // The thread keeps the task alive until it returns
+    if (VirtualTime::isEnabled())
+        task->thread = startThread(settings, [this, id, task]() { runVirtual(id, *task); });
+    else
+        task->thread = startThread(settings, [task]() { run(*task); });
+    m_tasks[id] = task;
+
+    return id;
+}
+
+bool PeriodicScheduler::cancel(TaskId id) {
+    std::shared_ptr<Task> task;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        auto it = m_tasks.find(id);
+        if (it == m_tasks.end())
+            return false;
+        task = it->second;
+        m_tasks.erase(it);
+
+        std::lock_guard<std::mutex> task_lock(task->mtx);
+        task->cancelled = true;
+    }
+    task->cv.notify_all();
+    m_virtual_cv.notify_all();
+
+    if (task->thread.get_id() == std::this_thread::get_id())
+        task->thread.detach();
+    else
+        task->thread.join();
+
+    return true;
+}
+
+void PeriodicScheduler::delay(TaskId id, m_clock::duration delay) {
+    std::shared_ptr<Task> task;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        auto it = m_tasks.find(id);
+        if (it == m_tasks.end())
+            return;
+        task = it->second;
+
+        std::lock_guard<std::mutex> task_lock(task->mtx);
+        task->next = m_clock::now() + delay;
+        task->delayed = true;
+    }
+    task->cv.notify_all();
+}
+
+void PeriodicScheduler::advance(m_clock::time_point time) {
+    if (!VirtualTime::isEnabled())
+        return;
+
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_virtual_limit = time;
+    m_virtual_cv.notify_all();
+    m_virtual_cv.wait(lock, [this]() { return !m_virtual_busy && nextVirtualTask() == 0; });
+    VirtualTime::advance(time.time_since_epoch());
+}
+
+PeriodicScheduler::TaskId PeriodicScheduler::nextVirtualTask() const {
+    TaskId next_id = 0;
+    m_clock::time_point next = m_virtual_limit;
+    for (const auto& task: m_tasks) {
+        if (task.second->finished || task.second->next > next)
+            continue;
+        // Ties go to the task scheduled first
+        if (next_id == 0 || task.second->next < next) {
+            next_id = task.first;
+            next = task.second->next;
+        }
+    }
+    return next_id;
+}
+
+void PeriodicScheduler::runVirtual(TaskId id, Task& task) {
+    std::unique_lock<std::mutex> lock(m_mtx);
+
+    while (true) {
+        m_virtual_cv.wait(lock, [this, id, &task]() { return task.cancelled || (!m_virtual_busy && nextVirtualTask() == id); });
+        if (task.cancelled)
+            break;
+
+        m_clock::time_point due = task.next;
+        VirtualTime::advance(due.time_since_epoch());
+        task.delayed = false;
+        m_virtual_busy = true;
+        lock.unlock();
+        bool keep_running = task.function();
+        lock.lock();
+        m_virtual_busy = false;
+        m_virtual_cv.notify_all();
+
+        if (!keep_running)
+            break;
+        if (!task.delayed)
+            task.next = due + task.period;
+    }
+
+    task.finished = true;
+    m_virtual_cv.notify_all();
+}
+
+void PeriodicScheduler::run(Task& task) {
+    std::unique_lock<std::mutex> lock(task.mtx);
+
+    while (true) {
+        // The due time can be moved by delay() while waiting
+        while (!task.cancelled && m_clock::now() < task.next)
+            task.cv.wait_until(lock, task.next);
+        if (task.cancelled)
+            break;
+
+        m_clock::time_point due = task.next;
+        task.delayed = false;
+        lock.unlock();
+        bool keep_running = task.function();
+        lock.lock();
+
+        if (!keep_running)
+            break;
+        if (task.delayed)
+            continue;
+
+        // If we are late by more than a period, do not try to catch up
+        task.next = due + task.period;
+        m_clock::time_point now = m_clock::now();
+        if (task.next < now)
+            task.next = now;
+    }
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <vector>
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include "Plugins.h"
+
+namespace {
+
+// Directory of the executable, from /proc (empty if unknown)
+std::string executableDirectory() {
+    std::vector<char> path(4096);
+    ssize_t length = readlink("/proc/self/exe", path.data(), path.size() - 1);
+    if (length <= 0)
+        return "";
+    std::string executable(path.data(), length);
+    std::size_t slash = executable.rfind('/');
+    return (slash == std::string::npos) ? "" : executable.substr(0, slash);
+}
+
+}
+
+PluginLoader& PluginLoader::get() {
+    static PluginLoader instance;
+    return instance;
+}
+
+PluginLoader::PluginLoader():
+    m_load_time(0)
+{}
+
+void PluginLoader::setDirectory(std::string directory) {
+    std::lock_guard<std::mutex> m_lock(m_mtx);
+    m_directory = directory;
+}
+
+void* PluginLoader::getSymbol(const std::string& plugin, const std::string& symbol) {
+    std::lock_guard<std::mutex> m_lock(m_mtx);
+
+    auto it = m_handles.find(plugin);
+    void* handle = (it == m_handles.end()) ? load(plugin) : it->second;
+
+    void* address = dlsym(handle, symbol.c_str());
+    if (!address)
+        throw plugin_error("Plugin " + plugin + " does not define " + symbol);
+    return address;
+}
+
+std::chrono::microseconds PluginLoader::getLoadTime() {
+    std::lock_guard<std::mutex> m_lock(m_mtx);
+    return m_load_time;
+}
+
+void* PluginLoader::load(const std::string& plugin) {
+    std::string directory = m_directory.empty() ? executableDirectory() + "/plugins" : m_directory;
+    std::string file_name = directory + "/libSlowControlPlugin_" + plugin + ".so";
+
+    auto start = std::chrono::steady_clock::now();
+    // RTLD_LOCAL: the symbols of a plugin do not clash with those of the others
+    void* handle = dlopen(file_name.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+        throw plugin_error("Could not load plugin " + plugin + ": " + dlerror());
+
+    typedef int (*APIFunction)();
+    APIFunction api = reinterpret_cast<APIFunction>(dlsym(handle, "slowControlPluginAPI"));
+    if (!api || api() != SLOWCONTROL_PLUGIN_API) {
+        dlclose(handle);
+        throw plugin_error("Plugin " + file_name + " was not built for this version of the program");
+    }
+    auto load_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    m_load_time += load_time;
+
+    std::cout << "Loaded plugin " << plugin << " in " << load_time.count() / 1000. << " ms." << std::endl;
+    m_handles[plugin] = handle;
+    return handle;
+}
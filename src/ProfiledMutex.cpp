@@ -0,0 +1,125 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <map>
+
+#include "ProfiledMutex.h"
+
+namespace {
+    double toMs(ProfiledMutex::m_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d).count() / 1000.;
+    }
+}
+
+void ProfiledMutex::Stats::add(m_clock::duration wait, m_clock::duration hold, bool long_hold) {
+    n_locks++;
+    if (long_hold)
+        n_long_holds++;
+    total_wait += wait;
+    total_hold += hold;
+    if (wait > max_wait)
+        max_wait = wait;
+    if (hold > max_hold)
+        max_hold = hold;
+}
+
+ProfiledMutex::ProfiledMutex(std::string name, std::chrono::microseconds threshold):
+    m_name(name),
+    m_threshold(threshold),
+    m_owner_function(nullptr),
+    m_owner_line(0),
+    m_owner_wait(0)
+{}
+
+void ProfiledMutex::lock(Site site) {
+    auto start = m_clock::now();
+    
+    if (!m_mtx.try_lock()) {
+        // Remember who was holding the lock when we started waiting
+        const char* blocker_function = m_owner_function;
+        int blocker_line = m_owner_line;
+        
+        m_mtx.lock();
+        
+        m_acquired = m_clock::now();
+        m_owner_wait = m_acquired - start;
+        if (m_owner_wait > m_threshold && blocker_function) {
+            std::cerr << "Warning: " << siteToString(site) << " waited " << toMs(m_owner_wait) << " ms for lock " << m_name
+                << " held by " << siteToString(Site(blocker_function, blocker_line)) << std::endl;
+        }
+    } else {
+        m_acquired = m_clock::now();
+        m_owner_wait = m_acquired - start;
+    }
+    
+    m_owner_function = site.first;
+    m_owner_line = site.second;
+}
+
+bool ProfiledMutex::try_lock(Site site) {
+    if (!m_mtx.try_lock())
+        return false;
+
+    m_acquired = m_clock::now();
+    m_owner_wait = m_clock::duration(0);
+    m_owner_function = site.first;
+    m_owner_line = site.second;
+
+    return true;
+}
+
+void ProfiledMutex::unlock() {
+    m_clock::duration hold = m_clock::now() - m_acquired;
+    bool long_hold = hold > m_threshold;
+    Site site(m_owner_function, m_owner_line);
+
+    m_interval.add(m_owner_wait, hold, long_hold);
+    m_sites[site].add(m_owner_wait, hold, long_hold);
+    
+    m_owner_function = nullptr;
+    m_owner_line = 0;
+    m_mtx.unlock();
+
+    // Do not print while holding the lock
+    if (long_hold)
+        std::cerr << "Warning: lock " << m_name << " held for " << toMs(hold) << " ms by " << siteToString(site) << std::endl;
+}
+
+ProfiledMutex::Stats ProfiledMutex::popIntervalStats() {
+    std::lock_guard<std::mutex> m_lock(m_mtx);
+    
+    Stats stats = m_interval;
+    m_interval = Stats();
+    
+    return stats;
+}
+
+std::map<std::string, ProfiledMutex::Stats> ProfiledMutex::getSiteStats() {
+    std::lock_guard<std::mutex> m_lock(m_mtx);
+
+    std::map<std::string, Stats> stats;
+    for (const auto& site: m_sites)
+        stats[siteToString(site.first)] = site.second;
+    
+    return stats;
+}
+
+void ProfiledMutex::printSummary(std::ostream& out) {
+    auto stats = getSiteStats();
+    
+    out << "Lock " << m_name << ":" << std::endl;
+    for (const auto& site: stats) {
+        out << "  " << std::left << std::setw(40) << site.first << std::right
+            << " n=" << site.second.n_locks
+            << " wait avg/max=" << toMs(site.second.total_wait) / site.second.n_locks << "/" << toMs(site.second.max_wait) << " ms"
+            << " hold avg/max=" << toMs(site.second.total_hold) / site.second.n_locks << "/" << toMs(site.second.max_hold) << " ms"
+            << " long holds=" << site.second.n_long_holds << std::endl;
+    }
+}
+
+// Static
+std::string ProfiledMutex::siteToString(Site site) {
+    if (!site.first)
+        return "unknown";
+    return std::string(site.first) + ":" + std::to_string(site.second);
+}
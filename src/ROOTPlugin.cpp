@@ -0,0 +1,115 @@
+#include <TFile.h>
+#include <TTree.h>
+
+#include "LogSink.h"
+#include "ReplaySetupManager.h"
+#include "Plugins.h"
+#include "MemoryTracker.h"
+
+/*
+ * Plugin "root": write the TDC events to the "Events" tree of a ROOT file (see LogSink.h),
+ * and read them back for the replay (see ReplaySetupManager). The only part of the program
+ * which needs ROOT, with the dictionary of the events.
+ */
+
+namespace {
+
+class ROOTSink: public LogSink {
+    public:
+        ROOTSink(std::string fileName);
+        virtual ~ROOTSink() override;
+
+        virtual void write(const LogRecord& record) override;
+
+    private:
+        TFile *m_root_file;
+        TTree *m_tree;
+        // The branch reads the event through this pointer: events are written without being copied
+        event *m_event;
+        event m_empty_event;
+};
+
+ROOTSink::ROOTSink(std::string fileName):
+    m_event(&m_empty_event)
+{
+    MemoryScope memory_scope(MemoryTracker::Subsystem::ROOT);
+    m_root_file = new TFile(fileName.c_str(), "recreate");
+    m_tree = new TTree("Events", "Events");
+    m_tree->Branch("Event", &m_event);
+}
+
+ROOTSink::~ROOTSink() {
+    MemoryScope memory_scope(MemoryTracker::Subsystem::ROOT);
+    m_tree->Write();
+    // Also deletes the tree
+    m_root_file->Close();
+    delete m_root_file;
+    m_tree = NULL;
+    m_root_file = NULL;
+}
+
+void ROOTSink::write(const LogRecord& record) {
+    // Baskets are allocated while filling
+    MemoryScope memory_scope(MemoryTracker::Subsystem::ROOT);
+    for (const auto& e: record.events) {
+        m_event = e.get();
+        m_tree->Fill();
+    }
+    m_event = &m_empty_event;
+}
+
+class ROOTSource: public ReplaySource {
+    public:
+        ROOTSource(std::string fileName):
+            m_file(fileName.c_str(), "read"),
+            m_tree(nullptr),
+            m_event(nullptr),
+            m_entry(0)
+        {
+            if (m_file.IsZombie())
+                throw std::ios_base::failure("Could not open " + fileName);
+            m_file.GetObject("Events", m_tree);
+            if (!m_tree)
+                throw std::ios_base::failure("No Events tree in " + fileName);
+            m_tree->SetBranchAddress("Event", &m_event);
+        }
+
+        virtual ~ROOTSource() override {
+            if (m_tree)
+                m_tree->ResetBranchAddresses();
+            delete m_event;
+        }
+
+        virtual std::uint64_t getNEvents() const override { return m_tree->GetEntries(); }
+
+        virtual bool next(event& e) override {
+            if (m_entry >= m_tree->GetEntries())
+                return false;
+            m_tree->GetEntry(m_entry++);
+            // Assignment keeps the memory of the vectors of `e`
+            e = *m_event;
+            return true;
+        }
+
+        virtual void rewind() override { m_entry = 0; }
+
+    private:
+        TFile m_file;
+        TTree* m_tree;
+        event* m_event;
+        Long64_t m_entry;
+};
+
+}
+
+extern "C" int slowControlPluginAPI() {
+    return SLOWCONTROL_PLUGIN_API;
+}
+
+extern "C" LogSink* slowControlCreateSink(const SinkContext& context) {
+    return new ROOTSink(context.file_name);
+}
+
+extern "C" ReplaySource* slowControlCreateReplaySource(const std::string& fileName) {
+    return new ROOTSource(fileName);
+}
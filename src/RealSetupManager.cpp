@@ -1,5 +1,7 @@
 #include <cstddef>
 #include <iostream>
+#include <thread>
+#include <chrono>
 
 #include "VmeUsbBridge.h"
 #include "HV.h"
@@ -8,52 +10,73 @@
 #include "Event.h"
 
 #include "RealSetupManager.h"
-#include "Interface.h"
 #include "ConditionManager.h"
 
-RealSetupManager::RealSetupManager(Interface& m_interface):
-    m_interface(m_interface),
+namespace {
+    // Polling of the answer of the HV crate, once v288::ResponseDelay has elapsed (us)
+    const unsigned int HVPollInterval = 10000;
+    const unsigned int HVResponseTimeout = 400000;
+}
+
+RealSetupManager::RealSetupManager(ConditionManager& m_conditions):
     m_controller(UsbController(NORMAL)),
     m_hvpmt(hv(&m_controller, 0xF0000, 2)),
     m_discri(discri(&m_controller)),
     m_TTC(ttcVi(&m_controller)),
     m_TDC(&m_controller, 0x00AA0000),
-    m_scaler(&m_controller, 0xCCCC00)
-    { }
+    m_scaler(&m_controller, 0xCCCC00),
+    m_conditions(m_conditions)
+{
+    for (std::size_t i = 0; i < 4; i++)
+        m_hv_rows[i] = m_hv_values[i];
+}
 
 RealSetupManager::~RealSetupManager() {
-    for (std::size_t id = 0; id < m_interface.getConditions().getNHVPMT(); id++) {
+    for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
         m_hvpmt.setChState(0, id);
     }
 }
 
+int RealSetupManager::runHVStep(unsigned int delay, std::function<int()> step) {
+    std::this_thread::sleep_for(std::chrono::microseconds(delay));
+    return m_conditions.getBus().call(BusScheduler::Priority::HV, step);
+}
+
 bool RealSetupManager::setHVPMT(std::size_t id) { 
-    int set_hv_value = m_interface.getConditions().getHVPMTSetValue(id);
+    int set_hv_value = m_conditions.getHVPMTSetValue(id);
     std::cout << "Setting the HV PMT number " << id << " to " << set_hv_value << "." << std::endl;
 
-    return m_hvpmt.setChV(set_hv_value, id) == 1;
+    return runHVStep(v288::SetDelay + v288::CommandDelay, [this, set_hv_value, id]() { return m_hvpmt.sendChV(set_hv_value, id); }) == 1;
 }
 
 bool RealSetupManager::switchHVPMTON(std::size_t id) {
     std::cout << "Switching the HV PMT " << id << " ON..." << std::endl;
     
-    return m_hvpmt.setChState(1, id) == 1;
+    return runHVStep(v288::CommandDelay, [this, id]() { return m_hvpmt.sendChState(1, id); }) == 1;
 }
 
 bool RealSetupManager::switchHVPMTOFF(std::size_t id) {
     std::cout << "Switching the HV PMT " << id << " OFF..." << std::endl;
     
-    return m_hvpmt.setChState(0, id) == 1;
+    return runHVStep(v288::CommandDelay, [this, id]() { return m_hvpmt.sendChState(0, id); }) == 1;
 }
 
 std::vector< std::pair<double, double> > RealSetupManager::getHVPMTValue() {
     // FIXME Maybe we could have a function reading value of only one PM
     // Would require to modify Martin's library
     std::vector< std::pair<double, double> > hv_values;
-    double ** temp_values = 0;
-    temp_values = m_hvpmt.readValues(temp_values);
-    for (std::size_t id = 0; id < m_interface.getConditions().getNHVPMT(); id++) {
-        hv_values.push_back(std::make_pair(temp_values[id][0], temp_values[id][1]));
+    if (runHVStep(v288::CommandDelay, [this]() { return m_hvpmt.sendReadValues(); }) != 1)
+        return hv_values;
+
+    int status = runHVStep(v288::ResponseDelay, [this]() { return m_hvpmt.readResponse(m_hv_rows); });
+    for (unsigned int waited = 0; status == 0 && waited < HVResponseTimeout; waited += HVPollInterval)
+        status = runHVStep(HVPollInterval, [this]() { return m_hvpmt.readResponse(m_hv_rows); });
+    // Read error: no values
+    if (status != 1)
+        return hv_values;
+
+    for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
+        hv_values.push_back(std::make_pair(m_hv_rows[id][0], m_hv_rows[id][1]));
     }
     return hv_values;
 }
@@ -65,14 +88,14 @@ bool RealSetupManager::propagateDiscriSettings() {
     bool succeeded_discriSettings = true;
     m_discri.setMultiChannel(0);
     m_discri.setTh(255);
-    for (int dc_id = m_interface.getConditions().getNDiscriChannels()-1; dc_id >= 0; dc_id--) {
-        succeeded_discriSettings = (succeeded_discriSettings && ((m_discri.setChannel(dc_id, m_interface.getConditions().getDiscriChannelState(dc_id))) == 1));
-        succeeded_discriSettings = (succeeded_discriSettings && (m_discri.setTh(m_interface.getConditions().getDiscriChannelThreshold(dc_id), dc_id) == 1));
-        succeeded_discriSettings = (succeeded_discriSettings && ((m_discri.setWidth(m_interface.getConditions().getDiscriChannelWidth(dc_id), dc_id)) == 1));
+    for (int dc_id = m_conditions.getNDiscriChannels()-1; dc_id >= 0; dc_id--) {
+        succeeded_discriSettings = (succeeded_discriSettings && ((m_discri.setChannel(dc_id, m_conditions.getDiscriChannelState(dc_id))) == 1));
+        succeeded_discriSettings = (succeeded_discriSettings && (m_discri.setTh(m_conditions.getDiscriChannelThreshold(dc_id), dc_id) == 1));
+        succeeded_discriSettings = (succeeded_discriSettings && ((m_discri.setWidth(m_conditions.getDiscriChannelWidth(dc_id), dc_id)) == 1));
 
     }
     
-    bool succeeded_majority = (m_discri.setMajority(m_interface.getConditions().getChannelsMajority()) == 1);
+    bool succeeded_majority = (m_discri.setMajority(m_conditions.getChannelsMajority()) == 1);
 
     return succeeded_majority && succeeded_discriSettings;
 }
@@ -116,21 +139,24 @@ int RealSetupManager::getTDCNEvents() {
     return m_TDC.getNumberOfEvents();
 }
 
-event RealSetupManager::getTDCEvent() {
-    return m_TDC.getEvent();
+void RealSetupManager::getTDCEvent(event& e) {
+    m_TDC.getEvent(e);
 }
 
 void RealSetupManager::configureTDC() {
-    // Empty TDC buffer
-    for (std::size_t i = 0; i < m_TDC.getNumberOfEvents(); i++) {
-        m_TDC.getEvent();
-    }
+    // Empty TDC buffer (in bulk: the events of the previous run are not needed)
+    if (!m_TDC.clear())
+        std::cerr << "Warning: TDC buffer could not be emptied!" << std::endl;
     m_TDC.reset();
     // Load all TDC parameters
     m_TDC.loadUserConfig();
     m_TDC.enableFIFO();
 }
 
+void RealSetupManager::setTDCAlmostFullLevel(unsigned int words) {
+    m_TDC.setAlmostFull(words);
+}
+
 void RealSetupManager::resetScaler() {
     if (!m_scaler.reset())
         std::cerr << "Warning: could not reset scaler!" << std::endl;
@@ -146,7 +172,7 @@ int RealSetupManager::getScalerCount(ScalerChannel channel) {
 //    std::vector<double> hv_values;
 //    double ** temp_values = 0;
 //    temp_values = m_hvpmt.readValues(temp_values);
-//    for (std::size_t id = 0; id < m_interface.getConditions().getNHVPMT(); id++) {
+//    for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
 //        std::cout << temp_values[id][0] << std::endl;
 //        hv_values.push_back(temp_values[id][0]);
 //    }
@@ -0,0 +1,388 @@
+#include "ReplaySetupManager.h"
+#include "ConditionManager.h"
+#include "ColumnarEvents.h"
+#include "TDC.h"
+#include "Plugins.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <cstddef>
+
+namespace {
+
+// Scaler counts are indexed by channel number
+const std::size_t ScalerSlots = static_cast<std::size_t>(ScalerChannel::Ileak) + 1;
+
+// Events in the FIFO beyond which the replay waits (the real TDC would lose triggers)
+const std::size_t FIFOSize = 2 * ReplaySetupManager::AlmostFullLevel;
+
+std::vector<std::string> splitCSVLine(const std::string& line) {
+    std::vector<std::string> fields;
+    std::istringstream input(line);
+    std::string field;
+    while (std::getline(input, field, ','))
+        fields.push_back(field);
+    return fields;
+}
+
+class ColumnarSource: public ReplaySource {
+    public:
+        ColumnarSource(std::string fileName):
+            m_reader(fileName)
+        {
+            rewind();
+        }
+
+        virtual std::uint64_t getNEvents() const override { return m_reader.getNEvents(); }
+
+        virtual bool next(event& e) override {
+            while (m_index >= m_columns.getNEvents()) {
+                if (m_row_group >= m_reader.getNRowGroups())
+                    return false;
+                m_reader.readRowGroup(m_row_group++, m_columns);
+                m_index = 0;
+                m_hit = 0;
+                m_tdc_error = 0;
+            }
+
+            e.clear();
+            e.eventNumber = m_columns.event_number[m_index];
+            e.time = m_columns.event_time[m_index];
+            e.errorCode = m_columns.error_code[m_index];
+            for (std::uint32_t i = 0; i < m_columns.n_hits[m_index]; i++, m_hit++)
+                e.hits.push_back({ m_columns.hit_channel[m_hit], m_columns.hit_time[m_hit], m_columns.hit_leading[m_hit] != 0 });
+            for (std::uint32_t i = 0; i < m_columns.n_tdc_errors[m_index]; i++, m_tdc_error++)
+                e.tdcErrors.push_back(m_columns.tdc_error[m_tdc_error]);
+            m_index++;
+            return true;
+        }
+
+        virtual void rewind() override {
+            m_columns.clear();
+            m_row_group = 0;
+            m_index = 0;
+            m_hit = 0;
+            m_tdc_error = 0;
+        }
+
+    private:
+        ColumnarEventReader m_reader;
+        EventColumns m_columns;
+        std::size_t m_row_group;
+        // Position in the current row group
+        std::size_t m_index;
+        std::size_t m_hit;
+        std::size_t m_tdc_error;
+};
+
+}
+
+ReplaySetupManager::ReplaySetupManager(ConditionManager& m_conditions, std::string fileName, double speed, std::string conditions_file):
+    m_conditions(m_conditions),
+    m_speed(std::max(speed, 0.)),
+    m_has_next(false),
+    m_last_second(0),
+    m_end_reported(false),
+    m_n_triggered(0),
+    m_n_replayed(0),
+    m_ttc_number(0),
+    m_running(false),
+    m_replay_time(0),
+    m_row(0),
+    m_scaler_offset(ScalerSlots, 0)
+{
+    std::size_t dot = fileName.rfind('.');
+    if (dot != std::string::npos && fileName.substr(dot) == ".evcol")
+        m_source = std::make_shared<ColumnarSource>(fileName);
+    else {
+        typedef ReplaySource* (*CreateFunction)(const std::string&);
+        try {
+            CreateFunction create = PluginLoader::get().getFunction<CreateFunction>("root", "slowControlCreateReplaySource");
+            m_source = std::shared_ptr<ReplaySource>(create(fileName));
+        } catch (PluginLoader::plugin_error& e) {
+            throw std::ios_base::failure("Cannot read " + fileName + ": " + e.what());
+        }
+    }
+
+    if (conditions_file.empty()) {
+        // events_run_N.root -> cont_log_run_N.csv in the same directory
+        std::size_t slash = fileName.rfind('/');
+        std::string dir = (slash == std::string::npos) ? "" : fileName.substr(0, slash + 1);
+        std::string base = fileName.substr(dir.size());
+        std::size_t run = base.find("run_");
+        if (run != std::string::npos) {
+            std::size_t end = base.find('.', run);
+            conditions_file = dir + "cont_log_" + base.substr(run, end - run) + ".csv";
+            if (!std::ifstream(conditions_file).good())
+                conditions_file.clear();
+        }
+    }
+    if (!conditions_file.empty())
+        loadConditions(conditions_file);
+
+    std::cout << "Replaying " << m_source->getNEvents() << " events from " << fileName;
+    if (m_speed > 0)
+        std::cout << " at " << m_speed << " times the recorded pace";
+    else
+        std::cout << " as fast as possible";
+    if (!m_cond_time.empty())
+        std::cout << ", with the conditions of " << conditions_file;
+    std::cout << std::endl;
+
+    rewind();
+}
+
+ReplaySetupManager::~ReplaySetupManager() {}
+
+void ReplaySetupManager::loadConditions(std::string conditions_file) {
+    std::ifstream file(conditions_file);
+    std::string line;
+    if (!std::getline(file, line))
+        throw std::ios_base::failure("Could not read " + conditions_file);
+
+    std::vector<std::string> header = splitCSVLine(line);
+    auto column = [&](const std::string& name) -> int {
+        auto it = std::find(header.begin(), header.end(), name);
+        return (it == header.end()) ? -1 : static_cast<int>(it - header.begin());
+    };
+
+    int time_column = column("timestamp");
+    if (time_column < 0)
+        throw std::ios_base::failure("No timestamp column in " + conditions_file);
+    std::vector<int> scaler_columns(ScalerSlots, -1);
+    for (const auto& reading: ConditionManager::ScalerReadings)
+        scaler_columns[static_cast<std::size_t>(reading.first)] = column(reading.second.first);
+    std::vector<int> hv_columns;
+    for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++)
+        hv_columns.push_back(column("hv_" + std::to_string(id) + "_readValue"));
+
+    auto value = [](const std::vector<std::string>& fields, int col) -> double {
+        if (col < 0 || col >= static_cast<int>(fields.size()) || fields[col].empty())
+            return 0;
+        return std::stod(fields[col]);
+    };
+
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields = splitCSVLine(line);
+        if (fields.empty())
+            continue;
+        double time = value(fields, time_column);
+
+        // The log has rates (times the constant of the reading): integrate them over the interval
+        std::vector<double> counts(ScalerSlots, 0);
+        if (!m_cond_time.empty()) {
+            double interval = (time - m_cond_time.back()) / 1000.;
+            for (const auto& reading: ConditionManager::ScalerReadings) {
+                std::size_t ch = static_cast<std::size_t>(reading.first);
+                counts[ch] = m_cond_counts.back()[ch] + std::max(value(fields, scaler_columns[ch]), 0.) / reading.second.second * interval;
+            }
+        }
+
+        std::vector<double> hv;
+        for (int col: hv_columns)
+            hv.push_back(value(fields, col));
+
+        m_cond_time.push_back(time);
+        m_cond_counts.push_back(counts);
+        m_cond_hv.push_back(hv);
+    }
+}
+
+void ReplaySetupManager::rewind() {
+    m_source->rewind();
+    m_events.clear();
+    m_n_triggered = 0;
+    m_n_replayed = 0;
+    m_ttc_number = 0;
+    m_running = false;
+    m_end_reported = false;
+    m_row = 0;
+    std::fill(m_scaler_offset.begin(), m_scaler_offset.end(), 0);
+
+    m_has_next = m_source->next(m_next);
+    m_last_second = m_has_next ? m_next.time : 0;
+    if (m_has_next)
+        m_replay_time = 1000. * m_next.time;
+    else
+        m_replay_time = m_cond_time.empty() ? 0 : m_cond_time.front();
+    m_last_update = m_clock::now();
+}
+
+bool ReplaySetupManager::readSecond() {
+    if (!m_has_next)
+        return false;
+
+    // Events recorded out of order are replayed with the current second
+    std::int64_t second = std::max<std::int64_t>(m_next.time, m_last_second);
+    std::size_t first = m_events.size();
+    do {
+        m_events.emplace_back();
+        std::swap(m_events.back().evt, m_next);
+        m_has_next = m_source->next(m_next);
+    } while (m_has_next && m_next.time <= second);
+
+    std::size_t n = m_events.size() - first;
+    for (std::size_t i = 0; i < n; i++)
+        m_events[first + i].trigger_time = 1000. * second + 1000. * i / n;
+    m_last_second = second;
+
+    return true;
+}
+
+void ReplaySetupManager::update() {
+    m_clock::time_point now = m_clock::now();
+    if (m_running && m_speed > 0)
+        m_replay_time += m_speed * std::chrono::duration<double, std::milli>(now - m_last_update).count();
+    m_last_update = now;
+
+    if (m_running) {
+        // As fast as possible: keep the FIFO half full, without ever reaching almost full
+        std::size_t max_fifo = (m_speed > 0) ? FIFOSize : AlmostFullLevel / 2;
+
+        while (m_n_triggered < max_fifo) {
+            if (m_n_triggered == m_events.size() && !readSecond())
+                break;
+            const ReplayEvent& next = m_events[m_n_triggered];
+            if (m_speed > 0 && next.trigger_time > m_replay_time)
+                break;
+            if (m_speed == 0)
+                m_replay_time = next.trigger_time;
+            m_ttc_number = static_cast<std::int64_t>(next.evt.eventNumber) + 1;
+            m_n_triggered++;
+            m_n_replayed++;
+        }
+
+        // FIFO full: the replay waits for the readout instead of losing triggers
+        if (m_n_triggered >= max_fifo && m_n_triggered < m_events.size())
+            m_replay_time = std::min(m_replay_time, m_events[m_n_triggered].trigger_time);
+
+        if (!m_has_next && m_n_triggered == m_events.size() && !m_end_reported) {
+            std::cout << "Replay: end of the event file after " << m_n_replayed << " events." << std::endl;
+            m_end_reported = true;
+        }
+    }
+
+    while (m_row + 1 < m_cond_time.size() && m_cond_time[m_row + 1] <= m_replay_time)
+        m_row++;
+}
+
+double ReplaySetupManager::getRecordedCount(ScalerChannel channel) const {
+    std::size_t ch = static_cast<std::size_t>(channel);
+    if (m_cond_time.empty())
+        return (channel == ScalerChannel::TTC) ? m_n_replayed : 0;
+
+    double count = m_cond_counts[m_row][ch];
+    if (m_row + 1 < m_cond_time.size() && m_replay_time > m_cond_time[m_row]) {
+        double fraction = (m_replay_time - m_cond_time[m_row]) / (m_cond_time[m_row + 1] - m_cond_time[m_row]);
+        count += std::min(fraction, 1.) * (m_cond_counts[m_row + 1][ch] - count);
+    }
+    return count;
+}
+
+bool ReplaySetupManager::setHVPMT(std::size_t /*id*/) {
+    return true;
+}
+
+bool ReplaySetupManager::switchHVPMTON(std::size_t /*id*/) {
+    return true;
+}
+
+bool ReplaySetupManager::switchHVPMTOFF(std::size_t /*id*/) {
+    return true;
+}
+
+std::vector< std::pair<double, double> > ReplaySetupManager::getHVPMTValue() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+
+    std::vector< std::pair<double, double> > hv_values;
+    for (std::size_t id = 0; id < m_conditions.getNHVPMT(); id++) {
+        double value = m_cond_hv.empty() ? 0 : m_cond_hv[m_row].at(id);
+        hv_values.push_back(std::make_pair(value, 0.));
+    }
+    return hv_values;
+}
+
+void ReplaySetupManager::setTrigger(int channel, int /*frequency*/) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    m_running = (channel != 7);
+}
+
+void ReplaySetupManager::resetTrigger() {
+}
+
+std::int64_t ReplaySetupManager::getTTCEventNumber() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    return m_ttc_number;
+}
+
+bool ReplaySetupManager::propagateDiscriSettings() {
+    return true;
+}
+
+void ReplaySetupManager::setTDCWindowOffset(int /*offset*/) {
+}
+
+void ReplaySetupManager::setTDCWindowWidth(int /*width*/) {
+}
+
+unsigned int ReplaySetupManager::getTDCStatus() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+
+    unsigned int status = 0;
+    if (m_n_triggered > 0)
+        status |= v1190::status::DataReady::mask;
+    if (m_n_triggered >= AlmostFullLevel)
+        status |= v1190::status::AlmostFull::mask;
+    if (m_n_triggered >= FIFOSize)
+        status |= v1190::status::Full::mask;
+    return status;
+}
+
+int ReplaySetupManager::getTDCNEvents() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    return static_cast<int>(m_n_triggered);
+}
+
+void ReplaySetupManager::getTDCEvent(event& e) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_n_triggered == 0) {
+        // Nothing to read: not a valid event
+        e.clear();
+        return;
+    }
+
+    std::swap(e, m_events.front().evt);
+    m_events.pop_front();
+    m_n_triggered--;
+}
+
+void ReplaySetupManager::configureTDC() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    rewind();
+}
+
+void ReplaySetupManager::setTDCAlmostFullLevel(unsigned int /*words*/) {
+}
+
+void ReplaySetupManager::resetScaler() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    for (const auto& reading: ConditionManager::ScalerReadings)
+        m_scaler_offset[static_cast<std::size_t>(reading.first)] = getRecordedCount(reading.first);
+}
+
+int ReplaySetupManager::getScalerCount(ScalerChannel channel) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    update();
+    double count = std::max(getRecordedCount(channel) - m_scaler_offset[static_cast<std::size_t>(channel)], 0.);
+    // 32-bit counter, as on the board
+    return static_cast<int>(static_cast<std::uint32_t>(static_cast<std::uint64_t>(count)));
+}
@@ -0,0 +1,325 @@
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "RunController.h"
+#include "ConditionManager.h"
+#include "LoggingManager.h"
+#include "TSDBSpool.h"
+#include "OnlineAnalysis.h"
+#include "ThreadUtils.h"
+#include "Plugins.h"
+#include "MemoryTracker.h"
+
+// Static
+const std::vector< std::pair<RunController::State, RunController::State> > RunController::m_transitions = {
+    { RunController::State::idle, RunController::State::configured },
+    { RunController::State::configured, RunController::State::running },
+    { RunController::State::running, RunController::State::idle },
+    { RunController::State::configured, RunController::State::idle }
+};
+
+// Static
+std::string RunController::stateToString(RunController::State state) {
+    switch(state) {
+        case State::idle:
+            return "idle";
+        case State::configured:
+            return "configured";
+        case State::running:
+            return "running";
+        default:
+            return "Unknown state!";
+    }
+}
+
+// Static
+bool RunController::checkTransition(RunController::State state_from, RunController::State state_to) { 
+    return std::find(m_transitions.begin(), m_transitions.end(), std::pair<State, State>( { state_from, state_to } ) ) != m_transitions.end();
+}
+
+void RunController::setState(RunController::State state) {
+    if( !checkTransition(m_state, state) ) { 
+        throw run_control_error("Transition from " + stateToString(m_state) + " to " + stateToString(state) + " is not allowed.");
+    }
+ 
+    std::cout << "Changing run state from " << stateToString(m_state) << " to " << stateToString(state) << std::endl;
+
+    m_state = state;
+
+    std::lock_guard<std::mutex> m_lock(m_listener_mtx);
+    if (m_state_listener)
+        m_state_listener();
+}
+
+void RunController::setStateListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> m_lock(m_listener_mtx);
+    m_state_listener = listener;
+}
+
+void RunController::setQuitHandler(std::function<void()> handler) {
+    std::lock_guard<std::mutex> m_lock(m_listener_mtx);
+    m_quit_handler = handler;
+}
+
+void RunController::requestQuit() {
+    m_quit = true;
+
+    std::lock_guard<std::mutex> m_lock(m_listener_mtx);
+    if (m_quit_handler)
+        m_quit_handler();
+}
+
+RunController::RunController(const Arguments& m_args):
+    m_args(m_args),
+    m_conditions(new ConditionManager(m_args)),
+    m_logger_task(0),
+    m_state(State::idle),
+    m_run_number(0),
+    m_quit(false),
+    m_startup_time(0),
+    m_configure_time(0)
+{
+    // Only needed by the tsdb sink
+    if (m_args.sinks.count("tsdb")) {
+        try {
+            m_tsdb_spool = std::make_shared<TSDBSpool>(m_args.getTSDBSpoolPath(), m_args.tsdb_host, m_args.tsdb_port,
+                    m_args.tsdb_spool_size * 1024 * 1024, makeThreadSettings(m_args, "tsdb-replay"));
+        } catch (std::ios_base::failure& e) {
+            std::cerr << "Warning: nothing will be sent to OpenTSDB: " << e.what() << std::endl;
+        }
+    }
+
+    if (m_args.analysis_reference >= 0)
+        m_analysis = std::make_shared<OnlineAnalysis>(m_args.analysis_reference, m_args.analysis_channels, m_args.coincidence_window);
+
+    // From the start of the process: includes loading the libraries and creating the ConditionManager
+    m_startup_time = getProcessAge();
+    std::cout << "Started in " << static_cast<int>(m_startup_time * 1000) << " ms." << std::endl;
+}
+
+RunController::~RunController() {
+    if (m_state != State::idle)
+        stopRun();
+}
+
+bool RunController::runFilesExist(std::uint32_t run_number) const {
+    return LoggingManager::checkRunNumber(run_number, m_args.log_path);
+}
+
+void RunController::configureRun(std::uint32_t run_number) {
+    std::lock_guard<std::mutex> m_lock(m_run_mtx);
+
+    if (m_state != State::idle)
+        throw run_control_error("Cannot configure run: state is " + stateToString(m_state));
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        ProfiledLock m_lock(m_conditions->getDiscriLock());
+        m_conditions->propagateDiscriSettings();
+    }
+
+    {
+        ProfiledLock m_lock(m_conditions->getTTCLock());
+        m_conditions->resetTrigger();
+    }
+
+    {
+        ProfiledLock m_lock(m_conditions->getTDCLock());
+        m_conditions->configureTDC();
+    }
+
+    m_run_number = run_number;
+    try {
+        m_logging_manager = std::make_shared<LoggingManager>(*m_conditions, run_number, m_args, m_tsdb_spool, m_analysis);
+    } catch (PluginLoader::plugin_error& e) {
+        throw run_control_error(std::string("Cannot create the outputs of the run: ") + e.what());
+    }
+
+    m_configure_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1e6;
+    std::cout << "Configured run " << run_number << " in " << static_cast<int>(m_configure_time.load() * 1000) << " ms (plugins loaded so far in "
+        << PluginLoader::get().getLoadTime().count() / 1000 << " ms)." << std::endl;
+    
+    setState(State::configured);
+}
+
+void RunController::startRun() {
+    std::lock_guard<std::mutex> m_lock(m_run_mtx);
+    
+    if (m_state != State::configured)
+        throw run_control_error("Cannot start run: state is " + stateToString(m_state));
+
+    // Start continuous logging
+    std::cout << "Starting logger." << std::endl;
+    std::shared_ptr<LoggingManager> logging_manager = m_logging_manager;
+    m_logger_task = m_conditions->getScheduler().schedule(makeThreadSettings(m_args, "logger"), std::chrono::milliseconds(m_args.sample_period),
+            [logging_manager]() { logging_manager->sample(); return true; });
+
+    m_conditions->startTDCReading();
+
+    // Start trigger
+    {
+        ProfiledLock m_lock(m_conditions->getTTCLock());
+        m_conditions->startTrigger();
+    }
+    
+    m_conditions->startScalerDaemon();
+
+    setState(State::running);
+}
+
+void RunController::stopRun() {
+    std::lock_guard<std::mutex> m_lock(m_run_mtx);
+    
+    if (m_state == State::idle)
+        return;
+
+    if (m_state == State::running) {
+        // Stop listening for TDC events
+        m_conditions->stopTDCReading();
+        
+        // Stop trigger
+        {
+            ProfiledLock m_lock(m_conditions->getTTCLock());
+            m_conditions->stopTrigger();
+        }
+
+        // Stop logging
+        m_conditions->getScheduler().cancel(m_logger_task);
+        m_logger_task = 0;
+        std::cout << "Stopping logger." << std::endl;
+    
+        m_conditions->stopScalerDaemon();
+    }
+
+    // Destroy logging manager
+    m_logging_manager.reset();
+
+    setState(State::idle);
+}
+
+void RunController::updateConditionLog() {
+    std::lock_guard<std::mutex> m_lock(m_run_mtx);
+    
+    if (m_state != State::idle)
+        m_logging_manager->updateConditionManagerLog();
+}
+
+std::string RunController::statusString() {
+    std::ostringstream status;
+    status << "state=" << stateToString(m_state) << " run=" << m_run_number;
+
+    if (m_state == State::running) {
+        {
+            ProfiledLock m_lock(m_conditions->getTDCLock());
+            status << " tdc_events=" << m_conditions->getTDCEventCount()
+                << " tdc_offset=" << m_conditions->getTDCOffset()
+                << " backpressure=" << m_conditions->checkTDCBackPressure()
+                << " fatal=" << m_conditions->checkTDCFatalError();
+        }
+        {
+            ProfiledLock m_lock(m_conditions->getTTCLock());
+            status << " ttc_events=" << m_conditions->getTriggerEventNumber();
+        }
+        if (m_analysis.get()) {
+            OnlineAnalysis::Results results = m_analysis->getResults();
+            status << " reference_rate=" << results.getReferenceRate() << " multiplicity=" << results.getMeanMultiplicity();
+        }
+    }
+
+    {
+        ProfiledLock m_lock(m_conditions->getHVLock());
+        for (std::size_t id = 0; id < m_conditions->getNHVPMT(); id++) {
+            status << " hv_" << id << "=" << m_conditions->getHVPMTSetValue(id) << "/" << m_conditions->getHVPMTReadValue(id)
+                << (m_conditions->getHVPMTSetState(id) ? "/on" : "/off");
+        }
+    }
+
+    if (m_tsdb_spool.get()) {
+        TSDBSpool::Stats tsdb_stats = m_tsdb_spool->getStats();
+        status << " tsdb=" << (tsdb_stats.server_up ? "up" : "down") << " tsdb_backlog_kB=" << tsdb_stats.backlog_bytes / 1024;
+    }
+
+    status << " startup_ms=" << static_cast<int>(m_startup_time * 1000) << " configure_ms=" << static_cast<int>(m_configure_time.load() * 1000);
+    status << " resident_MB=" << MemoryTracker::getResidentBytes() / (1024 * 1024);
+    
+    return status.str();
+}
+
+std::string RunController::executeCommand(const std::string& command) {
+    std::istringstream input(command);
+    std::string verb;
+    input >> verb;
+
+    try {
+        if (verb == "help") {
+            return "OK commands: status | configure RUN [force] | start | stop | trigger CHANNEL FREQUENCY_MODE | hv ID VOLTAGE | hvstate ID on|off | resetscaler | quit";
+        
+        } else if (verb == "status") {
+            return "OK " + statusString();
+        
+        } else if (verb == "configure") {
+            std::uint32_t run_number;
+            std::string force;
+            if (!(input >> run_number))
+                return "ERROR usage: configure RUN [force]";
+            input >> force;
+            if (runFilesExist(run_number) && force != "force")
+                return "ERROR log files for run " + std::to_string(run_number) + " already exist, use 'configure " + std::to_string(run_number) + " force' to overwrite them";
+            configureRun(run_number);
+        
+        } else if (verb == "start") {
+            startRun();
+        
+        } else if (verb == "stop") {
+            stopRun();
+        
+        } else if (verb == "trigger") {
+            int channel, frequency;
+            if (!(input >> channel >> frequency) || channel < -1 || channel > 7 || frequency < 0 || frequency > 7)
+                return "ERROR usage: trigger CHANNEL(-1..7) FREQUENCY_MODE(0..7)";
+            if (m_state != State::idle)
+                return "ERROR trigger settings can only be changed when idle";
+            ProfiledLock m_lock(m_conditions->getTTCLock());
+            m_conditions->setTriggerChannel(channel);
+            m_conditions->setTriggerRandomFrequency(frequency);
+        
+        } else if (verb == "hv" || verb == "hvstate") {
+            std::size_t id;
+            std::string value;
+            if (!(input >> id >> value) || id >= m_conditions->getNHVPMT())
+                return "ERROR usage: hv ID VOLTAGE | hvstate ID on|off";
+            bool success;
+            {
+                ProfiledLock m_lock(m_conditions->getHVLock());
+                if (verb == "hv") {
+                    m_conditions->setHVPMTValue(id, std::stoi(value));
+                    success = m_conditions->propagateHVPMTValue(id);
+                } else {
+                    m_conditions->setHVPMTState(id, value == "on");
+                    success = m_conditions->propagateHVPMTState(id);
+                }
+            }
+            updateConditionLog();
+            if (!success)
+                return "ERROR could not propagate HV setting to the board";
+        
+        } else if (verb == "resetscaler") {
+            ProfiledLock m_lock(m_conditions->getScalerLock());
+            m_conditions->resetScaler();
+        
+        } else if (verb == "quit") {
+            requestQuit();
+        
+        } else {
+            return "ERROR unknown command '" + verb + "', try 'help'";
+        }
+    } catch (std::exception& e) {
+        return std::string("ERROR ") + e.what();
+    }
+
+    return "OK " + statusString();
+}
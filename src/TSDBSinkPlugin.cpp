@@ -0,0 +1,65 @@
+#include "LogSink.h"
+#include "Plugins.h"
+#include "TSDBSpool.h"
+
+/*
+ * Plugin "tsdb": publish the conditions to OpenTSDB, through the spool (see LogSink.h)
+ */
+
+namespace {
+
+class TSDBSink: public LogSink {
+    public:
+        TSDBSink(std::shared_ptr<TSDBSpool> spool, const LogLayout& layout, std::string metric_suffix);
+        virtual ~TSDBSink() override {};
+
+        virtual void write(const LogRecord& record) override;
+
+    private:
+        std::shared_ptr<TSDBSpool> m_spool;
+        // Beginning of the lines of each time series (see TSDBSpool::pointPrefix())
+        std::vector<std::string> m_mean;
+        std::vector<std::string> m_min;
+        std::vector<std::string> m_max;
+        std::vector<std::string> m_values;
+        // Reused from one record to the next
+        std::string m_lines;
+};
+
+TSDBSink::TSDBSink(std::shared_ptr<TSDBSpool> spool, const LogLayout& layout, std::string metric_suffix):
+    m_spool(spool)
+{
+    for (const auto& channel: layout.sampled) {
+        m_mean.push_back(TSDBSpool::pointPrefix(channel.metric + metric_suffix, channel.tags));
+        m_min.push_back(TSDBSpool::pointPrefix(channel.metric + metric_suffix + ".min", channel.tags));
+        m_max.push_back(TSDBSpool::pointPrefix(channel.metric + metric_suffix + ".max", channel.tags));
+    }
+    for (const auto& channel: layout.values)
+        m_values.push_back(TSDBSpool::pointPrefix(channel.metric + metric_suffix, channel.tags));
+}
+
+void TSDBSink::write(const LogRecord& record) {
+    m_lines.clear();
+    std::size_t n_points = 0;
+
+    for (std::size_t ch = 0; ch < m_mean.size(); ch++) {
+        n_points += TSDBSpool::appendPoint(m_lines, m_mean[ch], record.timestamp, record.mean[ch]);
+        n_points += TSDBSpool::appendPoint(m_lines, m_min[ch], record.timestamp, record.min[ch]);
+        n_points += TSDBSpool::appendPoint(m_lines, m_max[ch], record.timestamp, record.max[ch]);
+    }
+    for (std::size_t ch = 0; ch < m_values.size(); ch++)
+        n_points += TSDBSpool::appendPoint(m_lines, m_values[ch], record.timestamp, record.values[ch]);
+
+    // One write to the spool per record
+    m_spool->append(m_lines, n_points);
+}
+
+}
+
+extern "C" int slowControlPluginAPI() {
+    return SLOWCONTROL_PLUGIN_API;
+}
+
+extern "C" LogSink* slowControlCreateSink(const SinkContext& context) {
+    return new TSDBSink(context.tsdb_spool, *context.layout, context.metric_suffix);
+}
@@ -0,0 +1,438 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "TSDBSpool.h"
+#include "MemoryTracker.h"
+
+namespace {
+
+    // Maximal size of a replayed batch
+    const std::size_t BatchBytes = 64 * 1024;
+    // Timeout of the HTTP requests
+    const int RequestTimeout_s = 5;
+
+    std::string escapeJSON(const std::string& str) {
+        std::string escaped;
+        for (char c: str) {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    /*
+     * Minimal HTTP/1.1 client: POST `body` as JSON and return the status code,
+     * or -1 if the request failed (`error` is then set)
+     */
+    int httpPost(const std::string& host, int port, const std::string& path, const std::string& body, std::string& error) {
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo* addresses;
+        int rc = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+        if (rc != 0) {
+            error = gai_strerror(rc);
+            return -1;
+        }
+
+        int fd = -1;
+        for (addrinfo* address = addresses; address; address = address->ai_next) {
+            fd = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+            if (fd < 0)
+                continue;
+
+            // Also applies to connect()
+            timeval timeout = { RequestTimeout_s, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0)
+                break;
+
+            error = std::strerror(errno);
+            ::close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(addresses);
+        if (fd < 0)
+            return -1;
+
+        std::string request = "POST " + path + " HTTP/1.1\r\n"
+            "Host: " + host + ":" + std::to_string(port) + "\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + body;
+
+        const char* data = request.data();
+        std::size_t remaining = request.size();
+        while (remaining) {
+            ssize_t sent = ::send(fd, data, remaining, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR)
+                    continue;
+                error = std::strerror(errno);
+                ::close(fd);
+                return -1;
+            }
+            data += sent;
+            remaining -= sent;
+        }
+
+        // Only the status line is needed
+        std::string response;
+        char buffer[512];
+        while (response.find("\r\n") == std::string::npos && response.size() < 4096) {
+            ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                break;
+            response.append(buffer, received);
+        }
+        ::close(fd);
+
+        std::istringstream status_line(response);
+        std::string version;
+        int status = -1;
+        if (!(status_line >> version >> status) || version.compare(0, 5, "HTTP/") != 0) {
+            error = "invalid response from server";
+            return -1;
+        }
+        return status;
+    }
+}
+
+TSDBSpool::TSDBSpool(std::string directory, std::string host, int port, std::uint64_t max_bytes, ThreadSettings settings):
+    m_directory(directory),
+    m_host(host),
+    m_port(port),
+    m_max_bytes(max_bytes),
+    // Small enough that bounding the disk usage does not drop too much at once
+    m_segment_size(std::max<std::uint64_t>(max_bytes / 16, 64 * 1024)),
+    m_write_seq(0),
+    m_write_fd(-1),
+    m_read_seq(0),
+    m_read_offset(0),
+    m_stats(Stats()),
+    m_last_replayed_points(0),
+    m_last_stats_time(std::chrono::steady_clock::now()),
+    m_running(true)
+{
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+        throw std::ios_base::failure("Could not create spool directory " + directory + ": " + std::strerror(errno));
+
+    // Pick up the segments left by a previous execution
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir)
+        throw std::ios_base::failure("Could not open spool directory " + directory + ": " + std::strerror(errno));
+    while (dirent* entry = ::readdir(dir)) {
+        unsigned long long seq;
+        char suffix[8];
+        if (std::sscanf(entry->d_name, "segment_%llu.%7s", &seq, suffix) == 2 && std::string(suffix) == "spool") {
+            struct stat info;
+            if (::stat(segmentName(seq).c_str(), &info) == 0)
+                m_segments[seq] = info.st_size;
+        }
+    }
+    ::closedir(dir);
+
+    unsigned long long checkpoint_seq = 0, checkpoint_offset = 0;
+    std::ifstream checkpoint(m_directory + "/checkpoint");
+    checkpoint >> checkpoint_seq >> checkpoint_offset;
+
+    // Segments before the checkpoint were already replayed
+    while (!m_segments.empty() && m_segments.begin()->first < checkpoint_seq)
+        removeSegment(m_segments.begin()->first);
+
+    m_write_seq = m_segments.empty() ? checkpoint_seq : m_segments.rbegin()->first + 1;
+    if (!m_segments.empty() && m_segments.begin()->first == checkpoint_seq) {
+        m_read_seq = checkpoint_seq;
+        m_read_offset = std::min<std::uint64_t>(checkpoint_offset, m_segments.begin()->second);
+    } else {
+        m_read_seq = m_segments.empty() ? m_write_seq : m_segments.begin()->first;
+        m_read_offset = 0;
+    }
+    openSegment(m_write_seq);
+
+    std::cout << "TSDB spool in " << directory << ": " << backlogBytes() / 1024 << " kB to replay to " << host << ":" << port << std::endl;
+
+    m_thread = startThread(settings, [this]() { run(); });
+}
+
+TSDBSpool::~TSDBSpool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_running = false;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+
+    ::close(m_write_fd);
+}
+
+std::string TSDBSpool::segmentName(std::uint64_t seq) const {
+    return m_directory + "/segment_" + std::to_string(seq) + ".spool";
+}
+
+void TSDBSpool::openSegment(std::uint64_t seq) {
+    if (m_write_fd >= 0)
+        ::close(m_write_fd);
+
+    m_write_seq = seq;
+    m_write_fd = ::open(segmentName(seq).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (m_write_fd < 0)
+        throw std::ios_base::failure("Could not open spool segment " + segmentName(seq) + ": " + std::strerror(errno));
+    m_segments[seq] = 0;
+}
+
+void TSDBSpool::removeSegment(std::uint64_t seq) {
+    std::remove(segmentName(seq).c_str());
+    m_segments.erase(seq);
+}
+
+void TSDBSpool::saveCheckpoint() {
+    // Write then rename, so that the checkpoint is never seen half-written
+    std::string temp_name = m_directory + "/checkpoint.tmp";
+    {
+        std::ofstream checkpoint(temp_name);
+        checkpoint << m_read_seq << " " << m_read_offset << std::endl;
+    }
+    if (std::rename(temp_name.c_str(), (m_directory + "/checkpoint").c_str()) != 0)
+        std::cerr << "Warning: could not save TSDB spool checkpoint: " << std::strerror(errno) << std::endl;
+}
+
+std::uint64_t TSDBSpool::backlogBytes() const {
+    std::uint64_t backlog = 0;
+    for (auto it = m_segments.lower_bound(m_read_seq); it != m_segments.end(); ++it)
+        backlog += it->second;
+    return backlog - m_read_offset;
+}
+
+void TSDBSpool::append(const std::string& lines, std::size_t n_points) {
+    if (lines.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+
+        if (m_segments[m_write_seq] > 0 && m_segments[m_write_seq] + lines.size() > m_segment_size) {
+            try {
+                openSegment(m_write_seq + 1);
+            } catch (std::ios_base::failure& e) {
+                std::cerr << "Warning: " << e.what() << std::endl;
+                return;
+            }
+        }
+
+        const char* data = lines.data();
+        std::size_t remaining = lines.size();
+        while (remaining) {
+            ssize_t written = ::write(m_write_fd, data, remaining);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                std::cerr << "Warning: could not write to TSDB spool: " << std::strerror(errno) << std::endl;
+                break;
+            }
+            data += written;
+            remaining -= written;
+        }
+        m_segments[m_write_seq] += lines.size() - remaining;
+        m_stats.spooled_points += n_points;
+
+        // Bound the disk usage by dropping the oldest segments
+        std::uint64_t total = 0;
+        for (const auto& segment: m_segments)
+            total += segment.second;
+        while (total > m_max_bytes && m_segments.size() > 1) {
+            std::uint64_t seq = m_segments.begin()->first;
+            std::uint64_t bytes = m_segments.begin()->second;
+
+            if (m_stats.dropped_bytes == 0)
+                std::cerr << "Warning: TSDB spool is full, dropping the oldest datapoints." << std::endl;
+            m_stats.dropped_bytes += (seq == m_read_seq) ? bytes - m_read_offset : bytes;
+            total -= bytes;
+
+            removeSegment(seq);
+            if (seq == m_read_seq) {
+                m_read_seq = m_segments.begin()->first;
+                m_read_offset = 0;
+                saveCheckpoint();
+            }
+        }
+    }
+    m_cv.notify_all();
+}
+
+TSDBSpool::Stats TSDBSpool::getStats() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_stats.backlog_bytes = backlogBytes();
+    return m_stats;
+}
+
+void TSDBSpool::updateReplayRate() {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_last_stats_time).count();
+    if (elapsed < 1)
+        return;
+
+    m_stats.replay_rate = (m_stats.replayed_points - m_last_replayed_points) / elapsed;
+    m_last_replayed_points = m_stats.replayed_points;
+    m_last_stats_time = now;
+}
+
+std::size_t TSDBSpool::readBatch(std::string& body, std::uint64_t& end_offset) {
+    while (true) {
+        auto segment = m_segments.find(m_read_seq);
+        if (segment == m_segments.end())
+            return 0;
+
+        // Segment completely replayed: go to the next one, unless it is being written
+        if (m_read_offset >= segment->second) {
+            if (m_read_seq == m_write_seq)
+                return 0;
+            removeSegment(m_read_seq);
+            m_read_seq = m_segments.begin()->first;
+            m_read_offset = 0;
+            saveCheckpoint();
+            continue;
+        }
+
+        std::string chunk(std::min<std::uint64_t>(segment->second - m_read_offset, BatchBytes), '\0');
+        int fd = ::open(segmentName(m_read_seq).c_str(), O_RDONLY | O_CLOEXEC);
+        ssize_t n_read = (fd >= 0) ? ::pread(fd, &chunk[0], chunk.size(), m_read_offset) : -1;
+        if (fd >= 0)
+            ::close(fd);
+        if (n_read <= 0) {
+            std::cerr << "Warning: could not read TSDB spool segment " << segmentName(m_read_seq) << ", skipping it." << std::endl;
+            m_read_offset = segment->second;
+            continue;
+        }
+        chunk.resize(n_read);
+
+        std::size_t last_line = chunk.rfind('\n');
+        if (last_line == std::string::npos) {
+            // Only the segment being written may end with an incomplete line (while it is written):
+            // in other segments, it was truncated by a crash
+            if (m_read_seq == m_write_seq)
+                return 0;
+            m_read_offset = segment->second;
+            continue;
+        }
+        chunk.resize(last_line);
+
+        std::size_t n_points = std::count(chunk.begin(), chunk.end(), '\n') + 1;
+        std::replace(chunk.begin(), chunk.end(), '\n', ',');
+        body = "[" + chunk + "]";
+        end_offset = m_read_offset + last_line + 1;
+        return n_points;
+    }
+}
+
+void TSDBSpool::advance(std::uint64_t end_offset) {
+    m_read_offset = end_offset;
+
+    if (m_read_offset >= m_segments[m_read_seq] && m_read_seq != m_write_seq) {
+        removeSegment(m_read_seq);
+        m_read_seq = m_segments.begin()->first;
+        m_read_offset = 0;
+    }
+
+    saveCheckpoint();
+}
+
+void TSDBSpool::run() {
+    MemoryScope memory_scope(MemoryTracker::Subsystem::TSDB);
+    std::chrono::seconds backoff(1);
+    const std::chrono::seconds max_backoff(30);
+
+    std::unique_lock<std::mutex> lock(m_mtx);
+
+    while (m_running) {
+        updateReplayRate();
+
+        std::string body;
+        std::uint64_t end_offset = 0;
+        std::size_t n_points = readBatch(body, end_offset);
+        std::uint64_t batch_seq = m_read_seq;
+
+        if (n_points == 0) {
+            m_cv.wait_for(lock, std::chrono::seconds(1));
+            continue;
+        }
+
+        lock.unlock();
+        std::string error;
+        int status = httpPost(m_host, m_port, "/api/put", body, error);
+        lock.lock();
+
+        if ((status >= 200 && status < 300) || status == 400) {
+            if (!m_stats.server_up)
+                std::cout << "OpenTSDB server " << m_host << ":" << m_port << " is reachable, replaying " << backlogBytes() / 1024 << " kB of datapoints." << std::endl;
+            m_stats.server_up = true;
+            backoff = std::chrono::seconds(1);
+
+            // A malformed batch would otherwise be retried forever
+            if (status == 400) {
+                std::cerr << "Warning: OpenTSDB rejected " << n_points << " datapoints." << std::endl;
+                m_stats.rejected_points += n_points;
+            } else {
+                m_stats.replayed_points += n_points;
+            }
+
+            // The segment may have been dropped in the meantime to bound the disk usage
+            if (batch_seq == m_read_seq)
+                advance(end_offset);
+        } else {
+            if (m_stats.server_up || (m_stats.replayed_points == 0 && backoff == std::chrono::seconds(1)))
+                std::cerr << "Warning: OpenTSDB server " << m_host << ":" << m_port << " unreachable (" << (status < 0 ? error : "HTTP status " + std::to_string(status)) << "), spooling datapoints." << std::endl;
+            m_stats.server_up = false;
+            m_stats.replay_rate = 0;
+
+            m_cv.wait_for(lock, backoff, [this]() { return !m_running; });
+            backoff = std::min(backoff * 2, max_backoff);
+        }
+    }
+}
+
+std::string TSDBSpool::pointPrefix(std::string metric, const TSTags_t& tags) {
+    std::string prefix = "{\"metric\":\"" + escapeJSON(metric) + "\",\"tags\":{";
+    bool first = true;
+    for (const auto& tag: tags) {
+        if (!first)
+            prefix += ",";
+        prefix += "\"" + escapeJSON(tag.first) + "\":\"" + escapeJSON(tag.second) + "\"";
+        first = false;
+    }
+    prefix += "},\"timestamp\":";
+    return prefix;
+}
+
+bool TSDBSpool::appendPoint(std::string& lines, const std::string& prefix, std::uint64_t timestamp, double value) {
+    if (!std::isfinite(value))
+        return false;
+
+    char buffer[64];
+    int length = std::snprintf(buffer, sizeof(buffer), "%llu,\"value\":%.10g}\n", static_cast<unsigned long long>(timestamp), value);
+    lines += prefix;
+    lines.append(buffer, length);
+    return true;
+}
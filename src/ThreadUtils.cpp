@@ -0,0 +1,140 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <cstring>
+#include <ctime>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "ThreadUtils.h"
+
+namespace {
+    
+    struct ThreadAccount {
+        ThreadAccount(): finished_time(0) {}
+        
+        std::map<pthread_t, clockid_t> running;
+        double finished_time;
+    };
+
+    std::mutex accounts_mtx;
+    std::map<std::string, ThreadAccount> accounts;
+
+    // CPUs available when the program started, before any thread was pinned
+    cpu_set_t getInitialCPUs() {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        sched_getaffinity(0, sizeof(cpus), &cpus);
+        return cpus;
+    }
+    const cpu_set_t initial_cpus = getInitialCPUs();
+
+    double clockSeconds(clockid_t clock) {
+        timespec time;
+        if (clock_gettime(clock, &time) != 0)
+            return 0;
+        return time.tv_sec + 1e-9 * time.tv_nsec;
+    }
+}
+
+ThreadSettings makeThreadSettings(const Arguments& m_args, std::string name) {
+    ThreadSettings settings(name);
+
+    auto cpus = m_args.thread_cpus.find(name);
+    if (cpus != m_args.thread_cpus.end())
+        settings.cpus = cpus->second;
+
+    // Only the TDC readout, and the bus thread which runs its VME accesses, may run with real-time priority
+    if (name == "tdc" || name == "bus")
+        settings.rt_priority = m_args.tdc_rt_priority;
+
+    return settings;
+}
+
+double getProcessAge() {
+    std::ifstream stat("/proc/self/stat");
+    std::string content;
+    if (!std::getline(stat, content))
+        return 0;
+
+    // The command name (2nd field) may contain spaces: count the fields after it.
+    // The start time (in clock ticks since boot) is the 22nd field, the 20th after the command name.
+    std::size_t paren = content.rfind(')');
+    if (paren == std::string::npos)
+        return 0;
+    std::istringstream fields(content.substr(paren + 1));
+    std::string field;
+    for (int i = 0; i < 20; i++) {
+        if (!(fields >> field))
+            return 0;
+    }
+
+    double uptime = 0;
+    if (!(std::ifstream("/proc/uptime") >> uptime))
+        return 0;
+    return uptime - std::stoull(field) / double(sysconf(_SC_CLK_TCK));
+}
+
+ThreadScope::ThreadScope(const ThreadSettings& settings):
+    m_name(settings.name)
+{
+    pthread_t self = pthread_self();
+
+    std::string thread_name = ("sc-" + settings.name).substr(0, 15);
+    pthread_setname_np(self, thread_name.c_str());
+
+    // Threads inherit the affinity of their creator: reset it if nothing was requested
+    cpu_set_t cpus = initial_cpus;
+    if (!settings.cpus.empty()) {
+        CPU_ZERO(&cpus);
+        for (int cpu: settings.cpus)
+            CPU_SET(cpu, &cpus);
+    }
+    int error = pthread_setaffinity_np(self, sizeof(cpus), &cpus);
+    if (error)
+        std::cerr << "Warning: could not set CPU affinity of thread " << thread_name << ": " << std::strerror(error) << std::endl;
+
+    // Same for the scheduling policy
+    sched_param param;
+    param.sched_priority = settings.rt_priority;
+    error = pthread_setschedparam(self, settings.rt_priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+    if (error)
+        std::cerr << "Warning: could not set scheduling of thread " << thread_name << " (priority " << settings.rt_priority << "): " << std::strerror(error) << std::endl;
+    else if (settings.rt_priority > 0)
+        std::cout << "Thread " << thread_name << " running with SCHED_FIFO priority " << settings.rt_priority << std::endl;
+
+    clockid_t clock;
+    if (pthread_getcpuclockid(self, &clock) == 0) {
+        std::lock_guard<std::mutex> m_lock(accounts_mtx);
+        accounts[m_name].running[self] = clock;
+    }
+}
+
+ThreadScope::~ThreadScope() {
+    pthread_t self = pthread_self();
+    double used = clockSeconds(CLOCK_THREAD_CPUTIME_ID);
+
+    std::lock_guard<std::mutex> m_lock(accounts_mtx);
+    ThreadAccount& account = accounts[m_name];
+    account.running.erase(self);
+    account.finished_time += used;
+}
+
+// Static
+std::map<std::string, double> ThreadScope::getCPUTimes() {
+    std::lock_guard<std::mutex> m_lock(accounts_mtx);
+
+    std::map<std::string, double> times;
+    for (const auto& account: accounts) {
+        double time = account.second.finished_time;
+        // Threads are unregistered before they finish, so their clocks are still valid here
+        for (const auto& thread: account.second.running)
+            time += clockSeconds(thread.second);
+        times[account.first] = time;
+    }
+
+    return times;
+}
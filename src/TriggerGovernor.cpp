@@ -0,0 +1,113 @@
+#include <cmath>
+
+#include "TriggerGovernor.h"
+
+const TriggerGovernor::m_clock::duration TriggerGovernor::SmoothingTime = std::chrono::milliseconds(100);
+const TriggerGovernor::m_clock::duration TriggerGovernor::MinInhibit = std::chrono::milliseconds(5);
+const TriggerGovernor::m_clock::duration TriggerGovernor::StepDownInterval = std::chrono::seconds(1);
+const TriggerGovernor::m_clock::duration TriggerGovernor::StepUpInterval = std::chrono::seconds(10);
+
+TriggerGovernor::TriggerGovernor(std::size_t low_watermark, std::size_t high_watermark, bool throttle):
+    m_low_watermark(low_watermark),
+    m_high_watermark(std::max(high_watermark, low_watermark)),
+    m_throttle_enabled(throttle)
+{
+    reset();
+}
+
+void TriggerGovernor::reset() {
+    m_started = false;
+    m_occupancy = 0;
+    m_last_occupancy = 0;
+    m_inhibited = false;
+    m_pressure = false;
+    m_throttle = 0;
+    m_last_step_up = false;
+    m_step_up_wait = StepUpInterval;
+    m_calm = false;
+    m_stats = { 0, 0, 0, 0 };
+}
+
+bool TriggerGovernor::update(m_clock::time_point now, bool almost_full, std::size_t fifo_events, int requested) {
+    bool changed = false;
+
+    // Smoothed occupancy (exponential moving average over SmoothingTime)
+    if (!m_started) {
+        m_started = true;
+        m_occupancy = fifo_events;
+        m_last_step = now;
+    } else {
+        double elapsed = std::chrono::duration<double>(now - m_last_update).count() / std::chrono::duration<double>(SmoothingTime).count();
+        m_occupancy += (1 - std::exp(-std::max(elapsed, 0.))) * (fifo_events - m_occupancy);
+    }
+    bool rising = (m_occupancy > m_last_occupancy);
+    m_last_occupancy = m_occupancy;
+    m_last_update = now;
+
+    // Inhibit: stop at almost full, restart once drained to the low watermark
+    if (!m_inhibited && almost_full) {
+        m_inhibited = true;
+        m_inhibit_start = now;
+        m_pressure = true;
+        m_stats.n_inhibits++;
+        changed = true;
+    } else if (m_inhibited && !almost_full && fifo_events <= m_low_watermark && now - m_inhibit_start >= MinInhibit) {
+        m_inhibited = false;
+        m_stats.inhibit_time += std::chrono::duration<double>(now - m_inhibit_start).count();
+        changed = true;
+    }
+
+    if (!m_throttle_enabled || requested < 0) {
+        m_pressure = false;
+        m_calm = false;
+        return changed;
+    }
+
+    // Throttle: a lower requested setting applies at once
+    int throttle = std::min(m_throttle, requested);
+    if (m_pressure || (m_occupancy > m_high_watermark && rising)) {
+        if (throttle == requested) {
+            // Lowest setting already
+            m_pressure = false;
+        } else if (now - m_last_step >= StepDownInterval) {
+            // The last step up was too much: wait longer before the next one
+            if (m_last_step_up && now - m_last_step < StepUpInterval)
+                m_step_up_wait = std::min(2 * m_step_up_wait, 16 * StepUpInterval);
+            throttle++;
+            m_stats.n_steps_down++;
+            m_last_step = now;
+            m_last_step_up = false;
+            m_pressure = false;
+        }
+    }
+
+    bool calm = !m_inhibited && m_occupancy < m_low_watermark;
+    if (!calm) {
+        m_calm = false;
+    } else if (!m_calm) {
+        m_calm = true;
+        m_calm_start = now;
+    }
+    if (m_calm && throttle > 0 && now - m_calm_start >= m_step_up_wait && now - m_last_step >= m_step_up_wait) {
+        throttle--;
+        m_stats.n_steps_up++;
+        m_last_step = now;
+        m_last_step_up = true;
+        m_calm_start = now;
+    }
+
+    if (throttle != m_throttle) {
+        m_throttle = throttle;
+        // Applied when the inhibit is released otherwise
+        if (!m_inhibited)
+            changed = true;
+    }
+    return changed;
+}
+
+TriggerGovernor::Stats TriggerGovernor::getStats(m_clock::time_point now) const {
+    Stats stats = m_stats;
+    if (m_inhibited)
+        stats.inhibit_time += std::chrono::duration<double>(now - m_inhibit_start).count();
+    return stats;
+}
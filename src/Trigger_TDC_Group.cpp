@@ -14,7 +14,8 @@
 
 Trigger_TDC_Group::Trigger_TDC_Group(Interface& m_interface):
     m_interface(m_interface),
-    QGroupBox("Trigger + TDC", &m_interface) {
+    QGroupBox("Trigger + TDC", &m_interface),
+    m_displayed_valid(false) {
 
         /* -- Trigger settings -- */
         QVBoxLayout *tdc_ttc_layout = new QVBoxLayout();
@@ -95,91 +96,48 @@ Trigger_TDC_Group::Trigger_TDC_Group(Interface& m_interface):
         setLayout(tdc_ttc_layout);
 }
 
-void Trigger_TDC_Group::notifyUpdate() {
-    {
-        std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getTDCLock());
-        
-        if (m_interface.m_conditions->checkTDCBackPressure()) {
-            m_tdc_backPressure_label->show();
-            m_tdc_ok_label->hide();
-        } else {
-            m_tdc_backPressure_label->hide();
-        }
-        
-        if (m_interface.m_conditions->checkTDCFatalError()) {
-            m_tdc_fatal_label->show();
-            m_tdc_ok_label->hide();
-        } else {
-            m_tdc_fatal_label->hide();
-        }
-        
-        if (!m_interface.m_conditions->checkTDCFatalError() && !m_interface.m_conditions->checkTDCBackPressure()) {
-            m_tdc_ok_label->show();
-        }
-        
-        m_tdc_eventCounter_label->setText(QString::number(m_interface.m_conditions->getTDCEventCount()));
-        m_tdc_offset_label->setText(QString::number(m_interface.m_conditions->getTDCOffset()));
-        m_tdc_FIFOEventCount_label->setText(QString::number(m_interface.m_conditions->getTDCFIFOEventCount()));
+void Trigger_TDC_Group::notifyUpdate(const ConditionManager::Status& status) {
+    if (!m_displayed_valid || status.tdcBackPressure != m_displayed.tdcBackPressure || status.tdcFatal != m_displayed.tdcFatal) {
+        m_tdc_backPressure_label->setVisible(status.tdcBackPressure);
+        m_tdc_fatal_label->setVisible(status.tdcFatal);
+        m_tdc_ok_label->setVisible(!status.tdcFatal && !status.tdcBackPressure);
     }
 
-    {
-        std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getTTCLock());
-        m_trigger_eventCounter_label->setText(QString::number(m_interface.m_conditions->getTriggerEventNumber()));
-    }
+    if (!m_displayed_valid || status.tdcEventCount != m_displayed.tdcEventCount)
+        m_tdc_eventCounter_label->setText(QString::number(status.tdcEventCount));
+    if (!m_displayed_valid || status.tdcOffset != m_displayed.tdcOffset)
+        m_tdc_offset_label->setText(QString::number(status.tdcOffset));
+    if (!m_displayed_valid || status.tdcFIFOEventCount != m_displayed.tdcFIFOEventCount)
+        m_tdc_FIFOEventCount_label->setText(QString::number(status.tdcFIFOEventCount));
+    if (!m_displayed_valid || status.triggerEventNumber != m_displayed.triggerEventNumber)
+        m_trigger_eventCounter_label->setText(QString::number(status.triggerEventNumber));
+
+    m_displayed = status;
+    m_displayed_valid = true;
 }
 
-void Trigger_TDC_Group::atConfigureRun() {
-    if (m_interface.m_state != Interface::State::idle)
-        return;
-
-    // Freeze trigger configuration
-    m_triggerChannel_box->setDisabled(true);
-    m_triggerRandom_box->setDisabled(true);
-    
-    {
-        // Propagate trigger info to condition manager and setup
-        std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getTTCLock());
-        m_interface.m_conditions->resetTrigger();
-        m_interface.m_conditions->setTriggerChannel(m_triggerChannel_box->value());
-        m_interface.m_conditions->setTriggerRandomFrequency(m_triggerRandom_box->value());
-    }
+void Trigger_TDC_Group::propagateTriggerSettings() {
+    ProfiledLock m_lock(m_interface.m_conditions->getTTCLock());
+    m_interface.m_conditions->setTriggerChannel(m_triggerChannel_box->value());
+    m_interface.m_conditions->setTriggerRandomFrequency(m_triggerRandom_box->value());
+}
 
+void Trigger_TDC_Group::atConfigureRun() {
+    // Freeze trigger configuration (it may have been set by another client of the RunController)
     {
-        std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getTDCLock());
-        m_interface.m_conditions->configureTDC();
+        ProfiledLock m_lock(m_interface.m_conditions->getTTCLock());
+        m_triggerChannel_box->setValue(m_interface.m_conditions->getTriggerChannel());
+        m_triggerRandom_box->setValue(m_interface.m_conditions->getTriggerRandomFrequency());
     }
+    m_triggerChannel_box->setDisabled(true);
+    m_triggerRandom_box->setDisabled(true);
 }
 
 void Trigger_TDC_Group::atStartRun() {
-    if (m_interface.m_state != Interface::State::configured)
-        return;
-
-    m_interface.m_conditions->startTDCReading();
-
-    // Start trigger
-    {
-        std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getTTCLock());
-        m_interface.m_conditions->startTrigger();
-    }
- 
     m_tdc_ok_label->show();
 }
 
 void Trigger_TDC_Group::atStopRun() {
-    if (m_interface.m_state == Interface::State::idle)
-        return;
-
-    if (m_interface.m_state == Interface::State::running) {
-        // Stop listening for TDC events
-        m_interface.m_conditions->stopTDCReading();
-        
-        // Stop trigger
-        {
-            std::lock_guard<std::mutex> m_lock(m_interface.m_conditions->getTTCLock());
-            m_interface.m_conditions->stopTrigger();
-        }
-    }
-
     m_triggerChannel_box->setDisabled(false);
     m_triggerRandom_box->setDisabled(false);
 
@@ -191,4 +149,6 @@ void Trigger_TDC_Group::atStopRun() {
     m_tdc_ok_label->hide();
     m_tdc_backPressure_label->hide();
     m_tdc_fatal_label->hide();
+
+    m_displayed_valid = false;
 }
@@ -0,0 +1,101 @@
+#include <algorithm>
+
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(std::size_t n_workers, ThreadSettings settings):
+    m_next_worker(0),
+    m_n_queued(0),
+    m_n_stolen(0),
+    m_n_pending(0),
+    m_stop(false)
+{
+    n_workers = std::max<std::size_t>(n_workers, 1);
+    for (std::size_t i = 0; i < n_workers; i++)
+        m_workers.emplace_back(new Worker());
+
+    for (std::size_t i = 0; i < n_workers; i++) {
+        ThreadSettings worker_settings = settings;
+        worker_settings.name = settings.name + "-" + std::to_string(i);
+        m_threads.push_back(startThread(worker_settings, [this, i]() { run(i); }));
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+    m_work_cv.notify_all();
+    for (auto& thread: m_threads)
+        thread.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    // Counted before being queued: a worker may take and complete the task at once
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_n_pending++;
+        m_n_queued++;
+    }
+
+    Worker& worker = *m_workers[m_next_worker++ % m_workers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mtx);
+        worker.tasks.push_back(std::move(task));
+    }
+    m_work_cv.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_done_cv.wait(lock, [this]() { return m_n_pending == 0; });
+}
+
+bool WorkStealingPool::takeTask(std::size_t index, Task& task) {
+    {
+        Worker& own = *m_workers[index];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal from the other workers, starting with the next one
+    for (std::size_t offset = 1; offset < m_workers.size(); offset++) {
+        Worker& victim = *m_workers[(index + offset) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_n_stolen++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::run(std::size_t index) {
+    while (true) {
+        Task task;
+        if (!takeTask(index, task)) {
+            // Sleep until a task is submitted: checked under m_mtx, so no submission is missed
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_work_cv.wait(lock, [this]() { return m_stop || m_n_queued > 0; });
+            if (m_stop)
+                return;
+            continue;
+        }
+        m_n_queued--;
+
+        task(index);
+
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (--m_n_pending == 0)
+            m_done_cv.notify_all();
+    }
+}
@@ -0,0 +1,419 @@
+/*
+ * Timing analysis of the TDC events of one or several runs, from columnar files (.evcol),
+ * using all the cores: row groups are decoded and analysed in parallel by a work-stealing pool.
+ *
+ * Computes:
+ * - the hit-time histogram of each channel
+ * - the time of each channel relative to a reference channel (first leading hit on the
+ *   reference minus the hit time, as in CosmicTrigger/scripts/TDCacqLoop.cpp)
+ * - the event error codes and TDC error flags
+ * - the continuity of the TDC event numbers (gaps, repeats) of each file
+ *
+ * Usage: analyse_run events_run_N.evcol [...] [--threads=N] [--reference=CHANNEL]
+ *                    [--time-bin=COUNTS] [--dt-bin=COUNTS] [--dt-range=COUNTS] [--output=PREFIX]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+#include "ColumnarEvents.h"
+#include "WorkStealingPool.h"
+#include "ThreadUtils.h"
+#include "CSV.h"
+
+namespace {
+
+    const std::size_t NChannels = 128;
+    // TDC measurements are 19-bit
+    const std::uint32_t TimeRange = 1 << 19;
+    // TDC event counter (global header) is 22-bit
+    const std::uint32_t EventNumberModulo = 1 << 22;
+    const std::size_t NTDCErrorFlags = 15;
+
+    struct Settings {
+        Settings():
+            n_threads(std::max(1u, std::thread::hardware_concurrency())),
+            reference(22),
+            time_bin(64),
+            dt_bin(4),
+            dt_range(4096)
+        {}
+
+        std::size_t n_threads;
+        // Reference channel, < 0 to disable the relative times
+        int reference;
+        std::uint32_t time_bin;
+        std::uint32_t dt_bin;
+        std::int64_t dt_range;
+        std::string output;
+
+        std::size_t getNTimeBins() const { return (TimeRange + time_bin - 1) / time_bin; }
+        std::size_t getNDtBins() const { return (2 * dt_range + dt_bin - 1) / dt_bin; }
+    };
+
+    /*
+     * Histograms and counters of one worker, over all the row groups it processed
+     */
+    struct Histograms {
+        Histograms(const Settings& settings):
+            n_events(0),
+            n_hits(0),
+            n_reference_events(0),
+            n_dt_outside(0),
+            n_time_bins(settings.getNTimeBins()),
+            n_dt_bins(settings.getNDtBins()),
+            channel_hits(NChannels, 0),
+            time(NChannels * n_time_bins, 0),
+            dt(NChannels * n_dt_bins, 0),
+            tdc_error_flags(NTDCErrorFlags, 0)
+        {}
+
+        void merge(const Histograms& other) {
+            n_events += other.n_events;
+            n_hits += other.n_hits;
+            n_reference_events += other.n_reference_events;
+            n_dt_outside += other.n_dt_outside;
+            for (std::size_t i = 0; i < channel_hits.size(); i++)
+                channel_hits[i] += other.channel_hits[i];
+            for (std::size_t i = 0; i < time.size(); i++)
+                time[i] += other.time[i];
+            for (std::size_t i = 0; i < dt.size(); i++)
+                dt[i] += other.dt[i];
+            for (const auto& code: other.error_codes)
+                error_codes[code.first] += code.second;
+            for (std::size_t i = 0; i < tdc_error_flags.size(); i++)
+                tdc_error_flags[i] += other.tdc_error_flags[i];
+        }
+
+        std::uint64_t n_events;
+        std::uint64_t n_hits;
+        // Events with a leading hit on the reference channel
+        std::uint64_t n_reference_events;
+        // Relative times outside of the histogram range
+        std::uint64_t n_dt_outside;
+
+        std::size_t n_time_bins;
+        std::size_t n_dt_bins;
+        std::vector<std::uint64_t> channel_hits;
+        // [channel * n_bins + bin]
+        std::vector<std::uint64_t> time;
+        std::vector<std::uint64_t> dt;
+        std::map<int, std::uint64_t> error_codes;
+        std::vector<std::uint64_t> tdc_error_flags;
+    };
+
+    /*
+     * Continuity of the TDC event numbers over a sequence of events. Computed for each row
+     * group in parallel, then concatenated in the order of the file.
+     */
+    struct SyncStats {
+        SyncStats():
+            n_events(0),
+            first_number(0),
+            last_number(0),
+            n_consecutive(0),
+            n_repeated(0),
+            n_gaps(0),
+            n_missing(0),
+            n_backwards(0),
+            max_gap(0)
+        {}
+
+        void add(std::uint32_t number) {
+            if (n_events == 0)
+                first_number = number;
+            else
+                step(last_number, number);
+            last_number = number;
+            n_events++;
+        }
+
+        void append(const SyncStats& next) {
+            if (next.n_events == 0)
+                return;
+            if (n_events == 0) {
+                *this = next;
+                return;
+            }
+
+            step(last_number, next.first_number);
+            last_number = next.last_number;
+            n_events += next.n_events;
+            n_consecutive += next.n_consecutive;
+            n_repeated += next.n_repeated;
+            n_gaps += next.n_gaps;
+            n_missing += next.n_missing;
+            n_backwards += next.n_backwards;
+            max_gap = std::max(max_gap, next.max_gap);
+        }
+
+        void step(std::uint32_t previous, std::uint32_t next) {
+            // Wrap-around safe: 2^32 is a multiple of the counter range
+            std::uint32_t delta = (next - previous) % EventNumberModulo;
+            if (delta == 1) {
+                n_consecutive++;
+            } else if (delta == 0) {
+                n_repeated++;
+            } else if (delta < EventNumberModulo / 2) {
+                n_gaps++;
+                n_missing += delta - 1;
+                max_gap = std::max(max_gap, delta - 1);
+            } else {
+                n_backwards++;
+            }
+        }
+
+        std::uint64_t n_events;
+        std::uint32_t first_number;
+        std::uint32_t last_number;
+        std::uint64_t n_consecutive;
+        std::uint64_t n_repeated;
+        std::uint64_t n_gaps;
+        std::uint64_t n_missing;
+        std::uint64_t n_backwards;
+        std::uint32_t max_gap;
+    };
+
+    void analyseRowGroup(const Settings& settings, const EventColumns& columns, Histograms& histograms, SyncStats& sync) {
+        std::size_t n_events = columns.getNEvents();
+        histograms.n_events += n_events;
+        histograms.n_hits += columns.getNHits();
+
+        std::size_t hit = 0;
+        std::size_t tdc_error = 0;
+        for (std::size_t i = 0; i < n_events; i++) {
+            sync.add(columns.event_number[i]);
+            if (columns.error_code[i] != 0)
+                histograms.error_codes[columns.error_code[i]]++;
+
+            for (std::size_t end = tdc_error + columns.n_tdc_errors[i]; tdc_error < end; tdc_error++)
+                for (std::size_t flag = 0; flag < NTDCErrorFlags; flag++)
+                    if (columns.tdc_error[tdc_error] & (1u << flag))
+                        histograms.tdc_error_flags[flag]++;
+
+            std::size_t first_hit = hit;
+            std::size_t end_hit = hit + columns.n_hits[i];
+            bool has_reference = false;
+            std::int64_t t0 = 0;
+            for (; hit < end_hit; hit++) {
+                std::uint32_t channel = columns.hit_channel[hit] % NChannels;
+                std::uint32_t time = std::min(columns.hit_time[hit], TimeRange - 1);
+                histograms.channel_hits[channel]++;
+                histograms.time[channel * histograms.n_time_bins + time / settings.time_bin]++;
+                if (!has_reference && static_cast<int>(channel) == settings.reference && columns.hit_leading[hit]) {
+                    has_reference = true;
+                    t0 = time;
+                }
+            }
+
+            if (!has_reference)
+                continue;
+            histograms.n_reference_events++;
+            for (hit = first_hit; hit < end_hit; hit++) {
+                std::uint32_t channel = columns.hit_channel[hit] % NChannels;
+                if (static_cast<int>(channel) == settings.reference || !columns.hit_leading[hit])
+                    continue;
+                std::int64_t dt = t0 - static_cast<std::int64_t>(columns.hit_time[hit]);
+                if (dt < -settings.dt_range || dt >= settings.dt_range) {
+                    histograms.n_dt_outside++;
+                    continue;
+                }
+                histograms.dt[channel * histograms.n_dt_bins + (dt + settings.dt_range) / settings.dt_bin]++;
+            }
+        }
+    }
+
+    /*
+     * Write one histogram per column, for the channels which have entries.
+     * Throws std::ios_base::failure.
+     */
+    void writeHistograms(std::string fileName, std::string bin_name, const std::vector<std::uint64_t>& histograms, std::size_t n_bins, std::int64_t first_bin, std::int64_t bin_width) {
+        CSV csv(fileName, 0);
+        CSV::Field bin_field = csv.addField(bin_name);
+
+        std::vector<std::pair<std::size_t, CSV::Field>> channels;
+        for (std::size_t channel = 0; channel < NChannels; channel++) {
+            auto begin = histograms.begin() + channel * n_bins;
+            if (std::any_of(begin, begin + n_bins, [](std::uint64_t count) { return count != 0; }))
+                channels.emplace_back(channel, csv.addField("ch_" + std::to_string(channel)));
+        }
+        csv.freeze();
+
+        for (std::size_t bin = 0; bin < n_bins; bin++) {
+            csv.setField(bin_field, first_bin + static_cast<std::int64_t>(bin) * bin_width);
+            for (const auto& channel: channels)
+                csv.setField(channel.second, histograms[channel.first * n_bins + bin]);
+            csv.putLine();
+        }
+        csv.flush();
+    }
+
+    void printSync(const std::string& fileName, const SyncStats& sync) {
+        std::cout << fileName << ": event numbers " << sync.first_number << " to " << sync.last_number
+                  << " (" << sync.n_events << " events)" << std::endl;
+        std::cout << "    consecutive: " << sync.n_consecutive << ", repeated: " << sync.n_repeated
+                  << ", backwards: " << sync.n_backwards << ", gaps: " << sync.n_gaps
+                  << " (" << sync.n_missing << " events missing, largest " << sync.max_gap << ")" << std::endl;
+    }
+
+    void usage(const char* name) {
+        Settings defaults;
+        std::cout << "Usage: " << name << " events_run_N.evcol [...] [options]" << std::endl;
+        std::cout << "Timing analysis of TDC events (convert ROOT files with export_columnar first)" << std::endl;
+        std::cout << "    --threads=N          Worker threads (default: " << defaults.n_threads << ")" << std::endl;
+        std::cout << "    --reference=CHANNEL  Reference channel of the relative times, -1 for none (default: " << defaults.reference << ")" << std::endl;
+        std::cout << "    --time-bin=COUNTS    Bin width of the hit-time histograms (default: " << defaults.time_bin << ")" << std::endl;
+        std::cout << "    --dt-bin=COUNTS      Bin width of the relative-time histograms (default: " << defaults.dt_bin << ")" << std::endl;
+        std::cout << "    --dt-range=COUNTS    Relative times from -COUNTS to COUNTS (default: " << defaults.dt_range << ")" << std::endl;
+        std::cout << "    --output=PREFIX      Write the histograms to PREFIX_time.csv and PREFIX_dt.csv" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    Settings settings;
+    std::vector<std::string> files;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            std::string value = arg.substr(arg.find('=') + 1);
+            if (arg.compare(0, 10, "--threads=") == 0) {
+                settings.n_threads = std::stoul(value);
+            } else if (arg.compare(0, 12, "--reference=") == 0) {
+                settings.reference = std::stoi(value);
+            } else if (arg.compare(0, 11, "--time-bin=") == 0) {
+                settings.time_bin = std::stoul(value);
+            } else if (arg.compare(0, 9, "--dt-bin=") == 0) {
+                settings.dt_bin = std::stoul(value);
+            } else if (arg.compare(0, 11, "--dt-range=") == 0) {
+                settings.dt_range = std::stol(value);
+            } else if (arg.compare(0, 9, "--output=") == 0) {
+                settings.output = value;
+            } else if (arg.compare(0, 1, "-") == 0) {
+                files.clear();
+                break;
+            } else {
+                files.push_back(arg);
+            }
+        }
+    } catch (std::logic_error&) {
+        files.clear();
+    }
+    if (files.empty() || settings.n_threads == 0 || settings.time_bin == 0 || settings.dt_bin == 0 || settings.dt_range <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<ColumnarEventReader>> readers;
+    std::uint64_t n_events = 0;
+    try {
+        for (const auto& file: files) {
+            readers.emplace_back(new ColumnarEventReader(file));
+            n_events += readers.back()->getNEvents();
+        }
+    } catch (std::ios_base::failure& error) {
+        std::cerr << "Error: " << error.what() << std::endl;
+        return 1;
+    }
+
+    // One task per row group, results per worker (histograms) or per row group (event numbers)
+    std::vector<std::vector<SyncStats>> sync(readers.size());
+    std::vector<std::vector<std::string>> errors(readers.size());
+    std::vector<Histograms> histograms(settings.n_threads, Histograms(settings));
+    std::vector<EventColumns> columns(settings.n_threads);
+
+    std::cout << "Analysing " << n_events << " events from " << files.size() << " file(s) with " << settings.n_threads << " thread(s)" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    std::size_t n_stolen;
+    {
+        WorkStealingPool pool(settings.n_threads, ThreadSettings("analysis"));
+        for (std::size_t f = 0; f < readers.size(); f++) {
+            sync[f].resize(readers[f]->getNRowGroups());
+            errors[f].resize(readers[f]->getNRowGroups());
+            for (std::size_t g = 0; g < readers[f]->getNRowGroups(); g++) {
+                pool.submit([&, f, g](std::size_t worker) {
+                            try {
+                                readers[f]->readRowGroup(g, columns[worker]);
+                            } catch (std::ios_base::failure& error) {
+                                errors[f][g] = error.what();
+                                return;
+                            }
+                            analyseRowGroup(settings, columns[worker], histograms[worker], sync[f][g]);
+                        });
+            }
+        }
+        pool.wait();
+        n_stolen = pool.getNStolen();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Histograms& total = histograms[0];
+    for (std::size_t i = 1; i < histograms.size(); i++)
+        total.merge(histograms[i]);
+
+    std::cout << "Analysed " << total.n_events << " events, " << total.n_hits << " hits in " << seconds << " s ("
+              << total.n_events / seconds << " events/s, " << total.n_hits / seconds << " hits/s, "
+              << n_stolen << " row groups stolen)" << std::endl;
+
+    int status = 0;
+    std::cout << std::endl << "Event numbers:" << std::endl;
+    for (std::size_t f = 0; f < readers.size(); f++) {
+        SyncStats file_sync;
+        for (std::size_t g = 0; g < sync[f].size(); g++) {
+            if (!errors[f][g].empty()) {
+                std::cerr << "Error: " << files[f] << ", row group " << g << ": " << errors[f][g] << std::endl;
+                status = 1;
+            }
+            file_sync.append(sync[f][g]);
+        }
+        printSync(files[f], file_sync);
+    }
+
+    std::cout << std::endl << "Event error codes:" << (total.error_codes.empty() ? " none" : "") << std::endl;
+    for (const auto& code: total.error_codes)
+        std::cout << "    " << std::setw(4) << code.first << ": " << code.second << std::endl;
+
+    std::cout << "TDC error flags:" << std::endl;
+    bool any_tdc_error = false;
+    for (std::size_t flag = 0; flag < NTDCErrorFlags; flag++) {
+        if (total.tdc_error_flags[flag] == 0)
+            continue;
+        std::cout << "    bit " << std::setw(2) << flag << ": " << total.tdc_error_flags[flag] << std::endl;
+        any_tdc_error = true;
+    }
+    if (!any_tdc_error)
+        std::cout << "    none" << std::endl;
+
+    std::cout << std::endl << "Hits per channel:" << std::endl;
+    for (std::size_t channel = 0; channel < NChannels; channel++)
+        if (total.channel_hits[channel])
+            std::cout << "    " << std::setw(3) << channel << ": " << total.channel_hits[channel] << std::endl;
+    if (settings.reference >= 0)
+        std::cout << total.n_reference_events << " events with a hit on reference channel " << settings.reference
+                  << ", " << total.n_dt_outside << " relative times outside of +-" << settings.dt_range << std::endl;
+
+    if (!settings.output.empty()) {
+        try {
+            writeHistograms(settings.output + "_time.csv", "time", total.time, total.n_time_bins, 0, settings.time_bin);
+            if (settings.reference >= 0)
+                writeHistograms(settings.output + "_dt.csv", "dt", total.dt, total.n_dt_bins, -settings.dt_range, settings.dt_bin);
+        } catch (std::ios_base::failure& error) {
+            std::cerr << "Error: " << error.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Histograms written to " << settings.output << "_*.csv" << std::endl;
+    }
+
+    return status;
+}
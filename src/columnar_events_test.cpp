@@ -0,0 +1,97 @@
+/*
+ * Round trip of events through a columnar file (ColumnarEventWriter -> ColumnarEventReader),
+ * including row groups without any hit (e.g. after the zero suppression of the event filter).
+ *
+ * Usage: columnar_events_test [DIRECTORY] (default: /tmp)
+ * Returns 0 if the events read are those written, 1 otherwise.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+#include "Event.h"
+#include "ColumnarEvents.h"
+
+namespace {
+
+    event makeEvent(unsigned int number, std::size_t n_hits) {
+        event e;
+        e.eventNumber = number;
+        e.time = 1577836800 + number;
+        e.errorCode = 0;
+        for (std::size_t i = 0; i < n_hits; i++)
+            e.hits.push_back({ static_cast<unsigned int>(i % 3), static_cast<unsigned int>(10000 + 7 * i + number), i % 2 == 0 });
+        return e;
+    }
+
+    /*
+     * Write `events` in row groups of `row_group_size`, read them back and compare
+     */
+    bool roundTrip(const std::string& name, const std::string& file_name, const std::vector<event>& events, std::size_t row_group_size) {
+        try {
+            {
+                ColumnarEventWriter writer(file_name, row_group_size);
+                for (const auto& e: events)
+                    writer.write(e);
+                writer.close();
+            }
+
+            ColumnarEventReader reader(file_name);
+            if (reader.getNEvents() != events.size()) {
+                std::cerr << name << ": " << reader.getNEvents() << " events read, " << events.size() << " written" << std::endl;
+                return false;
+            }
+
+            std::size_t index = 0;
+            EventColumns columns;
+            for (std::size_t row_group = 0; row_group < reader.getNRowGroups(); row_group++) {
+                reader.readRowGroup(row_group, columns);
+                std::size_t hit = 0;
+                for (std::size_t i = 0; i < columns.getNEvents(); i++, index++) {
+                    const event& e = events.at(index);
+                    bool same = columns.event_number[i] == e.eventNumber && columns.event_time[i] == e.time
+                        && columns.error_code[i] == e.errorCode && columns.n_hits[i] == e.hits.size();
+                    for (std::size_t h = 0; same && h < e.hits.size(); h++, hit++) {
+                        same = columns.hit_channel.at(hit) == e.hits[h].channel && columns.hit_time.at(hit) == e.hits[h].time
+                            && (columns.hit_leading.at(hit) != 0) == e.hits[h].leading;
+                    }
+                    if (!same) {
+                        std::cerr << name << ": event " << index << " differs" << std::endl;
+                        return false;
+                    }
+                }
+            }
+        } catch (std::ios_base::failure& e) {
+            std::cerr << name << ": " << e.what() << std::endl;
+            std::remove(file_name.c_str());
+            return false;
+        }
+        std::remove(file_name.c_str());
+        return true;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    std::string file_name = std::string(argc > 1 ? argv[1] : "/tmp") + "/columnar_events_test.evcol";
+
+    std::vector<event> no_hits;
+    for (unsigned int i = 0; i < 4; i++)
+        no_hits.push_back(makeEvent(i, 0));
+
+    // A row group without hits between row groups with hits
+    std::vector<event> mixed;
+    for (unsigned int i = 0; i < 12; i++)
+        mixed.push_back(makeEvent(i, (i / 4 == 1) ? 0 : 5));
+
+    bool passed = true;
+    passed = roundTrip("no hits", file_name, no_hits, ColumnarEventWriter::DefaultRowGroupSize) && passed;
+    passed = roundTrip("hitless row group", file_name, mixed, 4) && passed;
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+#include <algorithm>
+
+#include "RunController.h"
+#include "ConditionManager.h"
+#include "ControlSocket.h"
+#include "Utils.h"
+#include "DAQClock.h"
+
+/*
+ * Headless version of the slow control: the run is controlled through the
+ * control socket only (see RunController::executeCommand for the commands).
+ *
+ * With --simulate, it instead runs a single run in virtual time, without control socket.
+ */
+
+namespace {
+    std::atomic<bool> interrupted(false);
+
+    void handleSignal(int) {
+        interrupted = true;
+    }
+
+    /*
+     * Take a run of `hours` (virtual time), in the first run number without files,
+     * as fast as the daemons process it
+     */
+    int simulate(RunController& controller, double hours) {
+        std::uint32_t run_number = 1;
+        while (controller.runFilesExist(run_number))
+            run_number++;
+
+        auto real_start = std::chrono::steady_clock::now();
+        try {
+            controller.configureRun(run_number);
+            controller.startRun();
+        } catch (RunController::run_control_error& e) {
+            std::cerr << "Could not start the simulated run: " << e.what() << std::endl;
+            return 1;
+        }
+
+        // Advance by steps, to report the progress and to stop on signals
+        PeriodicScheduler& scheduler = controller.getConditions().getScheduler();
+        const DAQClock::duration step = std::chrono::minutes(1);
+        DAQClock::time_point start = DAQClock::now();
+        DAQClock::time_point end = start + std::chrono::duration_cast<DAQClock::duration>(std::chrono::duration<double, std::ratio<3600>>(hours));
+        std::uint64_t n_steps = 0;
+        for (DAQClock::time_point time = start; time < end && !interrupted;) {
+            time = std::min(time + step, end);
+            scheduler.advance(time);
+            if (++n_steps % 60 == 0)
+                std::cout << "Simulated " << n_steps / 60 << " h (" << std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count() << " s)." << std::endl;
+        }
+
+        controller.stopRun();
+        std::cout << "Simulated run " << run_number << ": " << std::chrono::duration<double, std::ratio<3600>>(DAQClock::now() - start).count() << " h in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count() << " s." << std::endl;
+        return 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    Arguments m_args(argc, argv);
+    if (m_args.socket_path.empty())
+        m_args.socket_path = "/tmp/SlowControlTBL.sock";
+
+    // The clocks must be virtual before anything uses them
+    if (m_args.simulate_hours > 0)
+        VirtualTime::enable();
+
+    RunController controller(m_args);
+
+    if (m_args.simulate_hours > 0) {
+        if (m_args.simulate_random >= 0) {
+            controller.getConditions().setTriggerChannel(5);
+            controller.getConditions().setTriggerRandomFrequency(m_args.simulate_random);
+        }
+        std::signal(SIGINT, handleSignal);
+        std::signal(SIGTERM, handleSignal);
+        return simulate(controller, m_args.simulate_hours);
+    }
+    
+    try {
+        ControlSocket control_socket(controller, m_args.socket_path);
+
+        std::signal(SIGINT, handleSignal);
+        std::signal(SIGTERM, handleSignal);
+
+        while (!controller.quitRequested() && !interrupted)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    } catch (ControlSocket::socket_error& e) {
+        std::cerr << "Could not start control socket: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Quitting." << std::endl;
+    controller.stopRun();
+
+    return 0;
+}
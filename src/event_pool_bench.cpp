@@ -0,0 +1,134 @@
+/*
+ * Benchmark of the TDC event flow: daemon -> event buffer -> logger -> ROOT sink.
+ *
+ * Compares passing events by value (as done before the event pool) with passing pooled
+ * events by handle, and reports the memory allocations and the bytes copied per event.
+ *
+ * Usage: event_pool_bench [N_EVENTS] [N_HITS]
+ */
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <cstddef>
+
+#include "Event.h"
+#include "EventPool.h"
+#include "MemoryTracker.h"
+
+namespace {
+
+    // Events are taken by the logger by batches of this size
+    const std::size_t BatchSize = 500;
+
+    // Stand-in for the decoding of the TDC output buffer
+    void decode(event& e, unsigned int number, std::size_t n_hits) {
+        e.eventNumber = number;
+        e.errorCode = 0;
+        for (std::size_t i = 0; i < n_hits; i++)
+            e.hits.push_back({ static_cast<unsigned int>(i % 32), number + static_cast<unsigned int>(i), (i % 2) == 0 });
+    }
+
+    // Stand-in for TTree::Fill(): reads the event
+    unsigned long fill(const event& e, unsigned long checksum) {
+        for (const auto& h: e.hits)
+            checksum += h.time ^ h.channel;
+        return checksum + e.eventNumber;
+    }
+
+    struct Result {
+        double seconds;
+        std::size_t n_allocations;
+        std::size_t allocated_bytes;
+        std::size_t copied_bytes;
+        unsigned long checksum;
+    };
+
+    Result byValue(std::size_t n_events, std::size_t n_hits) {
+        Result result = Result();
+        std::vector<event> buffer, record;
+        event tmp_event;
+
+        MemoryTracker::Usage usage_start = MemoryTracker::getTotalUsage();
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t n = 0; n < n_events; n++) {
+            // SetupManager::getTDCEvent() returned a new event
+            event this_evt;
+            decode(this_evt, n, n_hits);
+            // Copied into the event buffer by the daemon
+            buffer.push_back(this_evt);
+            result.copied_bytes += sizeof(event) + this_evt.hits.size() * sizeof(hit);
+
+            if (buffer.size() >= BatchSize || n == n_events - 1) {
+                buffer.swap(record);
+                // Copied again by the sink, before filling the tree
+                for (const auto& e: record) {
+                    tmp_event = e;
+                    result.copied_bytes += sizeof(event) + e.hits.size() * sizeof(hit);
+                    result.checksum = fill(tmp_event, result.checksum);
+                }
+                record.clear();
+            }
+        }
+
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        MemoryTracker::Usage usage = MemoryTracker::getTotalUsage();
+        result.n_allocations = usage.allocations - usage_start.allocations;
+        result.allocated_bytes = usage.allocated_bytes - usage_start.allocated_bytes;
+        return result;
+    }
+
+    Result byHandle(std::size_t n_events, std::size_t n_hits) {
+        Result result = Result();
+        EventPool pool(4 * BatchSize, n_hits);
+        std::vector<EventPool::Handle> buffer, record;
+        buffer.reserve(BatchSize);
+        record.reserve(BatchSize);
+
+        MemoryTracker::Usage usage_start = MemoryTracker::getTotalUsage();
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t n = 0; n < n_events; n++) {
+            EventPool::Handle this_evt = pool.acquire();
+            decode(*this_evt, n, n_hits);
+            buffer.push_back(std::move(this_evt));
+
+            if (buffer.size() >= BatchSize || n == n_events - 1) {
+                buffer.swap(record);
+                for (const auto& e: record)
+                    result.checksum = fill(*e, result.checksum);
+                // Recycle the events
+                record.clear();
+            }
+        }
+
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        MemoryTracker::Usage usage = MemoryTracker::getTotalUsage();
+        result.n_allocations = usage.allocations - usage_start.allocations;
+        result.allocated_bytes = usage.allocated_bytes - usage_start.allocated_bytes;
+        return result;
+    }
+
+    void print(std::string name, const Result& result, std::size_t n_events) {
+        std::cout << name << ": "
+            << result.seconds * 1e9 / n_events << " ns, "
+            << static_cast<double>(result.n_allocations) / n_events << " allocations, "
+            << static_cast<double>(result.allocated_bytes) / n_events << " bytes allocated, "
+            << static_cast<double>(result.copied_bytes) / n_events << " bytes copied per event"
+            << " (checksum " << result.checksum << ")" << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t n_events = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+    std::size_t n_hits = (argc > 2) ? std::stoul(argv[2]) : 16;
+
+    std::cout << n_events << " events of " << n_hits << " hits" << std::endl;
+    print("By value ", byValue(n_events, n_hits), n_events);
+    print("By handle", byHandle(n_events, n_hits), n_events);
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Convert the TDC events of a run from ROOT (events_run_N.root) to a columnar file (.evcol)
+ *
+ * Usage: export_columnar events_run_N.root [events_run_N.evcol] [--row-group=N_EVENTS]
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <exception>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include "Event.h"
+#include "ColumnarEvents.h"
+
+int main(int argc, char** argv) {
+    std::vector<std::string> files;
+    std::size_t row_group_size = ColumnarEventWriter::DefaultRowGroupSize;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 12, "--row-group=") == 0) {
+            row_group_size = std::stoul(arg.substr(12));
+        } else if (arg == "-h" || arg == "--help" || arg.compare(0, 2, "--") == 0) {
+            files.clear();
+            break;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty() || files.size() > 2) {
+        std::cout << "Usage: " << argv[0] << " events_run_N.root [events_run_N.evcol] [--row-group=N_EVENTS]" << std::endl;
+        std::cout << "Convert TDC events from ROOT to a columnar file (default: same name with .evcol, row groups of " << ColumnarEventWriter::DefaultRowGroupSize << " events)" << std::endl;
+        return 1;
+    }
+
+    std::string input_name = files[0];
+    std::string output_name;
+    if (files.size() == 2) {
+        output_name = files[1];
+    } else {
+        std::size_t dot = input_name.rfind(".root");
+        output_name = input_name.substr(0, dot) + ".evcol";
+    }
+
+    TFile input(input_name.c_str(), "read");
+    if (input.IsZombie()) {
+        std::cerr << "Could not open " << input_name << std::endl;
+        return 1;
+    }
+    TTree* tree = nullptr;
+    input.GetObject("Events", tree);
+    if (!tree) {
+        std::cerr << "No Events tree in " << input_name << std::endl;
+        return 1;
+    }
+
+    event* e = nullptr;
+    tree->SetBranchAddress("Event", &e);
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        ColumnarEventWriter writer(output_name, row_group_size);
+
+        Long64_t n_entries = tree->GetEntries();
+        for (Long64_t entry = 0; entry < n_entries; entry++) {
+            tree->GetEntry(entry);
+            writer.write(*e);
+        }
+        writer.close();
+    } catch (std::ios_base::failure& error) {
+        std::cerr << "Error: " << error.what() << std::endl;
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << tree->GetEntries() << " events to " << output_name << " in " << seconds << " s." << std::endl;
+
+    return 0;
+}
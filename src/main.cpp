@@ -1,13 +1,39 @@
 #include <QApplication>
 
+#include <memory>
+#include <iostream>
+
 #include "Interface.h"
+#include "RunController.h"
+#include "ControlSocket.h"
+#include "ThreadUtils.h"
 #include "Utils.h"
 
 int main(int argc, char **argv) {
     QApplication my_app(argc, argv);
  
     Arguments m_args(argc, argv);
-    Interface interface(m_args);
+    if (m_args.simulate_hours > 0)
+        std::cerr << "--simulate is only supported by the daemon (SlowControlTBLd): ignored." << std::endl;
+    
+    // Placement of the GUI thread: set before starting the daemons,
+    // which will reset their own placement
+    ThreadScope gui_scope(makeThreadSettings(m_args, "gui"));
+    
+    RunController controller(m_args);
+
+    // The run can also be controlled by scripts, if requested
+    std::shared_ptr<ControlSocket> control_socket;
+    if (!m_args.socket_path.empty()) {
+        try {
+            control_socket = std::make_shared<ControlSocket>(controller, m_args.socket_path);
+        } catch (ControlSocket::socket_error& e) {
+            // The interface can still control the run
+            std::cerr << "Could not start control socket: " << e.what() << std::endl;
+        }
+    }
+    
+    Interface interface(controller);
 
     interface.show();
 
@@ -0,0 +1,222 @@
+/*
+ * Soak test: takes a long run with the simulated setup in virtual time (see VirtualTime), as fast
+ * as the CPU allows, and checks that the memory of the process and the event buffer stay bounded.
+ *
+ * The resident memory and the memory allocated by each subsystem (see MemoryTracker) are recorded
+ * at the end of a warm-up, and compared with their values at the end of the run. The test fails if
+ * one of them grew by more than the bounds, or if the TDC event buffer ever held more events than
+ * allowed. The progress is printed every virtual hour.
+ *
+ * Usage: soak_test [--hours=H] [--warmup-hours=H] [--max-resident-growth=MB] [--max-allocated-growth=MB]
+ *                  [--max-event-buffer=N] [slow control options, e.g. --sinks=csv,root --simulate-random=5]
+ * The log files are written to a new directory in /tmp unless a log directory is given.
+ * Returns 0 if the bounds hold, 1 otherwise.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+
+#include "RunController.h"
+#include "ConditionManager.h"
+#include "MemoryTracker.h"
+#include "DAQClock.h"
+#include "Utils.h"
+
+namespace {
+
+    std::atomic<bool> interrupted(false);
+
+    void handleSignal(int) {
+        interrupted = true;
+    }
+
+    struct Bounds {
+        double hours = 24;
+        double warmup_hours = 1;
+        // MB
+        double max_resident_growth = 32;
+        double max_allocated_growth = 8;
+        // 0: the size of the event buffer (--event-buffer)
+        std::size_t max_event_buffer = 0;
+    };
+
+    struct Footprint {
+        std::uint64_t resident;
+        std::vector<std::int64_t> allocated;
+    };
+
+    Footprint measure() {
+        Footprint footprint;
+        footprint.resident = MemoryTracker::getResidentBytes();
+        for (std::size_t subsystem = 0; subsystem < MemoryTracker::NSubsystems; subsystem++)
+            footprint.allocated.push_back(MemoryTracker::getUsage(static_cast<MemoryTracker::Subsystem>(subsystem)).bytes);
+        return footprint;
+    }
+
+    void print(std::ostream& out, const Footprint& footprint) {
+        out << "resident " << footprint.resident / (1024 * 1024) << " MB, allocated";
+        for (std::size_t subsystem = 0; subsystem < MemoryTracker::NSubsystems; subsystem++)
+            out << " " << MemoryTracker::SubsystemNames[subsystem] << " " << footprint.allocated[subsystem] / 1024 << " kB";
+    }
+
+    void usage(const char* name) {
+        Bounds defaults;
+        std::cout << "Usage: " << name << " [options] [slow control options]" << std::endl;
+        std::cout << "    --hours=H                   Duration of the run, in virtual hours (default: " << defaults.hours << ")" << std::endl;
+        std::cout << "    --warmup-hours=H            Memory is compared with its value after H hours (default: " << defaults.warmup_hours << ")" << std::endl;
+        std::cout << "    --max-resident-growth=MB    Growth of the resident memory allowed (default: " << defaults.max_resident_growth << ")" << std::endl;
+        std::cout << "    --max-allocated-growth=MB   Growth of the memory allocated by each subsystem allowed (default: " << defaults.max_allocated_growth << ")" << std::endl;
+        std::cout << "    --max-event-buffer=N        Events waiting for the logger allowed (default: the size of the event buffer)" << std::endl;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    Bounds bounds;
+    // The other arguments are those of the slow control
+    std::vector<char*> other_args = { argv[0] };
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            std::string value = arg.substr(arg.find('=') + 1);
+            if (arg.compare(0, 8, "--hours=") == 0) {
+                bounds.hours = std::stod(value);
+            } else if (arg.compare(0, 15, "--warmup-hours=") == 0) {
+                bounds.warmup_hours = std::stod(value);
+            } else if (arg.compare(0, 22, "--max-resident-growth=") == 0) {
+                bounds.max_resident_growth = std::stod(value);
+            } else if (arg.compare(0, 23, "--max-allocated-growth=") == 0) {
+                bounds.max_allocated_growth = std::stod(value);
+            } else if (arg.compare(0, 19, "--max-event-buffer=") == 0) {
+                bounds.max_event_buffer = std::stoul(value);
+            } else if (arg == "-h" || arg == "--help") {
+                usage(argv[0]);
+                std::cout << std::endl << "Slow control options:" << std::endl;
+                Arguments help(2, argv + i - 1);
+                return 0;
+            } else {
+                other_args.push_back(argv[i]);
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << std::endl;
+        usage(argv[0]);
+        return 1;
+    }
+    if (bounds.warmup_hours >= bounds.hours) {
+        std::cerr << "The warm-up must be shorter than the run." << std::endl;
+        return 1;
+    }
+
+    Arguments m_args(other_args.size(), other_args.data());
+    m_args.use_fake_setup = true;
+    if (m_args.log_path == "./") {
+        char log_dir[] = "/tmp/soak_test_XXXXXX";
+        if (!mkdtemp(log_dir)) {
+            std::cerr << "Could not create a log directory." << std::endl;
+            return 1;
+        }
+        m_args.log_path = log_dir;
+    }
+    if (bounds.max_event_buffer == 0)
+        bounds.max_event_buffer = m_args.event_buffer_size;
+    std::cout << "Soak test: " << bounds.hours << " h run, logs in " << m_args.log_path << "." << std::endl;
+
+    // The clocks must be virtual before anything uses them
+    VirtualTime::enable();
+    auto real_start = std::chrono::steady_clock::now();
+
+    RunController controller(m_args);
+    ConditionManager& conditions = controller.getConditions();
+    if (m_args.simulate_random >= 0) {
+        conditions.setTriggerChannel(5);
+        conditions.setTriggerRandomFrequency(m_args.simulate_random);
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    std::uint32_t run_number = 1;
+    while (controller.runFilesExist(run_number))
+        run_number++;
+    try {
+        controller.configureRun(run_number);
+        controller.startRun();
+    } catch (RunController::run_control_error& e) {
+        std::cerr << "Could not start the run: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Advance second by second, to follow the occupancy of the event buffer
+    const DAQClock::duration step = std::chrono::seconds(1);
+    const std::uint64_t steps_per_hour = 3600;
+    const std::uint64_t n_steps = static_cast<std::uint64_t>(bounds.hours * steps_per_hour);
+    const std::uint64_t warmup_steps = static_cast<std::uint64_t>(bounds.warmup_hours * steps_per_hour);
+
+    DAQClock::time_point time = DAQClock::now();
+    std::size_t event_buffer_peak = 0;
+    Footprint warm = measure();
+    std::uint64_t done = 0;
+    for (; done < n_steps && !interrupted; done++) {
+        time += step;
+        conditions.getScheduler().advance(time);
+        {
+            ProfiledLock m_lock(conditions.getTDCLock());
+            event_buffer_peak = std::max(event_buffer_peak, conditions.getTDCEventBuffer().size());
+        }
+
+        if (done + 1 == warmup_steps)
+            warm = measure();
+        if ((done + 1) % steps_per_hour == 0) {
+            std::cout << "Hour " << (done + 1) / steps_per_hour << " ("
+                << std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count() << " s): ";
+            print(std::cout, measure());
+            std::cout << ", event buffer peak " << event_buffer_peak << std::endl;
+        }
+    }
+
+    // Measured before the run is stopped, which frees its buffers
+    Footprint end = measure();
+    controller.stopRun();
+
+    if (done < n_steps) {
+        std::cerr << "Interrupted." << std::endl;
+        return 1;
+    }
+
+    bool passed = true;
+    double resident_growth = (static_cast<double>(end.resident) - warm.resident) / (1024 * 1024);
+    if (resident_growth > bounds.max_resident_growth) {
+        std::cerr << "FAILED: resident memory grew by " << resident_growth << " MB (at most " << bounds.max_resident_growth << ")." << std::endl;
+        passed = false;
+    }
+    for (std::size_t subsystem = 0; subsystem < MemoryTracker::NSubsystems; subsystem++) {
+        double growth = static_cast<double>(end.allocated[subsystem] - warm.allocated[subsystem]) / (1024 * 1024);
+        if (growth > bounds.max_allocated_growth) {
+            std::cerr << "FAILED: memory allocated by " << MemoryTracker::SubsystemNames[subsystem] << " grew by " << growth
+                << " MB (at most " << bounds.max_allocated_growth << ")." << std::endl;
+            passed = false;
+        }
+    }
+    if (event_buffer_peak > bounds.max_event_buffer) {
+        std::cerr << "FAILED: the event buffer held " << event_buffer_peak << " events (at most " << bounds.max_event_buffer << ")." << std::endl;
+        passed = false;
+    }
+
+    std::cout << "After the warm-up: ";
+    print(std::cout, warm);
+    std::cout << std::endl << "At the end: ";
+    print(std::cout, end);
+    std::cout << std::endl << (passed ? "PASSED" : "FAILED") << " (" << bounds.hours << " h in "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count() << " s)." << std::endl;
+
+    return passed ? 0 : 1;
+}